@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+#include "RenderHandler.h"
+#include "ResourceHandler.h"
+#include <atomic>
+
+#ifdef COUNT_ALLOCATIONS
+static std::atomic<UINT64> g_nrOfAllocations(0);
+
+// Replaced Global Allocation, aligned versions keep the default implementation
+void* operator new(size_t size)
+{
+	g_nrOfAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (size == 0)
+		size = 1;
+
+	void* memory = malloc(size);
+	if (!memory)
+		throw std::bad_alloc();
+
+	return memory;
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+#endif // COUNT_ALLOCATIONS
+
+bool AllocationCounter::isCounting()
+{
+#ifdef COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+UINT64 AllocationCounter::getNrOfAllocations()
+{
+#ifdef COUNT_ALLOCATIONS
+	return g_nrOfAllocations.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+AllocationTestResult AllocationCounter::test(UINT nrOfObjects, UINT nrOfFrames)
+{
+	AllocationTestResult result;
+	result.nrOfObjects = nrOfObjects;
+	result.nrOfFrames = nrOfFrames;
+	result.counted = isCounting();
+	if (!result.counted)
+		return result;
+
+	// Window, never shown, the renderer keeps pointers to it and the settings
+	static Settings settings = { 1280, 720, 70.f, 0.0005f, false };
+	static HWND window = nullptr;
+	WNDCLASS windowClass = { };
+	windowClass.lpfnWndProc = DefWindowProc;
+	windowClass.hInstance = GetModuleHandle(NULL);
+	windowClass.lpszClassName = L"AllocationTest";
+	RegisterClass(&windowClass);
+	window = CreateWindowEx(0, windowClass.lpszClassName, L"Allocation Test", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT,
+		settings.width, settings.height, NULL, NULL, windowClass.hInstance, NULL);
+	if (!window)
+	{
+		OutputDebugStringA("Error, failed to create window for the allocation test!\n");
+		result.errors++;
+		return result;
+	}
+
+	// Renderer, set up the same way as the application does but without the UI
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGui_ImplWin32_Init(window);
+	ResourceHandler::getInstance();
+	RenderHandler* renderHandler = RenderHandler::getInstance();
+	renderHandler->initialize(&window, &settings);
+	renderHandler->setImGuiEnabled(false);
+
+	// Objects, two models on a grid so both passes cull, batch and sort real draws
+	const std::string modelNames[] = { "cube.obj", "Tree.FBX" };
+	const UINT gridWidth = 32;
+	std::vector<RenderObjectKey> keys(nrOfObjects);
+	for (UINT i = 0; i < nrOfObjects; i++)
+	{
+		keys[i] = renderHandler->newRenderObject(modelNames[i % 2]);
+		renderHandler->updateRenderObjectTransform(keys[i], XMFLOAT3(1.f, 1.f, 1.f), XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0.f, 0.f, 0.f),
+			XMFLOAT3((i % gridWidth) * 6.f, 0.f, (i / gridWidth) * 6.f));
+	}
+	ResourceHandler::getInstance().finishStreaming();
+
+	const double dt = 1.0 / 60.0;
+	auto frame = [&](UINT frameIndex)
+	{
+		// A few objects move and the camera turns, so some frames update every transform
+		for (UINT i = 0; i < nrOfObjects; i += 20)
+		{
+			renderHandler->updateRenderObjectTransform(keys[i], XMFLOAT3(1.f, 1.f, 1.f), XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0.f, frameIndex * 0.05f, 0.f),
+				XMFLOAT3((i % gridWidth) * 6.f, (frameIndex % 10) * 0.1f, (i / gridWidth) * 6.f));
+		}
+		if (frameIndex % 2 == 0)
+			renderHandler->updateCamera(XMVectorSet(-20.f, 15.f, -20.f, 1.f), XMVectorSet(0.3f, XM_PIDIV4 + frameIndex * 0.01f, 0.f, 0.f));
+
+		renderHandler->update(dt);
+		renderHandler->render(dt);
+	};
+
+	// Warm Up, lets the vectors reach their steady state capacity
+	UINT frameIndex = 0;
+	for (; frameIndex < 10; frameIndex++)
+		frame(frameIndex);
+
+	for (UINT i = 0; i < nrOfFrames; i++, frameIndex++)
+	{
+		UINT64 allocationsBefore = getNrOfAllocations();
+		frame(frameIndex);
+		UINT64 frameAllocations = getNrOfAllocations() - allocationsBefore;
+
+		result.totalAllocations += frameAllocations;
+		result.maxFrameAllocations = std::max(result.maxFrameAllocations, frameAllocations);
+		result.errors += frameAllocations > 0;
+	}
+
+	return result;
+}
@@ -0,0 +1,54 @@
+#include "pch.h"
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// Counting replaces the global operator new, so it is only compiled into debug builds. Profiling builds can define
+// COUNT_ALLOCATIONS themselves
+#if !defined( COUNT_ALLOCATIONS ) && ( defined( DEBUG ) || defined( _DEBUG ) )
+#define COUNT_ALLOCATIONS
+#endif
+
+struct AllocationTestResult
+{
+	UINT nrOfObjects = 0;
+	UINT nrOfFrames = 0;
+	UINT64 totalAllocations = 0; // Over the measured frames, after warm up
+	UINT64 maxFrameAllocations = 0;
+	UINT errors = 0; // Failed setup or a measured frame that allocated
+	bool counted = false; // False when the build does not count allocations, -alloctest then fails
+};
+
+// Counts heap allocations made through operator new, which is replaced in AllocationCounter.cpp when COUNT_ALLOCATIONS
+// is defined. Allocations inside other modules, like the D3D runtime, are not seen
+class AllocationCounter
+{
+private:
+	AllocationCounter() {};
+
+	// Frame
+	UINT64 m_frameStartAllocations = 0;
+	UINT64 m_lastFrameAllocations = 0;
+
+public:
+	AllocationCounter(AllocationCounter const&) = delete;
+	void operator=(AllocationCounter const&) = delete;
+	static AllocationCounter& getInstance()
+	{
+		static AllocationCounter counterInstance;
+		return counterInstance;
+	}
+
+	static bool isCounting();
+	static UINT64 getNrOfAllocations(); // Always 0 when not counting
+
+	// Frame
+	void beginFrame() { m_frameStartAllocations = getNrOfAllocations(); }
+	void endFrame() { m_lastFrameAllocations = getNrOfAllocations() - m_frameStartAllocations; }
+	UINT64 getLastFrameAllocations() const { return m_lastFrameAllocations; }
+
+	// Test, runs the renderer's update and render on a hidden window with moving objects and a moving camera and counts
+	// allocations per steady state frame, every allocating frame is an error
+	static AllocationTestResult test(UINT nrOfObjects = 1000, UINT nrOfFrames = 100);
+};
+
+#endif // !ALLOCATIONCOUNTER_H
@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "Application.h"
+#include "AllocationCounter.h"
+#include "JobSystem.h"
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
@@ -54,6 +56,12 @@ bool Application::initialize(HINSTANCE hInstance, LPWSTR lpCmdLine, HWND hwnd, i
 	// Show Window
 	ShowWindow(m_window, showCmd);
 
+	// Jobs, workers start before anything that loads
+	JobSystem::getInstance();
+
+	// Textures, created before the renderer so it outlives every material holding a texture handle
+	ResourceHandler::getInstance();
+
 	// Renderer
 	m_renderer = RenderHandler::getInstance();
 	m_renderer->initialize(&m_window, &m_settings);
@@ -320,6 +328,8 @@ void Application::applicationLoop()
 		}
 		else // Render/Logic Loop
 		{
+			AllocationCounter::getInstance().beginFrame();
+
 			// Delta Time
 			m_deltaTime = (float)m_timer.timeElapsed();
 			m_timer.restart();
@@ -337,6 +347,8 @@ void Application::applicationLoop()
 			// Render
 			if (m_renderToggle)
 				RenderHandler::getInstance()->render(m_deltaTime);
+
+			AllocationCounter::getInstance().endFrame();
 		}
 	}
 }
@@ -0,0 +1,463 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Bounding Volume Hierarchy over primitive bounds, pure CPU so it can be used for triangles and scene objects alike
+
+struct BVHNode
+{
+	DirectX::XMFLOAT3 boundsMin;
+	unsigned int leftFirst; // Left child for inner nodes (right child is leftFirst + 1), first primitive for leaves
+	DirectX::XMFLOAT3 boundsMax;
+	unsigned int count; // Primitives in the leaf, 0 for inner nodes
+};
+
+struct BVHBenchmarkResult
+{
+	unsigned int nrOfTriangles = 0;
+	unsigned int nrOfNodes = 0;
+	double buildTime = 0.0; // Milliseconds
+
+	double bruteForceRaysPerSecond = 0.0;
+	double bvhRaysPerSecond = 0.0;
+	unsigned int mismatches = 0; // Rays where the closest hit differs between the two paths, before and after a refit
+};
+
+class BVH
+{
+private:
+	static const unsigned int NR_OF_BINS = 12;
+	static const unsigned int MAX_DEPTH = 64; // Also the traversal stack size
+
+	std::vector<BVHNode> m_nodes;
+	std::vector<unsigned int> m_primitiveIndices;
+
+	// Helper Functions
+	static float halfArea(const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax)
+	{
+		float x = boundsMax.x - boundsMin.x;
+		float y = boundsMax.y - boundsMin.y;
+		float z = boundsMax.z - boundsMin.z;
+		return x * y + y * z + z * x;
+	}
+	static void grow(DirectX::XMFLOAT3& boundsMin, DirectX::XMFLOAT3& boundsMax, const DirectX::XMFLOAT3& otherMin, const DirectX::XMFLOAT3& otherMax)
+	{
+		boundsMin = DirectX::XMFLOAT3(std::min(boundsMin.x, otherMin.x), std::min(boundsMin.y, otherMin.y), std::min(boundsMin.z, otherMin.z));
+		boundsMax = DirectX::XMFLOAT3(std::max(boundsMax.x, otherMax.x), std::max(boundsMax.y, otherMax.y), std::max(boundsMax.z, otherMax.z));
+	}
+	static void getBounds(const std::vector<DirectX::BoundingBox>& boxes, std::vector<DirectX::XMFLOAT3>& boundsMin, std::vector<DirectX::XMFLOAT3>& boundsMax)
+	{
+		boundsMin.resize(boxes.size());
+		boundsMax.resize(boxes.size());
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			const DirectX::BoundingBox& box = boxes[i];
+			boundsMin[i] = DirectX::XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+			boundsMax[i] = DirectX::XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+		}
+	}
+	static void getBounds(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<unsigned int>& indices, std::vector<DirectX::XMFLOAT3>& boundsMin,
+		std::vector<DirectX::XMFLOAT3>& boundsMax)
+	{
+		size_t nrOfTriangles = indices.size() / 3;
+		boundsMin.resize(nrOfTriangles);
+		boundsMax.resize(nrOfTriangles);
+		for (size_t i = 0; i < nrOfTriangles; i++)
+		{
+			const DirectX::XMFLOAT3& v0 = vertices[indices[i * 3 + 0]];
+			boundsMin[i] = v0;
+			boundsMax[i] = v0;
+			grow(boundsMin[i], boundsMax[i], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 1]]);
+			grow(boundsMin[i], boundsMax[i], vertices[indices[i * 3 + 2]], vertices[indices[i * 3 + 2]]);
+		}
+	}
+	static float component(const DirectX::XMFLOAT3& vector, int axis)
+	{
+		return (&vector.x)[axis];
+	}
+
+	void updateNodeBounds(BVHNode& node, const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax)
+	{
+		node.boundsMin = DirectX::XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		node.boundsMax = DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (unsigned int i = 0; i < node.count; i++)
+		{
+			unsigned int primitive = m_primitiveIndices[node.leftFirst + i];
+			grow(node.boundsMin, node.boundsMax, boundsMin[primitive], boundsMax[primitive]);
+		}
+	}
+
+	// Splits the node with binned SAH, returns false if the node stays a leaf
+	bool subdivide(unsigned int nodeIndex, const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax, const std::vector<DirectX::XMFLOAT3>& centroids)
+	{
+		BVHNode node = m_nodes[nodeIndex];
+		if (node.count <= 1)
+			return false;
+
+		// Centroid Bounds
+		DirectX::XMFLOAT3 centroidMin(FLT_MAX, FLT_MAX, FLT_MAX);
+		DirectX::XMFLOAT3 centroidMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (unsigned int i = 0; i < node.count; i++)
+		{
+			const DirectX::XMFLOAT3& centroid = centroids[m_primitiveIndices[node.leftFirst + i]];
+			grow(centroidMin, centroidMax, centroid, centroid);
+		}
+
+		// Binning
+		int bestAxis = -1;
+		unsigned int bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float axisMin = component(centroidMin, axis);
+			float axisMax = component(centroidMax, axis);
+			if (axisMin == axisMax)
+				continue;
+
+			DirectX::XMFLOAT3 binMin[NR_OF_BINS];
+			DirectX::XMFLOAT3 binMax[NR_OF_BINS];
+			unsigned int binCount[NR_OF_BINS] = { 0 };
+			for (unsigned int b = 0; b < NR_OF_BINS; b++)
+			{
+				binMin[b] = DirectX::XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+				binMax[b] = DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			}
+
+			float scale = NR_OF_BINS / (axisMax - axisMin);
+			for (unsigned int i = 0; i < node.count; i++)
+			{
+				unsigned int primitive = m_primitiveIndices[node.leftFirst + i];
+				unsigned int bin = std::min(NR_OF_BINS - 1, (unsigned int)((component(centroids[primitive], axis) - axisMin) * scale));
+				binCount[bin]++;
+				grow(binMin[bin], binMax[bin], boundsMin[primitive], boundsMax[primitive]);
+			}
+
+			// Sweep from both sides, split i puts bins [0, i] left and [i + 1, NR_OF_BINS) right
+			float leftArea[NR_OF_BINS - 1];
+			float rightArea[NR_OF_BINS - 1];
+			unsigned int leftCount[NR_OF_BINS - 1];
+			unsigned int rightCount[NR_OF_BINS - 1];
+			DirectX::XMFLOAT3 leftMin(FLT_MAX, FLT_MAX, FLT_MAX), leftMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			DirectX::XMFLOAT3 rightMin(FLT_MAX, FLT_MAX, FLT_MAX), rightMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			unsigned int leftSum = 0;
+			unsigned int rightSum = 0;
+			for (unsigned int i = 0; i < NR_OF_BINS - 1; i++)
+			{
+				leftSum += binCount[i];
+				leftCount[i] = leftSum;
+				if (binCount[i])
+					grow(leftMin, leftMax, binMin[i], binMax[i]);
+				leftArea[i] = leftSum ? halfArea(leftMin, leftMax) : 0.f;
+
+				unsigned int r = NR_OF_BINS - 1 - i;
+				rightSum += binCount[r];
+				rightCount[r - 1] = rightSum;
+				if (binCount[r])
+					grow(rightMin, rightMax, binMin[r], binMax[r]);
+				rightArea[r - 1] = rightSum ? halfArea(rightMin, rightMax) : 0.f;
+			}
+
+			for (unsigned int i = 0; i < NR_OF_BINS - 1; i++)
+			{
+				if (leftCount[i] == 0 || rightCount[i] == 0)
+					continue;
+
+				float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+				if (cost < bestCost)
+				{
+					bestAxis = axis;
+					bestSplit = i;
+					bestCost = cost;
+				}
+			}
+		}
+
+		// Splitting has to be cheaper than testing every primitive in the node
+		float leafCost = node.count * halfArea(node.boundsMin, node.boundsMax);
+		if (bestAxis == -1 || bestCost >= leafCost)
+			return false;
+
+		// Partition
+		float axisMin = component(centroidMin, bestAxis);
+		float scale = NR_OF_BINS / (component(centroidMax, bestAxis) - axisMin);
+		auto first = m_primitiveIndices.begin() + node.leftFirst;
+		auto middle = std::partition(first, first + node.count, [&](unsigned int primitive)
+		{
+			unsigned int bin = std::min(NR_OF_BINS - 1, (unsigned int)((component(centroids[primitive], bestAxis) - axisMin) * scale));
+			return bin <= bestSplit;
+		});
+		unsigned int leftCount = (unsigned int)(middle - first);
+		if (leftCount == 0 || leftCount == node.count)
+			return false;
+
+		// Children
+		BVHNode leftNode;
+		leftNode.leftFirst = node.leftFirst;
+		leftNode.count = leftCount;
+		updateNodeBounds(leftNode, boundsMin, boundsMax);
+
+		BVHNode rightNode;
+		rightNode.leftFirst = node.leftFirst + leftCount;
+		rightNode.count = node.count - leftCount;
+		updateNodeBounds(rightNode, boundsMin, boundsMax);
+
+		m_nodes[nodeIndex].leftFirst = (unsigned int)m_nodes.size();
+		m_nodes[nodeIndex].count = 0;
+		m_nodes.push_back(leftNode);
+		m_nodes.push_back(rightNode);
+
+		return true;
+	}
+
+	// Distance to the box along the ray, FLT_MAX if missed or farther than closestDistance
+	static float intersectNode(const BVHNode& node, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& invDirection, float closestDistance)
+	{
+		float tx1 = (node.boundsMin.x - origin.x) * invDirection.x;
+		float tx2 = (node.boundsMax.x - origin.x) * invDirection.x;
+		float tMin = std::min(tx1, tx2);
+		float tMax = std::max(tx1, tx2);
+		float ty1 = (node.boundsMin.y - origin.y) * invDirection.y;
+		float ty2 = (node.boundsMax.y - origin.y) * invDirection.y;
+		tMin = std::max(tMin, std::min(ty1, ty2));
+		tMax = std::min(tMax, std::max(ty1, ty2));
+		float tz1 = (node.boundsMin.z - origin.z) * invDirection.z;
+		float tz2 = (node.boundsMax.z - origin.z) * invDirection.z;
+		tMin = std::max(tMin, std::min(tz1, tz2));
+		tMax = std::min(tMax, std::max(tz1, tz2));
+
+		if (tMax >= tMin && tMax > 0.f && tMin < closestDistance)
+			return tMin;
+		return FLT_MAX;
+	}
+
+public:
+	// Build
+	void build(const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax, size_t nrOfPrimitives)
+	{
+		m_nodes.clear();
+		m_primitiveIndices.resize(nrOfPrimitives);
+		if (nrOfPrimitives == 0)
+			return;
+
+		std::vector<DirectX::XMFLOAT3> centroids(nrOfPrimitives);
+		for (size_t i = 0; i < nrOfPrimitives; i++)
+		{
+			m_primitiveIndices[i] = (unsigned int)i;
+			centroids[i] = DirectX::XMFLOAT3(
+				(boundsMin[i].x + boundsMax[i].x) * 0.5f,
+				(boundsMin[i].y + boundsMax[i].y) * 0.5f,
+				(boundsMin[i].z + boundsMax[i].z) * 0.5f
+			);
+		}
+
+		m_nodes.reserve(nrOfPrimitives * 2 - 1);
+		BVHNode root;
+		root.leftFirst = 0;
+		root.count = (unsigned int)nrOfPrimitives;
+		updateNodeBounds(root, boundsMin, boundsMax);
+		m_nodes.push_back(root);
+
+		// Node index and depth
+		std::vector<std::pair<unsigned int, unsigned int>> nodeStack;
+		nodeStack.push_back({ 0, 1 });
+		while (!nodeStack.empty())
+		{
+			std::pair<unsigned int, unsigned int> current = nodeStack.back();
+			nodeStack.pop_back();
+
+			if (current.second < MAX_DEPTH && subdivide(current.first, boundsMin, boundsMax, centroids))
+			{
+				unsigned int leftIndex = m_nodes[current.first].leftFirst;
+				nodeStack.push_back({ leftIndex, current.second + 1 });
+				nodeStack.push_back({ leftIndex + 1, current.second + 1 });
+			}
+		}
+		m_nodes.shrink_to_fit();
+	}
+	void build(const std::vector<DirectX::BoundingBox>& boxes)
+	{
+		std::vector<DirectX::XMFLOAT3> boundsMin, boundsMax;
+		getBounds(boxes, boundsMin, boundsMax);
+		build(boundsMin.data(), boundsMax.data(), boxes.size());
+	}
+
+	// Refit, keeps the tree and only updates the node bounds after primitives moved. Needs the same primitives as the build,
+	// the tree gets worse the further they move from where they were built
+	void refit(const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax)
+	{
+		// Children are always stored after their parent
+		for (size_t i = m_nodes.size(); i-- > 0;)
+		{
+			BVHNode& node = m_nodes[i];
+			if (node.count > 0)
+				updateNodeBounds(node, boundsMin, boundsMax);
+			else
+			{
+				node.boundsMin = m_nodes[node.leftFirst].boundsMin;
+				node.boundsMax = m_nodes[node.leftFirst].boundsMax;
+				grow(node.boundsMin, node.boundsMax, m_nodes[node.leftFirst + 1].boundsMin, m_nodes[node.leftFirst + 1].boundsMax);
+			}
+		}
+	}
+	void refit(const std::vector<DirectX::BoundingBox>& boxes)
+	{
+		std::vector<DirectX::XMFLOAT3> boundsMin, boundsMax;
+		getBounds(boxes, boundsMin, boundsMax);
+		refit(boundsMin.data(), boundsMax.data());
+	}
+	void refit(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::vector<DirectX::XMFLOAT3> boundsMin, boundsMax;
+		getBounds(vertices, indices, boundsMin, boundsMax);
+		refit(boundsMin.data(), boundsMax.data());
+	}
+	void build(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::vector<DirectX::XMFLOAT3> boundsMin, boundsMax;
+		getBounds(vertices, indices, boundsMin, boundsMax);
+		build(boundsMin.data(), boundsMax.data(), boundsMin.size());
+	}
+
+	// Closest hit, intersectPrimitive(primitive, distance) returns true and the distance along the ray on a hit
+	template<class IntersectPrimitive>
+	bool intersect(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float& distance, unsigned int& primitive, IntersectPrimitive intersectPrimitive) const
+	{
+		if (m_nodes.empty())
+			return false;
+
+		DirectX::XMFLOAT3 invDirection(1.f / direction.x, 1.f / direction.y, 1.f / direction.z);
+		float closestDistance = FLT_MAX;
+		if (intersectNode(m_nodes[0], origin, invDirection, closestDistance) == FLT_MAX)
+			return false;
+
+		unsigned int nodeStack[MAX_DEPTH];
+		unsigned int stackSize = 0;
+		unsigned int nodeIndex = 0;
+		bool hit = false;
+		while (true)
+		{
+			const BVHNode& node = m_nodes[nodeIndex];
+			if (node.count > 0) // Leaf
+			{
+				for (unsigned int i = 0; i < node.count; i++)
+				{
+					unsigned int currentPrimitive = m_primitiveIndices[node.leftFirst + i];
+					float currentDistance = FLT_MAX;
+					if (intersectPrimitive(currentPrimitive, currentDistance) && currentDistance < closestDistance)
+					{
+						closestDistance = currentDistance;
+						primitive = currentPrimitive;
+						hit = true;
+					}
+				}
+				if (stackSize == 0)
+					break;
+				nodeIndex = nodeStack[--stackSize];
+				continue;
+			}
+
+			// Visit the nearer child first
+			unsigned int nearIndex = node.leftFirst;
+			unsigned int farIndex = node.leftFirst + 1;
+			float nearDistance = intersectNode(m_nodes[nearIndex], origin, invDirection, closestDistance);
+			float farDistance = intersectNode(m_nodes[farIndex], origin, invDirection, closestDistance);
+			if (nearDistance > farDistance)
+			{
+				std::swap(nearIndex, farIndex);
+				std::swap(nearDistance, farDistance);
+			}
+
+			if (nearDistance == FLT_MAX)
+			{
+				if (stackSize == 0)
+					break;
+				nodeIndex = nodeStack[--stackSize];
+			}
+			else
+			{
+				nodeIndex = nearIndex;
+				if (farDistance != FLT_MAX)
+					nodeStack[stackSize++] = farIndex;
+			}
+		}
+
+		if (hit)
+			distance = closestDistance;
+		return hit;
+	}
+
+	// Closest hit against the triangles the hierarchy was built from, direction has to be normalized
+	bool intersect(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<unsigned int>& indices, DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDirection, float& distance, unsigned int& triangle) const
+	{
+		DirectX::XMFLOAT3 origin, direction;
+		DirectX::XMStoreFloat3(&origin, rayOrigin);
+		DirectX::XMStoreFloat3(&direction, rayDirection);
+
+		return intersect(origin, direction, distance, triangle, [&](unsigned int primitive, float& triangleDistance)
+		{
+			return DirectX::TriangleTests::Intersects(rayOrigin, rayDirection,
+				DirectX::XMLoadFloat3(&vertices[indices[primitive * 3 + 0]]),
+				DirectX::XMLoadFloat3(&vertices[indices[primitive * 3 + 1]]),
+				DirectX::XMLoadFloat3(&vertices[indices[primitive * 3 + 2]]),
+				triangleDistance);
+		});
+	}
+
+	// Load, takes a hierarchy built earlier, like a cooked one. Returns false and stays empty when it does not fit
+	// nrOfPrimitives or would overflow the traversal stack
+	bool load(std::vector<BVHNode>&& nodes, std::vector<unsigned int>&& primitiveIndices, size_t nrOfPrimitives)
+	{
+		m_nodes.clear();
+		m_primitiveIndices.clear();
+		if (primitiveIndices.size() != nrOfPrimitives || nodes.empty() != (nrOfPrimitives == 0))
+			return false;
+		for (unsigned int primitive : primitiveIndices)
+		{
+			if (primitive >= nrOfPrimitives)
+				return false;
+		}
+
+		// Children after their parent, like a build stores them
+		std::vector<unsigned int> depths(nodes.size(), 1);
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const BVHNode& node = nodes[i];
+			if (depths[i] > MAX_DEPTH)
+				return false;
+			if (node.count > 0)
+			{
+				if ((size_t)node.leftFirst + node.count > nrOfPrimitives)
+					return false;
+			}
+			else
+			{
+				if (node.leftFirst <= i || (size_t)node.leftFirst + 1 >= nodes.size())
+					return false;
+				depths[node.leftFirst] = std::max(depths[node.leftFirst], depths[i] + 1);
+				depths[node.leftFirst + 1] = std::max(depths[node.leftFirst + 1], depths[i] + 1);
+			}
+		}
+
+		m_nodes = std::move(nodes);
+		m_primitiveIndices = std::move(primitiveIndices);
+		return true;
+	}
+
+	// Getters
+	bool isEmpty() const { return m_nodes.empty(); }
+	const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+	const std::vector<unsigned int>& getPrimitiveIndices() const { return m_primitiveIndices; }
+	size_t getNrOfNodes() const { return m_nodes.size(); }
+	size_t getSizeInBytes() const { return m_nodes.size() * sizeof(BVHNode) + m_primitiveIndices.size() * sizeof(unsigned int); }
+
+	// Benchmark, in BVHTests.cpp
+	static BVHBenchmarkResult benchmark(unsigned int gridSize = 360, unsigned int nrOfRays = 10000, unsigned int nrOfBruteForceRays = 100);
+};
+
+#endif // !BVH_H
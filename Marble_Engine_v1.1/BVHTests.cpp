@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "BVH.h"
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// Benchmark, closest hit rays against a noisy height field compared with testing every triangle
+BVHBenchmarkResult BVH::benchmark(unsigned int gridSize, unsigned int nrOfRays, unsigned int nrOfBruteForceRays)
+{
+	// Synthetic Mesh, gridSize 360 gives about 260k triangles
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> heightDistribution(0.f, 2.f);
+	std::vector<XMFLOAT3> vertices;
+	std::vector<unsigned int> indices;
+	vertices.reserve((size_t)(gridSize + 1) * (gridSize + 1));
+	indices.reserve((size_t)gridSize * gridSize * 6);
+	for (unsigned int z = 0; z <= gridSize; z++)
+		for (unsigned int x = 0; x <= gridSize; x++)
+			vertices.push_back(XMFLOAT3((float)x, heightDistribution(generator), (float)z));
+	for (unsigned int z = 0; z < gridSize; z++)
+	{
+		for (unsigned int x = 0; x < gridSize; x++)
+		{
+			unsigned int i0 = z * (gridSize + 1) + x;
+			unsigned int i1 = i0 + gridSize + 1;
+			indices.insert(indices.end(), { i0, i1, i1 + 1, i0, i1 + 1, i0 + 1 });
+		}
+	}
+
+	BVHBenchmarkResult result;
+	result.nrOfTriangles = (unsigned int)(indices.size() / 3);
+
+	auto startTime = std::chrono::steady_clock::now();
+	BVH bvh;
+	bvh.build(vertices, indices);
+	result.buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	result.nrOfNodes = (unsigned int)bvh.getNrOfNodes();
+
+	// Rays from above the field aimed at random points on it
+	std::uniform_real_distribution<float> positionDistribution(0.f, (float)gridSize);
+	std::vector<XMFLOAT3> rayOrigins(nrOfRays);
+	std::vector<XMFLOAT3> rayDirections(nrOfRays);
+	for (unsigned int i = 0; i < nrOfRays; i++)
+	{
+		XMVECTOR origin = XMVectorSet(positionDistribution(generator), 50.f, positionDistribution(generator), 1.f);
+		XMVECTOR target = XMVectorSet(positionDistribution(generator), 1.f, positionDistribution(generator), 1.f);
+		XMStoreFloat3(&rayOrigins[i], origin);
+		XMStoreFloat3(&rayDirections[i], XMVector3Normalize(target - origin));
+	}
+
+	// BVH
+	std::vector<float> bvhDistances(nrOfRays, FLT_MAX);
+	startTime = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < nrOfRays; i++)
+	{
+		unsigned int triangle = 0;
+		bvh.intersect(vertices, indices, XMLoadFloat3(&rayOrigins[i]), XMLoadFloat3(&rayDirections[i]), bvhDistances[i], triangle);
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.bvhRaysPerSecond = nrOfRays / std::max(elapsed, 1e-9);
+
+	// Brute Force
+	auto bruteForceDistance = [&](unsigned int ray)
+	{
+		XMVECTOR origin = XMLoadFloat3(&rayOrigins[ray]);
+		XMVECTOR direction = XMLoadFloat3(&rayDirections[ray]);
+		float closestDistance = FLT_MAX;
+		for (size_t t = 0; t < result.nrOfTriangles; t++)
+		{
+			float distance = 0.f;
+			if (TriangleTests::Intersects(origin, direction, XMLoadFloat3(&vertices[indices[t * 3 + 0]]), XMLoadFloat3(&vertices[indices[t * 3 + 1]]), XMLoadFloat3(&vertices[indices[t * 3 + 2]]), distance))
+				closestDistance = std::min(closestDistance, distance);
+		}
+		return closestDistance;
+	};
+	nrOfBruteForceRays = std::min(nrOfBruteForceRays, nrOfRays);
+	startTime = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < nrOfBruteForceRays; i++)
+	{
+		if (fabsf(bruteForceDistance(i) - bvhDistances[i]) > 1e-4f)
+			result.mismatches++;
+	}
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.bruteForceRaysPerSecond = nrOfBruteForceRays / std::max(elapsed, 1e-9);
+
+	// Refit, the field gets new heights and slides sideways, a refit hierarchy still has to find the same hits
+	for (XMFLOAT3& vertex : vertices)
+	{
+		vertex.x += 0.3f;
+		vertex.y = heightDistribution(generator) * 2.f;
+	}
+	bvh.refit(vertices, indices);
+	for (unsigned int i = 0; i < nrOfBruteForceRays; i++)
+	{
+		float distance = FLT_MAX;
+		unsigned int triangle = 0;
+		bvh.intersect(vertices, indices, XMLoadFloat3(&rayOrigins[i]), XMLoadFloat3(&rayDirections[i]), distance, triangle);
+		if (fabsf(bruteForceDistance(i) - distance) > 1e-4f)
+			result.mismatches++;
+	}
+
+	return result;
+}
+
@@ -0,0 +1,165 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Sort and sweep broadphase over AABB proxies, pure CPU so it can be stepped without a renderer
+
+struct BroadphaseBenchmarkResult
+{
+	unsigned int nrOfBodies = 0;
+	unsigned int nrOfSteps = 0;
+	double stepTime = 0.0; // Average milliseconds per step, integration + broadphase + narrowphase
+	double broadphaseTime = 0.0; // Average milliseconds per step spent in update()
+	double averagePairs = 0.0;
+	double averageContacts = 0.0;
+	unsigned int mismatches = 0; // Steps whose pairs or candidates differ from testing every pair of bodies
+};
+
+class Broadphase
+{
+private:
+	struct Proxy
+	{
+		DirectX::BoundingBox bounds;
+		void* userData = nullptr;
+		bool active = false;
+	};
+
+	// Proxies, removed slots are reused
+	std::vector<Proxy> m_proxies;
+	std::vector<unsigned int> m_freeProxies;
+	unsigned int m_nrOfActiveProxies = 0;
+
+	// Sweep
+	std::vector<std::pair<float, unsigned int>> m_sortedMinX;
+	std::vector<float> m_sortedMaxX;
+
+	// Pairs, first < second
+	std::vector<std::pair<unsigned int, unsigned int>> m_pairs;
+
+	// Candidates per proxy, proxy p owns [m_candidateOffsets[p], m_candidateOffsets[p + 1])
+	std::vector<unsigned int> m_candidateOffsets;
+	std::vector<unsigned int> m_candidates;
+	std::vector<unsigned int> m_fillOffsets;
+
+	static bool overlapsYZ(const DirectX::BoundingBox& a, const DirectX::BoundingBox& b)
+	{
+		return fabsf(a.Center.y - b.Center.y) <= a.Extents.y + b.Extents.y &&
+			fabsf(a.Center.z - b.Center.z) <= a.Extents.z + b.Extents.z;
+	}
+
+public:
+	// Proxies
+	unsigned int addProxy(const DirectX::BoundingBox& bounds, void* userData = nullptr)
+	{
+		unsigned int proxy;
+		if (!m_freeProxies.empty())
+		{
+			proxy = m_freeProxies.back();
+			m_freeProxies.pop_back();
+		}
+		else
+		{
+			proxy = (unsigned int)m_proxies.size();
+			m_proxies.emplace_back();
+		}
+		m_proxies[proxy].bounds = bounds;
+		m_proxies[proxy].userData = userData;
+		m_proxies[proxy].active = true;
+		m_nrOfActiveProxies++;
+
+		return proxy;
+	}
+	void removeProxy(unsigned int proxy)
+	{
+		if (proxy >= m_proxies.size() || !m_proxies[proxy].active)
+			return;
+
+		m_proxies[proxy].active = false;
+		m_proxies[proxy].userData = nullptr;
+		m_freeProxies.push_back(proxy);
+		m_nrOfActiveProxies--;
+	}
+	void updateProxy(unsigned int proxy, const DirectX::BoundingBox& bounds)
+	{
+		m_proxies[proxy].bounds = bounds;
+	}
+
+	// Sorts the proxies on min x and sweeps, O(n log n) plus the number of x overlaps
+	void update()
+	{
+		m_sortedMinX.clear();
+		for (unsigned int i = 0; i < (unsigned int)m_proxies.size(); i++)
+		{
+			if (m_proxies[i].active)
+				m_sortedMinX.push_back({ m_proxies[i].bounds.Center.x - m_proxies[i].bounds.Extents.x, i });
+		}
+		std::sort(m_sortedMinX.begin(), m_sortedMinX.end()); // Ties are ordered by proxy, keeps the pair order deterministic
+
+		m_sortedMaxX.resize(m_sortedMinX.size());
+		for (size_t i = 0; i < m_sortedMinX.size(); i++)
+		{
+			const DirectX::BoundingBox& bounds = m_proxies[m_sortedMinX[i].second].bounds;
+			m_sortedMaxX[i] = bounds.Center.x + bounds.Extents.x;
+		}
+
+		// Sweep
+		m_pairs.clear();
+		for (size_t i = 0; i < m_sortedMinX.size(); i++)
+		{
+			unsigned int proxyA = m_sortedMinX[i].second;
+			const DirectX::BoundingBox& boundsA = m_proxies[proxyA].bounds;
+			for (size_t j = i + 1; j < m_sortedMinX.size() && m_sortedMinX[j].first <= m_sortedMaxX[i]; j++)
+			{
+				unsigned int proxyB = m_sortedMinX[j].second;
+				if (overlapsYZ(boundsA, m_proxies[proxyB].bounds))
+					m_pairs.push_back({ std::min(proxyA, proxyB), std::max(proxyA, proxyB) });
+			}
+		}
+
+		// Candidates
+		m_candidateOffsets.assign(m_proxies.size() + 1, 0);
+		for (auto& pair : m_pairs)
+		{
+			m_candidateOffsets[pair.first + 1]++;
+			m_candidateOffsets[pair.second + 1]++;
+		}
+		for (size_t i = 1; i < m_candidateOffsets.size(); i++)
+			m_candidateOffsets[i] += m_candidateOffsets[i - 1];
+
+		m_candidates.resize(m_pairs.size() * 2);
+		m_fillOffsets.assign(m_candidateOffsets.begin(), m_candidateOffsets.end() - 1);
+		for (auto& pair : m_pairs)
+		{
+			m_candidates[m_fillOffsets[pair.first]++] = pair.second;
+			m_candidates[m_fillOffsets[pair.second]++] = pair.first;
+		}
+	}
+
+	// Getters
+	const std::vector<std::pair<unsigned int, unsigned int>>& getPairs() const { return m_pairs; }
+	const unsigned int* getCandidates(unsigned int proxy, unsigned int& nrOfCandidates) const
+	{
+		if (proxy + 1 >= m_candidateOffsets.size()) // Added after the last update
+		{
+			nrOfCandidates = 0;
+			return nullptr;
+		}
+		nrOfCandidates = m_candidateOffsets[proxy + 1] - m_candidateOffsets[proxy];
+		return m_candidates.data() + m_candidateOffsets[proxy];
+	}
+	const DirectX::BoundingBox& getBounds(unsigned int proxy) const { return m_proxies[proxy].bounds; }
+	void* getUserData(unsigned int proxy) const { return m_proxies[proxy].userData; }
+	unsigned int getNrOfProxies() const { return m_nrOfActiveProxies; }
+
+	// Test and Benchmark, in BroadphaseTests.cpp
+	static unsigned int test();
+	static BroadphaseBenchmarkResult benchmark(unsigned int nrOfBodies = 10000, unsigned int nrOfSteps = 100, float dt = 1.f / 60.f);
+};
+
+#endif // !BROADPHASE_H
@@ -0,0 +1,192 @@
+#include "pch.h"
+#include "Broadphase.h"
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// Every pair of bodies whose bounds overlap or touch, first < second and sorted
+static void bruteForcePairs(const std::vector<BoundingBox>& bounds, const std::vector<unsigned int>& proxies, std::vector<std::pair<unsigned int, unsigned int>>& pairs)
+{
+	pairs.clear();
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		const BoundingBox& a = bounds[i];
+		float minX = a.Center.x - a.Extents.x, maxX = a.Center.x + a.Extents.x;
+		for (size_t j = i + 1; j < bounds.size(); j++)
+		{
+			const BoundingBox& b = bounds[j];
+			if (b.Center.x - b.Extents.x <= maxX && minX <= b.Center.x + b.Extents.x &&
+				fabsf(a.Center.y - b.Center.y) <= a.Extents.y + b.Extents.y &&
+				fabsf(a.Center.z - b.Center.z) <= a.Extents.z + b.Extents.z)
+				pairs.push_back({ std::min(proxies[i], proxies[j]), std::max(proxies[i], proxies[j]) });
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+}
+
+// Number of differences between the broadphase output and the reference pairs, the pair list and every candidate list
+static unsigned int comparePairs(const Broadphase& broadphase, const std::vector<std::pair<unsigned int, unsigned int>>& reference, unsigned int nrOfProxySlots)
+{
+	unsigned int errors = 0;
+	std::vector<std::pair<unsigned int, unsigned int>> pairs = broadphase.getPairs();
+	std::sort(pairs.begin(), pairs.end());
+	errors += pairs != reference;
+
+	std::vector<std::vector<unsigned int>> referenceCandidates(nrOfProxySlots);
+	for (auto& pair : reference)
+	{
+		referenceCandidates[pair.first].push_back(pair.second);
+		referenceCandidates[pair.second].push_back(pair.first);
+	}
+	for (unsigned int proxy = 0; proxy < nrOfProxySlots; proxy++)
+	{
+		unsigned int nrOfCandidates = 0;
+		const unsigned int* candidates = broadphase.getCandidates(proxy, nrOfCandidates);
+		std::vector<unsigned int> sorted(candidates, candidates + nrOfCandidates);
+		std::sort(sorted.begin(), sorted.end());
+		std::sort(referenceCandidates[proxy].begin(), referenceCandidates[proxy].end());
+		errors += sorted != referenceCandidates[proxy];
+	}
+
+	return errors;
+}
+
+// Test, hand placed boxes on the edges of the overlap tests and proxy slots being reused
+unsigned int Broadphase::test()
+{
+	unsigned int errors = 0;
+	Broadphase broadphase;
+	unsigned int nrOfCandidates = 0;
+
+	// Empty
+	broadphase.update();
+	errors += !broadphase.getPairs().empty() || broadphase.getNrOfProxies() != 0;
+	errors += broadphase.getCandidates(0, nrOfCandidates) != nullptr || nrOfCandidates != 0;
+
+	// Faces touching on x, apart on y only, apart on z only, the same min x and a box inside another
+	std::vector<BoundingBox> bounds = {
+		BoundingBox(XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(2.f, 0.f, 0.f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(0.f, 2.5f, 0.f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(0.f, 0.f, -2.5f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(0.f, -10.f, 10.f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(0.f, -10.f, 10.f), XMFLOAT3(1.f, 1.f, 1.f)),
+		BoundingBox(XMFLOAT3(1.f, 0.f, 0.f), XMFLOAT3(0.f, 0.f, 0.f))
+	};
+	std::vector<unsigned int> proxies;
+	for (auto& box : bounds)
+		proxies.push_back(broadphase.addProxy(box));
+	broadphase.update();
+	std::vector<std::pair<unsigned int, unsigned int>> reference;
+	bruteForcePairs(bounds, proxies, reference);
+	errors += comparePairs(broadphase, reference, (unsigned int)bounds.size());
+	errors += reference.size() != 4; // 0-1, 0-6, 1-6 and 4-5
+
+	// Removed proxies leave the pairs, a new proxy reuses the slot and is only paired after the next update
+	broadphase.removeProxy(proxies[1]);
+	broadphase.removeProxy(proxies[1]);
+	errors += broadphase.getNrOfProxies() != (unsigned int)bounds.size() - 1;
+	bounds.erase(bounds.begin() + 1);
+	proxies.erase(proxies.begin() + 1);
+	broadphase.update();
+	bruteForcePairs(bounds, proxies, reference);
+	errors += comparePairs(broadphase, reference, (unsigned int)bounds.size() + 1);
+
+	BoundingBox addedBox(XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+	unsigned int addedProxy = broadphase.addProxy(addedBox);
+	errors += addedProxy != 1;
+	broadphase.getCandidates(addedProxy, nrOfCandidates);
+	errors += nrOfCandidates != 0;
+	bounds.push_back(addedBox);
+	proxies.push_back(addedProxy);
+	broadphase.update();
+	bruteForcePairs(bounds, proxies, reference);
+	errors += comparePairs(broadphase, reference, (unsigned int)bounds.size());
+
+	return errors;
+}
+
+// Benchmark, steps bodies bouncing inside a box and resolves overlaps between candidate pairs. The pairs of every step are
+// checked against testing every pair of bodies, outside of the timing
+BroadphaseBenchmarkResult Broadphase::benchmark(unsigned int nrOfBodies, unsigned int nrOfSteps, float dt)
+{
+	const float worldExtent = 200.f;
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> positionDistribution(-worldExtent, worldExtent);
+	std::uniform_real_distribution<float> extentDistribution(0.5f, 1.5f);
+	std::uniform_real_distribution<float> velocityDistribution(-10.f, 10.f);
+
+	std::vector<BoundingBox> bodies(nrOfBodies);
+	std::vector<BoundingBox> sweptBodies(nrOfBodies);
+	std::vector<XMFLOAT3> velocities(nrOfBodies);
+	std::vector<unsigned int> proxies(nrOfBodies);
+	Broadphase broadphase;
+	for (unsigned int i = 0; i < nrOfBodies; i++)
+	{
+		bodies[i].Center = XMFLOAT3(positionDistribution(generator), positionDistribution(generator), positionDistribution(generator));
+		bodies[i].Extents = XMFLOAT3(extentDistribution(generator), extentDistribution(generator), extentDistribution(generator));
+		velocities[i] = XMFLOAT3(velocityDistribution(generator), velocityDistribution(generator), velocityDistribution(generator));
+		proxies[i] = broadphase.addProxy(bodies[i]);
+	}
+
+	BroadphaseBenchmarkResult result;
+	result.nrOfBodies = nrOfBodies;
+	result.nrOfSteps = nrOfSteps;
+
+	double totalPairs = 0.0;
+	double totalContacts = 0.0;
+	double totalStepTime = 0.0;
+	double totalBroadphaseTime = 0.0;
+	std::vector<std::pair<unsigned int, unsigned int>> reference;
+	for (unsigned int step = 0; step < nrOfSteps; step++)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		// Integrate, bounce off the world bounds
+		for (unsigned int i = 0; i < nrOfBodies; i++)
+		{
+			float* center = &bodies[i].Center.x;
+			float* velocity = &velocities[i].x;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				center[axis] += velocity[axis] * dt;
+				if (fabsf(center[axis]) > worldExtent)
+					velocity[axis] = -velocity[axis];
+			}
+
+			// Swept bounds so next step's overlaps are found too
+			BoundingBox nextBounds = bodies[i];
+			nextBounds.Center = XMFLOAT3(center[0] + velocity[0] * dt, center[1] + velocity[1] * dt, center[2] + velocity[2] * dt);
+			BoundingBox::CreateMerged(sweptBodies[i], bodies[i], nextBounds);
+			broadphase.updateProxy(proxies[i], sweptBodies[i]);
+		}
+
+		auto broadphaseStartTime = std::chrono::steady_clock::now();
+		broadphase.update();
+		totalBroadphaseTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - broadphaseStartTime).count();
+		totalPairs += (double)broadphase.getPairs().size();
+
+		// Narrowphase, swap velocities of touching bodies
+		for (auto& pair : broadphase.getPairs())
+		{
+			if (bodies[pair.first].Intersects(bodies[pair.second]))
+			{
+				std::swap(velocities[pair.first], velocities[pair.second]);
+				totalContacts += 1.0;
+			}
+		}
+		totalStepTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		// Reference
+		bruteForcePairs(sweptBodies, proxies, reference);
+		result.mismatches += comparePairs(broadphase, reference, nrOfBodies) != 0;
+	}
+
+	result.stepTime = totalStepTime / std::max(nrOfSteps, 1u);
+	result.broadphaseTime = totalBroadphaseTime / std::max(nrOfSteps, 1u);
+	result.averagePairs = totalPairs / std::max(nrOfSteps, 1u);
+	result.averageContacts = totalContacts / std::max(nrOfSteps, 1u);
+
+	return result;
+}
@@ -5,6 +5,9 @@
 
 enum class BufferType { VERTEX, INDEX, CONSTANT};
 
+// Index Width, 16 bit indices reach vertex 65535 so up to 65536 vertices fit. Used by the cooker and the index buffers alike
+inline bool needs32BitIndices(UINT nrOfVertices) { return nrOfVertices > USHRT_MAX + 1; }
+
 template<class T>
 class Buffer
 {
@@ -15,13 +18,37 @@ private:
 	// Buffer
 	Microsoft::WRL::ComPtr< ID3D11Buffer > m_buffer;
 
-	// Data
-	std::shared_ptr<T> m_data;
-
 	// Meta Data
 	UINT m_stride;
 	UINT m_nrOf;
 
+	// Helper Functions
+	void createIndexBuffer(ID3D11Device* device, const void* data, UINT stride, UINT nrOfIndices, bool immutable)
+	{
+		// Meta Data
+		m_nrOf = nrOfIndices;
+		m_stride = stride;
+
+		// Buffer Description
+		D3D11_BUFFER_DESC bufferDesc;
+		ZeroMemory(&bufferDesc, sizeof(D3D11_BUFFER_DESC));
+		if (immutable)
+			bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		else
+			bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		bufferDesc.ByteWidth = m_nrOf * m_stride;
+		bufferDesc.CPUAccessFlags = 0;
+
+		// Subresource data
+		D3D11_SUBRESOURCE_DATA indexData;
+		ZeroMemory(&indexData, sizeof(D3D11_SUBRESOURCE_DATA));
+		indexData.pSysMem = data;
+
+		HRESULT hr = device->CreateBuffer(&bufferDesc, &indexData, m_buffer.GetAddressOf());
+		assert(SUCCEEDED(hr) && "Error, failed to create Index buffer!");
+	}
+
 public:
 	Buffer()
 	{
@@ -33,7 +60,6 @@ public:
 	{
 		m_deviceContext = otherBuffer.m_deviceContext;
 		m_buffer = otherBuffer.m_buffer;
-		m_data = otherBuffer.m_data;
 		m_stride = otherBuffer.m_stride;
 		m_nrOf = otherBuffer.m_nrOf;
 	}
@@ -41,7 +67,6 @@ public:
 	{
 		m_deviceContext = otherBuffer.m_deviceContext;
 		m_buffer = otherBuffer.m_buffer;
-		m_data = otherBuffer.m_data;
 		m_stride = otherBuffer.m_stride;
 		m_nrOf = otherBuffer.m_nrOf;
 		return *this;
@@ -52,10 +77,6 @@ public:
 	void initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, T* data, BufferType bufferType, UINT nrOfVertices = 0, bool immutable = true, bool streamOutputVertices = false)
 	{
 		m_deviceContext = deviceContext;
-		if (data == nullptr)
-			m_data = std::make_shared<T>();
-		else
-			m_data = std::make_shared<T>(*data);
 
 		D3D11_BUFFER_DESC bufferDesc;
 		ZeroMemory(&bufferDesc, sizeof(D3D11_BUFFER_DESC));
@@ -70,9 +91,10 @@ public:
 			bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-			// Data
+			// Data, zeroed when none is given
+			T defaultData = T();
 			D3D11_SUBRESOURCE_DATA constantData;
-			constantData.pSysMem = m_data.get();
+			constantData.pSysMem = data != nullptr ? data : &defaultData;
 			constantData.SysMemPitch = 0;
 			constantData.SysMemSlicePitch = 0;
 
@@ -116,28 +138,31 @@ public:
 			}
 		}
 		else if (bufferType == BufferType::INDEX)
-		{
-			// Meta Data
-			m_nrOf = nrOfVertices;
-			m_stride = sizeof(UINT);
-
-			// Buffer Description
-			if (immutable)
-				bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-			else
-				bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-			bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-			bufferDesc.ByteWidth = m_nrOf * m_stride;
-			bufferDesc.CPUAccessFlags = 0;
+			createIndexBuffer(device, data, sizeof(UINT), nrOfVertices, immutable);
+	}
 
-			// Subresource data
-			D3D11_SUBRESOURCE_DATA indexData;
-			ZeroMemory(&indexData, sizeof(D3D11_SUBRESOURCE_DATA));
-			indexData.pSysMem = data;
+	// Index buffer of 16 bit indices when every index fits, 32 bit otherwise. The stride tells which format to bind
+	void initializeIndices(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const UINT* indices, UINT nrOfIndices, UINT nrOfVertices)
+	{
+		m_deviceContext = deviceContext;
 
-			HRESULT hr = device->CreateBuffer(&bufferDesc, &indexData, m_buffer.GetAddressOf());
-			assert(SUCCEEDED(hr) && "Error, failed to create Index buffer!");
+		if (needs32BitIndices(nrOfVertices))
+		{
+			createIndexBuffer(device, indices, sizeof(UINT), nrOfIndices, true);
+			return;
 		}
+
+		std::vector<USHORT> indices16(nrOfIndices);
+		for (UINT i = 0; i < nrOfIndices; i++)
+			indices16[i] = (USHORT)indices[i];
+		createIndexBuffer(device, indices16.data(), sizeof(USHORT), nrOfIndices, true);
+	}
+	// Index buffer of indices that are already 16 bit, like the ones in a cooked model
+	void initializeIndices(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const USHORT* indices, UINT nrOfIndices)
+	{
+		m_deviceContext = deviceContext;
+
+		createIndexBuffer(device, indices, sizeof(USHORT), nrOfIndices, true);
 	}
 
 	// Accessors
@@ -148,29 +173,64 @@ public:
 	const UINT* getStridePointer() const { return &m_stride; }
 
 	UINT getSize() const { return m_nrOf; }
+	DXGI_FORMAT getIndexFormat() const { return m_stride == sizeof(USHORT) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT; }
 
-	// Update
-	void update(T** data)
+	// Update, copies straight into the mapped constant buffer without allocating
+	void update(const T* data)
 	{
-		m_data.reset(*data);
 		D3D11_MAPPED_SUBRESOURCE mapSubresource;
 		HRESULT hr = m_deviceContext->Map(m_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapSubresource);
 		assert(SUCCEEDED(hr) && "Error, failed to map constant buffer!");
-		CopyMemory(mapSubresource.pData, m_data.get(), sizeof(T));
+		CopyMemory(mapSubresource.pData, data, sizeof(T));
 
 		m_deviceContext->Unmap(m_buffer.Get(), 0);
 	}
-	void update(T* data)
+
+	// Map, lets the caller fill the constant buffer in place, write only and must be followed by unmap()
+	T* map()
 	{
-		T* newData = new T(*data);
-		m_data.reset(newData);
 		D3D11_MAPPED_SUBRESOURCE mapSubresource;
 		HRESULT hr = m_deviceContext->Map(m_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapSubresource);
 		assert(SUCCEEDED(hr) && "Error, failed to map constant buffer!");
-		CopyMemory(mapSubresource.pData, m_data.get(), sizeof(T));
 
+		return static_cast<T*>(mapSubresource.pData);
+	}
+	void unmap()
+	{
 		m_deviceContext->Unmap(m_buffer.Get(), 0);
 	}
 };
 
+// Constant buffer that also keeps the last data it was given inline, for buffers whose contents are read back on the CPU.
+// Only the constant buffer interface is exposed, mapped writes would bypass the copy
+template<class T>
+class ShadowedBuffer : private Buffer<T>
+{
+private:
+	// CPU Shadow Copy
+	T m_shadowData;
+
+public:
+	ShadowedBuffer() : m_shadowData() {}
+
+	// Initialization
+	void initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const T* data = nullptr)
+	{
+		m_shadowData = data != nullptr ? *data : T();
+		Buffer<T>::initialize(device, deviceContext, &m_shadowData, BufferType::CONSTANT);
+	}
+
+	// Accessors
+	using Buffer<T>::Get;
+	using Buffer<T>::GetAddressOf;
+	const T& getShadowData() const { return m_shadowData; }
+
+	// Update, copies into the mapped constant buffer and the shadow copy without allocating
+	void update(const T* data)
+	{
+		Buffer<T>::update(data);
+		m_shadowData = *data;
+	}
+};
+
 #endif // !BUFFER_H
\ No newline at end of file
@@ -10,6 +10,10 @@ private:
 	XMMATRIX* m_projectionMatrix;
 	XMMATRIX* m_viewMatrix;
 
+	// Frustum, view space from the projection and world space updated with the view
+	BoundingFrustum m_localFrustum;
+	BoundingFrustum m_frustum;
+
 	// Other
 	bool m_isInitialized;
 	float m_fov;
@@ -27,8 +31,7 @@ private:
 
 	void updateConstantBuffer()
 	{
-		PS_CAMERA_BUFFER* cameraData = new PS_CAMERA_BUFFER(m_cameraData);
-		m_cameraCBuffer.update(&cameraData);
+		m_cameraCBuffer.update(&m_cameraData);
 	}
 
 public:
@@ -57,6 +60,7 @@ public:
 		m_farZ = farZ;
 		m_projectionMatrix = new XMMATRIX(XMMatrixPerspectiveFovLH(m_fov, aspectRatio, nearZ, m_farZ));
 		m_cameraData.projInverseMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, *m_projectionMatrix));
+		BoundingFrustum::CreateFromMatrix(m_localFrustum, *m_projectionMatrix);
 
 		m_viewMatrix = new XMMATRIX(XMMatrixIdentity());
 		m_cameraCBuffer.initialize(device, deviceContext, &m_cameraData, BufferType::CONSTANT);
@@ -74,6 +78,7 @@ public:
 	XMMATRIX getInvViewMatrix() const { return m_cameraData.viewInverseMatrix; }
 	XMFLOAT3 getCameraPositionF3() const { XMFLOAT3 temp; XMStoreFloat3(&temp, m_cameraData.cameraPosition); return temp; }
 	XMVECTOR getCameraPosition() const { return m_cameraData.cameraPosition; }
+	const BoundingFrustum& getFrustum() const { return m_frustum; }
 	bool isInitialized() const { return m_isInitialized; }
 	float getFov() const { return m_fov; }
 	float getFarZ() const { return m_farZ; }
@@ -91,8 +96,10 @@ public:
 
 		// Update View Matrix with new Rotation
 		*m_viewMatrix = XMMatrixLookAtLH(position, lookAt, up);
-		m_cameraData.viewInverseMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, *m_viewMatrix));
+		XMMATRIX viewInverseMatrix = XMMatrixInverse(nullptr, *m_viewMatrix);
+		m_cameraData.viewInverseMatrix = XMMatrixTranspose(viewInverseMatrix);
 		m_cameraData.cameraPosition = position;
+		m_localFrustum.Transform(m_frustum, viewInverseMatrix);
 		updateConstantBuffer();
 	}
 
@@ -15,6 +15,13 @@ struct VS_WVP_CBUFFER
     }
 };
 
+// Quantized vertices, the position is offset + unorm * scale
+struct VS_QUANTIZATION_CBUFFER
+{
+    XMFLOAT4 positionOffset;
+    XMFLOAT4 positionScale;
+};
+
 struct VS_VP_MATRIX_CBUFFER
 {
     XMMATRIX viewMatrix;
@@ -80,18 +87,21 @@ struct Light
     BOOL        enabled = true;
 };
 
-const UINT LIGHT_CAP = 40;
+const UINT LIGHT_CAP = 4096;
 
+// Lights live in a structured buffer, directional lights first and then the clustered point and spot lights
 struct PS_LIGHT_BUFFER
 {
-    Light lights[LIGHT_CAP];
     UINT nrOfLights;
+    UINT nrOfDirectionalLights;
     float enviormentDiffContribution = 1.f;// 0.03f;
     float enviormentSpecContribution = 1.f;//0.04f;
     BOOL volumetricSunScattering = TRUE;
     BOOL fog = TRUE;
     BOOL procederualSky = TRUE;
-    XMFLOAT2 pad;
+    float clusterSliceScale = 0.f; // Slice = log(viewZ) * scale + bias
+    float clusterSliceBias = 0.f;
+    XMFLOAT3 pad;
 };
 
 struct SKY_LIGHT_DATA_CBUFFER
@@ -0,0 +1,367 @@
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <vector>
+#include <cmath>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Pure CPU culling, no device or render state involved
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define FRUSTUMCULLER_SSE
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FRUSTUMCULLER_AVX // MSVC accepts AVX intrinsics without /arch:AVX, selected at runtime
+#else
+#include <immintrin.h>
+#if defined(__AVX__)
+#define FRUSTUMCULLER_AVX
+#endif
+#endif
+#endif
+
+struct CullingStats
+{
+	unsigned int tested = 0;
+	unsigned int visible = 0;
+};
+
+// Six planes with normals pointing out of the volume, a point p is outside a plane if dot(n, p) + d > 0
+struct CullingPlanes
+{
+	DirectX::XMFLOAT4 planes[6];
+};
+
+// Axis aligned boxes stored as structure of arrays, so 4 or 8 boxes can be loaded per instruction
+struct CullingBoundsSoA
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+
+	size_t size() const { return centerX.size(); }
+	void clear()
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		extentX.clear();
+		extentY.clear();
+		extentZ.clear();
+	}
+	void reserve(size_t count)
+	{
+		centerX.reserve(count);
+		centerY.reserve(count);
+		centerZ.reserve(count);
+		extentX.reserve(count);
+		extentY.reserve(count);
+		extentZ.reserve(count);
+	}
+	void push_back(const DirectX::BoundingBox& box)
+	{
+		centerX.push_back(box.Center.x);
+		centerY.push_back(box.Center.y);
+		centerZ.push_back(box.Center.z);
+		extentX.push_back(box.Extents.x);
+		extentY.push_back(box.Extents.y);
+		extentZ.push_back(box.Extents.z);
+	}
+};
+
+struct CullingBenchmarkResult
+{
+	unsigned int nrOfBoxes = 0;
+	unsigned int iterations = 0;
+
+	// Average milliseconds per cull
+	double perObjectTime = 0.0;
+	double scalarTime = 0.0;
+	double sseTime = 0.0;
+	double avxTime = 0.0;
+
+	unsigned int perObjectVisible = 0;
+	unsigned int batchVisible = 0;
+	unsigned int mismatches = 0; // Kernel lists that differ from the scalar one or miss a per object hit, camera frustum and light volume
+};
+
+class FrustumCuller
+{
+private:
+	// Helper Functions
+	static void loadPlanes(const CullingPlanes& planes, float n[6][4], float absN[6][3])
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			n[p][0] = planes.planes[p].x;
+			n[p][1] = planes.planes[p].y;
+			n[p][2] = planes.planes[p].z;
+			n[p][3] = planes.planes[p].w;
+			absN[p][0] = fabsf(planes.planes[p].x);
+			absN[p][1] = fabsf(planes.planes[p].y);
+			absN[p][2] = fabsf(planes.planes[p].z);
+		}
+	}
+
+	// Box is culled when it lies fully on the outside of any plane, conservative near the volume corners. The SSE and AVX
+	// kernels add in the same order so every path culls the same boxes, also on a plane
+	static size_t cullScalarRange(const CullingBoundsSoA& bounds, const float n[6][4], const float absN[6][3], size_t begin, size_t end, unsigned int* visible, size_t nrOfVisible)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			bool outside = false;
+			for (int p = 0; p < 6; p++)
+			{
+				float distance = n[p][0] * bounds.centerX[i] + n[p][1] * bounds.centerY[i] + n[p][2] * bounds.centerZ[i] + n[p][3];
+				float radius = absN[p][0] * bounds.extentX[i] + absN[p][1] * bounds.extentY[i] + absN[p][2] * bounds.extentZ[i];
+				outside |= distance > radius;
+			}
+			visible[nrOfVisible] = (unsigned int)i;
+			nrOfVisible += !outside;
+		}
+		return nrOfVisible;
+	}
+
+	static CullingStats finish(size_t count, size_t nrOfVisible, std::vector<unsigned int>& visibleIndices)
+	{
+		visibleIndices.resize(nrOfVisible);
+
+		CullingStats stats;
+		stats.tested = (unsigned int)count;
+		stats.visible = (unsigned int)nrOfVisible;
+		return stats;
+	}
+
+public:
+	// Planes
+	static CullingPlanes createPlanes(const DirectX::BoundingFrustum& frustum)
+	{
+		DirectX::XMVECTOR planes[6];
+		frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+		CullingPlanes cullingPlanes;
+		for (int p = 0; p < 6; p++)
+			DirectX::XMStoreFloat4(&cullingPlanes.planes[p], planes[p]);
+		return cullingPlanes;
+	}
+	static CullingPlanes createPlanes(const DirectX::BoundingOrientedBox& box)
+	{
+		DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&box.Orientation));
+		DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&box.Center);
+		const float extents[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+
+		CullingPlanes cullingPlanes;
+		for (int a = 0; a < 3; a++)
+		{
+			DirectX::XMFLOAT3 axis;
+			DirectX::XMStoreFloat3(&axis, rotation.r[a]);
+			float centerDistance = DirectX::XMVectorGetX(DirectX::XMVector3Dot(rotation.r[a], center));
+
+			cullingPlanes.planes[a * 2] = DirectX::XMFLOAT4(axis.x, axis.y, axis.z, -centerDistance - extents[a]);
+			cullingPlanes.planes[a * 2 + 1] = DirectX::XMFLOAT4(-axis.x, -axis.y, -axis.z, centerDistance - extents[a]);
+		}
+		return cullingPlanes;
+	}
+
+	// Per Object, writes the indices of the boxes intersecting the volume to visibleIndices in ascending order.
+	// Volume can be any DirectXCollision type with Intersects(BoundingBox), e.g. BoundingFrustum or BoundingOrientedBox
+	template<class Volume>
+	static CullingStats cullPerObject(const DirectX::BoundingBox* boxes, size_t count, const Volume& volume, std::vector<unsigned int>& visibleIndices)
+	{
+		CullingStats stats;
+		stats.tested = (unsigned int)count;
+
+		visibleIndices.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (volume.Intersects(boxes[i]))
+				visibleIndices.push_back((unsigned int)i);
+		}
+		stats.visible = (unsigned int)visibleIndices.size();
+
+		return stats;
+	}
+
+	// Batch, same output as above but over SoA bounds and a plane set
+	static CullingStats cullScalar(const CullingBoundsSoA& bounds, const CullingPlanes& planes, std::vector<unsigned int>& visibleIndices)
+	{
+		float n[6][4];
+		float absN[6][3];
+		loadPlanes(planes, n, absN);
+
+		size_t count = bounds.size();
+		visibleIndices.resize(count);
+		size_t nrOfVisible = cullScalarRange(bounds, n, absN, 0, count, visibleIndices.data(), 0);
+
+		return finish(count, nrOfVisible, visibleIndices);
+	}
+
+#ifdef FRUSTUMCULLER_SSE
+	static CullingStats cullSSE(const CullingBoundsSoA& bounds, const CullingPlanes& planes, std::vector<unsigned int>& visibleIndices)
+	{
+		float n[6][4];
+		float absN[6][3];
+		loadPlanes(planes, n, absN);
+
+		__m128 planeX[6], planeY[6], planeZ[6], planeD[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm_set1_ps(n[p][0]);
+			planeY[p] = _mm_set1_ps(n[p][1]);
+			planeZ[p] = _mm_set1_ps(n[p][2]);
+			planeD[p] = _mm_set1_ps(n[p][3]);
+			absX[p] = _mm_set1_ps(absN[p][0]);
+			absY[p] = _mm_set1_ps(absN[p][1]);
+			absZ[p] = _mm_set1_ps(absN[p][2]);
+		}
+
+		size_t count = bounds.size();
+		size_t batchEnd = count - count % 4;
+		visibleIndices.resize(count);
+		unsigned int* visible = visibleIndices.data();
+		size_t nrOfVisible = 0;
+
+		for (size_t i = 0; i < batchEnd; i += 4)
+		{
+			__m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+			__m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+			__m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+			__m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+			__m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+			__m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)), _mm_mul_ps(planeZ[p], centerZ)), planeD[p]);
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], extentX), _mm_mul_ps(absY[p], extentY)), _mm_mul_ps(absZ[p], extentZ));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, radius));
+			}
+
+			// Compact the visible lanes
+			int visibleMask = ~_mm_movemask_ps(outside) & 0xF;
+			for (unsigned int lane = 0; visibleMask; lane++, visibleMask >>= 1)
+			{
+				visible[nrOfVisible] = (unsigned int)i + lane;
+				nrOfVisible += visibleMask & 1;
+			}
+		}
+		nrOfVisible = cullScalarRange(bounds, n, absN, batchEnd, count, visible, nrOfVisible);
+
+		return finish(count, nrOfVisible, visibleIndices);
+	}
+#endif
+
+#ifdef FRUSTUMCULLER_AVX
+	static CullingStats cullAVX(const CullingBoundsSoA& bounds, const CullingPlanes& planes, std::vector<unsigned int>& visibleIndices)
+	{
+		float n[6][4];
+		float absN[6][3];
+		loadPlanes(planes, n, absN);
+
+		__m256 planeX[6], planeY[6], planeZ[6], planeD[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm256_set1_ps(n[p][0]);
+			planeY[p] = _mm256_set1_ps(n[p][1]);
+			planeZ[p] = _mm256_set1_ps(n[p][2]);
+			planeD[p] = _mm256_set1_ps(n[p][3]);
+			absX[p] = _mm256_set1_ps(absN[p][0]);
+			absY[p] = _mm256_set1_ps(absN[p][1]);
+			absZ[p] = _mm256_set1_ps(absN[p][2]);
+		}
+
+		size_t count = bounds.size();
+		size_t batchEnd = count - count % 8;
+		visibleIndices.resize(count);
+		unsigned int* visible = visibleIndices.data();
+		size_t nrOfVisible = 0;
+
+		for (size_t i = 0; i < batchEnd; i += 8)
+		{
+			__m256 centerX = _mm256_loadu_ps(&bounds.centerX[i]);
+			__m256 centerY = _mm256_loadu_ps(&bounds.centerY[i]);
+			__m256 centerZ = _mm256_loadu_ps(&bounds.centerZ[i]);
+			__m256 extentX = _mm256_loadu_ps(&bounds.extentX[i]);
+			__m256 extentY = _mm256_loadu_ps(&bounds.extentY[i]);
+			__m256 extentZ = _mm256_loadu_ps(&bounds.extentZ[i]);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX), _mm256_mul_ps(planeY[p], centerY)), _mm256_mul_ps(planeZ[p], centerZ)), planeD[p]);
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], extentX), _mm256_mul_ps(absY[p], extentY)), _mm256_mul_ps(absZ[p], extentZ));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, radius, _CMP_GT_OQ));
+			}
+
+			// Compact the visible lanes
+			int visibleMask = ~_mm256_movemask_ps(outside) & 0xFF;
+			for (unsigned int lane = 0; visibleMask; lane++, visibleMask >>= 1)
+			{
+				visible[nrOfVisible] = (unsigned int)i + lane;
+				nrOfVisible += visibleMask & 1;
+			}
+		}
+		nrOfVisible = cullScalarRange(bounds, n, absN, batchEnd, count, visible, nrOfVisible);
+
+		return finish(count, nrOfVisible, visibleIndices);
+	}
+#endif
+
+	static bool isAVXSupported()
+	{
+#if defined(__AVX__)
+		return true;
+#elif defined(FRUSTUMCULLER_AVX)
+		static const bool avxSupported = []()
+		{
+			int cpuInfo[4];
+			__cpuid(cpuInfo, 1);
+			bool osUsesXSave = (cpuInfo[2] & (1 << 27)) != 0;
+			bool cpuHasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+			return osUsesXSave && cpuHasAVX && (_xgetbv(0) & 0x6) == 0x6; // OS saves the YMM registers
+		}();
+		return avxSupported;
+#else
+		return false;
+#endif
+	}
+
+	// Picks the widest kernel the CPU supports
+	static CullingStats cull(const CullingBoundsSoA& bounds, const CullingPlanes& planes, std::vector<unsigned int>& visibleIndices)
+	{
+#if defined(FRUSTUMCULLER_AVX)
+		if (isAVXSupported())
+			return cullAVX(bounds, planes, visibleIndices);
+#endif
+#if defined(FRUSTUMCULLER_SSE)
+		return cullSSE(bounds, planes, visibleIndices);
+#else
+		return cullScalar(bounds, planes, visibleIndices);
+#endif
+	}
+
+	// Everything visible, used when culling is turned off
+	static CullingStats passThrough(size_t count, std::vector<unsigned int>& visibleIndices)
+	{
+		CullingStats stats;
+		stats.tested = (unsigned int)count;
+		stats.visible = (unsigned int)count;
+
+		visibleIndices.resize(count);
+		for (size_t i = 0; i < count; i++)
+			visibleIndices[i] = (unsigned int)i;
+
+		return stats;
+	}
+
+	// Test and Benchmark, in FrustumCullerTests.cpp
+	static unsigned int test();
+	static CullingBenchmarkResult benchmark(unsigned int nrOfBoxes = 100000, unsigned int iterations = 100);
+};
+
+#endif // !FRUSTUMCULLER_H
@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// Random boxes around the origin, some flat or a point so they can sit exactly on a plane
+static void createTestBoxes(unsigned int nrOfBoxes, float range, unsigned int seed, std::vector<BoundingBox>& boxes, CullingBoundsSoA& bounds)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> positionDistribution(-range, range);
+	std::uniform_real_distribution<float> extentDistribution(0.5f, 5.f);
+
+	boxes.resize(nrOfBoxes);
+	bounds.clear();
+	bounds.reserve(nrOfBoxes);
+	for (unsigned int i = 0; i < nrOfBoxes; i++)
+	{
+		boxes[i].Center = XMFLOAT3(positionDistribution(generator), positionDistribution(generator), positionDistribution(generator));
+		boxes[i].Extents = XMFLOAT3(extentDistribution(generator), extentDistribution(generator), extentDistribution(generator));
+		if (i % 7 == 3)
+			boxes[i].Extents.y = 0.f;
+		if (i % 11 == 5)
+			boxes[i].Extents = XMFLOAT3(0.f, 0.f, 0.f);
+		bounds.push_back(boxes[i]);
+	}
+}
+
+static BoundingFrustum createTestFrustum(XMVECTOR position, XMVECTOR target, float farZ)
+{
+	BoundingFrustum localFrustum, frustum;
+	BoundingFrustum::CreateFromMatrix(localFrustum, XMMatrixPerspectiveFovLH(XMConvertToRadians(80.f), 16.f / 9.f, 0.1f, farZ));
+	XMMATRIX viewMatrix = XMMatrixLookAtLH(position, target, XMVectorSet(0.f, 1.f, 0.f, 0.f));
+	localFrustum.Transform(frustum, XMMatrixInverse(nullptr, viewMatrix));
+	return frustum;
+}
+
+// Number of wrong lists, every batch kernel has to match the scalar one exactly and the scalar one may only keep extra boxes
+// near the volume corners, never lose one the per object test sees
+template<class Volume>
+static unsigned int compareKernels(const std::vector<BoundingBox>& boxes, const CullingBoundsSoA& bounds, const Volume& volume, unsigned int* nrOfVisible = nullptr)
+{
+	unsigned int errors = 0;
+	CullingPlanes planes = FrustumCuller::createPlanes(volume);
+
+	std::vector<unsigned int> perObject, scalar, kernel;
+	FrustumCuller::cullPerObject(boxes.data(), boxes.size(), volume, perObject);
+	CullingStats scalarStats = FrustumCuller::cullScalar(bounds, planes, scalar);
+	errors += scalarStats.tested != boxes.size() || scalarStats.visible != scalar.size();
+	errors += !std::is_sorted(scalar.begin(), scalar.end()) || std::adjacent_find(scalar.begin(), scalar.end()) != scalar.end();
+	errors += !scalar.empty() && scalar.back() >= boxes.size();
+	errors += !std::includes(scalar.begin(), scalar.end(), perObject.begin(), perObject.end());
+
+#ifdef FRUSTUMCULLER_SSE
+	CullingStats sseStats = FrustumCuller::cullSSE(bounds, planes, kernel);
+	errors += kernel != scalar || sseStats.visible != scalarStats.visible || sseStats.tested != scalarStats.tested;
+#endif
+#ifdef FRUSTUMCULLER_AVX
+	if (FrustumCuller::isAVXSupported())
+	{
+		CullingStats avxStats = FrustumCuller::cullAVX(bounds, planes, kernel);
+		errors += kernel != scalar || avxStats.visible != scalarStats.visible || avxStats.tested != scalarStats.tested;
+	}
+#endif
+	FrustumCuller::cull(bounds, planes, kernel);
+	errors += kernel != scalar;
+
+	if (nrOfVisible)
+		*nrOfVisible = (unsigned int)scalar.size();
+	return errors;
+}
+
+unsigned int FrustumCuller::test()
+{
+	unsigned int errors = 0;
+
+	// Camera frustum and a rotated light volume, over counts that leave every possible tail after the 4 and 8 wide batches
+	BoundingFrustum frustum = createTestFrustum(XMVectorSet(3.f, 2.f, -5.f, 1.f), XMVectorSet(0.f, 0.f, 0.f, 1.f), 100.f);
+	BoundingOrientedBox lightVolume;
+	lightVolume.Center = XMFLOAT3(1.f, 2.f, 3.f);
+	lightVolume.Extents = XMFLOAT3(30.f, 10.f, 45.f);
+	XMStoreFloat4(&lightVolume.Orientation, XMQuaternionRotationRollPitchYaw(0.3f, 0.7f, 0.1f));
+
+	std::vector<BoundingBox> boxes;
+	CullingBoundsSoA bounds;
+	for (unsigned int nrOfBoxes : { 0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 13u, 15u, 16u, 17u, 31u, 257u, 1001u, 4099u })
+	{
+		createTestBoxes(nrOfBoxes, 60.f, nrOfBoxes + 1, boxes, bounds);
+		unsigned int frustumVisible = 0, lightVisible = 0;
+		errors += compareKernels(boxes, bounds, frustum, &frustumVisible);
+		errors += compareKernels(boxes, bounds, lightVolume, &lightVisible);
+
+		// The large scenes have boxes on both sides of both volumes
+		if (nrOfBoxes > 1000)
+			errors += frustumVisible == 0 || frustumVisible == nrOfBoxes || lightVisible == 0 || lightVisible == nrOfBoxes;
+	}
+
+	// Boxes on the planes of an axis aligned volume, touching counts as visible on every path
+	{
+		BoundingOrientedBox unitVolume(XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3(1.f, 1.f, 1.f), XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+		boxes.clear();
+		bounds.clear();
+		for (int i = 0; i < 19; i++)
+		{
+			float offset = 1.f + (i % 3) * 0.5f;
+			BoundingBox box(XMFLOAT3(i % 2 ? offset : -offset, 0.f, 0.f), XMFLOAT3((i % 3) * 0.5f, 0.5f, 0.5f));
+			boxes.push_back(box);
+			bounds.push_back(box);
+		}
+		unsigned int nrOfVisible = 0;
+		errors += compareKernels(boxes, bounds, unitVolume, &nrOfVisible);
+		errors += nrOfVisible != boxes.size();
+	}
+
+	// Pass through keeps everything in order
+	std::vector<unsigned int> visibleIndices;
+	CullingStats stats = passThrough(9, visibleIndices);
+	errors += stats.visible != 9 || visibleIndices.size() != 9 || visibleIndices[8] != 8;
+
+	return errors;
+}
+
+// Benchmark, culls random boxes against a camera frustum with every path and checks the lists against each other, then
+// checks them on a light volume as well
+CullingBenchmarkResult FrustumCuller::benchmark(unsigned int nrOfBoxes, unsigned int iterations)
+{
+	// Synthetic Scene
+	std::vector<BoundingBox> boxes;
+	CullingBoundsSoA bounds;
+	createTestBoxes(nrOfBoxes, 500.f, 1337, boxes, bounds);
+	BoundingFrustum frustum = createTestFrustum(XMVectorSet(0.f, 20.f, -400.f, 1.f), XMVectorSet(0.f, 0.f, 0.f, 1.f), 1000.f);
+	CullingPlanes planes = createPlanes(frustum);
+
+	// Timing
+	std::vector<unsigned int> visibleIndices;
+	visibleIndices.reserve(nrOfBoxes);
+	auto timeCull = [&](auto cullFunction)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			cullFunction();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+		return elapsed.count() / (double)iterations;
+	};
+
+	CullingBenchmarkResult result;
+	result.nrOfBoxes = nrOfBoxes;
+	result.iterations = iterations;
+
+	result.perObjectTime = timeCull([&]() { result.perObjectVisible = cullPerObject(boxes.data(), boxes.size(), frustum, visibleIndices).visible; });
+	std::vector<unsigned int> perObject = visibleIndices;
+	result.scalarTime = timeCull([&]() { result.batchVisible = cullScalar(bounds, planes, visibleIndices).visible; });
+	std::vector<unsigned int> scalar = visibleIndices;
+	result.mismatches += !std::includes(scalar.begin(), scalar.end(), perObject.begin(), perObject.end());
+#ifdef FRUSTUMCULLER_SSE
+	result.sseTime = timeCull([&]() { cullSSE(bounds, planes, visibleIndices); });
+	result.mismatches += visibleIndices != scalar;
+#endif
+#ifdef FRUSTUMCULLER_AVX
+	if (isAVXSupported())
+	{
+		result.avxTime = timeCull([&]() { cullAVX(bounds, planes, visibleIndices); });
+		result.mismatches += visibleIndices != scalar;
+	}
+#endif
+
+	// The shadow pass culls the same bounds against its light volume, every kernel has to agree there as well
+	BoundingOrientedBox lightVolume;
+	lightVolume.Center = XMFLOAT3(0.f, 0.f, 0.f);
+	lightVolume.Extents = XMFLOAT3(300.f, 100.f, 450.f);
+	XMStoreFloat4(&lightVolume.Orientation, XMQuaternionRotationRollPitchYaw(0.9f, 0.4f, 0.f));
+	result.mismatches += compareKernels(boxes, bounds, lightVolume);
+
+	return result;
+}
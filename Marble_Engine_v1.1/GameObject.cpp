@@ -15,6 +15,8 @@ GameObject::GameObject()
 
 GameObject::~GameObject()
 {
+	if (m_physicsComponent)
+		PhysicsWorld::getInstance().removeComponent(m_physicsComponent.get());
 	if (m_renderKey.isValid())
 		m_renderHandler->deleteRenderObject(m_renderKey);
 }
@@ -28,6 +30,7 @@ void GameObject::initialize(std::string modelName, UINT id, ShaderStates shaderS
 
 	m_physicsComponent = std::make_unique<PhysicsComponent>();
 	m_physicsComponent->initialize(m_movementComponent.get(), 10.f, XMFLOAT3(.1f, .1f, .1f), XMFLOAT3(.99f, .99f, .99f));
+	PhysicsWorld::getInstance().addComponent(m_physicsComponent.get());
 
 	m_shaderType = shaderState;
 	m_renderKey = m_renderHandler->newRenderObject(modelName, shaderState, meshData);
@@ -146,10 +149,12 @@ void GameObject::rotate(XMFLOAT3 rotation)
 void GameObject::setPosition(XMVECTOR newPosition)
 {
 	m_movementComponent->position = newPosition;
+	m_physicsComponent->resetInterpolation();
 }
 void GameObject::setPosition(XMFLOAT3 newPosition)
 {
 	m_movementComponent->position = XMLoadFloat3(&newPosition);
+	m_physicsComponent->resetInterpolation();
 }
 
 void GameObject::update(double dt)
@@ -167,7 +172,9 @@ void GameObject::update(double dt)
 		{
 			ImGui::DragFloat3("Scale", &m_movementComponent->scale.m128_f32[0], 0.1f);
 			ImGui::DragFloat3("Rotation", &m_movementComponent->rotation.m128_f32[0], 0.1f);
-			ImGui::DragFloat3("Position", &m_movementComponent->position.m128_f32[0], 0.1f);
+			if (ImGui::DragFloat3("Position", &m_movementComponent->position.m128_f32[0], 0.1f))
+				m_physicsComponent->resetInterpolation();
+			ImGui::Checkbox("Collision", m_physicsComponent->getCollisionEnabledPtr());
 		}
 
 		//if (ImGui::CollapsingHeader("Other Component"))
@@ -205,7 +212,9 @@ void GameObject::update(double dt)
 	ImGui::Separator();
 	ImGui::PopID();
 
-	// Movement
-	m_physicsComponent->updatePosition(dt);
-	m_renderHandler->updateRenderObjectWorld(m_renderKey, m_movementComponent->getWorldMatrix());
+	// Movement, stepped by the physics world, rendered between the last two steps
+	XMFLOAT3 localRotation, renderPosition;
+	XMStoreFloat3(&localRotation, m_movementComponent->localRotation);
+	XMStoreFloat3(&renderPosition, m_physicsComponent->getInterpolatedPosition(PhysicsWorld::getInstance().getInterpolationAlpha()));
+	m_renderHandler->updateRenderObjectTransform(m_renderKey, getScaleF3(), localRotation, getRotationF3(), renderPosition);
 }
\ No newline at end of file
@@ -3,7 +3,7 @@
 
 #include "RenderHandler.h"
 #include "MovementComponent.h"
-#include "PhysicsComponent.h"
+#include "PhysicsWorld.h"
 
 class GameObject
 {
@@ -332,10 +332,35 @@ void GameState::initialize(Settings settings)
 	m_camera.initialize(settings.mouseSensitivity);
 }
 
+void GameState::pickGameObject(UINT pointX, UINT pointY)
+{
+	RenderObjectKey key;
+	if (m_renderHandler->pickRenderObject(pointX, pointY, key))
+	{
+		for (size_t i = 0; i < m_gameObjects.size(); i++)
+		{
+			if (m_gameObjects[i]->getKey() == key)
+			{
+				m_selectedIndex = (int)i;
+				m_renderHandler->updateSelectedObject(key, m_gameObjects[i]->getPositionF3());
+				return;
+			}
+		}
+	}
+
+	// Clicked empty space
+	if (m_selectedIndex > -1)
+	{
+		m_selectedIndex = -1;
+		m_renderHandler->deselectObject();
+	}
+}
+
 void GameState::controls(double dt)
 {
 	if (!InputHandler::getInstance().keyBufferIsEmpty())
 	{
+		bool cameraWasRotating = m_mouseCameraRotation;
 		if (InputHandler::getInstance().keyIsPressed(KeyCodes::F) || InputHandler::getInstance().isMouseRightDown())
 			m_mouseCameraRotation = true;
 		if (InputHandler::getInstance().keyIsPressed(KeyCodes::G) || InputHandler::getInstance().isMouseLeftDown())
@@ -368,6 +393,10 @@ void GameState::controls(double dt)
 			}
 			else if (mouseEvent.type == MouseEventType::LPress)
 			{
+				// Object Picking, the click that stops camera rotation and clicks on the UI are ignored
+				if (!cameraWasRotating && !ImGui::GetIO().WantCaptureMouse)
+					pickGameObject((UINT)mouseEvent.point.x, (UINT)mouseEvent.point.y);
+
 				/*if (m_selectedIndex > -1)
 				{
 					if (!m_dragging)
@@ -523,6 +552,9 @@ void GameState::update(double dt)
 	ImGui::NewFrame();
 	ImGuiStyle& imguiStyle = ImGui::GetStyle();
 
+	// Physics, fixed steps covering this frame
+	PhysicsWorld::getInstance().update(dt);
+
 	// Settings Window
 	ImGuiWindowFlags windowFlags = 0;
 	if (!m_windowResizeFlag)
@@ -564,6 +596,9 @@ void GameState::update(double dt)
 			m_renderHandler->UIVolumetricSunSettings();
 			m_renderHandler->UIbloomSettings();
 			m_renderHandler->UILensFlareSettings();
+			m_renderHandler->UIStatistics();
+			if (ImGui::CollapsingHeader("Physics"))
+				PhysicsWorld::getInstance().updateUI();
 			ImGui::PushItemWidth(-1);
 			ImGui::PopItemWidth();
 			ImGui::Checkbox("Window Resize", &m_windowResizeFlag);
@@ -686,11 +721,13 @@ void GameState::update(double dt)
 		ImGui::SameLine(ImGui::GetWindowContentRegionMax().x - 24);
 		if (ImGui::ImageButton(ResourceHandler::getInstance().getTexture(L"baseline_delete_white_18dp.png"), ImVec2(20, 20)))
 		{
-			if (m_selectedIndex = (int)i)
+			if (m_selectedIndex == (int)i)
 			{
 				m_selectedIndex = -1;
 				m_renderHandler->deselectObject();
 			}
+			else if (m_selectedIndex > (int)i)
+				m_selectedIndex--;
 			//m_mapHandler.removeGameObjectFromFile(i, m_gameObjects.size());
 			delete m_gameObjects[i];
 			m_gameObjects.erase(m_gameObjects.begin() + i);
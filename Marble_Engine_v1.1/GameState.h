@@ -47,6 +47,7 @@ private:
 	bool m_dragging;
 	char m_draggingDimension;
 	float m_origin;
+	void pickGameObject(UINT pointX, UINT pointY);
 
 	// Testing
 	bool m_shouldRotateLastObject = true;
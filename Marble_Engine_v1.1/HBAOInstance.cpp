@@ -310,8 +310,7 @@ void HBAOInstance::updateViewMatrix(XMMATRIX viewMatrix)
 {
     m_HBAOCameraData.viewMatrix = XMMatrixTranspose(viewMatrix);
 
-    PS_HBAO_CAMERA_BUFFER* HBAOCameraData = new PS_HBAO_CAMERA_BUFFER(m_HBAOCameraData);
-    m_HBAOCameraBuffer.update(&HBAOCameraData);
+    m_HBAOCameraBuffer.update(&m_HBAOCameraData);
 }
 
 void HBAOInstance::updateShaders()
@@ -0,0 +1,563 @@
+#include "pch.h"
+#include "HeadlessModes.h"
+#include "Application.h"
+#include "AllocationCounter.h"
+#include "JobSystem.h"
+#include "ResourceHandler.h"
+#include "TextureCooker.h"
+#include "RenderQueue.h"
+#include "OcclusionCuller.h"
+#include "MapHandler.h"
+#include <cstdarg>
+#include <deque>
+#include <set>
+
+HeadlessLog::HeadlessLog()
+{
+	m_nrOfErrors = 0;
+
+	// A windows subsystem exe has no console of its own, attach to the one it was started from unless stdout is redirected
+	if (GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) == FILE_TYPE_UNKNOWN && AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		FILE* console = nullptr;
+		freopen_s(&console, "CONOUT$", "w", stdout);
+	}
+
+	if (fopen_s(&m_file, "headless.log", "w") != 0)
+		m_file = nullptr;
+}
+
+HeadlessLog::~HeadlessLog()
+{
+	if (m_file)
+		fclose(m_file);
+	fflush(stdout);
+}
+
+void HeadlessLog::print(const char* format, ...)
+{
+	char text[1024];
+	va_list arguments;
+	va_start(arguments, format);
+	vsnprintf(text, sizeof(text), format, arguments);
+	va_end(arguments);
+
+	fputs(text, stdout);
+	OutputDebugStringA(text);
+	if (m_file)
+		fputs(text, m_file);
+}
+
+// Offline Cooking, cooks every model in the Models folder and then every texture their materials and the maps use. Runs from
+// the engine exe because loading falls back to the same import, weld, quantize and LOD path when a cooked file is missing or
+// stale, so the cookers and their Assimp and DirectXTex link are in the exe either way
+static void runCook(HeadlessLog& log)
+{
+	UINT nrOfCookedModels = MeshCooker::cookModels();
+	log.print("Cooked %u models\n", nrOfCookedModels);
+	UINT nrOfCookedTextures = TextureCooker::cookTextures();
+	log.print("Cooked %u textures\n", nrOfCookedTextures);
+}
+
+// Map Benchmark, converts every text map in the Maps folder to binary and back, times loading both formats and checks
+// that neither conversion changes the map
+static void runMapBench(HeadlessLog& log)
+{
+	std::vector<std::string> mapFiles;
+	struct dirent* entry;
+	DIR* dir = opendir("Maps");
+	if (dir != NULL)
+	{
+		while ((entry = readdir(dir)) != NULL)
+		{
+			std::string name = entry->d_name;
+			if (entry->d_type != DT_DIR && name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0)
+				mapFiles.push_back(name);
+		}
+		closedir(dir);
+	}
+
+	for (const std::string& mapFile : mapFiles)
+	{
+		MapBenchmarkResult result = MapHandler::benchmark(mapFile);
+		if (!result.converted)
+		{
+			log.print("%s, could not be converted\n", mapFile.c_str());
+			log.addErrors(1);
+			continue;
+		}
+
+		log.print("%s, %u objects, %u lights, text %.1f KB %.3f ms, binary %.1f KB %.3f ms (%.1fx), %u mismatches\n",
+			mapFile.c_str(), result.nrOfGameObjects, result.nrOfLights, result.textBytes / 1024.0, result.textLoadTime,
+			result.binaryBytes / 1024.0, result.binaryLoadTime, result.binaryLoadTime > 0.0 ? result.textLoadTime / result.binaryLoadTime : 0.0, result.mismatches);
+		log.addErrors(result.mismatches);
+	}
+}
+
+// Culling Benchmark, compares the per object DirectXCollision path with the batch culler
+static void runCullBench(HeadlessLog& log)
+{
+	unsigned int testErrors = FrustumCuller::test();
+	CullingBenchmarkResult result = FrustumCuller::benchmark();
+	log.print("Culled %u boxes, per object %.3f ms (%u visible), scalar %.3f ms, SSE %.3f ms, AVX %.3f ms (%u visible), %u mismatches, test errors %u\n",
+		result.nrOfBoxes, result.perObjectTime, result.perObjectVisible, result.scalarTime, result.sseTime, result.avxTime, result.batchVisible, result.mismatches, testErrors);
+	log.addErrors(result.mismatches + testErrors);
+}
+
+// Picking Benchmark, compares closest hit rays through the BVH with testing every triangle
+static void runPickBench(HeadlessLog& log)
+{
+	BVHBenchmarkResult result = BVH::benchmark();
+	log.print("Picked %u triangles (%u nodes, built in %.1f ms), brute force %.0f rays/s, BVH %.0f rays/s, %u mismatches\n",
+		result.nrOfTriangles, result.nrOfNodes, result.buildTime, result.bruteForceRaysPerSecond, result.bvhRaysPerSecond, result.mismatches);
+	log.addErrors(result.mismatches);
+}
+
+// Physics Benchmark, steps bouncing bodies through the sort and sweep broadphase and checks the pairs against testing every pair
+static void runPhysBench(HeadlessLog& log)
+{
+	unsigned int testErrors = Broadphase::test();
+	BroadphaseBenchmarkResult result = Broadphase::benchmark();
+	log.print("Stepped %u bodies for %u steps, %.3f ms per step (broadphase %.3f ms), %.0f candidate pairs, %.0f contacts per step, %u mismatches, test errors %u\n",
+		result.nrOfBodies, result.nrOfSteps, result.stepTime, result.broadphaseTime, result.averagePairs, result.averageContacts, result.mismatches, testErrors);
+	log.addErrors(result.mismatches + testErrors);
+}
+
+// Physics Replay, records bodies driven by input at random frame times and replays them headless
+static void runPhysReplay(HeadlessLog& log)
+{
+	PhysicsReplayResult result = PhysicsWorld::replayTest();
+	log.print("Replayed %u bodies over %u frames (%llu fixed steps) at %.0f steps/s, %u mismatches\n",
+		result.nrOfBodies, result.nrOfFrames, result.nrOfSteps, result.stepsPerSecond, result.mismatches);
+	log.addErrors(result.mismatches);
+}
+
+// Transform Benchmark, compares rebuilding every matrix per object with the dirty flagged transform store
+static void runTransformBench(HeadlessLog& log)
+{
+	unsigned int testErrors = TransformStore::test();
+	TransformBenchmarkResult result = TransformStore::benchmark();
+	log.print("Updated %u transforms (%u moving), per object %.3f ms, store %.3f ms static camera, %.3f ms moving camera, %u mismatches, test errors %u\n",
+		result.nrOfTransforms, result.nrOfMoving, result.perObjectTime, result.staticCameraTime, result.movingCameraTime, result.mismatches, testErrors);
+	log.addErrors(result.mismatches + testErrors);
+}
+
+// Allocation Test, renders a scene on a hidden window and fails on any heap allocation in a steady state frame
+static void runAllocTest(HeadlessLog& log)
+{
+	AllocationTestResult result = AllocationCounter::test();
+	if (!result.counted)
+	{
+		log.print("Error, allocations are only counted in debug builds or with COUNT_ALLOCATIONS defined\n");
+		log.addErrors(1);
+		return;
+	}
+	log.print("Rendered %u objects for %u frames, %llu heap allocations (%llu max per frame), errors %u\n",
+		result.nrOfObjects, result.nrOfFrames, result.totalAllocations, result.maxFrameAllocations, result.errors);
+	log.addErrors(result.errors);
+}
+
+// Shader Cache Benchmark, compiles every shader into an empty cache and loads them again warm, after the cache and
+// permutation tests
+static void runShaderBench(HeadlessLog& log)
+{
+	unsigned int testErrors = ShaderCache::test(L"Shaders\\Cache\\Test");
+	unsigned int permutationErrors = ShaderPermutations<Shaders>::test(L"Shaders\\Cache\\PermutationTest");
+	ShaderCacheBenchmarkResult result = Shaders::benchmark();
+	log.print("Loaded %u shaders, cold %.2f ms (%u compiles), warm %.2f ms (%u compiles), test errors %u, permutation test errors %u\n",
+		result.nrOfShaders, result.coldTime, result.coldCompiles, result.warmTime, result.warmCompiles, testErrors, permutationErrors);
+	log.addErrors(testErrors + permutationErrors);
+}
+
+// Shader Program Benchmark, creates the render object program per object and through the registry
+static void runProgramBench(HeadlessLog& log)
+{
+	ShaderProgramBenchmarkResult result = ShaderProgramRegistry::benchmark();
+	log.print("Created %u programs, per object %.2f ms (%u driver objects), registry %.2f ms (%u driver objects), %u errors\n",
+		result.nrOfObjects, result.perObjectTime, result.perObjectDriverObjects, result.registryTime, result.registryDriverObjects, result.errors);
+	log.addErrors(result.errors);
+}
+
+// Light Cluster Benchmark, bins point and spot lights into the camera clusters and checks them against the brute force reference
+static void runClusterBench(HeadlessLog& log)
+{
+	unsigned int testErrors = LightClusters::test();
+	LightClusterBenchmarkResult result = LightClusters::benchmark();
+	log.print("Binned %u lights over %u frames, %.3f ms (%.0f lights/ms), brute force %.3f ms, %u indices, %u mismatches, test errors %u\n",
+		result.nrOfLights, result.nrOfFrames, result.binTime, result.lightsPerMillisecond, result.bruteForceTime, result.nrOfIndices, result.mismatches, testErrors);
+	log.addErrors(result.mismatches + testErrors);
+}
+
+// Job System Benchmark, stress tests the scheduler, measures the overhead per job and the scaling from 1 to every hardware thread
+static void runJobBench(HeadlessLog& log)
+{
+	JobSystemBenchmarkResult result = JobSystem::benchmark();
+	log.print("Ran %u jobs, %.1f ns per job on 1 thread, %.1f ns per job on %u threads, %u stress errors\n",
+		result.nrOfJobs, result.singleThreadOverhead, result.overhead, result.nrOfThreads, result.stressErrors);
+	for (size_t i = 0; i < result.scalingTimes.size(); i++)
+		log.print("  %zu threads: %.2f ms (%.2fx)\n", i + 1, result.scalingTimes[i], result.scalingTimes[0] / result.scalingTimes[i]);
+	log.addErrors(result.stressErrors);
+}
+
+// Texture Streaming Benchmark, tests the decode queue, decodes the Textures folder on one thread and through the streamer
+static void runStreamBench(HeadlessLog& log)
+{
+	unsigned int testErrors = TextureStreamer<size_t>::test();
+	TextureStreamingBenchmarkResult result = ResourceHandler::benchmarkStreaming();
+	log.print("Decoded %u textures (%.1f MB, %u failed), serial %.2f ms (%.1f MB/s), streamed on %u threads %.2f ms (%.1f MB/s), %u test errors\n",
+		result.nrOfTextures, result.megabytes, result.nrOfFailed, result.serialTime, result.megabytes / (result.serialTime / 1000.0),
+		result.nrOfThreads, result.streamedTime, result.megabytes / (result.streamedTime / 1000.0), testErrors);
+	log.addErrors(testErrors);
+}
+
+// Texture Cache Test, runs the reference counting and eviction policy checks
+static void runCacheTest(HeadlessLog& log)
+{
+	unsigned int testErrors = TextureCache<int>::test();
+	log.print("Texture cache test, %u errors\n", testErrors);
+	log.addErrors(testErrors);
+}
+
+// Texture Cooking Benchmark, encodes material textures to every block compression format on one thread and on every job
+// system thread and checks their PSNR
+static void runTexBench(HeadlessLog& log)
+{
+	TextureCookBenchmarkResult result = TextureCooker::benchmark();
+	log.print("Encoded %u textures (%.1f megapixels) per format on %u threads\n", result.nrOfTextures, result.megapixels, result.nrOfThreads);
+	for (const TextureCookBenchmarkFormat& format : result.formats)
+	{
+		log.print("  %s: %.2f MP/s on 1 thread, %.2f MP/s, PSNR %.1f dB average, %.1f dB min, %u below %.0f dB\n", TextureCooker::getFormatName(format.format),
+			format.singleThreadMegapixelsPerSecond, format.megapixelsPerSecond, format.averagePSNR, format.minPSNR, format.nrBelowMinPSNR, TEXTURE_COOK_MIN_PSNR);
+		log.addErrors(format.nrBelowMinPSNR);
+	}
+}
+
+// Render Queue Benchmark, runs the key, sort and submission checks, then builds and sorts a frame of draws and counts the
+// binds before and after sorting and skipping redundant state
+static void runQueueBench(HeadlessLog& log)
+{
+	unsigned int testErrors = RenderQueue::test();
+	RenderQueueBenchmarkResult result = RenderQueue::benchmark();
+	log.print("Queued %u draws over %u frames, build %.3f ms, radix sort %.3f ms, std::stable_sort %.3f ms\n",
+		result.nrOfDraws, result.nrOfFrames, result.buildTime, result.sortTime, result.stdSortTime);
+	log.print("Binds unsorted %u, sorted %u (%u skipped), shaders %u -> %u, textures %u -> %u, %u state errors, %u test errors\n",
+		result.unsorted.getNrOfBinds(), result.sorted.getNrOfBinds(), result.sorted.nrOfSkippedBinds, result.unsorted.nrOfShaderBinds, result.sorted.nrOfShaderBinds,
+		result.unsorted.nrOfTextureBinds, result.sorted.nrOfTextureBinds, result.errors, testErrors);
+	log.addErrors(result.errors + testErrors);
+}
+
+// Map Instancing Benchmark, groups the map's draws like the renderer does with every object visible, nrOfCopies places the map side by side
+struct MapInstancingBenchmarkResult
+{
+	unsigned int nrOfObjects = 0;
+	InstanceBatcherStats shadowStats;
+	InstanceBatcherStats gBufferStats;
+	double buildTime = 0.0; // Average milliseconds per frame, both passes
+};
+
+static MapInstancingBenchmarkResult benchmarkMapInstancing(std::string mapFileName, unsigned int nrOfCopies, unsigned int nrOfFrames = 100)
+{
+	MapInstancingBenchmarkResult result;
+	MapHandler mapHandler;
+	mapHandler.initialize(mapFileName, 0);
+	const std::vector<GameObjectData>& gameObjects = mapHandler.getGameObjectData();
+	if (gameObjects.empty())
+		return result;
+
+	// Meshes and texture paths stand in for the shared GPU resources, textures are shared by path through the resource handler
+	std::map<std::string, ImportedModel> models;
+	std::set<std::wstring> texturePaths;
+	auto getTexture = [&](const std::wstring& path) -> const void* { return path.empty() ? nullptr : &*texturePaths.insert(path).first; };
+	char shaders[2][ShaderStates::NUM] = {}; // Plain and instanced, shadow pass uses PHONG
+	std::deque<PS_MATERIAL_BUFFER> materials;
+	std::deque<PS_MATERIAL_PBR_BUFFER> materialsPBR;
+
+	std::vector<RenderDraw> shadowDraws;
+	std::vector<RenderDraw> gBufferDraws;
+	std::vector<ShaderStates> gBufferShaders;
+	std::vector<unsigned int> drawObjects;
+	for (size_t i = 0; i < gameObjects.size(); i++)
+	{
+		const GameObjectData& object = gameObjects[i];
+		auto model = models.find(object.modelFile);
+		if (model == models.end())
+		{
+			ImportedModel importedModel;
+			if (object.modelFile.empty() || !MeshCooker::loadModel(object.modelFile, MODEL_IMPORT_FLAGS, importedModel))
+				continue;
+			model = models.emplace(object.modelFile, std::move(importedModel)).first;
+		}
+
+		for (size_t j = 0; j < model->second.meshes.size(); j++)
+		{
+			const ImportedMesh& mesh = model->second.meshes[j];
+			const ImportedMaterial& importedMaterial = model->second.materials[mesh.materialSlot];
+			PS_MATERIAL_BUFFER material = importedMaterial.material;
+			PS_MATERIAL_PBR_BUFFER materialPBR = importedMaterial.materialPBR;
+			TexturePaths paths = importedMaterial.texturePaths;
+			TexturePathsPBR pathsPBR = importedMaterial.texturePathsPBR;
+			if (j < object.meshes.size())
+				Model::applyMeshData(object.meshes[j], material, materialPBR, paths, pathsPBR);
+
+			RenderDraw draw;
+			draw.vertexBuffer = &mesh;
+			draw.vertexStride = sizeof(VertexPosNormTexTan);
+			draw.indexBuffer = &mesh;
+			draw.count = mesh.indexCount;
+			shadowDraws.push_back(draw);
+
+			if (object.shaderType == ShaderStates::PBR)
+			{
+				materialsPBR.push_back(materialPBR);
+				draw.materialData = &materialsPBR.back();
+				draw.materialSize = sizeof(PS_MATERIAL_PBR_BUFFER);
+				draw.textureSet.setTexture(0, getTexture(pathsPBR.albedoPath));
+				draw.textureSet.setTexture(1, getTexture(pathsPBR.normalPath));
+				draw.textureSet.setTexture(2, getTexture(pathsPBR.metallicPath));
+				draw.textureSet.setTexture(3, getTexture(pathsPBR.roughnessPath));
+				draw.textureSet.setTexture(4, getTexture(pathsPBR.emissivePath));
+				draw.textureSet.setTexture(5, getTexture(pathsPBR.ambientOcclusionPath));
+				draw.textureSet.displacement = getTexture(pathsPBR.displacementPath);
+			}
+			else
+			{
+				materials.push_back(material);
+				draw.materialData = &materials.back();
+				draw.materialSize = sizeof(PS_MATERIAL_BUFFER);
+				draw.textureSet.setTexture(0, getTexture(paths.diffusePath));
+				draw.textureSet.setTexture(1, getTexture(paths.specularPath));
+				draw.textureSet.setTexture(2, getTexture(paths.normalPath));
+				draw.textureSet.displacement = getTexture(paths.displacementPath);
+			}
+			gBufferDraws.push_back(draw);
+			gBufferShaders.push_back(object.shaderType);
+			drawObjects.push_back((unsigned int)i);
+		}
+		result.nrOfObjects++;
+	}
+	result.nrOfObjects *= nrOfCopies;
+
+	InstanceBatcher<unsigned int> batcher;
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		Timer buildTimer;
+		buildTimer.start();
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			batcher.clear();
+			for (unsigned int copy = 0; copy < nrOfCopies; copy++)
+			{
+				for (size_t i = 0; i < gBufferDraws.size(); i++)
+				{
+					unsigned int instance = copy * (unsigned int)gameObjects.size() + drawObjects[i];
+					if (pass == 0)
+					{
+						RenderDraw draw = shadowDraws[i];
+						draw.shader = &shaders[0][ShaderStates::PHONG];
+						batcher.add(draw, &shaders[1][ShaderStates::PHONG], 0.f, instance);
+					}
+					else
+					{
+						RenderDraw draw = gBufferDraws[i];
+						draw.shader = &shaders[0][gBufferShaders[i]];
+						batcher.add(draw, &shaders[1][gBufferShaders[i]], 0.f, instance);
+					}
+				}
+			}
+			batcher.build();
+			(pass == 0 ? result.shadowStats : result.gBufferStats) = batcher.getStats();
+		}
+
+		buildTimer.stop();
+		result.buildTime += buildTimer.timeElapsed() * 1000.0;
+	}
+	if (nrOfFrames)
+		result.buildTime /= nrOfFrames;
+
+	return result;
+}
+
+// Instancing Benchmark, runs the grouping checks and a synthetic frame, then counts the draws of the shipped maps before and
+// after grouping, once as they are and once with 16 copies side by side
+static void runInstanceBench(HeadlessLog& log)
+{
+	unsigned int testErrors = InstanceBatcher<unsigned int>::test();
+	InstanceBatcherBenchmarkResult result = InstanceBatcher<unsigned int>::benchmark();
+	log.print("Grouped %u draws over %u frames, build %.3f ms, %u -> %u draws, %u instanced, %u errors, %u test errors\n",
+		result.nrOfDraws, result.nrOfFrames, result.buildTime, result.stats.nrOfDraws, result.stats.nrOfBatchedDraws, result.stats.nrOfInstancedDraws, result.errors, testErrors);
+	log.addErrors(result.errors + testErrors);
+
+	const char* mapFiles[] = { "map_knights.txt", "map_nano_walls.txt" };
+	for (const char* mapFile : mapFiles)
+	{
+		for (unsigned int nrOfCopies : { 1u, 16u })
+		{
+			MapInstancingBenchmarkResult mapResult = benchmarkMapInstancing(mapFile, nrOfCopies);
+			log.print("%s x%u, %u objects, shadow %u -> %u draws, g-buffer %u -> %u draws (%u instanced), build %.3f ms\n",
+				mapFile, nrOfCopies, mapResult.nrOfObjects, mapResult.shadowStats.nrOfDraws, mapResult.shadowStats.nrOfBatchedDraws,
+				mapResult.gBufferStats.nrOfDraws, mapResult.gBufferStats.nrOfBatchedDraws, mapResult.gBufferStats.nrOfInstancedDraws, mapResult.buildTime);
+		}
+	}
+}
+
+// Occlusion Culling Benchmark, runs the rasterizer and bounds checks, then rasterizes city block occluders and tests small
+// objects between them while the camera turns
+static void runOcclusionBench(HeadlessLog& log)
+{
+	unsigned int testErrors = OcclusionCuller::test();
+	OcclusionBenchmarkResult result = OcclusionCuller::benchmark();
+	log.print("Occluders %u per frame, %u / %u triangles rasterized, %u / %u objects rejected over %u frames\n",
+		result.stats.occluders / result.nrOfFrames, result.stats.rasterizedTriangles, result.stats.occluderTriangles, result.stats.rejected, result.stats.tested, result.nrOfFrames);
+	log.print("Per frame, rasterize %.1f us, test %.1f us, scalar rasterize %.1f us, scalar test %.1f us, %u errors, %u test errors\n",
+		result.rasterizeTime, result.testTime, result.scalarRasterizeTime, result.scalarTestTime, result.errors, testErrors);
+	log.addErrors(result.errors + testErrors);
+}
+
+// Vertex Welding Benchmark, runs the welder checks and a face by face grid, then imports Sponza and the nanosuit without
+// welding and reports vertex counts, buffer sizes and weld time
+static void runWeldBench(HeadlessLog& log)
+{
+	unsigned int testErrors = VertexWelder::test();
+	VertexWelderBenchmarkResult gridResult = VertexWelder::benchmark();
+	log.print("Grid, %u -> %u vertices in %.2f ms, %.1f M vertices/s, %zu KB scratch, %u test errors\n",
+		gridResult.nrOfVertices, gridResult.nrOfWeldedVertices, gridResult.weldTime, gridResult.nrOfVertices / (gridResult.weldTime * 1000.0),
+		gridResult.scratchBytes / 1024, testErrors);
+	log.addErrors(testErrors);
+
+	const std::string modelFiles[] = { "Sponza\\Sponza.gltf", "nanosuit.obj" };
+	for (const std::string& modelFile : modelFiles)
+	{
+		VertexWeldBenchmarkResult result = MeshCooker::benchmarkWelding(modelFile);
+		log.print("%s, %u meshes, %u -> %u vertices, %zu -> %zu KB, %.2f ms, %.1f M vertices/s, %zu KB scratch\n",
+			modelFile.c_str(), result.nrOfMeshes, result.verticesBefore, result.verticesAfter, result.bytesBefore / 1024, result.bytesAfter / 1024,
+			result.weldTime, result.weldTime > 0.0 ? result.verticesBefore / (result.weldTime * 1000.0) : 0.0, result.scratchBytes / 1024);
+	}
+}
+
+// Index Optimization Benchmark, runs the optimizer checks and a shuffled grid, then imports Sponza and the nanosuit welded and
+// reports the FIFO cache ACMR before and after, the index buffer sizes and the optimization time
+static void runMeshOptBench(HeadlessLog& log)
+{
+	unsigned int testErrors = MeshOptimizer::test();
+	MeshOptimizerBenchmarkResult gridResult = MeshOptimizer::benchmark();
+	log.print("Grid, %u triangles, ACMR %.3f -> %.3f -> %.3f, vertex cache %.2f ms, overdraw %.2f ms, vertex fetch %.2f ms, %u test errors\n",
+		gridResult.nrOfTriangles, gridResult.acmrBefore, gridResult.acmrAfterCache, gridResult.acmrAfterOverdraw,
+		gridResult.vertexCacheTime, gridResult.overdrawTime, gridResult.vertexFetchTime, testErrors);
+	log.addErrors(testErrors);
+
+	const std::string modelFiles[] = { "Sponza\\Sponza.gltf", "nanosuit.obj" };
+	for (const std::string& modelFile : modelFiles)
+	{
+		IndexOptimizeBenchmarkResult result = MeshCooker::benchmarkIndexOptimization(modelFile);
+		log.print("%s, %u meshes, %u triangles, ACMR %.3f -> %.3f, indices %zu -> %zu KB, %.2f ms\n",
+			modelFile.c_str(), result.nrOfMeshes, result.nrOfTriangles, result.acmrBefore, result.acmrAfter,
+			result.indexBytesBefore / 1024, result.indexBytesAfter / 1024, result.optimizeTime);
+	}
+}
+
+// Vertex Quantization Benchmark, runs the quantizer checks and a million random vertices, then imports Sponza and the nanosuit
+// and reports the vertex buffer sizes, the largest decode errors and the encode time
+static void runQuantizeBench(HeadlessLog& log)
+{
+	unsigned int testErrors = VertexQuantizer::test();
+	VertexQuantizerBenchmarkResult randomResult = VertexQuantizer::benchmark();
+	log.print("Random, %u vertices, %zu -> %zu KB, encode %.2f ms, decode %.2f ms, errors position %g normal %g tangent %g uv %g, %u test errors\n",
+		randomResult.nrOfVertices, randomResult.bytesBefore / 1024, randomResult.bytesAfter / 1024, randomResult.encodeTime, randomResult.decodeTime,
+		randomResult.errors.position, randomResult.errors.normal, randomResult.errors.tangent, randomResult.errors.texCoord, testErrors);
+	log.addErrors(testErrors);
+
+	const std::string modelFiles[] = { "Sponza\\Sponza.gltf", "nanosuit.obj" };
+	for (const std::string& modelFile : modelFiles)
+	{
+		VertexQuantizeBenchmarkResult result = MeshCooker::benchmarkQuantization(modelFile);
+		log.print("%s, %u meshes, %u vertices, %zu -> %zu KB, encode %.2f ms, errors position %g normal %g tangent %g bitangent %g uv %g\n",
+			modelFile.c_str(), result.nrOfMeshes, result.nrOfVertices, result.bytesBefore / 1024, result.bytesAfter / 1024, result.encodeTime,
+			result.errors.position, result.errors.normal, result.errors.tangent, result.errors.bitangent, result.errors.texCoord);
+	}
+}
+
+// Mesh LOD Benchmark, runs the simplifier and LOD selection checks, a noisy sphere and a field of objects in front of a swaying
+// camera, then builds the LOD chains of the tree, the knight and the Cerberus and reports the triangles and errors of every LOD,
+// the index buffer sizes and the simplification time
+static void runLodBench(HeadlessLog& log)
+{
+	unsigned int testErrors = MeshSimplifier::test() + LodSelector::test();
+	MeshSimplifierBenchmarkResult sphereResult = MeshSimplifier::benchmark();
+	LodSelectorBenchmarkResult selectResult = LodSelector::benchmark();
+	log.print("Sphere, %u LODs, triangles %u %u %u %u, errors %g %g %g %g, %.2f ms, %u test errors\n", sphereResult.nrOfLods,
+		sphereResult.nrOfTriangles[0], sphereResult.nrOfTriangles[1], sphereResult.nrOfTriangles[2], sphereResult.nrOfTriangles[3],
+		sphereResult.error[0], sphereResult.error[1], sphereResult.error[2], sphereResult.error[3], sphereResult.simplifyTime, testErrors);
+	log.print("Selection, %u objects, %u frames, LODs %u %u %u %u, %u switches (%u without hysteresis), %.3f ms per frame\n",
+		selectResult.nrOfObjects, selectResult.nrOfFrames, selectResult.nrOfObjectsPerLod[0], selectResult.nrOfObjectsPerLod[1], selectResult.nrOfObjectsPerLod[2],
+		selectResult.nrOfObjectsPerLod[3], selectResult.nrOfSwitches, selectResult.nrOfSwitchesWithoutHysteresis, selectResult.selectTime);
+	log.addErrors(testErrors);
+
+	const std::string modelFiles[] = { "Tree.FBX", "SoiKnightA.fbx", "Cerberus_by_Andrew_Maximov\\Cerberus_LP.FBX" };
+	for (const std::string& modelFile : modelFiles)
+	{
+		MeshLodBenchmarkResult result = MeshCooker::benchmarkLods(modelFile);
+		log.print("%s, %u meshes, %u LODs, triangles %u %u %u %u, errors %g %g %g %g, indices %zu -> %zu KB, %.2f ms\n",
+			modelFile.c_str(), result.nrOfMeshes, result.nrOfLods, result.nrOfTriangles[0], result.nrOfTriangles[1], result.nrOfTriangles[2],
+			result.nrOfTriangles[3], result.error[0], result.error[1], result.error[2], result.error[3], result.indexBytesBefore / 1024,
+			result.indexBytesAfter / 1024, result.simplifyTime);
+	}
+}
+
+static const HeadlessMode HEADLESS_MODES[] =
+{
+	{ L"-cook", runCook },
+	{ L"-mapbench", runMapBench },
+	{ L"-cullbench", runCullBench },
+	{ L"-pickbench", runPickBench },
+	{ L"-physbench", runPhysBench },
+	{ L"-physreplay", runPhysReplay },
+	{ L"-transformbench", runTransformBench },
+	{ L"-alloctest", runAllocTest },
+	{ L"-shaderbench", runShaderBench },
+	{ L"-programbench", runProgramBench },
+	{ L"-clusterbench", runClusterBench },
+	{ L"-jobbench", runJobBench },
+	{ L"-streambench", runStreamBench },
+	{ L"-cachetest", runCacheTest },
+	{ L"-texbench", runTexBench },
+	{ L"-queuebench", runQueueBench },
+	{ L"-instancebench", runInstanceBench },
+	{ L"-occlusionbench", runOcclusionBench },
+	{ L"-weldbench", runWeldBench },
+	{ L"-meshoptbench", runMeshOptBench },
+	{ L"-quantizebench", runQuantizeBench },
+	{ L"-lodbench", runLodBench },
+};
+
+bool runHeadlessModes(const std::wstring& commandLine, int& exitCode)
+{
+	// Flags are matched whole, in table order, so "-cook -lodbench" cooks first and benchmarks the cooked models
+	std::vector<std::wstring> arguments;
+	std::wistringstream argumentStream(commandLine);
+	std::wstring argument;
+	while (argumentStream >> argument)
+		arguments.push_back(argument);
+
+	std::vector<const HeadlessMode*> modes;
+	for (const HeadlessMode& mode : HEADLESS_MODES)
+	{
+		if (std::find(arguments.begin(), arguments.end(), mode.flag) != arguments.end())
+			modes.push_back(&mode);
+	}
+	if (modes.empty())
+		return false;
+
+	HeadlessLog log;
+	for (const HeadlessMode* mode : modes)
+	{
+		unsigned int errorsBefore = log.getNrOfErrors();
+		log.print("%ls\n", mode->flag);
+		mode->run(log);
+		if (log.getNrOfErrors() != errorsBefore)
+			log.print("%ls failed, %u errors\n", mode->flag, log.getNrOfErrors() - errorsBefore);
+	}
+
+	exitCode = log.getNrOfErrors() > 0 ? 1 : 0;
+	return true;
+}
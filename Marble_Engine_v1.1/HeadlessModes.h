@@ -0,0 +1,32 @@
+#ifndef HEADLESSMODES_H
+#define HEADLESSMODES_H
+
+// Headless Log, results go to the console the exe was started from, the debugger output and headless.log,
+// errors reported by the tests are counted and turned into the exit code
+class HeadlessLog
+{
+private:
+	FILE* m_file;
+	unsigned int m_nrOfErrors;
+
+public:
+	HeadlessLog();
+	~HeadlessLog();
+
+	void print(const char* format, ...);
+	void addErrors(unsigned int nrOfErrors) { m_nrOfErrors += nrOfErrors; }
+	unsigned int getNrOfErrors() const { return m_nrOfErrors; }
+};
+
+// Headless Mode, a tool, test or benchmark that runs instead of the engine and exits without opening a window
+struct HeadlessMode
+{
+	const wchar_t* flag;
+	void (*run)(HeadlessLog& log);
+};
+
+// Runs every mode whose flag is on the command line, returns false when there is none so the engine starts as usual.
+// The exit code is 0 when no test reported errors and 1 otherwise
+bool runHeadlessModes(const std::wstring& commandLine, int& exitCode);
+
+#endif // !HEADLESSMODES_H
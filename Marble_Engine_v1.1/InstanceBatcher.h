@@ -0,0 +1,233 @@
+#ifndef INSTANCEBATCHER_H
+#define INSTANCEBATCHER_H
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include "RenderQueue.h"
+
+// Turns the draws of one pass into instanced draws. Draws of the same mesh with the same shader, textures and material
+// values become one draw, and the per object data of its instances is packed next to each other into the instance array.
+// Material values are compared byte for byte, an object whose material was changed on its own ends up in its own group
+
+struct InstanceBatcherStats
+{
+	unsigned int nrOfDraws = 0; // Added
+	unsigned int nrOfBatchedDraws = 0; // Instanced and single draws after grouping
+	unsigned int nrOfInstancedDraws = 0;
+	unsigned int nrOfInstances = 0;
+};
+
+struct InstanceBatcherBenchmarkResult
+{
+	unsigned int nrOfDraws = 0;
+	unsigned int nrOfFrames = 0;
+	double buildTime = 0.0; // Average milliseconds per frame
+	InstanceBatcherStats stats; // Last frame
+	unsigned int errors = 0; // Instances that lost their data or draws that changed, over all frames
+};
+
+// A draw of the batcher output and its depth for the render queue
+struct BatchedDraw
+{
+	RenderDraw draw;
+	float depth = 0.f;
+};
+
+template<typename Instance>
+class InstanceBatcher
+{
+private:
+	struct Item
+	{
+		RenderDraw draw;
+		const void* instancedShader = nullptr;
+		uint64_t groupHash = 0; // Everything compare() looks at, so most comparisons end here
+		float depth = 0.f;
+		Instance instance;
+	};
+
+	std::vector<Item> m_items;
+	std::vector<unsigned int> m_order;
+
+	// Output
+	std::vector<BatchedDraw> m_draws;
+	std::vector<Instance> m_instances;
+
+	// Stats
+	InstanceBatcherStats m_stats;
+
+	// Helper Functions
+	static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		// FNV-1a
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	static uint64_t hashValue(uint64_t hash, const T& value)
+	{
+		return hashBytes(hash, &value, sizeof(T));
+	}
+
+	static uint64_t hashGroup(const RenderDraw& draw, const void* instancedShader)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		hash = hashValue(hash, draw.shader);
+		hash = hashValue(hash, instancedShader);
+		hash = hashValue(hash, draw.vertexBuffer);
+		hash = hashValue(hash, draw.geometryBuffer);
+		hash = hashValue(hash, draw.indexBuffer);
+		hash = hashValue(hash, draw.vertexStride);
+		hash = hashValue(hash, draw.startIndex);
+		hash = hashValue(hash, draw.count);
+		hash = hashBytes(hash, draw.textureSet.textures, sizeof(draw.textureSet.textures));
+		hash = hashValue(hash, draw.textureSet.mask);
+		hash = hashValue(hash, draw.textureSet.displacement);
+		hash = hashValue(hash, draw.materialSize);
+		return hashBytes(hash, draw.materialData, draw.materialSize);
+	}
+
+	// Full order of everything that decides whether two draws can share one instanced draw
+	static int compare(const Item& a, const Item& b)
+	{
+		auto order = [](const void* x, const void* y) { return std::less<const void*>()(x, y) ? -1 : (x != y ? 1 : 0); };
+		auto orderValue = [](uint64_t x, uint64_t y) { return x < y ? -1 : (x != y ? 1 : 0); };
+
+		int result;
+		if ((result = order(a.draw.shader, b.draw.shader)) != 0) return result;
+		if ((result = order(a.instancedShader, b.instancedShader)) != 0) return result;
+		if ((result = order(a.draw.vertexBuffer, b.draw.vertexBuffer)) != 0) return result;
+		if ((result = order(a.draw.geometryBuffer, b.draw.geometryBuffer)) != 0) return result;
+		if ((result = order(a.draw.indexBuffer, b.draw.indexBuffer)) != 0) return result;
+		if ((result = orderValue(a.draw.vertexStride, b.draw.vertexStride)) != 0) return result;
+		if ((result = orderValue(a.draw.startIndex, b.draw.startIndex)) != 0) return result;
+		if ((result = orderValue(a.draw.count, b.draw.count)) != 0) return result;
+		if (a.draw.textureSet < b.draw.textureSet) return -1;
+		if (b.draw.textureSet < a.draw.textureSet) return 1;
+		if ((result = orderValue(a.draw.materialSize, b.draw.materialSize)) != 0) return result;
+		if (a.draw.materialSize > 0 && (result = std::memcmp(a.draw.materialData, b.draw.materialData, a.draw.materialSize)) != 0) return result;
+		return 0;
+	}
+
+public:
+	// Draws need their object buffer and the instance data their instanced shader reads in its place. Without an
+	// instanced shader the draw is never batched
+	void add(const RenderDraw& draw, const void* instancedShader, float depth, const Instance& instance)
+	{
+		Item item;
+		item.draw = draw;
+		item.instancedShader = instancedShader;
+		item.groupHash = hashGroup(draw, instancedShader);
+		item.depth = depth;
+		item.instance = instance;
+		m_items.push_back(item);
+	}
+
+	void clear()
+	{
+		m_items.clear();
+		m_draws.clear();
+		m_instances.clear();
+	}
+
+	// Groups with at least minInstances draws become one instanced draw using the first draw's material buffer and
+	// the depth of its closest instance, smaller groups are passed through unchanged
+	void build(unsigned int minInstances = 2)
+	{
+		m_order.resize(m_items.size());
+		for (unsigned int i = 0; i < (unsigned int)m_order.size(); i++)
+			m_order[i] = i;
+		// Equal hashes next to each other, ties keep the order the draws were added in
+		std::sort(m_order.begin(), m_order.end(), [this](unsigned int a, unsigned int b)
+			{
+				return m_items[a].groupHash != m_items[b].groupHash ? m_items[a].groupHash < m_items[b].groupHash : a < b;
+			});
+
+		// Runs with a hash collision are sorted again on the full comparison
+		for (size_t begin = 0; begin < m_order.size();)
+		{
+			size_t end = begin + 1;
+			bool collision = false;
+			while (end < m_order.size() && m_items[m_order[end]].groupHash == m_items[m_order[begin]].groupHash)
+			{
+				collision = collision || compare(m_items[m_order[begin]], m_items[m_order[end]]) != 0;
+				end++;
+			}
+			if (collision)
+			{
+				std::sort(m_order.begin() + begin, m_order.begin() + end, [this](unsigned int a, unsigned int b)
+					{
+						int result = compare(m_items[a], m_items[b]);
+						return result != 0 ? result < 0 : a < b;
+					});
+			}
+			begin = end;
+		}
+
+		m_draws.clear();
+		m_instances.clear();
+		m_stats = InstanceBatcherStats();
+		m_stats.nrOfDraws = (unsigned int)m_items.size();
+
+		size_t begin = 0;
+		while (begin < m_order.size())
+		{
+			size_t end = begin + 1;
+			while (end < m_order.size() && m_items[m_order[end]].groupHash == m_items[m_order[begin]].groupHash && compare(m_items[m_order[begin]], m_items[m_order[end]]) == 0)
+				end++;
+
+			const Item& first = m_items[m_order[begin]];
+			unsigned int nrOfInstances = (unsigned int)(end - begin);
+			if (first.instancedShader && nrOfInstances >= std::max(minInstances, 1u))
+			{
+				BatchedDraw batchedDraw;
+				batchedDraw.draw = first.draw;
+				batchedDraw.draw.shader = first.instancedShader;
+				batchedDraw.draw.objectBuffer = nullptr;
+				batchedDraw.draw.instanceCount = nrOfInstances;
+				batchedDraw.draw.startInstance = (unsigned int)m_instances.size();
+				batchedDraw.depth = first.depth;
+				for (size_t i = begin; i < end; i++)
+				{
+					const Item& item = m_items[m_order[i]];
+					batchedDraw.depth = std::min(batchedDraw.depth, item.depth);
+					m_instances.push_back(item.instance);
+				}
+				m_draws.push_back(batchedDraw);
+				m_stats.nrOfInstancedDraws++;
+				m_stats.nrOfInstances += nrOfInstances;
+			}
+			else
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					const Item& item = m_items[m_order[i]];
+					m_draws.push_back({ item.draw, item.depth });
+				}
+			}
+
+			begin = end;
+		}
+		m_stats.nrOfBatchedDraws = (unsigned int)m_draws.size();
+	}
+
+	// Getters
+	const std::vector<BatchedDraw>& getDraws() const { return m_draws; }
+	const std::vector<Instance>& getInstances() const { return m_instances; }
+	const InstanceBatcherStats& getStats() const { return m_stats; }
+
+	// Test and Benchmark, in InstanceBatcherTests.cpp
+	static unsigned int test();
+	static InstanceBatcherBenchmarkResult benchmark(unsigned int nrOfObjects = 5000, unsigned int nrOfFrames = 100);
+};
+
+#endif // !INSTANCEBATCHER_H
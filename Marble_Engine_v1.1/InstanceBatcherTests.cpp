@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "InstanceBatcher.h"
+#include "TestSupport.h"
+#include <map>
+#include <chrono>
+
+// Adds the scene with the object index as the instance data
+static void addTestScene(InstanceBatcher<unsigned int>& batcher, const TestScene& scene)
+{
+	batcher.clear();
+	for (const TestSceneDraw& sceneDraw : scene.draws)
+		batcher.add(sceneDraw.draw, sceneDraw.instancedShader, sceneDraw.depth, sceneDraw.object);
+}
+
+// Checks every output draw against the draws that were added, through the instances they carry. Returns the number of errors
+static unsigned int verify(const InstanceBatcher<unsigned int>& batcher, const TestScene& scene)
+{
+	unsigned int errors = 0;
+	std::vector<unsigned int> seen(scene.draws.size(), 0);
+
+	// An object draws each mesh once, so the object and the vertex buffer find the added draw
+	std::map<std::pair<unsigned int, const void*>, size_t> addedByObject;
+	std::map<std::pair<const void*, const void*>, size_t> addedByObjectBuffer;
+	for (size_t i = 0; i < scene.draws.size(); i++)
+	{
+		addedByObject[{ scene.draws[i].object, scene.draws[i].draw.vertexBuffer }] = i;
+		addedByObjectBuffer[{ scene.draws[i].draw.objectBuffer, scene.draws[i].draw.vertexBuffer }] = i;
+	}
+	auto findAdded = [&](const RenderDraw& draw, unsigned int object) -> int
+	{
+		auto it = addedByObject.find({ object, draw.vertexBuffer });
+		if (it == addedByObject.end())
+			return -1;
+
+		const RenderDraw& other = scene.draws[it->second].draw;
+		if (other.indexBuffer != draw.indexBuffer || other.startIndex != draw.startIndex || other.count != draw.count || other.textureSet < draw.textureSet || draw.textureSet < other.textureSet ||
+			other.materialSize != draw.materialSize || std::memcmp(other.materialData, draw.materialData, draw.materialSize) != 0)
+			return -1;
+		return (int)it->second;
+	};
+
+	for (const BatchedDraw& batchedDraw : batcher.getDraws())
+	{
+		const RenderDraw& draw = batchedDraw.draw;
+		if (draw.instanceCount == 0)
+		{
+			auto it = addedByObjectBuffer.find({ draw.objectBuffer, draw.vertexBuffer });
+			if (it == addedByObjectBuffer.end() || scene.draws[it->second].draw.shader != draw.shader || scene.draws[it->second].draw.materialBuffer != draw.materialBuffer)
+				errors++;
+			else
+				seen[it->second]++;
+			continue;
+		}
+
+		if (draw.objectBuffer || draw.startInstance + draw.instanceCount > batcher.getInstances().size())
+		{
+			errors++;
+			continue;
+		}
+		for (unsigned int i = 0; i < draw.instanceCount; i++)
+		{
+			int index = findAdded(draw, batcher.getInstances()[draw.startInstance + i]);
+			if (index < 0)
+				errors++;
+			else
+				seen[index]++;
+		}
+	}
+
+	// Every added draw drawn exactly once
+	for (unsigned int count : seen)
+	{
+		if (count != 1)
+			errors++;
+	}
+	return errors;
+}
+
+// Test, checks grouping, material overrides and the packed instances, returns the number of failed checks
+template<typename Instance>
+unsigned int InstanceBatcher<Instance>::test()
+{
+	unsigned int errors = 0;
+
+	// Two objects of one mesh share a draw, a third with an override and a fourth with other textures do not
+	{
+		InstanceBatcher<unsigned int> batcher;
+		char shader = 0, instancedShader = 0, geometry = 0, textureA = 0, textureB = 0, objects[4] = {}, materialBuffers[4] = {};
+		float materialValues[4] = { 1.f, 1.f, 2.f, 1.f };
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			RenderDraw draw;
+			draw.shader = &shader;
+			draw.vertexBuffer = &geometry;
+			draw.count = 36;
+			draw.objectBuffer = &objects[i];
+			draw.materialBuffer = &materialBuffers[i];
+			draw.materialData = &materialValues[i];
+			draw.materialSize = sizeof(float);
+			draw.textureSet.setTexture(0, i == 3 ? &textureB : &textureA);
+			batcher.add(draw, &instancedShader, 1.f - i * 0.25f, i);
+		}
+		batcher.build();
+
+		const std::vector<BatchedDraw>& draws = batcher.getDraws();
+		unsigned int nrOfInstanced = 0;
+		for (const BatchedDraw& draw : draws)
+		{
+			if (draw.draw.instanceCount == 0)
+				continue;
+			nrOfInstanced++;
+			const std::vector<unsigned int>& instances = batcher.getInstances();
+			if (draw.draw.instanceCount != 2 || draw.draw.shader != &instancedShader || draw.draw.objectBuffer != nullptr ||
+				draw.draw.materialBuffer != &materialBuffers[0] || instances[draw.draw.startInstance] != 0 || instances[draw.draw.startInstance + 1] != 1 ||
+				draw.depth != 0.75f)
+				errors++;
+		}
+		if (draws.size() != 3 || nrOfInstanced != 1 || batcher.getStats().nrOfInstances != 2 || batcher.getStats().nrOfBatchedDraws != 3)
+			errors++;
+
+		// A minimum above the group size passes everything through
+		batcher.build(3);
+		if (batcher.getDraws().size() != 4 || !batcher.getInstances().empty())
+			errors++;
+	}
+
+	// Random scene, every draw kept once with its own state
+	{
+		TestScene scene;
+		fillTestScene(500, 3, scene);
+		InstanceBatcher<unsigned int> batcher;
+		addTestScene(batcher, scene);
+		batcher.build();
+		errors += verify(batcher, scene);
+		if (batcher.getStats().nrOfBatchedDraws >= batcher.getStats().nrOfDraws || batcher.getStats().nrOfInstancedDraws == 0)
+			errors++;
+
+		// Through the render queue, the batched draws are submitted with the state they ask for
+		RenderQueue queue;
+		for (const BatchedDraw& draw : batcher.getDraws())
+			queue.add(RenderPass::GBUFFER, draw.draw, draw.depth);
+		queue.sort();
+		RenderRecordingContext context;
+		errors += submitRecorded(queue, context);
+		if (context.nrOfDraws != batcher.getStats().nrOfBatchedDraws)
+			errors++;
+	}
+
+	// Nothing added
+	{
+		InstanceBatcher<unsigned int> batcher;
+		batcher.build();
+		if (!batcher.getDraws().empty() || batcher.getStats().nrOfDraws != 0)
+			errors++;
+	}
+
+	return errors;
+}
+
+// Benchmark, groups a scene of repeated models every frame and checks the output against the added draws on the last frame
+template<typename Instance>
+InstanceBatcherBenchmarkResult InstanceBatcher<Instance>::benchmark(unsigned int nrOfObjects, unsigned int nrOfFrames)
+{
+	InstanceBatcherBenchmarkResult result;
+	result.nrOfFrames = nrOfFrames;
+
+	TestScene scene;
+	InstanceBatcher<unsigned int> batcher;
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		fillTestScene(nrOfObjects, frame, scene);
+		addTestScene(batcher, scene);
+
+		auto startTime = std::chrono::steady_clock::now();
+		batcher.build();
+		result.buildTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	result.stats = batcher.getStats();
+	result.nrOfDraws = result.stats.nrOfDraws;
+
+	result.errors = verify(batcher, scene);
+	result.buildTime /= std::max(nrOfFrames, 1u);
+
+	return result;
+}
+
+template unsigned int InstanceBatcher<unsigned int>::test();
+template InstanceBatcherBenchmarkResult InstanceBatcher<unsigned int>::benchmark(unsigned int nrOfObjects, unsigned int nrOfFrames);
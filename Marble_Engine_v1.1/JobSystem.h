@@ -0,0 +1,286 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+// Work stealing job scheduler. Every worker owns a deque, it pushes and pops its own jobs at the back and steals from the
+// front of the others. Threads that are not workers share queue 0 and help run jobs while they wait on a counter
+
+class JobSystem;
+
+struct Job
+{
+	std::function<void()> function;
+	class JobCounter* counter = nullptr;
+};
+
+// Number of unfinished jobs, jobs queued with runAfter() start when it reaches zero
+class JobCounter
+{
+private:
+	friend class JobSystem;
+	std::atomic<unsigned int> m_value;
+	std::mutex m_mutex;
+	std::vector<Job> m_continuations;
+
+public:
+	JobCounter() { m_value = 0; }
+	JobCounter(const JobCounter&) = delete;
+	void operator=(const JobCounter&) = delete;
+
+	bool isDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+	unsigned int getValue() const { return m_value.load(std::memory_order_acquire); }
+};
+
+struct JobSystemBenchmarkResult
+{
+	unsigned int nrOfThreads = 0; // Workers plus the calling thread
+	unsigned int nrOfJobs = 0;
+	double singleThreadOverhead = 0.0; // Nanoseconds per empty job
+	double overhead = 0.0; // Nanoseconds per empty job, every thread
+	std::vector<double> scalingTimes; // Milliseconds for the same parallelFor workload, index 0 is 1 thread
+	unsigned int stressErrors = 0;
+};
+
+class JobSystem
+{
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	// Workers, queue 0 belongs to threads that are not workers
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+	std::atomic<bool> m_running;
+
+	// Sleeping, workers sleep when every queue is empty
+	std::atomic<int> m_nrOfQueuedJobs;
+	std::atomic<int> m_nrOfSleepingWorkers;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+
+	// Stats
+	std::atomic<unsigned long long> m_nrOfExecutedJobs;
+	std::atomic<unsigned long long> m_nrOfStolenJobs;
+
+	// Thread Identity
+	inline static thread_local JobSystem* t_system = nullptr;
+	inline static thread_local unsigned int t_queue = 0;
+
+	// Helper Functions
+	unsigned int getQueueIndex() const
+	{
+		return t_system == this ? t_queue : 0;
+	}
+
+	void push(Job&& job)
+	{
+		WorkerQueue& queue = *m_queues[getQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+			m_nrOfQueuedJobs++;
+		}
+
+		// Taking the sleep mutex orders the wake up after a worker that is about to sleep has checked the queues
+		if (m_nrOfSleepingWorkers > 0)
+		{
+			{ std::lock_guard<std::mutex> lock(m_sleepMutex); }
+			m_sleepCondition.notify_one();
+		}
+	}
+
+	bool pop(unsigned int queueIndex, Job& job)
+	{
+		// Own queue, newest first while it is still in cache
+		{
+			WorkerQueue& queue = *m_queues[queueIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				m_nrOfQueuedJobs--;
+				return true;
+			}
+		}
+
+		// Steal, oldest first since it is the largest piece of work left
+		unsigned int nrOfQueues = (unsigned int)m_queues.size();
+		for (unsigned int i = 1; i < nrOfQueues; i++)
+		{
+			WorkerQueue& queue = *m_queues[(queueIndex + i) % nrOfQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				m_nrOfQueuedJobs--;
+				m_nrOfStolenJobs++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void execute(Job& job)
+	{
+		job.function();
+		m_nrOfExecutedJobs++;
+		if (job.counter)
+			finish(*job.counter);
+	}
+
+	void finish(JobCounter& counter)
+	{
+		// The counter is only touched under its mutex, wait() takes it last so the owner can destroy the counter after
+		std::vector<Job> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter.m_mutex);
+			if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				continuations.swap(counter.m_continuations);
+		}
+		for (Job& continuation : continuations)
+			push(std::move(continuation));
+	}
+
+	void workerLoop(unsigned int queueIndex)
+	{
+		t_system = this;
+		t_queue = queueIndex;
+
+		Job job;
+		while (m_running)
+		{
+			if (pop(queueIndex, job))
+			{
+				execute(job);
+				job.function = nullptr;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_nrOfSleepingWorkers++;
+			m_sleepCondition.wait(lock, [this]() { return m_nrOfQueuedJobs > 0 || !m_running; });
+			m_nrOfSleepingWorkers--;
+		}
+	}
+
+public:
+	// Workers in addition to the calling thread, 0 runs every job on the thread that waits
+	JobSystem(unsigned int nrOfWorkers)
+	{
+		m_running = true;
+		m_nrOfQueuedJobs = 0;
+		m_nrOfSleepingWorkers = 0;
+		m_nrOfExecutedJobs = 0;
+		m_nrOfStolenJobs = 0;
+
+		for (unsigned int i = 0; i < nrOfWorkers + 1; i++)
+			m_queues.push_back(std::make_unique<WorkerQueue>());
+		for (unsigned int i = 0; i < nrOfWorkers; i++)
+			m_workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+	}
+	~JobSystem()
+	{
+		// Jobs still queued are dropped, wait on their counters first
+		m_running = false;
+		{ std::lock_guard<std::mutex> lock(m_sleepMutex); }
+		m_sleepCondition.notify_all();
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+	JobSystem(const JobSystem&) = delete;
+	void operator=(const JobSystem&) = delete;
+
+	// One worker per hardware thread besides the main thread
+	static JobSystem& getInstance()
+	{
+		static JobSystem jobSystemInstance(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+		return jobSystemInstance;
+	}
+
+	// Jobs
+	void run(std::function<void()> function, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		push({ std::move(function), counter });
+	}
+
+	// Queued once dependency reaches zero, right away if it already has
+	void runAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_mutex);
+			if (!dependency.isDone())
+			{
+				dependency.m_continuations.push_back({ std::move(function), counter });
+				return;
+			}
+		}
+		push({ std::move(function), counter });
+	}
+
+	// Runs other jobs until the counter reaches zero, safe to call from inside a job
+	void wait(JobCounter& counter)
+	{
+		unsigned int queueIndex = getQueueIndex();
+		Job job;
+		while (!counter.isDone())
+		{
+			if (pop(queueIndex, job))
+			{
+				execute(job);
+				job.function = nullptr;
+			}
+			else
+				std::this_thread::yield();
+		}
+		std::lock_guard<std::mutex> lock(counter.m_mutex);
+	}
+
+	// Splits [0, nrOfItems) into batches of function(begin, end) and waits for all of them, batchSize 0 picks one
+	void parallelFor(unsigned int nrOfItems, unsigned int batchSize, const std::function<void(unsigned int begin, unsigned int end)>& function)
+	{
+		if (nrOfItems == 0)
+			return;
+		if (batchSize == 0)
+			batchSize = std::max(nrOfItems / (getNrOfThreads() * 4), 1u);
+
+		JobCounter counter;
+		for (unsigned int begin = 0; begin < nrOfItems; begin += batchSize)
+		{
+			unsigned int end = std::min(begin + batchSize, nrOfItems);
+			run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+		wait(counter);
+	}
+
+	// Getters
+	unsigned int getNrOfWorkers() const { return (unsigned int)m_workers.size(); }
+	unsigned int getNrOfThreads() const { return (unsigned int)m_workers.size() + 1; }
+
+	// Stats
+	unsigned long long getNrOfExecutedJobs() const { return m_nrOfExecutedJobs; }
+	unsigned long long getNrOfStolenJobs() const { return m_nrOfStolenJobs; }
+
+	// Stress Test and Benchmark, in JobSystemTests.cpp
+	static unsigned int stressTest(unsigned int nrOfWorkers);
+	static JobSystemBenchmarkResult benchmark(unsigned int nrOfJobs = 200000, unsigned int nrOfItems = 1 << 20);
+};
+
+#endif // !JOBSYSTEM_H
@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cmath>
+
+// Stress Test, returns the number of failed checks
+unsigned int JobSystem::stressTest(unsigned int nrOfWorkers)
+{
+	JobSystem jobSystem(nrOfWorkers);
+	unsigned int errors = 0;
+
+	// Many small jobs
+	{
+		std::atomic<unsigned int> sum;
+		sum = 0;
+		JobCounter counter;
+		for (unsigned int i = 0; i < 100000; i++)
+			jobSystem.run([&sum]() { sum++; }, &counter);
+		jobSystem.wait(counter);
+		if (sum != 100000)
+			errors++;
+	}
+
+	// Nested, jobs spawn and wait on their own children
+	{
+		std::atomic<unsigned int> sum;
+		sum = 0;
+		JobCounter counter;
+		for (unsigned int i = 0; i < 64; i++)
+		{
+			jobSystem.run([&jobSystem, &sum]()
+				{
+					JobCounter childCounter;
+					for (unsigned int j = 0; j < 64; j++)
+						jobSystem.run([&sum]() { sum++; }, &childCounter);
+					jobSystem.wait(childCounter);
+					sum++;
+				}, &counter);
+		}
+		jobSystem.wait(counter);
+		if (sum != 64 * 64 + 64)
+			errors++;
+	}
+
+	// Chain, every job depends on the one before it
+	{
+		const unsigned int chainLength = 1000;
+		std::vector<unsigned int> order;
+		std::vector<std::unique_ptr<JobCounter>> links(chainLength);
+		for (unsigned int i = 0; i < chainLength; i++)
+			links[i] = std::make_unique<JobCounter>();
+
+		jobSystem.run([&order]() { order.push_back(0); }, links[0].get());
+		for (unsigned int i = 1; i < chainLength; i++)
+			jobSystem.runAfter(*links[i - 1], [&order, i]() { order.push_back(i); }, links[i].get());
+		jobSystem.wait(*links[chainLength - 1]);
+
+		if (order.size() != chainLength)
+			errors++;
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			if (order[i] != i)
+			{
+				errors++;
+				break;
+			}
+		}
+	}
+
+	// Fan in, the continuation sees every job of its dependency done
+	{
+		std::atomic<unsigned int> sum;
+		sum = 0;
+		unsigned int seen = 0;
+		JobCounter dependency, counter;
+		for (unsigned int i = 0; i < 256; i++)
+			jobSystem.run([&sum]() { sum++; }, &dependency);
+		jobSystem.runAfter(dependency, [&sum, &seen]() { seen = sum; }, &counter);
+		jobSystem.wait(counter);
+		if (seen != 256)
+			errors++;
+	}
+
+	// Parallel For, every item visited exactly once
+	{
+		const unsigned int nrOfItems = 1000003;
+		std::vector<unsigned char> visits(nrOfItems, 0);
+		jobSystem.parallelFor(nrOfItems, 0, [&visits](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+					visits[i]++;
+			});
+		for (unsigned int i = 0; i < nrOfItems; i++)
+		{
+			if (visits[i] != 1)
+			{
+				errors++;
+				break;
+			}
+		}
+	}
+
+	return errors;
+}
+
+// Benchmark, scheduling overhead of empty jobs and scaling of one parallelFor workload from 1 to every hardware thread
+JobSystemBenchmarkResult JobSystem::benchmark(unsigned int nrOfJobs, unsigned int nrOfItems)
+{
+	JobSystemBenchmarkResult result;
+	result.nrOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	result.nrOfJobs = nrOfJobs;
+
+	// Overhead
+	for (unsigned int nrOfWorkers : { 0u, result.nrOfThreads - 1 })
+	{
+		JobSystem jobSystem(nrOfWorkers);
+		JobCounter counter;
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < nrOfJobs; i++)
+			jobSystem.run([]() {}, &counter);
+		jobSystem.wait(counter);
+		double overhead = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count() / std::max(nrOfJobs, 1u);
+
+		if (nrOfWorkers == 0)
+			result.singleThreadOverhead = overhead;
+		if (nrOfWorkers == result.nrOfThreads - 1)
+			result.overhead = overhead;
+	}
+
+	// Scaling
+	std::vector<float> output(nrOfItems);
+	auto workload = [&output](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			float value = (float)i;
+			for (int j = 0; j < 64; j++)
+				value = std::sqrt(value + (float)j);
+			output[i] = value;
+		}
+	};
+	for (unsigned int nrOfThreads = 1; nrOfThreads <= result.nrOfThreads; nrOfThreads++)
+	{
+		JobSystem jobSystem(nrOfThreads - 1);
+		auto startTime = std::chrono::steady_clock::now();
+		jobSystem.parallelFor(nrOfItems, 0, workload);
+		result.scalingTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+	}
+
+	// Stress
+	result.stressErrors = stressTest(0) + stressTest(result.nrOfThreads - 1);
+
+	return result;
+}
+
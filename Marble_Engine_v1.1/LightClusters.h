@@ -0,0 +1,313 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Clustered light assignment on the CPU. The view frustum is split into a froxel grid, tiles in screen space
+// and exponential slices in depth, and every point and spot light is binned into the clusters its bounds touch
+
+// Grid, must match LightPassPS.hlsl
+const unsigned int CLUSTER_GRID_X = 16;
+const unsigned int CLUSTER_GRID_Y = 9;
+const unsigned int CLUSTER_GRID_Z = 24;
+const unsigned int CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+// Light list of one cluster, offset into the packed light indices
+struct ClusterRange
+{
+	unsigned int offset = 0;
+	unsigned int count = 0;
+};
+
+struct LightClusterBenchmarkResult
+{
+	unsigned int nrOfLights = 0;
+	unsigned int nrOfFrames = 0;
+	double binTime = 0.0; // Average milliseconds per frame
+	double bruteForceTime = 0.0; // Every light against every cluster
+	double lightsPerMillisecond = 0.0;
+	unsigned int nrOfIndices = 0; // Last frame
+	unsigned int mismatches = 0; // Clusters whose light list differs from the brute force reference, over all frames
+};
+
+class LightClusters
+{
+private:
+	// View space bounds of one froxel
+	struct ClusterBounds
+	{
+		float min[3];
+		float max[3];
+	};
+
+	// Grid, rebuilt when the projection changes
+	DirectX::XMFLOAT4X4 m_projectionMatrix;
+	float m_nearZ = 0.f;
+	float m_farZ = 0.f;
+	float m_sliceScale = 0.f;
+	float m_sliceBias = 0.f;
+	std::vector<ClusterBounds> m_clusterBounds;
+
+	// Lights, view space center and radius
+	std::vector<DirectX::XMFLOAT4> m_viewSpheres;
+
+	// Cluster and light pairs, sorted into the light lists
+	std::vector<unsigned int> m_pairClusters;
+	std::vector<unsigned int> m_pairLights;
+	std::vector<unsigned int> m_fillOffsets;
+
+	// Light Lists
+	std::vector<ClusterRange> m_ranges;
+	std::vector<unsigned int> m_lightIndices;
+
+	// Helper Functions
+	static float axisDistance(float center, float min, float max)
+	{
+		if (center < min)
+			return min - center;
+		if (center > max)
+			return center - max;
+		return 0.f;
+	}
+	static bool intersects(const DirectX::XMFLOAT4& sphere, const ClusterBounds& bounds)
+	{
+		float dx = axisDistance(sphere.x, bounds.min[0], bounds.max[0]);
+		float dy = axisDistance(sphere.y, bounds.min[1], bounds.max[1]);
+		float dz = axisDistance(sphere.z, bounds.min[2], bounds.max[2]);
+		return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+	}
+	// Per axis test, implied by intersects() so it never rejects a cluster the full test would accept
+	static bool overlapsAxis(float center, float radius, float min, float max)
+	{
+		float distance = axisDistance(center, min, max);
+		return distance * distance <= radius * radius;
+	}
+
+	int getSlice(float z) const
+	{
+		if (z <= m_nearZ)
+			return 0;
+		if (z >= m_farZ)
+			return (int)CLUSTER_GRID_Z - 1;
+		return std::min((int)(std::log(z) * m_sliceScale + m_sliceBias), (int)CLUSTER_GRID_Z - 1);
+	}
+
+	void buildGrid(const DirectX::XMFLOAT4X4& projectionMatrix)
+	{
+		if (!m_clusterBounds.empty() && memcmp(&projectionMatrix, &m_projectionMatrix, sizeof(DirectX::XMFLOAT4X4)) == 0)
+			return;
+		m_projectionMatrix = projectionMatrix;
+
+		// Left handed perspective projection, row vectors
+		float xScale = projectionMatrix._11;
+		float yScale = projectionMatrix._22;
+		m_nearZ = -projectionMatrix._43 / projectionMatrix._33;
+		m_farZ = projectionMatrix._33 * m_nearZ / (projectionMatrix._33 - 1.f);
+
+		float logDepthRange = std::log(m_farZ / m_nearZ);
+		m_sliceScale = (float)CLUSTER_GRID_Z / logDepthRange;
+		m_sliceBias = -(float)CLUSTER_GRID_Z * std::log(m_nearZ) / logDepthRange;
+
+		m_clusterBounds.resize(CLUSTER_COUNT);
+		for (unsigned int z = 0; z < CLUSTER_GRID_Z; z++)
+		{
+			float sliceNear = m_nearZ * std::pow(m_farZ / m_nearZ, (float)z / CLUSTER_GRID_Z);
+			float sliceFar = m_nearZ * std::pow(m_farZ / m_nearZ, (float)(z + 1) / CLUSTER_GRID_Z);
+			for (unsigned int y = 0; y < CLUSTER_GRID_Y; y++)
+			{
+				// Rows from the top of the screen, like texture coordinates
+				float ndcTop = 1.f - 2.f * y / CLUSTER_GRID_Y;
+				float ndcBottom = 1.f - 2.f * (y + 1) / CLUSTER_GRID_Y;
+				for (unsigned int x = 0; x < CLUSTER_GRID_X; x++)
+				{
+					float ndcLeft = -1.f + 2.f * x / CLUSTER_GRID_X;
+					float ndcRight = -1.f + 2.f * (x + 1) / CLUSTER_GRID_X;
+
+					ClusterBounds& bounds = m_clusterBounds[getClusterIndex(x, y, z)];
+					bounds.min[0] = std::min(ndcLeft * sliceNear, ndcLeft * sliceFar) / xScale;
+					bounds.max[0] = std::max(ndcRight * sliceNear, ndcRight * sliceFar) / xScale;
+					bounds.min[1] = std::min(ndcBottom * sliceNear, ndcBottom * sliceFar) / yScale;
+					bounds.max[1] = std::max(ndcTop * sliceNear, ndcTop * sliceFar) / yScale;
+					bounds.min[2] = sliceNear;
+					bounds.max[2] = sliceFar;
+				}
+			}
+		}
+	}
+
+	void transformLights(const std::vector<DirectX::BoundingSphere>& lights, const DirectX::XMFLOAT4X4& viewMatrix)
+	{
+		m_viewSpheres.resize(lights.size());
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			const DirectX::XMFLOAT3& center = lights[i].Center;
+			m_viewSpheres[i].x = center.x * viewMatrix._11 + center.y * viewMatrix._21 + center.z * viewMatrix._31 + viewMatrix._41;
+			m_viewSpheres[i].y = center.x * viewMatrix._12 + center.y * viewMatrix._22 + center.z * viewMatrix._32 + viewMatrix._42;
+			m_viewSpheres[i].z = center.x * viewMatrix._13 + center.y * viewMatrix._23 + center.z * viewMatrix._33 + viewMatrix._43;
+			m_viewSpheres[i].w = lights[i].Radius;
+		}
+	}
+
+public:
+	LightClusters()
+	{
+		memset(&m_projectionMatrix, 0, sizeof(DirectX::XMFLOAT4X4));
+	}
+
+	// Bins every light, light lists are in ascending light order
+	void update(const std::vector<DirectX::BoundingSphere>& lights, DirectX::FXMMATRIX viewMatrix, DirectX::CXMMATRIX projectionMatrix)
+	{
+		DirectX::XMFLOAT4X4 view, projection;
+		DirectX::XMStoreFloat4x4(&view, viewMatrix);
+		DirectX::XMStoreFloat4x4(&projection, projectionMatrix);
+		buildGrid(projection);
+		transformLights(lights, view);
+
+		// Pairs, only the slices, columns and rows the light can reach are tested
+		m_pairClusters.clear();
+		m_pairLights.clear();
+		for (unsigned int light = 0; light < (unsigned int)m_viewSpheres.size(); light++)
+		{
+			const DirectX::XMFLOAT4& sphere = m_viewSpheres[light];
+			if (sphere.w <= 0.f)
+				continue;
+
+			// One slice of margin on both sides covers the log rounding
+			int firstSlice = std::max(getSlice(sphere.z - sphere.w) - 1, 0);
+			int lastSlice = std::min(getSlice(sphere.z + sphere.w) + 1, (int)CLUSTER_GRID_Z - 1);
+			for (int z = firstSlice; z <= lastSlice; z++)
+			{
+				const ClusterBounds* slice = &m_clusterBounds[getClusterIndex(0, 0, z)];
+				if (!overlapsAxis(sphere.z, sphere.w, slice->min[2], slice->max[2]))
+					continue;
+
+				// Column bounds only depend on the column within a slice, row bounds on the row
+				int firstColumn = CLUSTER_GRID_X, lastColumn = -1;
+				for (int x = 0; x < (int)CLUSTER_GRID_X; x++)
+				{
+					if (overlapsAxis(sphere.x, sphere.w, slice[x].min[0], slice[x].max[0]))
+					{
+						firstColumn = std::min(firstColumn, x);
+						lastColumn = x;
+					}
+				}
+				int firstRow = CLUSTER_GRID_Y, lastRow = -1;
+				for (int y = 0; y < (int)CLUSTER_GRID_Y; y++)
+				{
+					if (overlapsAxis(sphere.y, sphere.w, slice[y * CLUSTER_GRID_X].min[1], slice[y * CLUSTER_GRID_X].max[1]))
+					{
+						firstRow = std::min(firstRow, y);
+						lastRow = y;
+					}
+				}
+
+				for (int y = firstRow; y <= lastRow; y++)
+				{
+					for (int x = firstColumn; x <= lastColumn; x++)
+					{
+						unsigned int cluster = getClusterIndex(x, y, z);
+						if (intersects(sphere, m_clusterBounds[cluster]))
+						{
+							m_pairClusters.push_back(cluster);
+							m_pairLights.push_back(light);
+						}
+					}
+				}
+			}
+		}
+
+		// Light Lists, counting sort by cluster keeps the light order
+		m_ranges.assign(CLUSTER_COUNT, ClusterRange());
+		for (size_t i = 0; i < m_pairClusters.size(); i++)
+			m_ranges[m_pairClusters[i]].count++;
+
+		m_fillOffsets.resize(CLUSTER_COUNT);
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < CLUSTER_COUNT; i++)
+		{
+			m_ranges[i].offset = offset;
+			m_fillOffsets[i] = offset;
+			offset += m_ranges[i].count;
+		}
+
+		m_lightIndices.resize(m_pairClusters.size());
+		for (size_t i = 0; i < m_pairClusters.size(); i++)
+			m_lightIndices[m_fillOffsets[m_pairClusters[i]]++] = m_pairLights[i];
+	}
+
+	// Reference, every light against every cluster
+	void updateBruteForce(const std::vector<DirectX::BoundingSphere>& lights, DirectX::FXMMATRIX viewMatrix, DirectX::CXMMATRIX projectionMatrix)
+	{
+		DirectX::XMFLOAT4X4 view, projection;
+		DirectX::XMStoreFloat4x4(&view, viewMatrix);
+		DirectX::XMStoreFloat4x4(&projection, projectionMatrix);
+		buildGrid(projection);
+		transformLights(lights, view);
+
+		m_ranges.assign(CLUSTER_COUNT, ClusterRange());
+		m_lightIndices.clear();
+		for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+		{
+			m_ranges[cluster].offset = (unsigned int)m_lightIndices.size();
+			for (unsigned int light = 0; light < (unsigned int)m_viewSpheres.size(); light++)
+			{
+				if (m_viewSpheres[light].w > 0.f && intersects(m_viewSpheres[light], m_clusterBounds[cluster]))
+					m_lightIndices.push_back(light);
+			}
+			m_ranges[cluster].count = (unsigned int)m_lightIndices.size() - m_ranges[cluster].offset;
+		}
+	}
+
+	static unsigned int getClusterIndex(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+	}
+
+	// Bounds of the part of the range sphere inside the cone, cosOuter is the cosine of the outer angle
+	static DirectX::BoundingSphere getSpotLightBounds(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& direction, float range, float cosOuter)
+	{
+		DirectX::BoundingSphere bounds;
+		bounds.Center = position;
+		bounds.Radius = range;
+
+		float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		if (cosOuter <= 0.f || length <= 0.f)
+			return bounds;
+
+		float offset;
+		if (cosOuter >= 0.70710678f) // Narrower than 90 degrees, the apex and the rim lie on the sphere
+		{
+			offset = range / (2.f * cosOuter);
+			bounds.Radius = offset;
+		}
+		else // Wide, the rim circle is the widest part
+		{
+			offset = range * cosOuter;
+			bounds.Radius = range * std::sqrt(1.f - cosOuter * cosOuter);
+		}
+		bounds.Center.x += direction.x / length * offset;
+		bounds.Center.y += direction.y / length * offset;
+		bounds.Center.z += direction.z / length * offset;
+
+		return bounds;
+	}
+
+	// Getters
+	const std::vector<ClusterRange>& getRanges() const { return m_ranges; }
+	const std::vector<unsigned int>& getLightIndices() const { return m_lightIndices; }
+	float getNearZ() const { return m_nearZ; }
+	float getFarZ() const { return m_farZ; }
+	float getSliceScale() const { return m_sliceScale; }
+	float getSliceBias() const { return m_sliceBias; }
+
+	// Test and Benchmark, in LightClustersTests.cpp
+	static unsigned int test();
+	static LightClusterBenchmarkResult benchmark(unsigned int nrOfLights = 4096, unsigned int nrOfFrames = 100);
+};
+
+#endif // !LIGHTCLUSTERS_H
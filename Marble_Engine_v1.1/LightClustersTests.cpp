@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "LightClusters.h"
+#include <chrono>
+#include <random>
+
+using namespace DirectX;
+
+// Clusters whose light list differs between the two
+static unsigned int compareLists(const LightClusters& clusters, const LightClusters& reference)
+{
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < CLUSTER_COUNT; i++)
+	{
+		const ClusterRange& range = clusters.getRanges()[i];
+		const ClusterRange& referenceRange = reference.getRanges()[i];
+		if (range.count != referenceRange.count ||
+			!std::equal(clusters.getLightIndices().begin() + range.offset, clusters.getLightIndices().begin() + range.offset + range.count, reference.getLightIndices().begin() + referenceRange.offset))
+			mismatches++;
+	}
+	return mismatches;
+}
+
+// Number of clusters the light is binned into
+static unsigned int countClusters(const LightClusters& clusters, unsigned int light)
+{
+	unsigned int count = 0;
+	for (const ClusterRange& range : clusters.getRanges())
+		count += (unsigned int)std::count(clusters.getLightIndices().begin() + range.offset, clusters.getLightIndices().begin() + range.offset + range.count, light);
+	return count;
+}
+
+// Number of points of the cone outside its bounds, the apex, the rim and random points inside
+static unsigned int countPointsOutsideSpotBounds(const XMFLOAT3& position, const XMFLOAT3& direction, float range, float cosOuter, std::mt19937& generator)
+{
+	BoundingSphere bounds = LightClusters::getSpotLightBounds(position, direction, range, cosOuter);
+	XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&direction));
+	XMVECTOR side = XMVector3Normalize(XMVector3Cross(axis, fabsf(direction.y) < 0.9f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&direction))) ? XMVectorSet(0.f, 1.f, 0.f, 0.f) : XMVectorSet(1.f, 0.f, 0.f, 0.f)));
+	XMVECTOR up = XMVector3Cross(axis, side);
+	float angle = std::acos(std::max(-1.f, std::min(cosOuter, 1.f)));
+
+	auto isOutside = [&](float distance, float pointAngle, float around)
+	{
+		XMVECTOR pointDirection = axis * std::cos(pointAngle) + (side * std::cos(around) + up * std::sin(around)) * std::sin(pointAngle);
+		XMVECTOR point = XMLoadFloat3(&position) + pointDirection * distance;
+		float centerDistance = XMVectorGetX(XMVector3Length(point - XMLoadFloat3(&bounds.Center)));
+		return centerDistance > bounds.Radius + 1e-4f * range;
+	};
+
+	unsigned int outside = isOutside(0.f, 0.f, 0.f) + isOutside(range, 0.f, 0.f);
+	std::uniform_real_distribution<float> unitDistribution(0.f, 1.f);
+	for (int i = 0; i < 64; i++)
+	{
+		float around = unitDistribution(generator) * XM_2PI;
+		outside += isOutside(range, angle, around); // Rim
+		outside += isOutside(range * std::cbrt(unitDistribution(generator)), angle * std::sqrt(unitDistribution(generator)), around);
+	}
+	return outside;
+}
+
+// Test, lights on the edges of the grid against the brute force reference, and spot light bounds around the 90 degree switch
+unsigned int LightClusters::test()
+{
+	unsigned int errors = 0;
+
+	// Camera at the origin looking down +z
+	XMMATRIX viewMatrix = XMMatrixIdentity();
+	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(80.f), 16.f / 9.f, 0.5f, 100.f);
+	std::vector<BoundingSphere> lights = {
+		BoundingSphere(XMFLOAT3(0.f, 0.f, -5.f), 2.f), // 0, behind the camera
+		BoundingSphere(XMFLOAT3(1.f, 0.f, -1.f), 3.f), // 1, behind the camera reaching past the near plane
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 0.5f), 0.1f), // 2, centered on the near plane
+		BoundingSphere(XMFLOAT3(-0.2f, 0.1f, 0.2f), 0.35f), // 3, between the camera and the near plane, reaching past it
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 0.2f), 0.1f), // 4, between the camera and the near plane
+		BoundingSphere(XMFLOAT3(5.f, -2.f, 100.f), 4.f), // 5, centered on the far plane
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 103.f), 4.f), // 6, beyond the far plane reaching back into it
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 130.f), 10.f), // 7, beyond the far plane
+		BoundingSphere(XMFLOAT3(200.f, 0.f, 50.f), 10.f), // 8, beside the frustum
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 0.f), 1000.f), // 9, around everything
+		BoundingSphere(XMFLOAT3(0.f, 0.f, 10.f), 0.f) // 10, no range
+	};
+
+	LightClusters clusters, reference;
+	clusters.update(lights, viewMatrix, projectionMatrix);
+	reference.updateBruteForce(lights, viewMatrix, projectionMatrix);
+	errors += compareLists(clusters, reference);
+	errors += std::abs(clusters.getNearZ() - 0.5f) > 1e-4f || std::abs(clusters.getFarZ() - 100.f) > 1e-2f;
+	errors += countClusters(clusters, 0) != 0 || countClusters(clusters, 4) != 0 || countClusters(clusters, 7) != 0 || countClusters(clusters, 8) != 0 || countClusters(clusters, 10) != 0;
+	errors += countClusters(clusters, 1) == 0 || countClusters(clusters, 2) == 0 || countClusters(clusters, 3) == 0 || countClusters(clusters, 5) == 0 || countClusters(clusters, 6) == 0;
+	errors += countClusters(clusters, 9) != CLUSTER_COUNT;
+
+	// Lights on the near and far planes are binned into the first and last slices only
+	for (unsigned int y = 0; y < CLUSTER_GRID_Y; y++)
+	{
+		for (unsigned int x = 0; x < CLUSTER_GRID_X; x++)
+		{
+			for (unsigned int z = 1; z + 1 < CLUSTER_GRID_Z; z++)
+			{
+				const ClusterRange& range = clusters.getRanges()[getClusterIndex(x, y, z)];
+				const unsigned int* indices = clusters.getLightIndices().data() + range.offset;
+				errors += std::count(indices, indices + range.count, 2u) + std::count(indices, indices + range.count, 6u) > 0;
+			}
+		}
+	}
+
+	// The same lights from a camera that moved and turned
+	viewMatrix = XMMatrixLookAtLH(XMVectorSet(10.f, 3.f, -20.f, 1.f), XMVectorSet(0.f, 0.f, 50.f, 1.f), XMVectorSet(0.f, 1.f, 0.f, 0.f));
+	clusters.update(lights, viewMatrix, projectionMatrix);
+	reference.updateBruteForce(lights, viewMatrix, projectionMatrix);
+	errors += compareLists(clusters, reference);
+
+	// Spot light bounds hold the whole cone, from narrow through the 90 degree switch to wider than a hemisphere
+	std::mt19937 generator(1337);
+	const float cosOuters[] = { 0.99f, 0.9f, 0.71f, 0.7f, 0.5f, 0.1f, 0.f, -0.5f };
+	const XMFLOAT3 directions[] = { XMFLOAT3(0.f, 0.f, 1.f), XMFLOAT3(0.f, -3.f, 0.f), XMFLOAT3(1.f, 2.f, -2.f) };
+	for (float cosOuter : cosOuters)
+	{
+		for (const XMFLOAT3& direction : directions)
+		{
+			XMFLOAT3 position(4.f, 2.f, 30.f);
+			errors += countPointsOutsideSpotBounds(position, direction, 8.f, cosOuter, generator);
+
+			// Never larger than the range sphere, and smaller for anything narrower than a hemisphere
+			BoundingSphere bounds = getSpotLightBounds(position, direction, 8.f, cosOuter);
+			errors += bounds.Radius > 8.f || (cosOuter > 0.f && bounds.Radius >= 8.f);
+
+			// Binned like any other light
+			std::vector<BoundingSphere> spotLights = { bounds };
+			clusters.update(spotLights, XMMatrixIdentity(), projectionMatrix);
+			reference.updateBruteForce(spotLights, XMMatrixIdentity(), projectionMatrix);
+			errors += compareLists(clusters, reference);
+		}
+	}
+
+	return errors;
+}
+
+// Benchmark, bins lights scattered through a scene for a moving camera and checks every frame against the brute force reference
+LightClusterBenchmarkResult LightClusters::benchmark(unsigned int nrOfLights, unsigned int nrOfFrames)
+{
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> positionDistribution(-100.f, 100.f);
+	std::uniform_real_distribution<float> heightDistribution(0.f, 20.f);
+	std::uniform_real_distribution<float> rangeDistribution(1.f, 10.f);
+	std::uniform_real_distribution<float> unitDistribution(-1.f, 1.f);
+	std::uniform_real_distribution<float> cosDistribution(0.3f, 0.95f);
+
+	std::vector<BoundingSphere> lights(nrOfLights);
+	for (unsigned int i = 0; i < nrOfLights; i++)
+	{
+		XMFLOAT3 position(positionDistribution(generator), heightDistribution(generator), positionDistribution(generator));
+		float range = rangeDistribution(generator);
+		if (i % 2) // Spot
+			lights[i] = getSpotLightBounds(position, XMFLOAT3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator)), range, cosDistribution(generator));
+		else
+			lights[i] = BoundingSphere(position, range);
+	}
+	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(80.f), 16.f / 9.f, 0.1f, 1000.f);
+
+	LightClusterBenchmarkResult result;
+	result.nrOfLights = nrOfLights;
+	result.nrOfFrames = nrOfFrames;
+
+	LightClusters clusters, reference;
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		float angle = (float)frame / nrOfFrames * XM_2PI;
+		XMMATRIX viewMatrix = XMMatrixLookAtLH(XMVectorSet(std::cos(angle) * 60.f, 10.f, std::sin(angle) * 60.f, 1.f), XMVectorSet(0.f, 5.f, 0.f, 1.f), XMVectorSet(0.f, 1.f, 0.f, 0.f));
+
+		auto startTime = std::chrono::steady_clock::now();
+		clusters.update(lights, viewMatrix, projectionMatrix);
+		result.binTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		reference.updateBruteForce(lights, viewMatrix, projectionMatrix);
+		result.bruteForceTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		result.mismatches += compareLists(clusters, reference);
+		result.nrOfIndices = (unsigned int)clusters.m_lightIndices.size();
+	}
+
+	result.binTime /= std::max(nrOfFrames, 1u);
+	result.bruteForceTime /= std::max(nrOfFrames, 1u);
+	result.lightsPerMillisecond = result.binTime > 0.0 ? nrOfLights / result.binTime : 0.0;
+
+	return result;
+}
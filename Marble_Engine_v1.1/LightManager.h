@@ -3,6 +3,8 @@
 #define LIGHTMANAGER_H
 
 #include "RenderObject.h"
+#include "StructuredBuffer.h"
+#include "LightClusters.h"
 
 enum LightType { POINT_LIGHT, SPOT_LIGHT, DIRECTIONAL_LIGHT, NONE };
 static const char* LightTypeNames[] = { "Point", "Spot", "Directional"};
@@ -15,11 +17,21 @@ private:
     ID3D11DeviceContext* m_deviceContext;
 
     // Lights
+    std::vector<Light> m_lights;
     PS_LIGHT_BUFFER m_lightData;
 
     // Constant Buffer
     Buffer<PS_LIGHT_BUFFER> m_lightBuffer;
 
+    // Clusters, rebuilt every frame from the camera
+    LightClusters m_clusters;
+    std::vector<Light> m_packedLights; // Enabled lights, directional first
+    std::vector<BoundingSphere> m_lightBounds; // Point and spot lights in packed order
+    StructuredBuffer<Light> m_lightsBuffer;
+    StructuredBuffer<ClusterRange> m_clusterRangesBuffer;
+    StructuredBuffer<UINT> m_clusterLightIndicesBuffer;
+    double m_clusterTime = 0.0; // Milliseconds
+
     // Render Objects for Point and Spot Lights
     std::vector<RenderObject> m_renderObjects;
     static const UINT POINT_MESH = 0;
@@ -35,6 +47,7 @@ public:
         m_viewMatrix = nullptr;
         m_projectionMatrix = nullptr;
         m_lightData.nrOfLights = 0;
+        m_lightData.nrOfDirectionalLights = 0;
     }
     ~LightManager() {}
 
@@ -48,6 +61,9 @@ public:
         m_projectionMatrix = projectionMatrix;
 
         m_lightBuffer.initialize(device, deviceContext, &m_lightData, BufferType::CONSTANT);
+        m_lightsBuffer.initialize(device, deviceContext, 64);
+        m_clusterRangesBuffer.initialize(device, deviceContext, CLUSTER_COUNT);
+        m_clusterLightIndicesBuffer.initialize(device, deviceContext, CLUSTER_COUNT);
 
         // Add Render Objects
         // - Sphere
@@ -65,27 +81,26 @@ public:
     // Getters
     ID3D11Buffer* Get() const { return m_lightBuffer.Get(); }
     ID3D11Buffer* const* GetAddressOf() const { return m_lightBuffer.GetAddressOf(); }
-    int const getNrOfLights() const { return m_lightData.nrOfLights; }
+    int const getNrOfLights() const { return (int)m_lights.size(); }
+    const PS_LIGHT_BUFFER& getLightData() const { return m_lightData; }
+
+    // Stats
+    UINT getNrOfClusterLightIndices() const { return m_clusterLightIndicesBuffer.getSize(); }
+    double getClusterTime() const { return m_clusterTime; }
 
     // Update
     bool addLight(Light newLight)
     {
-        if (m_lightData.nrOfLights >= LIGHT_CAP)
+        if (m_lights.size() >= LIGHT_CAP)
             return false;
-        m_lightData.lights[m_lightData.nrOfLights] = newLight;
-        m_lightData.nrOfLights++;
+        m_lights.push_back(newLight);
 
         return true;
     }
 
     void removeLight(int id)
     {
-        std::vector<Light> lights;
-        for (size_t i = 0; i < m_lightData.nrOfLights; i++)
-            lights.push_back(m_lightData.lights[i]);
-
-        m_lightData.nrOfLights--;
-        lights.erase(lights.begin() + id);
+        m_lights.erase(m_lights.begin() + id);
         /*if (m_lightData.lights[id].type == POINT_LIGHT || m_lightData.lights[id].type == SPOT_LIGHT)
         {
             for (size_t j = 0; j < m_renderObjects.size(); j++)
@@ -99,27 +114,22 @@ public:
             }
         }*/
 
-        for (size_t i = 0; i < m_lightData.nrOfLights; i++)
-        {
-            m_lightData.lights[i] = lights[i];
-        }
-
         update();
     }
 
     void updateLight(Light* light, int id)
     {
-        m_lightData.lights[id] = *light;
+        m_lights[id] = *light;
         update();
     }
 
     void enableLight(UINT index)
     {
-        m_lightData.lights[index].enabled = true;
+        m_lights[index].enabled = true;
     }
     void disableLight(UINT index)
     {
-        m_lightData.lights[index].enabled = false;
+        m_lights[index].enabled = false;
     }
 
     void enviormentDiffContributionUI()
@@ -155,8 +165,57 @@ public:
 
     void update()
     {
-        PS_LIGHT_BUFFER* lightData = new PS_LIGHT_BUFFER(m_lightData);
-        m_lightBuffer.update(&lightData);
+        m_lightBuffer.update(&m_lightData);
+    }
+
+    // Packs the enabled lights and bins the point and spot lights into the camera clusters, call once per frame before the light pass
+    void updateClusters()
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        m_packedLights.clear();
+        m_lightBounds.clear();
+        for (const Light& light : m_lights)
+        {
+            if (light.enabled && light.type == DIRECTIONAL_LIGHT)
+                m_packedLights.push_back(light);
+        }
+        UINT nrOfDirectionalLights = (UINT)m_packedLights.size();
+        for (const Light& light : m_lights)
+        {
+            if (!light.enabled)
+                continue;
+            if (light.type == POINT_LIGHT)
+                m_lightBounds.push_back(BoundingSphere(XMFLOAT3(light.position.x, light.position.y, light.position.z), light.range));
+            else if (light.type == SPOT_LIGHT)
+                m_lightBounds.push_back(LightClusters::getSpotLightBounds(XMFLOAT3(light.position.x, light.position.y, light.position.z), light.direction, light.range, light.spotAngles.y));
+            else
+                continue;
+            m_packedLights.push_back(light);
+        }
+
+        m_clusters.update(m_lightBounds, *m_viewMatrix, *m_projectionMatrix);
+
+        // Structured Buffers
+        m_lightsBuffer.update(m_packedLights.data(), (UINT)m_packedLights.size());
+        m_clusterRangesBuffer.update(m_clusters.getRanges().data(), CLUSTER_COUNT);
+        m_clusterLightIndicesBuffer.update(m_clusters.getLightIndices().data(), (UINT)m_clusters.getLightIndices().size());
+
+        // Constant Buffer
+        m_lightData.nrOfLights = (UINT)m_packedLights.size();
+        m_lightData.nrOfDirectionalLights = nrOfDirectionalLights;
+        m_lightData.clusterSliceScale = m_clusters.getSliceScale();
+        m_lightData.clusterSliceBias = m_clusters.getSliceBias();
+        update();
+
+        m_clusterTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    // Lights, Cluster Ranges and Cluster Light Indices in consecutive pixel shader slots
+    void bindClusters(UINT startSlot)
+    {
+        ID3D11ShaderResourceView* clusterSRVs[] = { m_lightsBuffer.getSRV(), m_clusterRangesBuffer.getSRV(), m_clusterLightIndicesBuffer.getSRV() };
+        m_deviceContext->PSSetShaderResources(startSlot, 3, clusterSRVs);
     }
 
     void renderLightIndicators()
@@ -175,12 +234,12 @@ public:
         //    m_renderObjects[i].second->updateWCPBuffer(worldMatrix, viewProjMatrix);
         //    m_renderObjects[i].second->render();
         //}
-        for (size_t i = 0; i < m_lightData.nrOfLights; i++)
+        for (size_t i = 0; i < m_lights.size(); i++)
         {
-            if (m_lightData.lights[i].type == POINT_LIGHT)
+            if (m_lights[i].type == POINT_LIGHT)
             {
                 PS_MATERIAL_BUFFER material;
-                XMFLOAT4 col = XMFLOAT4(m_lightData.lights[i].color.x * 4.f, m_lightData.lights[i].color.y * 4.f, m_lightData.lights[i].color.z * 4.f, 1.f);
+                XMFLOAT4 col = XMFLOAT4(m_lights[i].color.x * 4.f, m_lights[i].color.y * 4.f, m_lights[i].color.z * 4.f, 1.f);
                 material.ambient = col;
                 material.diffuse = col;
                 material.specular = XMFLOAT4(0,0,0,0);
@@ -189,15 +248,15 @@ public:
 
                 XMMATRIX worldMatrix = XMMatrixScaling(.03f, .03f, .03f);
 
-                worldMatrix *= XMMATRIX(XMMatrixTranslationFromVector(XMLoadFloat4(&m_lightData.lights[i].position)));
+                worldMatrix *= XMMATRIX(XMMatrixTranslationFromVector(XMLoadFloat4(&m_lights[i].position)));
 
                 m_renderObjects[POINT_MESH].updateWCPBuffer(worldMatrix, viewMatrix, projMatrix);
                 m_renderObjects[POINT_MESH].render(true);
             }
-            else if (m_lightData.lights[i].type == SPOT_LIGHT)
+            else if (m_lights[i].type == SPOT_LIGHT)
             {
                 PS_MATERIAL_BUFFER material;
-                XMFLOAT4 col = XMFLOAT4(m_lightData.lights[i].color.x * 4.f, m_lightData.lights[i].color.y * 4.f, m_lightData.lights[i].color.z * 4.f, 1.f);
+                XMFLOAT4 col = XMFLOAT4(m_lights[i].color.x * 4.f, m_lights[i].color.y * 4.f, m_lights[i].color.z * 4.f, 1.f);
                 material.ambient = col;
                 material.diffuse = col;
                 material.specular = XMFLOAT4(0,0,0,0);
@@ -205,16 +264,16 @@ public:
                 m_renderObjects[SPOT_MESH].setMaterial(material);
 
                 XMMATRIX worldMatrix = XMMatrixIdentity();
-                worldMatrix *= lookAtMatrix(XMLoadFloat4(&m_lightData.lights[i].position), XMVector3Normalize(XMVectorSetW(XMLoadFloat3(&m_lightData.lights[i].direction), 0.f)), XMVectorSet(0,1,0,0));
+                worldMatrix *= lookAtMatrix(XMLoadFloat4(&m_lights[i].position), XMVector3Normalize(XMVectorSetW(XMLoadFloat3(&m_lights[i].direction), 0.f)), XMVectorSet(0,1,0,0));
                 
                 m_renderObjects[SPOT_MESH].updateWCPBuffer(worldMatrix, viewMatrix, projMatrix);
                 m_renderObjects[SPOT_MESH].render(true);
             }
-            else if (m_lightData.lights[i].type == DIRECTIONAL_LIGHT)
+            else if (m_lights[i].type == DIRECTIONAL_LIGHT)
             {
                 /*float colorScale = 6.f;
                 PS_MATERIAL_BUFFER material;
-                XMFLOAT4 col = XMFLOAT4(m_lightData.lights[i].color.x * colorScale, m_lightData.lights[i].color.y * colorScale, m_lightData.lights[i].color.z * colorScale, 1.f);
+                XMFLOAT4 col = XMFLOAT4(m_lights[i].color.x * colorScale, m_lights[i].color.y * colorScale, m_lights[i].color.z * colorScale, 1.f);
                 material.ambient = col;
                 material.diffuse = col;
                 material.specular = col;
@@ -222,10 +281,10 @@ public:
                 m_renderObjects[SPOT_MESH].setMaterial(material);
 
                 XMVECTOR position = XMVectorSet(0,0,0,1);
-                XMVECTOR newPos = (-2.f * 50.f * XMLoadFloat4(&m_lightData.lights[i].direction)) + position;
+                XMVECTOR newPos = (-2.f * 50.f * XMLoadFloat4(&m_lights[i].direction)) + position;
 
                 XMMATRIX worldMatrix = XMMatrixScaling(2.f, 2.f, 2.f);
-                worldMatrix *= lookAtMatrix(newPos, XMVector3Normalize(XMVectorSetW(XMLoadFloat4(&m_lightData.lights[i].direction), 0.f)), XMVectorSet(0, 1, 0, 0));
+                worldMatrix *= lookAtMatrix(newPos, XMVector3Normalize(XMVectorSetW(XMLoadFloat4(&m_lights[i].direction), 0.f)), XMVectorSet(0, 1, 0, 0));
 
                 m_renderObjects[SPOT_MESH].updateWCPBuffer(worldMatrix, viewMatrix, projMatrix);
                 m_renderObjects[SPOT_MESH].render(true);*/
@@ -0,0 +1,77 @@
+#ifndef LODSELECTOR_H
+#define LODSELECTOR_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Screen size LOD selection, an object draws the coarsest LOD whose simplification error covers at most LOD_MAX_PIXEL_ERROR
+// pixels. LOD errors are relative to the bounding sphere radius, so the error in pixels is the error times the projected radius.
+// A coarser LOD is picked once its error is below the limit by LOD_HYSTERESIS and a finer one once the current error is above
+// it by as much, objects sitting on a boundary keep their LOD instead of switching every frame
+
+const unsigned int MAX_MESH_LODS = 4; // LOD 0 included
+const float LOD_MAX_PIXEL_ERROR = 1.f;
+const float LOD_HYSTERESIS = 0.25f;
+
+// Index range of one LOD inside the index buffer of its mesh, LOD 0 first
+struct MeshLod
+{
+	unsigned int indexOffset = 0;
+	unsigned int indexCount = 0;
+	float error = 0.f; // Relative to half the diagonal of the mesh bounds
+};
+
+struct LodStats
+{
+	unsigned int nrOfObjects[MAX_MESH_LODS] = {};
+	unsigned int nrOfTriangles = 0; // Selected LODs
+	unsigned int nrOfFullTriangles = 0; // Everything at LOD 0
+	unsigned int nrOfSwitches = 0;
+};
+
+struct LodSelectorBenchmarkResult
+{
+	unsigned int nrOfObjects = 0;
+	unsigned int nrOfFrames = 0;
+	unsigned int nrOfObjectsPerLod[MAX_MESH_LODS] = {}; // Last frame
+	unsigned int nrOfSwitches = 0;
+	unsigned int nrOfSwitchesWithoutHysteresis = 0;
+	double selectTime = 0.0; // Milliseconds per frame
+};
+
+class LodSelector
+{
+public:
+	// Bounding sphere radius on screen in pixels, projectionScale is the y scale of the projection matrix, 1 / tan(fovY / 2).
+	// A camera inside the sphere sees it as infinitely large
+	static float getProjectedRadius(float radius, float distance, float projectionScale, float screenHeight)
+	{
+		if (distance <= radius)
+			return std::numeric_limits<float>::max();
+		return radius * projectionScale * 0.5f * screenHeight / distance;
+	}
+
+	// lodErrors rise with the LOD, the error of LOD 0 is 0
+	static unsigned int selectLod(float projectedRadius, const float* lodErrors, unsigned int nrOfLods, unsigned int currentLod,
+		float maxPixelError = LOD_MAX_PIXEL_ERROR, float hysteresis = LOD_HYSTERESIS)
+	{
+		if (nrOfLods == 0)
+			return 0;
+
+		unsigned int lod = std::min(currentLod, nrOfLods - 1);
+		while (lod > 0 && lodErrors[lod] * projectedRadius > maxPixelError * (1.f + hysteresis))
+			lod--;
+		while (lod + 1 < nrOfLods && lodErrors[lod + 1] * projectedRadius < maxPixelError * (1.f - hysteresis))
+			lod++;
+		return lod;
+	}
+
+	// Test and Benchmark, in LodSelectorTests.cpp
+	static unsigned int test();
+
+	static LodSelectorBenchmarkResult benchmark(unsigned int nrOfObjects = 100000, unsigned int nrOfFrames = 100);
+};
+
+#endif // !LODSELECTOR_H
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "LodSelector.h"
+#include <chrono>
+#include <random>
+
+// Test
+unsigned int LodSelector::test()
+{
+	unsigned int errors = 0;
+	const float lodErrors[MAX_MESH_LODS] = { 0.f, 0.001f, 0.004f, 0.016f };
+
+	// Shrinking objects only ever get coarser and growing ones finer, LOD 1 starts below 750 pixels and ends above 1250
+	unsigned int lod = 0;
+	unsigned int switchDown = 0, switchUp = 0;
+	for (float radius = 10000.f; radius > 1.f; radius *= 0.99f)
+	{
+		unsigned int nextLod = selectLod(radius, lodErrors, MAX_MESH_LODS, lod);
+		errors += nextLod < lod;
+		if (lod == 0 && nextLod == 1)
+			switchDown = (unsigned int)radius;
+		lod = nextLod;
+	}
+	errors += lod != MAX_MESH_LODS - 1;
+	for (float radius = 1.f; radius < 10000.f; radius *= 1.01f)
+	{
+		unsigned int nextLod = selectLod(radius, lodErrors, MAX_MESH_LODS, lod);
+		errors += nextLod > lod;
+		if (lod == 1 && nextLod == 0)
+			switchUp = (unsigned int)radius;
+		lod = nextLod;
+	}
+	errors += lod != 0;
+	errors += switchDown > 750 || switchDown < 740;
+	errors += switchUp < 1250 || switchUp > 1265;
+
+	// Hysteresis, a radius jittering around a boundary keeps the LOD it has
+	for (unsigned int start = 0; start < 2; start++)
+	{
+		lod = start;
+		for (int frame = 0; frame < 100; frame++)
+			lod = selectLod(frame % 2 ? 990.f : 1010.f, lodErrors, MAX_MESH_LODS, lod);
+		errors += lod != start;
+	}
+
+	// Without hysteresis the boundary is exact
+	errors += selectLod(990.f, lodErrors, MAX_MESH_LODS, 0, 1.f, 0.f) != 1;
+	errors += selectLod(1010.f, lodErrors, MAX_MESH_LODS, 1, 1.f, 0.f) != 0;
+
+	// Jumps skip every LOD in between, out of range LODs are clamped
+	errors += selectLod(std::numeric_limits<float>::max(), lodErrors, MAX_MESH_LODS, MAX_MESH_LODS - 1) != 0;
+	errors += selectLod(0.f, lodErrors, MAX_MESH_LODS, 0) != MAX_MESH_LODS - 1;
+	errors += selectLod(0.f, lodErrors, 2, 3) != 1;
+	errors += selectLod(0.f, lodErrors, 1, 0) != 0;
+	errors += selectLod(0.f, lodErrors, 0, 0) != 0;
+
+	// Perfect LODs are always taken
+	const float exactErrors[2] = { 0.f, 0.f };
+	errors += selectLod(1.0e6f, exactErrors, 2, 0) != 1;
+
+	// Projection, the radius halves with twice the distance and is unbounded inside the sphere
+	float nearRadius = getProjectedRadius(1.f, 10.f, 1.f, 1000.f);
+	float farRadius = getProjectedRadius(1.f, 20.f, 1.f, 1000.f);
+	errors += std::fabs(nearRadius - 50.f) > 0.001f || std::fabs(farRadius - 25.f) > 0.001f;
+	errors += getProjectedRadius(1.f, 0.5f, 1.f, 1000.f) != std::numeric_limits<float>::max();
+
+	return errors;
+}
+
+// Benchmark, objects at random distances in front of a camera moving back and forth, switches are counted with and
+// without hysteresis
+LodSelectorBenchmarkResult LodSelector::benchmark(unsigned int nrOfObjects, unsigned int nrOfFrames)
+{
+	const float lodErrors[MAX_MESH_LODS] = { 0.f, 0.002f, 0.008f, 0.03f };
+	const float projectionScale = 1.f / std::tan(0.785398f * 0.5f);
+	const float screenHeight = 1080.f;
+
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> distanceDistribution(1.f, 500.f);
+	std::uniform_real_distribution<float> radiusDistribution(0.5f, 4.f);
+	std::vector<float> distances(nrOfObjects), radii(nrOfObjects);
+	for (unsigned int i = 0; i < nrOfObjects; i++)
+	{
+		distances[i] = distanceDistribution(generator);
+		radii[i] = radiusDistribution(generator);
+	}
+
+	LodSelectorBenchmarkResult result;
+	result.nrOfObjects = nrOfObjects;
+	result.nrOfFrames = nrOfFrames;
+	std::vector<unsigned int> lods(nrOfObjects, 0), exactLods(nrOfObjects, 0);
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		// Camera sways half a unit
+		float offset = frame % 2 ? 0.5f : -0.5f;
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < nrOfObjects; i++)
+		{
+			float projectedRadius = getProjectedRadius(radii[i], distances[i] + offset, projectionScale, screenHeight);
+			unsigned int lod = selectLod(projectedRadius, lodErrors, MAX_MESH_LODS, lods[i]);
+			result.nrOfSwitches += frame > 0 && lod != lods[i];
+			lods[i] = lod;
+		}
+		result.selectTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		for (unsigned int i = 0; i < nrOfObjects; i++)
+		{
+			float projectedRadius = getProjectedRadius(radii[i], distances[i] + offset, projectionScale, screenHeight);
+			unsigned int lod = selectLod(projectedRadius, lodErrors, MAX_MESH_LODS, exactLods[i], LOD_MAX_PIXEL_ERROR, 0.f);
+			result.nrOfSwitchesWithoutHysteresis += frame > 0 && lod != exactLods[i];
+			exactLods[i] = lod;
+		}
+	}
+	if (nrOfFrames)
+		result.selectTime /= nrOfFrames;
+
+	for (unsigned int lod : lods)
+		result.nrOfObjectsPerLod[lod]++;
+
+	return result;
+}
+
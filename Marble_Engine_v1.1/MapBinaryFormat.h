@@ -0,0 +1,148 @@
+#ifndef MAPBINARYFORMAT_H
+#define MAPBINARYFORMAT_H
+
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "MapFileStructs.h"
+
+// Binary Map Layout
+// [MapBinaryHeader][MapBinaryGameObject * n][MapBinaryMesh * n][MapBinaryLight * n][String Table]
+// All records are fixed size so the file can be read straight from a mapped view.
+
+const char MAP_BINARY_MAGIC[4] = { 'M', 'B', 'M', 'P' };
+const UINT MAP_BINARY_VERSION = 1;
+const std::string MAP_BINARY_EXTENSION = ".mbin";
+
+// Reference into the string table, length is in characters (char or wchar_t depending on the field)
+struct MapBinaryString
+{
+	UINT offset = 0;
+	UINT length = 0;
+};
+
+struct MapBinaryHeader
+{
+	char magic[4] = { MAP_BINARY_MAGIC[0], MAP_BINARY_MAGIC[1], MAP_BINARY_MAGIC[2], MAP_BINARY_MAGIC[3] };
+	UINT version = MAP_BINARY_VERSION;
+	UINT fileSize = 0;
+
+	UINT nrOfGameObjects = 0;
+	UINT nrOfMeshes = 0;
+	UINT nrOfLights = 0;
+	UINT stringTableSize = 0; // Bytes
+
+	UINT gameObjectsOffset = 0;
+	UINT meshesOffset = 0;
+	UINT lightsOffset = 0;
+	UINT stringTableOffset = 0;
+};
+
+struct MapBinaryGameObject
+{
+	MapBinaryString modelFile; // char
+	UINT shaderType = 0;
+	DirectX::XMFLOAT3 scale;
+	DirectX::XMFLOAT3 rotation;
+	DirectX::XMFLOAT3 position;
+	UINT firstMesh = 0;
+	UINT nrOfMeshes = 0;
+};
+
+struct MapBinaryMesh
+{
+	MapBinaryString name; // char
+	UINT matType = 0;
+
+	// Phong, paths are wchar_t
+	MapBinaryString phDiffusePath;
+	MapBinaryString phSpecularPath;
+	MapBinaryString phNormalPath;
+	MapBinaryString phDisplacementPath;
+	DirectX::XMFLOAT4 phEmissive;
+	DirectX::XMFLOAT4 phAmbient;
+	DirectX::XMFLOAT4 phDiffuse;
+	DirectX::XMFLOAT4 phSpecular;
+	float phShininess = 0.f;
+	BOOL phDiffTextureExists = FALSE;
+	BOOL phSpecTextureExists = FALSE;
+	BOOL phNormTextureExists = FALSE;
+
+	// PBR, paths are wchar_t
+	MapBinaryString pbAlbedoPath;
+	MapBinaryString pbNormalPath;
+	MapBinaryString pbMetallicPath;
+	MapBinaryString pbRoughnessPath;
+	MapBinaryString pbEmissivePath;
+	MapBinaryString pbAmbientOcclusionPath;
+	MapBinaryString pbDisplacementPath;
+	DirectX::XMFLOAT3 pbAlbedo;
+	float pbMetallic = 0.f;
+	float pbRoughness = 0.f;
+	float pbEmissiveStrength = 0.f;
+	BOOL pbMaterialTextured = FALSE;
+	BOOL pbEmissiveTextured = FALSE;
+};
+
+// Mirrors the fields written to the text format, Light::spotAngles is derived on load
+struct MapBinaryLight
+{
+	DirectX::XMFLOAT4 position;
+	DirectX::XMFLOAT3 direction;
+	float intensity = 0.f;
+	DirectX::XMFLOAT3 color;
+	float range = 0.f;
+	DirectX::XMFLOAT2 spotAngles; // LightHelper::spotAngles
+	int type = 0;
+	BOOL enabled = FALSE;
+	DirectX::XMFLOAT3 rotationDeg;
+};
+
+// Builds a deduplicated string table, wide strings are kept 2 byte aligned
+class MapBinaryStringTable
+{
+private:
+	std::vector<char> m_data;
+	std::map<std::string, MapBinaryString> m_strings;
+	std::map<std::wstring, MapBinaryString> m_wideStrings;
+
+public:
+	MapBinaryString add(const std::string& str)
+	{
+		auto it = m_strings.find(str);
+		if (it != m_strings.end())
+			return it->second;
+
+		MapBinaryString ref;
+		ref.offset = (UINT)m_data.size();
+		ref.length = (UINT)str.size();
+		m_data.insert(m_data.end(), str.begin(), str.end());
+		m_strings[str] = ref;
+
+		return ref;
+	}
+
+	MapBinaryString add(const std::wstring& str)
+	{
+		auto it = m_wideStrings.find(str);
+		if (it != m_wideStrings.end())
+			return it->second;
+
+		if (m_data.size() % sizeof(wchar_t) != 0)
+			m_data.push_back('\0');
+
+		MapBinaryString ref;
+		ref.offset = (UINT)m_data.size();
+		ref.length = (UINT)str.size();
+		const char* bytes = (const char*)str.data();
+		m_data.insert(m_data.end(), bytes, bytes + str.size() * sizeof(wchar_t));
+		m_wideStrings[str] = ref;
+
+		return ref;
+	}
+
+	const std::vector<char>& getData() const { return m_data; }
+};
+
+#endif // !MAPBINARYFORMAT_H
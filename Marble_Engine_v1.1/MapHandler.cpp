@@ -36,18 +36,30 @@ void MapHandler::dumpDataToFile()
 				{
 				case PHONG:
 				{
-					// Texture Paths
-					nameCStr = m_gameObjectData[i].meshes[j].matPhong.diffusePath.c_str();
-					m_file << MAT_DIFF_PATH_PREFIX << " " << nameCStr << "\n";
+					// Texture Paths, empty paths are left out since they would be read back as the previous token
+					if (!m_gameObjectData[i].meshes[j].matPhong.diffusePath.empty())
+					{
+						nameCStr = m_gameObjectData[i].meshes[j].matPhong.diffusePath.c_str();
+						m_file << MAT_DIFF_PATH_PREFIX << " " << nameCStr << "\n";
+					}
 
-					nameCStr = m_gameObjectData[i].meshes[j].matPhong.specularPath.c_str();
-					m_file << PH_SPEC_PATH_PREFIX << " " << nameCStr << "\n";
+					if (!m_gameObjectData[i].meshes[j].matPhong.specularPath.empty())
+					{
+						nameCStr = m_gameObjectData[i].meshes[j].matPhong.specularPath.c_str();
+						m_file << PH_SPEC_PATH_PREFIX << " " << nameCStr << "\n";
+					}
 
-					nameCStr = m_gameObjectData[i].meshes[j].matPhong.normalPath.c_str();
-					m_file << MAT_NORM_PATH_PREFIX << " " << nameCStr << "\n";
+					if (!m_gameObjectData[i].meshes[j].matPhong.normalPath.empty())
+					{
+						nameCStr = m_gameObjectData[i].meshes[j].matPhong.normalPath.c_str();
+						m_file << MAT_NORM_PATH_PREFIX << " " << nameCStr << "\n";
+					}
 
-					nameCStr = m_gameObjectData[i].meshes[j].matPhong.displacementPath.c_str();
-					m_file << MAT_DISP_PATH_PREFIX << " " << nameCStr << "\n";
+					if (!m_gameObjectData[i].meshes[j].matPhong.displacementPath.empty())
+					{
+						nameCStr = m_gameObjectData[i].meshes[j].matPhong.displacementPath.c_str();
+						m_file << MAT_DISP_PATH_PREFIX << " " << nameCStr << "\n";
+					}
 
 					// Colors
 					tempStr = f4ToString(m_gameObjectData[i].meshes[j].matPhong.emissive, " ");
@@ -176,9 +188,397 @@ void MapHandler::dumpDataToFile()
 	}
 }
 
+std::string MapHandler::getBinaryMapFileName() const
+{
+	size_t extensionStart = m_mapFileName.find_last_of('.');
+	return m_mapFileName.substr(0, extensionStart) + MAP_BINARY_EXTENSION;
+}
+
+bool MapHandler::isBinaryMapUpToDate() const
+{
+	WIN32_FILE_ATTRIBUTE_DATA binaryAttributes;
+	WIN32_FILE_ATTRIBUTE_DATA textAttributes;
+
+	if (!GetFileAttributesExA(("Maps\\" + getBinaryMapFileName()).c_str(), GetFileExInfoStandard, &binaryAttributes))
+		return false;
+
+	if (!GetFileAttributesExA(("Maps\\" + m_mapFileName).c_str(), GetFileExInfoStandard, &textAttributes))
+		return true;
+
+	return CompareFileTime(&binaryAttributes.ftLastWriteTime, &textAttributes.ftLastWriteTime) >= 0;
+}
+
+bool MapHandler::readBinaryFile(const std::string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool result = false;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(MapBinaryHeader))
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+		{
+			const char* view = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view)
+			{
+				result = readBinaryData(view, (size_t)fileSize.QuadPart);
+				UnmapViewOfFile(view);
+			}
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+
+	if (!result)
+	{
+		OutputDebugStringA("Error, invalid binary map file: ");
+		OutputDebugStringA(path.c_str());
+		OutputDebugStringA("\n");
+	}
+
+	return result;
+}
+
+bool MapHandler::readBinaryData(const char* data, size_t size)
+{
+	// Validate
+	const MapBinaryHeader* header = (const MapBinaryHeader*)data;
+	if (memcmp(header->magic, MAP_BINARY_MAGIC, sizeof(MAP_BINARY_MAGIC)) != 0 || header->version != MAP_BINARY_VERSION || header->fileSize != size)
+		return false;
+
+	if ((size_t)header->gameObjectsOffset + (size_t)header->nrOfGameObjects * sizeof(MapBinaryGameObject) > size ||
+		(size_t)header->meshesOffset + (size_t)header->nrOfMeshes * sizeof(MapBinaryMesh) > size ||
+		(size_t)header->lightsOffset + (size_t)header->nrOfLights * sizeof(MapBinaryLight) > size ||
+		(size_t)header->stringTableOffset + (size_t)header->stringTableSize > size)
+		return false;
+
+	const MapBinaryGameObject* gameObjects = (const MapBinaryGameObject*)(data + header->gameObjectsOffset);
+	const MapBinaryMesh* meshes = (const MapBinaryMesh*)(data + header->meshesOffset);
+	const MapBinaryLight* lights = (const MapBinaryLight*)(data + header->lightsOffset);
+	const char* stringTable = data + header->stringTableOffset;
+
+	bool validStrings = true;
+	auto getString = [&](const MapBinaryString& ref)
+	{
+		if ((size_t)ref.offset + ref.length > header->stringTableSize)
+		{
+			validStrings = false;
+			return std::string();
+		}
+		return std::string(stringTable + ref.offset, ref.length);
+	};
+	auto getWideString = [&](const MapBinaryString& ref)
+	{
+		if ((size_t)ref.offset + (size_t)ref.length * sizeof(wchar_t) > header->stringTableSize)
+		{
+			validStrings = false;
+			return std::wstring();
+		}
+		return std::wstring((const wchar_t*)(stringTable + ref.offset), ref.length);
+	};
+
+	// Game Objects
+	m_gameObjectData.clear();
+	m_gameObjectData.resize(header->nrOfGameObjects);
+	for (UINT i = 0; i < header->nrOfGameObjects; i++)
+	{
+		const MapBinaryGameObject& src = gameObjects[i];
+		GameObjectData& dst = m_gameObjectData[i];
+
+		if ((size_t)src.firstMesh + src.nrOfMeshes > header->nrOfMeshes)
+		{
+			m_gameObjectData.clear();
+			m_lightData.clear();
+			return false;
+		}
+
+		dst.modelFile = getString(src.modelFile);
+		dst.shaderType = (ShaderStates)src.shaderType;
+		dst.scale = src.scale;
+		dst.rotation = src.rotation;
+		dst.position = src.position;
+
+		// Meshes
+		dst.meshes.resize(src.nrOfMeshes);
+		for (UINT j = 0; j < src.nrOfMeshes; j++)
+		{
+			const MapBinaryMesh& srcMesh = meshes[src.firstMesh + j];
+			MeshData& dstMesh = dst.meshes[j];
+
+			dstMesh.name = getString(srcMesh.name);
+			dstMesh.matType = (ShaderStates)srcMesh.matType;
+
+			// Phong
+			dstMesh.matPhong.diffusePath = getWideString(srcMesh.phDiffusePath);
+			dstMesh.matPhong.specularPath = getWideString(srcMesh.phSpecularPath);
+			dstMesh.matPhong.normalPath = getWideString(srcMesh.phNormalPath);
+			dstMesh.matPhong.displacementPath = getWideString(srcMesh.phDisplacementPath);
+			dstMesh.matPhong.emissive = srcMesh.phEmissive;
+			dstMesh.matPhong.ambient = srcMesh.phAmbient;
+			dstMesh.matPhong.diffuse = srcMesh.phDiffuse;
+			dstMesh.matPhong.specular = srcMesh.phSpecular;
+			dstMesh.matPhong.shininess = srcMesh.phShininess;
+			dstMesh.matPhong.diffTextureExists = srcMesh.phDiffTextureExists;
+			dstMesh.matPhong.specTextureExists = srcMesh.phSpecTextureExists;
+			dstMesh.matPhong.normTextureExists = srcMesh.phNormTextureExists;
+
+			// PBR
+			dstMesh.matPBR.albedoPath = getWideString(srcMesh.pbAlbedoPath);
+			dstMesh.matPBR.normalPath = getWideString(srcMesh.pbNormalPath);
+			dstMesh.matPBR.metallicPath = getWideString(srcMesh.pbMetallicPath);
+			dstMesh.matPBR.roughnessPath = getWideString(srcMesh.pbRoughnessPath);
+			dstMesh.matPBR.emissivePath = getWideString(srcMesh.pbEmissivePath);
+			dstMesh.matPBR.ambientOcclusionPath = getWideString(srcMesh.pbAmbientOcclusionPath);
+			dstMesh.matPBR.displacementPath = getWideString(srcMesh.pbDisplacementPath);
+			dstMesh.matPBR.albedo = srcMesh.pbAlbedo;
+			dstMesh.matPBR.metallic = srcMesh.pbMetallic;
+			dstMesh.matPBR.roughness = srcMesh.pbRoughness;
+			dstMesh.matPBR.emissiveStrength = srcMesh.pbEmissiveStrength;
+			dstMesh.matPBR.materialTextured = srcMesh.pbMaterialTextured != FALSE;
+			dstMesh.matPBR.emissiveTextured = srcMesh.pbEmissiveTextured != FALSE;
+		}
+	}
+
+	// Lights
+	m_lightData.clear();
+	m_lightData.resize(header->nrOfLights);
+	for (UINT i = 0; i < header->nrOfLights; i++)
+	{
+		const MapBinaryLight& src = lights[i];
+		Light& light = m_lightData[i].first;
+		LightHelper& lightHelper = m_lightData[i].second;
+
+		light.position = src.position;
+		light.direction = src.direction;
+		light.intensity = src.intensity;
+		light.color = src.color;
+		light.range = src.range;
+		light.type = src.type;
+		light.enabled = src.enabled;
+		lightHelper.spotAngles = src.spotAngles;
+		lightHelper.rotationDeg = src.rotationDeg;
+		light.spotAngles.x = 1.f / (cosf(lightHelper.spotAngles.x) - cosf(lightHelper.spotAngles.y));
+		light.spotAngles.y = cosf(lightHelper.spotAngles.y);
+	}
+
+	if (!validStrings)
+	{
+		m_gameObjectData.clear();
+		m_lightData.clear();
+	}
+
+	return validStrings;
+}
+
+std::vector<char> MapHandler::getBinaryData() const
+{
+	MapBinaryStringTable stringTable;
+	std::vector<MapBinaryGameObject> gameObjects(m_gameObjectData.size());
+	std::vector<MapBinaryMesh> meshes;
+	std::vector<MapBinaryLight> lights(m_lightData.size());
+
+	// Game Objects
+	for (size_t i = 0; i < m_gameObjectData.size(); i++)
+	{
+		const GameObjectData& src = m_gameObjectData[i];
+		MapBinaryGameObject& dst = gameObjects[i];
+
+		dst.modelFile = stringTable.add(src.modelFile);
+		dst.shaderType = (UINT)src.shaderType;
+		dst.scale = src.scale;
+		dst.rotation = src.rotation;
+		dst.position = src.position;
+		dst.firstMesh = (UINT)meshes.size();
+		dst.nrOfMeshes = (UINT)src.meshes.size();
+
+		// Meshes
+		for (size_t j = 0; j < src.meshes.size(); j++)
+		{
+			const MeshData& srcMesh = src.meshes[j];
+			meshes.emplace_back();
+			MapBinaryMesh& dstMesh = meshes.back();
+
+			dstMesh.name = stringTable.add(srcMesh.name);
+			dstMesh.matType = (UINT)srcMesh.matType;
+
+			// Phong
+			dstMesh.phDiffusePath = stringTable.add(srcMesh.matPhong.diffusePath);
+			dstMesh.phSpecularPath = stringTable.add(srcMesh.matPhong.specularPath);
+			dstMesh.phNormalPath = stringTable.add(srcMesh.matPhong.normalPath);
+			dstMesh.phDisplacementPath = stringTable.add(srcMesh.matPhong.displacementPath);
+			dstMesh.phEmissive = srcMesh.matPhong.emissive;
+			dstMesh.phAmbient = srcMesh.matPhong.ambient;
+			dstMesh.phDiffuse = srcMesh.matPhong.diffuse;
+			dstMesh.phSpecular = srcMesh.matPhong.specular;
+			dstMesh.phShininess = srcMesh.matPhong.shininess;
+			dstMesh.phDiffTextureExists = srcMesh.matPhong.diffTextureExists;
+			dstMesh.phSpecTextureExists = srcMesh.matPhong.specTextureExists;
+			dstMesh.phNormTextureExists = srcMesh.matPhong.normTextureExists;
+
+			// PBR
+			dstMesh.pbAlbedoPath = stringTable.add(srcMesh.matPBR.albedoPath);
+			dstMesh.pbNormalPath = stringTable.add(srcMesh.matPBR.normalPath);
+			dstMesh.pbMetallicPath = stringTable.add(srcMesh.matPBR.metallicPath);
+			dstMesh.pbRoughnessPath = stringTable.add(srcMesh.matPBR.roughnessPath);
+			dstMesh.pbEmissivePath = stringTable.add(srcMesh.matPBR.emissivePath);
+			dstMesh.pbAmbientOcclusionPath = stringTable.add(srcMesh.matPBR.ambientOcclusionPath);
+			dstMesh.pbDisplacementPath = stringTable.add(srcMesh.matPBR.displacementPath);
+			dstMesh.pbAlbedo = srcMesh.matPBR.albedo;
+			dstMesh.pbMetallic = srcMesh.matPBR.metallic;
+			dstMesh.pbRoughness = srcMesh.matPBR.roughness;
+			dstMesh.pbEmissiveStrength = srcMesh.matPBR.emissiveStrength;
+			dstMesh.pbMaterialTextured = srcMesh.matPBR.materialTextured;
+			dstMesh.pbEmissiveTextured = srcMesh.matPBR.emissiveTextured;
+		}
+	}
+
+	// Lights
+	for (size_t i = 0; i < m_lightData.size(); i++)
+	{
+		const Light& light = m_lightData[i].first;
+		const LightHelper& lightHelper = m_lightData[i].second;
+		MapBinaryLight& dst = lights[i];
+
+		dst.position = light.position;
+		dst.direction = light.direction;
+		dst.intensity = light.intensity;
+		dst.color = light.color;
+		dst.range = light.range;
+		dst.type = light.type;
+		dst.enabled = light.enabled;
+		dst.spotAngles = lightHelper.spotAngles;
+		dst.rotationDeg = lightHelper.rotationDeg;
+	}
+
+	// Header
+	const std::vector<char>& stringData = stringTable.getData();
+	MapBinaryHeader header;
+	header.nrOfGameObjects = (UINT)gameObjects.size();
+	header.nrOfMeshes = (UINT)meshes.size();
+	header.nrOfLights = (UINT)lights.size();
+	header.stringTableSize = (UINT)stringData.size();
+	header.gameObjectsOffset = sizeof(MapBinaryHeader);
+	header.meshesOffset = header.gameObjectsOffset + header.nrOfGameObjects * sizeof(MapBinaryGameObject);
+	header.lightsOffset = header.meshesOffset + header.nrOfMeshes * sizeof(MapBinaryMesh);
+	header.stringTableOffset = header.lightsOffset + header.nrOfLights * sizeof(MapBinaryLight);
+	header.fileSize = header.stringTableOffset + header.stringTableSize;
+
+	std::vector<char> data(header.fileSize);
+	memcpy(data.data(), &header, sizeof(MapBinaryHeader));
+	memcpy(data.data() + header.gameObjectsOffset, gameObjects.data(), gameObjects.size() * sizeof(MapBinaryGameObject));
+	memcpy(data.data() + header.meshesOffset, meshes.data(), meshes.size() * sizeof(MapBinaryMesh));
+	memcpy(data.data() + header.lightsOffset, lights.data(), lights.size() * sizeof(MapBinaryLight));
+	memcpy(data.data() + header.stringTableOffset, stringData.data(), stringData.size());
+
+	return data;
+}
+
+bool MapHandler::writeBinaryFile(const std::string& path) const
+{
+	std::ofstream binaryFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!binaryFile.is_open())
+	{
+		OutputDebugStringA("Error, could not write binary map file: ");
+		OutputDebugStringA(path.c_str());
+		OutputDebugStringA("\n");
+		return false;
+	}
+
+	std::vector<char> data = getBinaryData();
+	binaryFile.write(data.data(), data.size());
+	binaryFile.close();
+
+	return !binaryFile.fail();
+}
+
+bool MapHandler::convertTextToBinary(std::string textMapFileName)
+{
+	MapHandler mapHandler;
+	mapHandler.m_mapFileName = textMapFileName;
+	if (!mapHandler.readTextFile(false))
+		return false;
+
+	return mapHandler.writeBinaryFile("Maps\\" + mapHandler.getBinaryMapFileName());
+}
+
+bool MapHandler::convertBinaryToText(std::string binaryMapFileName, std::string textMapFileName)
+{
+	MapHandler mapHandler;
+	mapHandler.m_mapFileName = textMapFileName;
+	if (!mapHandler.readBinaryFile("Maps\\" + binaryMapFileName))
+		return false;
+
+	mapHandler.dumpDataToFile();
+
+	return true;
+}
+
+MapBenchmarkResult MapHandler::benchmark(std::string textMapFileName, unsigned int nrOfLoads)
+{
+	MapBenchmarkResult result;
+	if (!convertTextToBinary(textMapFileName))
+		return result;
+
+	// Loads, the last load of each format is kept for the comparison
+	MapHandler textMap;
+	MapHandler binaryMap;
+	textMap.m_mapFileName = textMapFileName;
+	Timer loadTimer;
+	for (unsigned int i = 0; i < nrOfLoads; i++)
+	{
+		textMap.m_gameObjectData.clear();
+		textMap.m_lightData.clear();
+		loadTimer.start();
+		textMap.readTextFile(false);
+		loadTimer.stop();
+		result.textLoadTime += loadTimer.timeElapsed() * 1000.0;
+	}
+	std::string binaryMapFileName = textMap.getBinaryMapFileName();
+	for (unsigned int i = 0; i < nrOfLoads; i++)
+	{
+		loadTimer.start();
+		binaryMap.readBinaryFile("Maps\\" + binaryMapFileName);
+		loadTimer.stop();
+		result.binaryLoadTime += loadTimer.timeElapsed() * 1000.0;
+	}
+	if (nrOfLoads)
+	{
+		result.textLoadTime /= nrOfLoads;
+		result.binaryLoadTime /= nrOfLoads;
+	}
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExA(("Maps\\" + textMapFileName).c_str(), GetFileExInfoStandard, &attributes))
+		result.textBytes = attributes.nFileSizeLow;
+	if (GetFileAttributesExA(("Maps\\" + binaryMapFileName).c_str(), GetFileExInfoStandard, &attributes))
+		result.binaryBytes = attributes.nFileSizeLow;
+
+	// Round Trip, binary back to text and parsed again, every stage is compared through its binary image
+	std::string roundTripFileName = textMapFileName.substr(0, textMapFileName.find_last_of('.')) + "_roundtrip.txt";
+	MapHandler roundTripMap;
+	roundTripMap.m_mapFileName = roundTripFileName;
+	if (convertBinaryToText(binaryMapFileName, roundTripFileName))
+		roundTripMap.readTextFile(false);
+	DeleteFileA(("Maps\\" + roundTripFileName).c_str());
+
+	std::vector<char> textData = textMap.getBinaryData();
+	std::vector<char> binaryData = binaryMap.getBinaryData();
+	result.nrOfGameObjects = (unsigned int)textMap.m_gameObjectData.size();
+	result.nrOfLights = (unsigned int)textMap.m_lightData.size();
+	result.mismatches = (textData != binaryData ? 1 : 0) + (binaryData != roundTripMap.getBinaryData() ? 1 : 0);
+	result.converted = true;
+
+	return result;
+}
+
 MapHandler::MapHandler()
 {
 	m_nrOfDifference = 0;
+	m_loadedFromBinary = false;
+	m_loadTime = 0.0;
 }
 
 MapHandler::~MapHandler()
@@ -186,10 +586,9 @@ MapHandler::~MapHandler()
 	m_file.close();
 }
 
-void MapHandler::initialize(std::string mapFileName, int nrOfHardCodedGameObjects, bool createIfNotFound)
+bool MapHandler::readTextFile(bool createIfNotFound)
 {
-	m_mapFileName = mapFileName;
-	m_nrOfDifference = nrOfHardCodedGameObjects;
+	bool foundFile = false;
 	m_file.open("Maps\\" + m_mapFileName, std::ios::out | std::ios::in);
 
 	if (m_file.is_open()) // Found
@@ -197,6 +596,7 @@ void MapHandler::initialize(std::string mapFileName, int nrOfHardCodedGameObject
 		OutputDebugStringA("Map File opened: ");
 		OutputDebugStringA(m_mapFileName.c_str());
 		OutputDebugStringA("\n");
+		foundFile = true;
 
 		std::stringstream sStream;
 		std::string line = "";
@@ -292,7 +692,7 @@ void MapHandler::initialize(std::string mapFileName, int nrOfHardCodedGameObject
 								{
 									sStream >> tempStr;
 									tempCStr = tempStr.c_str();
-									m_gameObjectData.back().meshes[i].matPhong.normalPath = tempCStr;
+									m_gameObjectData.back().meshes[i].matPhong.displacementPath = tempCStr;
 								}
 								else if (prefix == PH_EMISSIVE_COL_PREFIX)
 								{
@@ -538,6 +938,36 @@ void MapHandler::initialize(std::string mapFileName, int nrOfHardCodedGameObject
 			OutputDebugStringA("\n");
 		}
 	}
+
+	return foundFile;
+}
+
+void MapHandler::initialize(std::string mapFileName, int nrOfHardCodedGameObjects, bool createIfNotFound)
+{
+	m_mapFileName = mapFileName;
+	m_nrOfDifference = nrOfHardCodedGameObjects;
+
+	Timer loadTimer;
+	loadTimer.start();
+
+	// Prefer the binary map when it is at least as new as the text map, otherwise parse the text and rebuild the binary
+	std::string binaryPath = "Maps\\" + getBinaryMapFileName();
+	m_loadedFromBinary = isBinaryMapUpToDate() && readBinaryFile(binaryPath);
+	if (!m_loadedFromBinary)
+	{
+		m_gameObjectData.clear();
+		m_lightData.clear();
+
+		if (readTextFile(createIfNotFound))
+			writeBinaryFile(binaryPath);
+	}
+
+	loadTimer.stop();
+	m_loadTime = loadTimer.timeElapsed() * 1000.0;
+
+	OutputDebugStringA(m_loadedFromBinary ? "Binary map loaded in " : "Text map loaded in ");
+	OutputDebugStringA(std::to_string(m_loadTime).c_str());
+	OutputDebugStringA(" ms\n");
 }
 
 void MapHandler::importGameObjects(std::vector<GameObject*>& gameObjects, std::vector<std::pair<Light, LightHelper>>& lights)
@@ -694,6 +1124,7 @@ void MapHandler::addGameObjectToFile(GameObject* gameObject)
 		}
 
 		m_file.close();
+		writeBinaryFile("Maps\\" + getBinaryMapFileName());
 
 		OutputDebugStringA("Game Object Added to Map File: ");
 		OutputDebugStringA(m_mapFileName.c_str());
@@ -713,6 +1144,7 @@ void MapHandler::removeGameObjectFromFile(int removedIndex, int gameObjectSize)
 	m_gameObjectData.erase(m_gameObjectData.begin() + removedIndex - sizeDifference);
 
 	dumpDataToFile();
+	writeBinaryFile("Maps\\" + getBinaryMapFileName());
 }
 
 void MapHandler::updateDataList(std::vector<GameObject*>& gameObjects, std::vector<std::pair<Light, LightHelper>>& lights)
@@ -732,4 +1164,5 @@ void MapHandler::updateDataList(std::vector<GameObject*>& gameObjects, std::vect
 	m_lightData = lights;
 
 	dumpDataToFile();
+	writeBinaryFile("Maps\\" + getBinaryMapFileName());
 }
@@ -2,6 +2,19 @@
 #define MAPHANDLER_H
 
 #include "GameObject.h"
+#include "MapBinaryFormat.h"
+
+struct MapBenchmarkResult
+{
+	bool converted = false;
+	unsigned int nrOfGameObjects = 0;
+	unsigned int nrOfLights = 0;
+	size_t textBytes = 0;
+	size_t binaryBytes = 0;
+	double textLoadTime = 0.0; // Average milliseconds per load
+	double binaryLoadTime = 0.0;
+	unsigned int mismatches = 0; // Text to binary and binary to text conversions that changed the map
+};
 
 class MapHandler
 {
@@ -12,8 +25,23 @@ private:
 	std::vector<std::pair<Light, LightHelper>> m_lightData;
 	int m_nrOfDifference;
 
+	// Load Stats
+	bool m_loadedFromBinary;
+	double m_loadTime;
+
+	std::string getBinaryMapFileName() const;
+	bool isBinaryMapUpToDate() const;
+
+	// Text Format
+	bool readTextFile(bool createIfNotFound);
 	void dumpDataToFile();
 
+	// Binary Format
+	bool readBinaryFile(const std::string& path);
+	bool readBinaryData(const char* data, size_t size);
+	std::vector<char> getBinaryData() const;
+	bool writeBinaryFile(const std::string& path) const;
+
 public:
 	MapHandler();
 	~MapHandler();
@@ -23,6 +51,16 @@ public:
 
 	// Getters
 	size_t getNrOfGameObjects() const { return m_gameObjectData.size(); }
+	const std::vector<GameObjectData>& getGameObjectData() const { return m_gameObjectData; }
+	bool isLoadedFromBinary() const { return m_loadedFromBinary; }
+	double getLoadTime() const { return m_loadTime; }
+
+	// Conversion
+	static bool convertTextToBinary(std::string textMapFileName);
+	static bool convertBinaryToText(std::string binaryMapFileName, std::string textMapFileName);
+
+	// Benchmark, converts the text map to binary and back, times loading both formats and compares every stage
+	static MapBenchmarkResult benchmark(std::string textMapFileName, unsigned int nrOfLoads = 20);
 
 	// Update
 	void importGameObjects(std::vector<GameObject*>& gameObjects, std::vector<std::pair<Light, LightHelper>>& lights);
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "ResourceHandler.h"
+#include "RenderQueue.h"
 
 struct TexturePaths
 {
@@ -41,10 +42,10 @@ private:
 	PhongTexturesTypes m_texTypeToLoad;
 
 	// Textures
-	ID3D11ShaderResourceView* m_diffuseTexture;
-	ID3D11ShaderResourceView* m_specularTexture;
-	ID3D11ShaderResourceView* m_normalTexture;
-	ID3D11ShaderResourceView* m_displacementTexture;
+	TextureHandle m_diffuseTexture;
+	TextureHandle m_specularTexture;
+	TextureHandle m_normalTexture;
+	TextureHandle m_displacementTexture;
 	TexturePaths m_texturePaths;
 
 	// Constant Buffer
@@ -58,29 +59,25 @@ private:
 		m_texturePaths = texturePaths;
 		if (texturePaths.diffusePath != L"")
 		{
-			m_diffuseTexture = ResourceHandler::getInstance().getTexture(texturePaths.diffusePath.c_str());
-			m_diffuseTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.diffusePath.c_str());
+			m_diffuseTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.diffusePath.c_str(), L"DefaultWhite.jpg");
 			m_materialData.diffTextureExists = true;
 			m_diffTextureExists = true;
 		}
 		if (texturePaths.specularPath != L"")
 		{
-			m_specularTexture = ResourceHandler::getInstance().getTexture(texturePaths.specularPath.c_str());
-			m_specularTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.specularPath.c_str());
+			m_specularTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.specularPath.c_str(), L"DefaultGrey.bmp");
 			m_materialData.specTextureExists = true;
 			m_specTextureExists = true;
 		}
 		if (texturePaths.normalPath != L"")
 		{
-			m_normalTexture = ResourceHandler::getInstance().getTexture(texturePaths.normalPath.c_str());
-			m_normalTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.normalPath.c_str());
+			m_normalTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.normalPath.c_str(), L"DefaultNormal.dds");
 			m_materialData.normTextureExists = true;
 			m_normTextureExists = true;
 		}
 		if (texturePaths.displacementPath != L"")
 		{
-			m_displacementTexture = ResourceHandler::getInstance().getTexture(texturePaths.displacementPath.c_str());
-			m_displacementTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.displacementPath.c_str());
+			m_displacementTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.displacementPath.c_str(), L"DefaultGrey.bmp");
 			m_displacementExists = true;
 		}
 	}
@@ -88,8 +85,7 @@ private:
 	{
 		if (ImGui::Checkbox("Use", (bool*)&textureExistsBool))
 		{
-			PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-			m_materialCBuffer.update(&materialData);
+			m_materialCBuffer.update(&m_materialData);
 		}
 	}
 
@@ -173,14 +169,12 @@ public:
 		if (m_normalTexture != nullptr)
 			m_materialData.normTextureExists = true;
 		
-		PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-		m_materialCBuffer.update(&materialData);
+		m_materialCBuffer.update(&m_materialData);
 	}
 	void setTextures(TexturePaths texturePaths)
 	{
 		loadTextures(texturePaths);
-		PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-		m_materialCBuffer.update(&materialData);
+		m_materialCBuffer.update(&m_materialData);
 	}
 	void setName(std::string newName)
 	{
@@ -223,8 +217,8 @@ public:
 			{
 				if (m_diffTextureExists)
 				{
-					ImGui::Image(m_diffuseTexture, ImVec2(imageSize, imageSize));
-					m_diffuseTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
+					ImGui::Image(*m_diffuseTexture, ImVec2(imageSize, imageSize));
+					(*m_diffuseTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
 					nameCStr = name;
 				}
 				else
@@ -245,8 +239,7 @@ public:
 
 				if (ImGui::ColorEdit4("Color##2f", &m_materialData.diffuse.x, ImGuiColorEditFlags_Float))
 				{
-					PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 
 				ImGui::EndGroup();
@@ -258,8 +251,8 @@ public:
 			{
 				if (m_normTextureExists)
 				{
-					ImGui::Image(m_normalTexture, ImVec2(imageSize, imageSize));
-					m_normalTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
+					ImGui::Image(*m_normalTexture, ImVec2(imageSize, imageSize));
+					(*m_normalTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
 					nameCStr = name;
 				}
 				else
@@ -288,8 +281,8 @@ public:
 			{
 				if (m_specTextureExists)
 				{
-					ImGui::Image(m_specularTexture, ImVec2(imageSize, imageSize));
-					m_specularTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
+					ImGui::Image(*m_specularTexture, ImVec2(imageSize, imageSize));
+					(*m_specularTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
 					nameCStr = name;
 				}
 				else
@@ -311,8 +304,7 @@ public:
 
 				if (ImGui::ColorEdit4("Color##2f", &m_materialData.specular.x, ImGuiColorEditFlags_Float))
 				{
-					PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 
 				ImGui::EndGroup();
@@ -327,22 +319,19 @@ public:
 					if (m_useEmisson)
 					{
 						m_materialData.emissive = m_emissiveColor;
-						PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-						m_materialCBuffer.update(&materialData);
+						m_materialCBuffer.update(&m_materialData);
 					}
 					else
 					{
 						m_materialData.emissive = XMFLOAT4(0.f, 0.f, 0.f, 1.f);
-						PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-						m_materialCBuffer.update(&materialData);
+						m_materialCBuffer.update(&m_materialData);
 					}
 				}
 				
 				if (m_useEmisson && ImGui::ColorEdit4("Color##2f", &m_emissiveColor.x, ImGuiColorEditFlags_Float))
 				{
 					m_materialData.emissive = m_emissiveColor;
-					PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 
 				ImGui::TreePop();
@@ -353,8 +342,8 @@ public:
 			{
 				if (m_displacementExists)
 				{
-					ImGui::Image(m_displacementTexture, ImVec2(imageSize, imageSize));
-					m_displacementTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
+					ImGui::Image(*m_displacementTexture, ImVec2(imageSize, imageSize));
+					(*m_displacementTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &nameSize, (void*)name);
 					nameCStr = name;
 				}
 				else
@@ -385,29 +374,25 @@ public:
 			switch (m_texTypeToLoad)
 			{
 			case PhongTexturesTypes::DIFFUSE:
-				m_diffuseTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_diffuseTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_diffuseTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultWhite.jpg");
 				m_diffTextureExists = true;
 				m_materialData.diffTextureExists = true;
 				m_texturePaths.diffusePath = path;
 				break;
 			case PhongTexturesTypes::SPECULAR:
-				m_specularTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_specularTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_specularTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultGrey.bmp");
 				m_specTextureExists = true;
 				m_materialData.specTextureExists = true;
 				m_texturePaths.specularPath = path;
 				break;
 			case PhongTexturesTypes::NORMAL:
-				m_normalTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_normalTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_normalTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultNormal.dds");
 				m_normTextureExists = true;
 				m_materialData.normTextureExists = true;
 				m_texturePaths.normalPath = path;
 				break;
 			case PhongTexturesTypes::DISPLACEMENT:
-				m_displacementTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_displacementTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_displacementTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultGrey.bmp");
 				m_displacementExists = true;
 				m_texturePaths.displacementPath = path;
 				break;
@@ -415,8 +400,7 @@ public:
 				break;
 			}
 			m_texTypeToLoad = PhongTexturesTypes::NONE; // Reset
-			PS_MATERIAL_BUFFER* materialData = new PS_MATERIAL_BUFFER(m_materialData);
-			m_materialCBuffer.update(&materialData);
+			m_materialCBuffer.update(&m_materialData);
 
 			m_fileDialog.ClearSelected();
 		}
@@ -430,16 +414,36 @@ public:
 
 		// Testures
 		if (m_materialData.diffTextureExists)
-			m_deviceContext->PSSetShaderResources(0, 1, &m_diffuseTexture);
+			m_deviceContext->PSSetShaderResources(0, 1, m_diffuseTexture);
 
 		if (m_materialData.specTextureExists)
-			m_deviceContext->PSSetShaderResources(1, 1, &m_specularTexture);
+			m_deviceContext->PSSetShaderResources(1, 1, m_specularTexture);
 
 		if (m_materialData.normTextureExists)
-			m_deviceContext->PSSetShaderResources(2, 1, &m_normalTexture);
+			m_deviceContext->PSSetShaderResources(2, 1, m_normalTexture);
 
 		if (m_displacementExists)
-			m_deviceContext->DSSetShaderResources(0, 1, &m_displacementTexture);
+			m_deviceContext->DSSetShaderResources(0, 1, m_displacementTexture);
+	}
+
+	// Same state as sendCBufferAndTextures(), for the render queue
+	void fillDraw(RenderDraw& draw) const
+	{
+		draw.materialBuffer = m_materialCBuffer.Get();
+		draw.materialData = &m_materialData;
+		draw.materialSize = sizeof(PS_MATERIAL_BUFFER);
+
+		if (m_materialData.diffTextureExists)
+			draw.textureSet.setTexture(0, *m_diffuseTexture);
+
+		if (m_materialData.specTextureExists)
+			draw.textureSet.setTexture(1, *m_specularTexture);
+
+		if (m_materialData.normTextureExists)
+			draw.textureSet.setTexture(2, *m_normalTexture);
+
+		if (m_displacementExists)
+			draw.textureSet.displacement = *m_displacementTexture;
 	}
 };
 
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "ResourceHandler.h"
+#include "RenderQueue.h"
 
 struct TexturePathsPBR
 {
@@ -64,13 +65,13 @@ private:
 	PBRTexturesTypes m_texTypeToLoad;
 
 	// Testures
-	ID3D11ShaderResourceView* m_albedoTexture;
-	ID3D11ShaderResourceView* m_normalTexture;
-	ID3D11ShaderResourceView* m_metallicTexture;
-	ID3D11ShaderResourceView* m_roughnessTexture;
-	ID3D11ShaderResourceView* m_emissiveTexture;
-	ID3D11ShaderResourceView* m_ambientOcclusionTexture;
-	ID3D11ShaderResourceView* m_displacementTexture;
+	TextureHandle m_albedoTexture;
+	TextureHandle m_normalTexture;
+	TextureHandle m_metallicTexture;
+	TextureHandle m_roughnessTexture;
+	TextureHandle m_emissiveTexture;
+	TextureHandle m_ambientOcclusionTexture;
+	TextureHandle m_displacementTexture;
 	bool m_displacementExists;
 	TexturePathsPBR m_texturePaths;
 
@@ -85,88 +86,74 @@ private:
 
 		if (texturePaths.albedoPath != L"")
 		{
-			m_albedoTexture = ResourceHandler::getInstance().getTexture(texturePaths.albedoPath.c_str());
-			m_albedoTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.albedoPath.c_str());
+			m_albedoTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.albedoPath.c_str(), L"DefaultWhite.jpg");
 			m_materialData.materialTextured = true;
 		}
 		else
 		{
-			m_albedoTexture = ResourceHandler::getInstance().getTexture(L"DefaultWhite.jpg");
-			m_albedoTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultWhite.jpg");
+			m_albedoTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultWhite.jpg");
 		}
 
 		if (texturePaths.normalPath != L"")
 		{
-			m_normalTexture = ResourceHandler::getInstance().getTexture(texturePaths.normalPath.c_str());
-			m_normalTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.normalPath.c_str());
+			m_normalTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.normalPath.c_str(), L"DefaultNormal.dds");
 			m_materialData.materialTextured = true;
 		}
 		else
 		{
-			m_normalTexture = ResourceHandler::getInstance().getTexture(L"DefaultNormal.dds");
-			m_normalTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultNormal.dds");
+			m_normalTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultNormal.dds");
 		}
 
 		if (texturePaths.metallicPath != L"")
 		{
-			m_metallicTexture = ResourceHandler::getInstance().getTexture(texturePaths.metallicPath.c_str());
-			m_metallicTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.metallicPath.c_str());
+			m_metallicTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.metallicPath.c_str(), L"DefaultGrey.bmp");
 			m_materialData.materialTextured = true;
 		}
 		else
 		{
-			m_metallicTexture = ResourceHandler::getInstance().getTexture(L"DefaultGrey.bmp");
-			m_metallicTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultGrey.bmp");
+			m_metallicTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultGrey.bmp");
 		}
 
 		if (texturePaths.roughnessPath != L"")
 		{
-			m_roughnessTexture = ResourceHandler::getInstance().getTexture(texturePaths.roughnessPath.c_str());
-			m_roughnessTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.roughnessPath.c_str());
+			m_roughnessTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.roughnessPath.c_str(), L"DefaultGrey.bmp");
 			m_materialData.materialTextured = true;
 		}
 		else
 		{
-			m_roughnessTexture = ResourceHandler::getInstance().getTexture(L"DefaultGrey.bmp");
-			m_roughnessTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultGrey.bmp");
+			m_roughnessTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultGrey.bmp");
 		}
 
 		if (texturePaths.emissivePath != L"")
 		{
-			m_emissiveTexture = ResourceHandler::getInstance().getTexture(texturePaths.emissivePath.c_str());
-			m_emissiveTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.emissivePath.c_str());
+			m_emissiveTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.emissivePath.c_str(), L"DefaultWhite.jpg");
 			m_materialData.emissiveTextured = true;
 		}
 		else
 		{
-			m_emissiveTexture = ResourceHandler::getInstance().getTexture(L"DefaultWhite.jpg");
-			m_emissiveTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultBlack.bmp");
+			m_emissiveTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultWhite.jpg");
 		}
 
 		if (texturePaths.ambientOcclusionPath != L"")
 		{
-			m_ambientOcclusionTexture = ResourceHandler::getInstance().getTexture(texturePaths.ambientOcclusionPath.c_str());
-			m_ambientOcclusionTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.ambientOcclusionPath.c_str());
+			m_ambientOcclusionTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.ambientOcclusionPath.c_str(), L"DefaultWhite.jpg");
 			m_materialData.materialTextured = true;
 		}
 		else
 		{
-			m_ambientOcclusionTexture = ResourceHandler::getInstance().getTexture(L"DefaultWhite.jpg");
-			m_ambientOcclusionTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, L"DefaultWhite.jpg");
+			m_ambientOcclusionTexture = ResourceHandler::getInstance().getTextureHandle(L"DefaultWhite.jpg");
 		}
 
 		if (texturePaths.displacementPath != L"")
 		{
-			m_displacementTexture = ResourceHandler::getInstance().getTexture(texturePaths.displacementPath.c_str());
-			m_displacementTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, texturePaths.displacementPath.c_str());
+			m_displacementTexture = ResourceHandler::getInstance().getTextureAsync(texturePaths.displacementPath.c_str(), L"DefaultGrey.bmp");
 		}
 	}
 	void UIUseTextureCheckbox(BOOL& textureExistsBool)
 	{
 		if (ImGui::Checkbox(" ", (bool*)&textureExistsBool))
 		{
-			PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-			m_materialCBuffer.update(&materialData);
+			m_materialCBuffer.update(&m_materialData);
 		}
 	}
 
@@ -212,14 +199,12 @@ public:
 	{
 		m_materialData = material;
 		
-		PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-		m_materialCBuffer.update(&materialData);
+		m_materialCBuffer.update(&m_materialData);
 	}
 	void setTextures(TexturePathsPBR texturePaths)
 	{
 		loadTextures(texturePaths);
-		PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-		m_materialCBuffer.update(&materialData);
+		m_materialCBuffer.update(&m_materialData);
 	}
 	void setName(std::string newName)
 	{
@@ -258,8 +243,8 @@ public:
 			{
 				if (m_albedoTexture)
 				{
-					ImGui::Image(m_albedoTexture, ImVec2(m_imageSize, m_imageSize));
-					m_albedoTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_albedoTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_albedoTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -283,8 +268,7 @@ public:
 				ImGui::PushItemWidth(ImGui::GetWindowWidth() - m_imageSize - m_offset - 80.f);
 				if (ImGui::ColorEdit3("Color##2f", &m_materialData.albedo.x, ImGuiColorEditFlags_Float))
 				{
-					PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 				ImGui::PopItemWidth();
 				ImGui::EndGroup();
@@ -297,8 +281,8 @@ public:
 			{
 				if (m_normalTexture)
 				{
-					ImGui::Image(m_normalTexture, ImVec2(m_imageSize, m_imageSize));
-					m_normalTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_normalTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_normalTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -323,8 +307,8 @@ public:
 			{
 				if (m_metallicTexture)
 				{
-					ImGui::Image(m_metallicTexture, ImVec2(m_imageSize, m_imageSize));
-					m_metallicTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_metallicTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_metallicTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -344,8 +328,7 @@ public:
 				ImGui::PushItemWidth(ImGui::GetWindowWidth() - m_imageSize - m_offset - 40.f);
 				if (ImGui::DragFloat("##MetallicValue", &m_materialData.metallic, 0.01f, 0.f, 1.f))
 				{
-					PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 				ImGui::PopItemWidth();
 				ImGui::EndGroup();
@@ -358,8 +341,8 @@ public:
 			{
 				if (m_roughnessTexture)
 				{
-					ImGui::Image(m_roughnessTexture, ImVec2(m_imageSize, m_imageSize));
-					m_roughnessTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_roughnessTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_roughnessTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -379,8 +362,7 @@ public:
 				ImGui::PushItemWidth(ImGui::GetWindowWidth() - m_imageSize - m_offset - 40.f);
 				if (ImGui::DragFloat("##RoughnessValue", &m_materialData.roughness, 0.01f, 0.f, 1.f))
 				{
-					PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 				ImGui::PopItemWidth();
 				ImGui::EndGroup();
@@ -393,8 +375,8 @@ public:
 			{
 				if (m_emissiveTexture)
 				{
-					ImGui::Image(m_emissiveTexture, ImVec2(m_imageSize, m_imageSize));
-					m_emissiveTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_emissiveTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_emissiveTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -418,8 +400,7 @@ public:
 				ImGui::PushItemWidth(ImGui::GetWindowWidth() - m_imageSize - m_offset - 40.f);
 				if (ImGui::DragFloat("##EmissiveStrength", &m_materialData.emissiveStrength, 0.1f, 0.f, 100.f))
 				{
-					PS_MATERIAL_PBR_BUFFER* materialData = new PS_MATERIAL_PBR_BUFFER(m_materialData);
-					m_materialCBuffer.update(&materialData);
+					m_materialCBuffer.update(&m_materialData);
 				}
 				ImGui::PopItemWidth();
 				ImGui::EndGroup();
@@ -432,8 +413,8 @@ public:
 			{
 				if (m_ambientOcclusionTexture)
 				{
-					ImGui::Image(m_ambientOcclusionTexture, ImVec2(m_imageSize, m_imageSize));
-					m_ambientOcclusionTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_ambientOcclusionTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_ambientOcclusionTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -458,8 +439,8 @@ public:
 			{
 				if (m_displacementTexture)
 				{
-					ImGui::Image(m_displacementTexture, ImVec2(m_imageSize, m_imageSize));
-					m_displacementTexture->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
+					ImGui::Image(*m_displacementTexture, ImVec2(m_imageSize, m_imageSize));
+					(*m_displacementTexture)->GetPrivateData(WKPDID_D3DDebugObjectNameW, &m_tempNameSize, (void*)m_tempName);
 					nameCStr = m_tempName;
 				}
 				else
@@ -492,38 +473,31 @@ public:
 			switch (m_texTypeToLoad)
 			{
 			case PBRTexturesTypes::ALBEDO:
-				m_albedoTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_albedoTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_albedoTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultWhite.jpg");
 				m_texturePaths.albedoPath = path;
 				break;
 			case PBRTexturesTypes::NORMAL:
-				m_normalTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_normalTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_normalTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultNormal.dds");
 				m_texturePaths.normalPath = path;
 				break;
 			case PBRTexturesTypes::METALLIC:
-				m_metallicTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_metallicTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_metallicTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultGrey.bmp");
 				m_texturePaths.metallicPath = path;
 				break;
 			case PBRTexturesTypes::ROUGHNESS:
-				m_roughnessTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_roughnessTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_roughnessTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultGrey.bmp");
 				m_texturePaths.roughnessPath = path;
 				break;
 			case PBRTexturesTypes::EMISSIVE:
-				m_emissiveTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_emissiveTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_emissiveTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultWhite.jpg");
 				m_texturePaths.emissivePath = path;
 				break;
 			case PBRTexturesTypes::AMBIENT_OCCLUSION:
-				m_ambientOcclusionTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_ambientOcclusionTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_ambientOcclusionTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultWhite.jpg");
 				m_texturePaths.ambientOcclusionPath = path;
 				break;
 			case PBRTexturesTypes::DISPLACEMENT:
-				m_displacementTexture = ResourceHandler::getInstance().getTexture(path.c_str());
-				m_displacementTexture->SetPrivateData(WKPDID_D3DDebugObjectNameW, 64, path.c_str());
+				m_displacementTexture = ResourceHandler::getInstance().getTextureAsync(path.c_str(), L"DefaultGrey.bmp");
 				m_texturePaths.displacementPath = path;
 				break;
 			default:
@@ -542,16 +516,37 @@ public:
 		// Testures
 		if (m_materialData.materialTextured)
 		{
-			m_deviceContext->PSSetShaderResources(0, 1, &m_albedoTexture);
-			m_deviceContext->PSSetShaderResources(1, 1, &m_normalTexture);
-			m_deviceContext->PSSetShaderResources(2, 1, &m_metallicTexture);
-			m_deviceContext->PSSetShaderResources(3, 1, &m_roughnessTexture);
-			m_deviceContext->PSSetShaderResources(4, 1, &m_emissiveTexture);
-			m_deviceContext->PSSetShaderResources(5, 1, &m_ambientOcclusionTexture);
+			m_deviceContext->PSSetShaderResources(0, 1, m_albedoTexture);
+			m_deviceContext->PSSetShaderResources(1, 1, m_normalTexture);
+			m_deviceContext->PSSetShaderResources(2, 1, m_metallicTexture);
+			m_deviceContext->PSSetShaderResources(3, 1, m_roughnessTexture);
+			m_deviceContext->PSSetShaderResources(4, 1, m_emissiveTexture);
+			m_deviceContext->PSSetShaderResources(5, 1, m_ambientOcclusionTexture);
 		}
 
 		if (m_displacementExists)
-			m_deviceContext->DSSetShaderResources(0, 1, &m_displacementTexture);
+			m_deviceContext->DSSetShaderResources(0, 1, m_displacementTexture);
+	}
+
+	// Same state as sendCBufferAndTextures(), for the render queue
+	void fillDraw(RenderDraw& draw) const
+	{
+		draw.materialBuffer = m_materialCBuffer.Get();
+		draw.materialData = &m_materialData;
+		draw.materialSize = sizeof(PS_MATERIAL_PBR_BUFFER);
+
+		if (m_materialData.materialTextured)
+		{
+			draw.textureSet.setTexture(0, *m_albedoTexture);
+			draw.textureSet.setTexture(1, *m_normalTexture);
+			draw.textureSet.setTexture(2, *m_metallicTexture);
+			draw.textureSet.setTexture(3, *m_roughnessTexture);
+			draw.textureSet.setTexture(4, *m_emissiveTexture);
+			draw.textureSet.setTexture(5, *m_ambientOcclusionTexture);
+		}
+
+		if (m_displacementExists)
+			draw.textureSet.displacement = *m_displacementTexture;
 	}
 };
 
@@ -4,6 +4,16 @@
 #include "pch.h"
 #include "Material.h"
 #include "MaterialPBR.h"
+#include "LodSelector.h"
+
+// Quantized Vertices, uploads the bounds their positions are decoded with the way the vertex shader reads them
+inline void initializeQuantizationBuffer(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const VertexQuantizationBounds& bounds, Buffer<VS_QUANTIZATION_CBUFFER>& quantizationBuffer)
+{
+	VS_QUANTIZATION_CBUFFER quantization;
+	quantization.positionOffset = XMFLOAT4(bounds.offset[0], bounds.offset[1], bounds.offset[2], 0.f);
+	quantization.positionScale = XMFLOAT4(bounds.scale[0], bounds.scale[1], bounds.scale[2], 0.f);
+	quantizationBuffer.initialize(device, deviceContext, &quantization, BufferType::CONSTANT);
+}
 
 template<class T>
 class Mesh
@@ -17,14 +27,41 @@ private:
 	
 	// Buffers
 	std::shared_ptr< Buffer<T> > m_vertexBuffer;
+	Buffer<VS_QUANTIZATION_CBUFFER> m_quantizationBuffer; // Vertex shader slot 2, only set for quantized vertices
 	Buffer<UINT> m_IndexBuffer;
 	bool m_hasIndices = false;
 
+	// LODs, index ranges in m_IndexBuffer, none means the whole buffer
+	UINT m_nrOfLods = 0;
+	MeshLod m_lods[MAX_MESH_LODS];
+
 	// Material
 	ShaderStates m_materialType;
 	Material m_material;
 	MaterialPBR m_materialPBR;
 
+	// Helper Functions
+	void initializeMaterials(ID3D11Device* device, PS_MATERIAL_BUFFER material, TexturePaths texturePaths)
+	{
+		m_materialType = ShaderStates::PHONG;
+		m_material.initialize(device, m_deviceContext, material, texturePaths);
+
+		// PBR conversion, not accurate at all
+		PS_MATERIAL_PBR_BUFFER materialPBR;
+		materialPBR.albedo = XMFLOAT3(material.diffuse.x, material.diffuse.y, material.diffuse.z);
+		XMVECTOR specVector = XMLoadFloat4(&material.specular);
+		materialPBR.metallic = DirectX::XMVector3Length(specVector).m128_f32[0];
+		materialPBR.roughness = std::pow(1 - material.shininess, 2.f);
+		XMVECTOR emVector = XMLoadFloat4(&material.emissive);
+		materialPBR.emissiveStrength = DirectX::XMVector3Length(emVector).m128_f32[0];
+
+		TexturePathsPBR texturePathsPBR;
+		texturePathsPBR.albedoPath = texturePaths.diffusePath;
+		texturePathsPBR.normalPath = texturePaths.normalPath;
+		texturePathsPBR.displacementPath = texturePaths.displacementPath;
+		m_materialPBR.initialize(device, m_deviceContext, materialPBR, texturePathsPBR);
+	}
+
 public:
 	Mesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, std::vector<T>& vertices, std::vector<UINT>& indices, PS_MATERIAL_BUFFER material, TexturePaths texturePaths, std::string name = "")
 	{
@@ -38,28 +75,26 @@ public:
 		
 		if (indices.size() > 0)
 		{
-			m_IndexBuffer.initialize(device, deviceContext, indices.data(), BufferType::INDEX, (UINT)indices.size());
+			m_IndexBuffer.initializeIndices(device, deviceContext, indices.data(), (UINT)indices.size(), (UINT)vertices.size());
 			m_hasIndices = true;
 		}
 
 		// Material
-		m_materialType = ShaderStates::PHONG;
-		m_material.initialize(device, deviceContext, material, texturePaths);
+		initializeMaterials(device, material, texturePaths);
+	}
+	Mesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, std::shared_ptr< Buffer<T> > vertexBuffer, Buffer<UINT> indexBuffer, PS_MATERIAL_BUFFER material, TexturePaths texturePaths, std::string name = "")
+	{
+		m_deviceContext = deviceContext;
 
-		// PBR conversion, not accurate at all
-		PS_MATERIAL_PBR_BUFFER materialPBR;
-		materialPBR.albedo = XMFLOAT3(material.diffuse.x, material.diffuse.y, material.diffuse.z);
-		XMVECTOR specVector = XMLoadFloat4(&material.specular);
-		materialPBR.metallic = DirectX::XMVector3Length(specVector).m128_f32[0];
-		materialPBR.roughness = std::pow(1 - material.shininess, 2.f);
-		XMVECTOR emVector = XMLoadFloat4(&material.emissive);
-		materialPBR.emissiveStrength = DirectX::XMVector3Length(emVector).m128_f32[0];
+		setName(name);
 
-		TexturePathsPBR texturePathsPBR;
-		texturePathsPBR.albedoPath = texturePaths.diffusePath;
-		texturePathsPBR.normalPath = texturePaths.normalPath;
-		texturePathsPBR.displacementPath = texturePaths.displacementPath;
-		m_materialPBR.initialize(device, deviceContext, materialPBR, texturePathsPBR);
+		// Shared Geometry, only the material is unique to this mesh
+		m_vertexBuffer = vertexBuffer;
+		m_IndexBuffer = indexBuffer;
+		m_hasIndices = m_IndexBuffer.getSize() > 0;
+
+		// Material
+		initializeMaterials(device, material, texturePaths);
 	}
 	Mesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, std::vector<T>& vertices, std::vector<UINT>& indices, PS_MATERIAL_PBR_BUFFER material, TexturePathsPBR texturePaths)
 	{
@@ -71,7 +106,7 @@ public:
 
 		if (indices.size() > 0)
 		{
-			m_IndexBuffer.initialize(device, deviceContext, indices.data(), BufferType::INDEX, indices.size());
+			m_IndexBuffer.initializeIndices(device, deviceContext, indices.data(), (UINT)indices.size(), (UINT)vertices.size());
 			m_hasIndices = true;
 		}
 
@@ -98,15 +133,39 @@ public:
 	{
 		m_deviceContext = otherMesh.m_deviceContext;
 		m_vertexBuffer = otherMesh.m_vertexBuffer;
+		m_quantizationBuffer = otherMesh.m_quantizationBuffer;
 		m_IndexBuffer = otherMesh.m_IndexBuffer;
 		m_hasIndices = otherMesh.m_hasIndices;
+		m_nrOfLods = otherMesh.m_nrOfLods;
+		std::copy(otherMesh.m_lods, otherMesh.m_lods + MAX_MESH_LODS, m_lods);
 		m_materialType = otherMesh.m_materialType;
 		m_material = otherMesh.m_material;
 		m_materialPBR = otherMesh.m_materialPBR;
 		m_name = otherMesh.m_name;
 	}
 
+	// Setters
+	void setLods(const MeshLod* lods, UINT nrOfLods)
+	{
+		m_nrOfLods = std::min(nrOfLods, MAX_MESH_LODS);
+		std::copy(lods, lods + m_nrOfLods, m_lods);
+	}
+
+	void setQuantization(const Buffer<VS_QUANTIZATION_CBUFFER>& quantizationBuffer)
+	{
+		m_quantizationBuffer = quantizationBuffer;
+	}
+
 	// Getters
+	UINT getIndexCount(UINT lod = 0) const
+	{
+		if (!m_hasIndices)
+			return 0;
+		if (m_nrOfLods == 0)
+			return m_IndexBuffer.getSize();
+		return m_lods[std::min(lod, m_nrOfLods - 1)].indexCount;
+	}
+
 	Material& getMaterial()
 	{
 		switch (m_materialType)
@@ -209,6 +268,8 @@ public:
 		// Vertex Buffer
 		UINT vertexOffset = 0;
 		m_deviceContext->IASetVertexBuffers(0, 1, m_vertexBuffer->GetAddressOf(), m_vertexBuffer->getStridePointer(), &vertexOffset);
+		if (m_quantizationBuffer.Get())
+			m_deviceContext->VSSetConstantBuffers(2, 1, m_quantizationBuffer.GetAddressOf());
 
 		switch (m_materialType)
 		{
@@ -225,12 +286,39 @@ public:
 		// Draw
 		if (m_hasIndices)
 		{
-			m_deviceContext->IASetIndexBuffer(m_IndexBuffer.Get(), DXGI_FORMAT::DXGI_FORMAT_R32_UINT, 0);
-			m_deviceContext->DrawIndexed(m_IndexBuffer.getSize(), 0, 0);
+			m_deviceContext->IASetIndexBuffer(m_IndexBuffer.Get(), m_IndexBuffer.getIndexFormat(), 0);
+			m_deviceContext->DrawIndexed(getIndexCount(), 0, 0);
 		}
 		else
 			m_deviceContext->Draw(m_vertexBuffer->getSize(), 0);
 	}
+
+	// Fills the geometry of the given LOD and, unless the pass only writes depth, the material state of a render queue draw
+	void fillDraw(RenderDraw& draw, bool depthOnly, UINT lod = 0) const
+	{
+		draw.vertexBuffer = m_vertexBuffer->Get();
+		draw.vertexStride = *m_vertexBuffer->getStridePointer();
+		draw.geometryBuffer = m_quantizationBuffer.Get();
+		draw.indexBuffer = m_hasIndices ? m_IndexBuffer.Get() : nullptr;
+		draw.indexSize = *m_IndexBuffer.getStridePointer();
+		draw.startIndex = m_hasIndices && m_nrOfLods > 0 ? m_lods[std::min(lod, m_nrOfLods - 1)].indexOffset : 0;
+		draw.count = m_hasIndices ? getIndexCount(lod) : m_vertexBuffer->getSize();
+
+		if (depthOnly)
+			return;
+
+		switch (m_materialType)
+		{
+		case PHONG:
+			m_material.fillDraw(draw);
+			break;
+		case PBR:
+			m_materialPBR.fillDraw(draw);
+			break;
+		default:
+			break;
+		}
+	}
 };
 
 #endif // !MESH_H
\ No newline at end of file
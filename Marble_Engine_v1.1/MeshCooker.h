@@ -0,0 +1,1099 @@
+#include "pch.h"
+#ifndef MESHCOOKER_H
+#define MESHCOOKER_H
+
+#include "Material.h"
+#include "MaterialPBR.h"
+#include "MapBinaryFormat.h"
+#include "VertexWelder.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantizer.h"
+#include "MeshSimplifier.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+
+const UINT MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace;
+
+// Welding, Assimp keeps one vertex per face corner so every mesh is welded after import. Vertices merge when every attribute
+// is within its tolerance
+struct VertexWeldSettings
+{
+	bool enabled = true;
+	float positionEpsilon = 0.00001f;
+	float directionEpsilon = 0.001f; // Normal, tangent and bitangent
+	float texCoordEpsilon = 0.00001f;
+};
+
+// Index Optimization, after welding every mesh gets a vertex cache order, an overdraw cluster order and a vertex fetch order
+struct IndexOptimizeSettings
+{
+	bool enabled = true;
+	float overdrawThreshold = OVERDRAW_THRESHOLD;
+};
+
+// LODs, after index optimization every mesh gets a chain of quadric error simplified index lists sharing its vertices
+struct MeshLodSettings
+{
+	bool enabled = true;
+	UINT maxLods = MAX_MESH_LODS; // LOD 0 included
+	float maxError = LOD_MAX_ERROR; // Relative to half the diagonal of the mesh bounds
+};
+
+// Cooked Mesh Layout
+// [CookedMeshHeader][CookedMeshEntry * n][CookedMaterialEntry * n][Vertices][Quantized Vertices][Indices, 16 or 32 bit]
+// [BVHNode * n][BVH Primitive Indices][Occluder Indices][String Table]
+
+const char COOKED_MESH_MAGIC[4] = { 'M', 'C', 'M', 'H' };
+const UINT COOKED_MESH_VERSION = 7; // 2, welded vertices, 3, optimized index and vertex order, 4, LODs, 5, picking hierarchy and occluders, 6, quantized vertices, 7, positions instead of float vertices
+const std::string COOKED_MESH_EXTENSION = ".cmesh";
+
+struct CookedMeshHeader
+{
+	char magic[4] = { COOKED_MESH_MAGIC[0], COOKED_MESH_MAGIC[1], COOKED_MESH_MAGIC[2], COOKED_MESH_MAGIC[3] };
+	UINT version = COOKED_MESH_VERSION;
+	UINT fileSize = 0;
+	UINT importFlags = 0;
+
+	UINT nrOfMeshes = 0;
+	UINT nrOfMaterials = 0;
+	UINT nrOfVertices = 0;
+	UINT nrOfIndices = 0;
+	UINT indexSize = 0; // 2 or 4 bytes
+	UINT nrOfBVHNodes = 0;
+	UINT nrOfBVHPrimitives = 0; // LOD 0 triangles of every mesh
+	UINT nrOfOccluderIndices = 0;
+	UINT stringTableSize = 0;
+
+	UINT meshesOffset = 0;
+	UINT materialsOffset = 0;
+	UINT positionsOffset = 0; // Picking positions, one per vertex
+	UINT quantizedVerticesOffset = 0; // One per vertex
+	UINT indicesOffset = 0;
+	UINT bvhNodesOffset = 0;
+	UINT bvhPrimitivesOffset = 0;
+	UINT occluderIndicesOffset = 0;
+	UINT stringTableOffset = 0;
+
+	XMFLOAT3 boundsMin;
+	XMFLOAT3 boundsMax;
+};
+
+struct CookedMeshEntry
+{
+	MapBinaryString name; // char
+	UINT vertexOffset = 0;
+	UINT vertexCount = 0;
+	UINT indexOffset = 0;
+	UINT indexCount = 0;
+	UINT materialSlot = 0;
+	XMFLOAT3 boundsMin;
+	XMFLOAT3 boundsMax;
+	UINT nrOfLods = 1;
+	MeshLod lods[MAX_MESH_LODS];
+	VertexQuantizationBounds quantization;
+};
+
+struct CookedMaterialEntry
+{
+	PS_MATERIAL_BUFFER material;
+	PS_MATERIAL_PBR_BUFFER materialPBR;
+
+	// Paths are wchar_t
+	MapBinaryString diffusePath;
+	MapBinaryString specularPath;
+	MapBinaryString normalPath;
+	MapBinaryString displacementPath;
+	MapBinaryString albedoPath;
+	MapBinaryString normalPathPBR;
+	MapBinaryString metallicPath;
+	MapBinaryString roughnessPath;
+	MapBinaryString emissivePath;
+	MapBinaryString ambientOcclusionPath;
+	MapBinaryString displacementPathPBR;
+};
+
+// Imported Model, CPU side result of either an Assimp import or a cooked file
+struct ImportedMaterial
+{
+	PS_MATERIAL_BUFFER material;
+	PS_MATERIAL_PBR_BUFFER materialPBR;
+	TexturePaths texturePaths;
+	TexturePathsPBR texturePathsPBR;
+};
+
+struct ImportedMesh
+{
+	std::string name;
+	UINT vertexOffset = 0;
+	UINT vertexCount = 0;
+	UINT indexOffset = 0;
+	UINT indexCount = 0; // Indices are local to the mesh
+	UINT materialSlot = 0;
+	BoundingBox boundingBox;
+
+	// LOD 0 is indexOffset and indexCount, the other LODs follow it and their offsets start at indexOffset
+	UINT nrOfLods = 1;
+	MeshLod lods[MAX_MESH_LODS];
+
+	// Bounds the quantized vertices of the mesh are decoded with
+	VertexQuantizationBounds quantization;
+
+	UINT getLodIndexCount() const { return lods[nrOfLods - 1].indexOffset + lods[nrOfLods - 1].indexCount; }
+};
+
+struct ImportedModel
+{
+	std::vector<VertexPosNormTexTan> vertices; // Full precision, only imports have them
+	std::vector<XMFLOAT3> positions; // Picking positions, one per vertex
+	std::vector<VertexPosNormTexTanQuantized> quantizedVertices; // What the vertex buffers hold, every mesh against its own bounds
+	std::vector<UINT> indices;
+	std::vector<USHORT> indices16; // Cooked 16 bit indices as stored, empty for imports and 32 bit files
+	std::vector<ImportedMesh> meshes;
+	std::vector<ImportedMaterial> materials;
+	BoundingBox boundingBox;
+	UINT nrOfImportedVertices = 0; // Before welding, equal to the vertex count for cooked files
+
+	// Vertex cache misses in the imported and the optimized order, ACMR is misses per triangle
+	UINT importedCacheMisses = 0;
+	UINT optimizedCacheMisses = 0;
+
+	// Triangles per LOD over every mesh, meshes with fewer LODs count with their last one
+	UINT lodTriangles[MAX_MESH_LODS] = {};
+
+	// Picking hierarchy and occluder triangles over the picking geometry, only cooked files carry them
+	bool hasPickingData = false;
+	BVH bvh;
+	std::vector<UINT> occluderIndices;
+};
+
+struct VertexWeldBenchmarkResult
+{
+	UINT nrOfMeshes = 0;
+	UINT verticesBefore = 0;
+	UINT verticesAfter = 0;
+	size_t bytesBefore = 0; // Vertex and index buffers
+	size_t bytesAfter = 0;
+	size_t scratchBytes = 0; // Largest mesh
+	UINT iterations = 0;
+	double weldTime = 0.0; // Average milliseconds per model
+};
+
+struct IndexOptimizeBenchmarkResult
+{
+	UINT nrOfMeshes = 0;
+	UINT nrOfTriangles = 0;
+	float acmrBefore = 0.f;
+	float acmrAfter = 0.f;
+	size_t indexBytesBefore = 0; // 32 bit indices
+	size_t indexBytesAfter = 0; // 16 bit for meshes with few enough vertices
+	double optimizeTime = 0.0; // Milliseconds per model
+};
+
+struct MeshLodBenchmarkResult
+{
+	UINT nrOfMeshes = 0;
+	UINT nrOfLods = 0; // Longest chain
+	UINT nrOfTriangles[MAX_MESH_LODS] = {}; // Meshes with fewer LODs count with their last one
+	float error[MAX_MESH_LODS] = {}; // Largest relative error over every mesh
+	size_t indexBytesBefore = 0; // 32 bit, LOD 0 only
+	size_t indexBytesAfter = 0; // Every LOD
+	double simplifyTime = 0.0; // Milliseconds per model
+};
+
+struct VertexQuantizeBenchmarkResult
+{
+	UINT nrOfMeshes = 0;
+	UINT nrOfVertices = 0;
+	size_t bytesBefore = 0;
+	size_t bytesAfter = 0;
+	double encodeTime = 0.0; // Milliseconds per model
+	VertexQuantizerErrors errors; // Largest over all meshes
+};
+
+class MeshCooker
+{
+private:
+	// Helper Functions
+	static std::wstring getTexturePath(aiMaterial* aMaterial, aiTextureType textureType)
+	{
+		aiString texturePath;
+		if (aMaterial->GetTextureCount(textureType) > 0 && aMaterial->GetTexture(textureType, 0, &texturePath) == AI_SUCCESS)
+		{
+			std::string strTexturePath(texturePath.C_Str());
+			size_t pos = strTexturePath.find("Textures\\");
+			strTexturePath.erase(0, pos);
+
+			return extractFileName(charToWchar(strTexturePath.c_str()).c_str());
+		}
+		return L"";
+	}
+	static void processMaterial(ImportedMaterial& importedMaterial, aiMaterial* aMaterial)
+	{
+		PS_MATERIAL_BUFFER& material = importedMaterial.material;
+		PS_MATERIAL_PBR_BUFFER& materialPBR = importedMaterial.materialPBR;
+		aiColor3D color(0.f, 0.f, 0.f);
+
+		aMaterial->Get(AI_MATKEY_COLOR_EMISSIVE, color);
+		material.emissive = XMFLOAT4(color.r, color.g, color.b, 1.f);
+		XMVECTOR emVector = XMLoadFloat4(&material.emissive);
+		materialPBR.emissiveStrength = DirectX::XMVector3Length(emVector).m128_f32[0];
+
+		aMaterial->Get(AI_MATKEY_COLOR_AMBIENT, color);
+		material.ambient = XMFLOAT4(color.r, color.g, color.b, 1.f);
+
+		aMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+		material.diffuse = XMFLOAT4(color.r, color.g, color.b, 1.f);
+		materialPBR.albedo = XMFLOAT3(color.r, color.g, color.b);
+
+		if (material.ambient.x == material.diffuse.x &&
+			material.ambient.y == material.diffuse.y &&
+			material.ambient.z == material.diffuse.z)
+		{
+			material.ambient = XMFLOAT4(.1f, .1f, .1f, 1.f);
+			material.diffuse = XMFLOAT4(1.f, 1.f, 1.f, 1.f);
+			materialPBR.albedo = XMFLOAT3(1.f, 1.f, 1.f);
+		}
+		aMaterial->Get(AI_MATKEY_COLOR_SPECULAR, color);
+		material.specular = XMFLOAT4(color.r, color.g, color.b, 1.f);
+		XMVECTOR specVector = XMLoadFloat4(&material.specular);
+		materialPBR.metallic = DirectX::XMVector3Length(specVector).m128_f32[0];
+
+		aMaterial->Get(AI_MATKEY_SHININESS, material.shininess);
+		if (material.shininess == 0.f)
+			material.shininess = 30.f;
+		else
+			material.shininess /= 4.f; // Assimps scales by * 4, this reverses it
+		materialPBR.roughness = std::pow(1 - material.shininess, 2.f);
+
+		// Material Textures
+		TexturePaths& texturePaths = importedMaterial.texturePaths;
+		TexturePathsPBR& texturePathsPBR = importedMaterial.texturePathsPBR;
+
+		texturePaths.diffusePath = texturePathsPBR.albedoPath = getTexturePath(aMaterial, aiTextureType_DIFFUSE);
+		texturePaths.normalPath = texturePathsPBR.normalPath = getTexturePath(aMaterial, aiTextureType_NORMALS);
+		texturePaths.specularPath = getTexturePath(aMaterial, aiTextureType_SPECULAR);
+		texturePathsPBR.metallicPath = getTexturePath(aMaterial, aiTextureType_METALNESS);
+		texturePathsPBR.roughnessPath = getTexturePath(aMaterial, aiTextureType_SHININESS);
+		texturePathsPBR.ambientOcclusionPath = getTexturePath(aMaterial, aiTextureType_AMBIENT);
+		texturePathsPBR.emissivePath = getTexturePath(aMaterial, aiTextureType_EMISSIVE);
+		texturePaths.displacementPath = texturePathsPBR.displacementPath = getTexturePath(aMaterial, aiTextureType_DISPLACEMENT);
+
+		aiString fileBaseColor, fileMetallicRoughness;
+		aMaterial->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_TEXTURE, &fileBaseColor);
+		aMaterial->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &fileMetallicRoughness);
+
+		if (fileMetallicRoughness.length > 0)
+		{
+			texturePathsPBR.metallicPath = extractFileName(charToWchar(fileMetallicRoughness.C_Str()).c_str());
+			texturePathsPBR.roughnessPath = extractFileName(charToWchar(fileMetallicRoughness.C_Str()).c_str());
+		}
+	}
+	static void getWeldEpsilons(const VertexWeldSettings& settings, float epsilons[sizeof(VertexPosNormTexTan) / sizeof(float)])
+	{
+		// VertexPosNormTexTan, position, normal, tangent, bitangent, texCoord
+		static_assert(sizeof(VertexPosNormTexTan) == 14 * sizeof(float), "Weld epsilons do not match VertexPosNormTexTan");
+		for (int i = 0; i < 3; i++)
+		{
+			epsilons[i] = settings.positionEpsilon;
+			epsilons[3 + i] = epsilons[6 + i] = epsilons[9 + i] = settings.directionEpsilon;
+		}
+		epsilons[12] = epsilons[13] = settings.texCoordEpsilon;
+	}
+	static void weldMesh(ImportedModel& model, ImportedMesh& mesh, const float* epsilons)
+	{
+		// The mesh is the last one added, so its vertices are at the end of the model
+		mesh.vertexCount = VertexWelder::weld(model.vertices.data() + mesh.vertexOffset, mesh.vertexCount, model.indices.data() + mesh.indexOffset, mesh.indexCount, epsilons);
+		model.vertices.resize((size_t)mesh.vertexOffset + mesh.vertexCount);
+	}
+	static void optimizeMesh(ImportedModel& model, ImportedMesh& mesh, const IndexOptimizeSettings& optimizeSettings)
+	{
+		VertexPosNormTexTan* vertices = model.vertices.data() + mesh.vertexOffset;
+		UINT* indices = model.indices.data() + mesh.indexOffset;
+		model.importedCacheMisses += MeshOptimizer::analyzeVertexCache(indices, mesh.indexCount, mesh.vertexCount).cacheMisses;
+
+		// Unreferenced vertices are dropped, the mesh is the last one added so its vertices are at the end of the model
+		mesh.vertexCount = MeshOptimizer::optimize(vertices, mesh.vertexCount, indices, mesh.indexCount, &vertices[0].position.x, optimizeSettings.overdrawThreshold);
+		model.vertices.resize((size_t)mesh.vertexOffset + mesh.vertexCount);
+
+		model.optimizedCacheMisses += MeshOptimizer::analyzeVertexCache(indices, mesh.indexCount, mesh.vertexCount).cacheMisses;
+	}
+	static void generateLods(ImportedModel& model, ImportedMesh& mesh, const MeshLodSettings& lodSettings)
+	{
+		// The mesh is the last one added, so the LODs go right after its indices
+		mesh.nrOfLods = MeshSimplifier::buildLodChain(model.indices, mesh.indexCount, &model.vertices[mesh.vertexOffset].position.x, sizeof(VertexPosNormTexTan),
+			mesh.vertexCount, mesh.lods, lodSettings.maxLods, lodSettings.maxError);
+
+		// Collapses keep the order of the surviving triangles, which no longer suits the cache
+		for (UINT lod = 1; lod < mesh.nrOfLods; lod++)
+			MeshOptimizer::optimizeVertexCache(model.indices.data() + mesh.indexOffset + mesh.lods[lod].indexOffset, mesh.lods[lod].indexCount, mesh.vertexCount);
+	}
+	static void processMesh(ImportedModel& model, aiMesh* mesh, std::vector<int>& materialSlots, const aiScene* scene, const VertexWeldSettings& weldSettings, const IndexOptimizeSettings& optimizeSettings,
+		const MeshLodSettings& lodSettings)
+	{
+		model.meshes.emplace_back();
+		ImportedMesh& importedMesh = model.meshes.back();
+		importedMesh.name = mesh->mName.C_Str();
+		importedMesh.vertexOffset = (UINT)model.vertices.size();
+		importedMesh.vertexCount = mesh->mNumVertices;
+		importedMesh.indexOffset = (UINT)model.indices.size();
+
+		// Vertices
+		model.vertices.resize(model.vertices.size() + mesh->mNumVertices);
+		VertexPosNormTexTan* vertices = model.vertices.data() + importedMesh.vertexOffset;
+		for (UINT i = 0; i < mesh->mNumVertices; i++)
+		{
+			VertexPosNormTexTan& vertex = vertices[i];
+
+			vertex.position = { mesh->mVertices[i].x,
+								mesh->mVertices[i].y,
+								mesh->mVertices[i].z };
+
+			if (mesh->HasNormals())
+			{
+				vertex.normal = {	mesh->mNormals[i].x,
+									mesh->mNormals[i].y,
+									mesh->mNormals[i].z };
+			}
+			if (mesh->HasTangentsAndBitangents())
+			{
+				vertex.tangent = {	mesh->mTangents[i].x,
+									mesh->mTangents[i].y,
+									mesh->mTangents[i].z };
+
+				vertex.bitangent = {mesh->mBitangents[i].x,
+									mesh->mBitangents[i].y,
+									mesh->mBitangents[i].z };
+			}
+			if (mesh->mTextureCoords[0])
+				vertex.texCoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+		}
+
+		// Indices
+		model.indices.reserve(model.indices.size() + mesh->mNumFaces * (size_t)3);
+		for (UINT i = 0; i < mesh->mNumFaces; i++)
+		{
+			const aiFace& face = mesh->mFaces[i];
+			model.indices.insert(model.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+		}
+		importedMesh.indexCount = (UINT)model.indices.size() - importedMesh.indexOffset;
+
+		// Welding
+		model.nrOfImportedVertices += importedMesh.vertexCount;
+		if (weldSettings.enabled)
+		{
+			float epsilons[sizeof(VertexPosNormTexTan) / sizeof(float)];
+			getWeldEpsilons(weldSettings, epsilons);
+			weldMesh(model, importedMesh, epsilons);
+		}
+
+		// Index and Vertex Order
+		if (optimizeSettings.enabled && importedMesh.indexCount > 0)
+			optimizeMesh(model, importedMesh, optimizeSettings);
+
+		// LODs
+		importedMesh.lods[0].indexCount = importedMesh.indexCount;
+		if (lodSettings.enabled && importedMesh.indexCount > 0)
+			generateLods(model, importedMesh, lodSettings);
+		for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+			model.lodTriangles[lod] += importedMesh.lods[std::min(lod, importedMesh.nrOfLods - 1)].indexCount / 3;
+
+		// Bounds
+		if (importedMesh.vertexCount > 0)
+			BoundingBox::CreateFromPoints(importedMesh.boundingBox, importedMesh.vertexCount, &vertices[0].position, sizeof(VertexPosNormTexTan));
+
+		// Material, one slot per scene material
+		if (materialSlots[mesh->mMaterialIndex] == -1)
+		{
+			materialSlots[mesh->mMaterialIndex] = (int)model.materials.size();
+			model.materials.emplace_back();
+			processMaterial(model.materials.back(), scene->mMaterials[mesh->mMaterialIndex]);
+		}
+		importedMesh.materialSlot = (UINT)materialSlots[mesh->mMaterialIndex];
+	}
+	static void processNodes(ImportedModel& model, aiNode* node, std::vector<int>& materialSlots, const aiScene* scene, const VertexWeldSettings& weldSettings, const IndexOptimizeSettings& optimizeSettings,
+		const MeshLodSettings& lodSettings)
+	{
+		for (UINT i = 0; i < node->mNumMeshes; i++)
+			processMesh(model, scene->mMeshes[node->mMeshes[i]], materialSlots, scene, weldSettings, optimizeSettings, lodSettings);
+
+		for (UINT i = 0; i < node->mNumChildren; i++)
+			processNodes(model, node->mChildren[i], materialSlots, scene, weldSettings, optimizeSettings, lodSettings);
+	}
+	static void computeModelBounds(ImportedModel& model)
+	{
+		if (model.meshes.empty())
+			return;
+
+		model.boundingBox = model.meshes[0].boundingBox;
+		for (size_t i = 1; i < model.meshes.size(); i++)
+			BoundingBox::CreateMerged(model.boundingBox, model.boundingBox, model.meshes[i].boundingBox);
+	}
+	// The streams a cooked file keeps instead of the float vertices
+	static void quantizeModel(ImportedModel& model)
+	{
+		model.quantizedVertices.resize(model.vertices.size());
+		for (ImportedMesh& mesh : model.meshes)
+			mesh.quantization = VertexQuantizer::encode(model.vertices.data() + mesh.vertexOffset, mesh.vertexCount, model.quantizedVertices.data() + mesh.vertexOffset);
+
+		model.positions.resize(model.vertices.size());
+		for (size_t i = 0; i < model.vertices.size(); i++)
+			model.positions[i] = model.vertices[i].position;
+	}
+	static bool isCookedModelUpToDate(const std::string& modelFile)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA cookedAttributes;
+		WIN32_FILE_ATTRIBUTE_DATA sourceAttributes;
+
+		if (!GetFileAttributesExA(getCookedModelPath(modelFile).c_str(), GetFileExInfoStandard, &cookedAttributes))
+			return false;
+
+		if (!GetFileAttributesExA(("Models\\" + modelFile).c_str(), GetFileExInfoStandard, &sourceAttributes))
+			return true;
+
+		return CompareFileTime(&cookedAttributes.ftLastWriteTime, &sourceAttributes.ftLastWriteTime) >= 0;
+	}
+
+public:
+	static std::string getCookedModelPath(const std::string& modelFile)
+	{
+		return "Models\\" + modelFile + COOKED_MESH_EXTENSION;
+	}
+
+	// Picking Geometry, positions of every mesh one after the other and their LOD 0 triangles indexing them
+	static void getPickingGeometry(const ImportedModel& model, std::vector<XMFLOAT3>& vertices, std::vector<UINT>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		vertices.reserve(model.positions.size());
+		indices.reserve(model.indices.size());
+		for (const ImportedMesh& mesh : model.meshes)
+		{
+			UINT indexOffset = (UINT)vertices.size();
+			for (UINT j = 0; j < mesh.vertexCount; j++)
+				vertices.push_back(model.positions[mesh.vertexOffset + j]);
+			for (UINT j = 0; j < mesh.indexCount; j++)
+				indices.push_back(indexOffset + model.indices[mesh.indexOffset + j]);
+		}
+	}
+
+	// Import
+	static bool importModel(const std::string& modelFile, UINT importFlags, ImportedModel& model, const VertexWeldSettings& weldSettings = VertexWeldSettings(),
+		const IndexOptimizeSettings& optimizeSettings = IndexOptimizeSettings(), const MeshLodSettings& lodSettings = MeshLodSettings())
+	{
+		std::string modelPath = "Models\\" + modelFile;
+		Assimp::Importer importer;
+
+		const aiScene* pScene = importer.ReadFile(modelPath, importFlags);
+		// Assimp tries to load gltf2 files with gltf1 importer first for some reason and throws a exception,
+		// just ignore it as it will import with version 2 of the importer right after
+
+		if (!pScene) // if nullptr
+			return false;
+
+		std::vector<int> materialSlots(pScene->mNumMaterials, -1);
+		processNodes(model, pScene->mRootNode, materialSlots, pScene, weldSettings, optimizeSettings, lodSettings);
+		computeModelBounds(model);
+		quantizeModel(model);
+
+		if (weldSettings.enabled)
+		{
+			char weldText[128];
+			sprintf_s(weldText, "Vertices welded: %u -> %u, ", model.nrOfImportedVertices, (UINT)model.vertices.size());
+			OutputDebugStringA(weldText);
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+		}
+		if (optimizeSettings.enabled && !model.indices.empty())
+		{
+			char acmrText[128];
+			float nrOfTriangles = (float)model.lodTriangles[0];
+			sprintf_s(acmrText, "Vertex cache ACMR: %.3f -> %.3f, ", model.importedCacheMisses / nrOfTriangles, model.optimizedCacheMisses / nrOfTriangles);
+			OutputDebugStringA(acmrText);
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+		}
+		if (lodSettings.enabled && !model.indices.empty())
+		{
+			std::string lodText = "LOD triangles:";
+			for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+				lodText += " " + std::to_string(model.lodTriangles[lod]);
+			OutputDebugStringA((lodText + ", " + modelFile + "\n").c_str());
+		}
+
+		return true;
+	}
+
+	// Cooked File
+	static bool writeCookedModel(const std::string& path, const ImportedModel& model, UINT importFlags)
+	{
+		MapBinaryStringTable stringTable;
+		std::vector<CookedMeshEntry> meshes(model.meshes.size());
+		std::vector<CookedMaterialEntry> materials(model.materials.size());
+
+		// Meshes
+		bool use16BitIndices = true;
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			const ImportedMesh& src = model.meshes[i];
+			CookedMeshEntry& dst = meshes[i];
+
+			dst.name = stringTable.add(src.name);
+			dst.vertexOffset = src.vertexOffset;
+			dst.vertexCount = src.vertexCount;
+			dst.indexOffset = src.indexOffset;
+			dst.indexCount = src.indexCount;
+			dst.materialSlot = src.materialSlot;
+			dst.boundsMin = XMFLOAT3(src.boundingBox.Center.x - src.boundingBox.Extents.x, src.boundingBox.Center.y - src.boundingBox.Extents.y, src.boundingBox.Center.z - src.boundingBox.Extents.z);
+			dst.boundsMax = XMFLOAT3(src.boundingBox.Center.x + src.boundingBox.Extents.x, src.boundingBox.Center.y + src.boundingBox.Extents.y, src.boundingBox.Center.z + src.boundingBox.Extents.z);
+			dst.nrOfLods = src.nrOfLods;
+			std::copy(src.lods, src.lods + MAX_MESH_LODS, dst.lods);
+			dst.quantization = src.quantization;
+
+			// Indices are mesh local, 16 bit is enough when every mesh fits
+			if (needs32BitIndices(src.vertexCount))
+				use16BitIndices = false;
+		}
+
+		// Materials
+		for (size_t i = 0; i < model.materials.size(); i++)
+		{
+			const ImportedMaterial& src = model.materials[i];
+			CookedMaterialEntry& dst = materials[i];
+
+			dst.material = src.material;
+			dst.materialPBR = src.materialPBR;
+			dst.diffusePath = stringTable.add(src.texturePaths.diffusePath);
+			dst.specularPath = stringTable.add(src.texturePaths.specularPath);
+			dst.normalPath = stringTable.add(src.texturePaths.normalPath);
+			dst.displacementPath = stringTable.add(src.texturePaths.displacementPath);
+			dst.albedoPath = stringTable.add(src.texturePathsPBR.albedoPath);
+			dst.normalPathPBR = stringTable.add(src.texturePathsPBR.normalPath);
+			dst.metallicPath = stringTable.add(src.texturePathsPBR.metallicPath);
+			dst.roughnessPath = stringTable.add(src.texturePathsPBR.roughnessPath);
+			dst.emissivePath = stringTable.add(src.texturePathsPBR.emissivePath);
+			dst.ambientOcclusionPath = stringTable.add(src.texturePathsPBR.ambientOcclusionPath);
+			dst.displacementPathPBR = stringTable.add(src.texturePathsPBR.displacementPath);
+		}
+
+		// Indices
+		std::vector<USHORT> indices16;
+		if (use16BitIndices)
+		{
+			indices16.resize(model.indices.size());
+			for (size_t i = 0; i < model.indices.size(); i++)
+				indices16[i] = (USHORT)model.indices[i];
+		}
+
+		// Picking Hierarchy and Occluders, built once here instead of on every load
+		std::vector<XMFLOAT3> pickingVertices;
+		std::vector<UINT> pickingIndices;
+		getPickingGeometry(model, pickingVertices, pickingIndices);
+		BVH bvh;
+		bvh.build(pickingVertices, pickingIndices);
+		std::vector<UINT> occluderIndices;
+		OcclusionCuller::selectOccluderTriangles((const float*)pickingVertices.data(), pickingIndices.data(), pickingIndices.size(), OCCLUDER_MAX_TRIANGLES, occluderIndices);
+		const std::vector<BVHNode>& bvhNodes = bvh.getNodes();
+		const std::vector<UINT>& bvhPrimitives = bvh.getPrimitiveIndices();
+
+		// Header
+		const std::vector<char>& stringData = stringTable.getData();
+		CookedMeshHeader header;
+		header.importFlags = importFlags;
+		header.nrOfMeshes = (UINT)meshes.size();
+		header.nrOfMaterials = (UINT)materials.size();
+		header.nrOfVertices = (UINT)model.positions.size();
+		header.nrOfIndices = (UINT)model.indices.size();
+		header.indexSize = use16BitIndices ? sizeof(USHORT) : sizeof(UINT);
+		header.nrOfBVHNodes = (UINT)bvhNodes.size();
+		header.nrOfBVHPrimitives = (UINT)bvhPrimitives.size();
+		header.nrOfOccluderIndices = (UINT)occluderIndices.size();
+		header.stringTableSize = (UINT)stringData.size();
+		header.meshesOffset = sizeof(CookedMeshHeader);
+		header.materialsOffset = header.meshesOffset + header.nrOfMeshes * sizeof(CookedMeshEntry);
+		header.positionsOffset = header.materialsOffset + header.nrOfMaterials * sizeof(CookedMaterialEntry);
+		header.quantizedVerticesOffset = header.positionsOffset + header.nrOfVertices * sizeof(XMFLOAT3);
+		header.indicesOffset = header.quantizedVerticesOffset + header.nrOfVertices * sizeof(VertexPosNormTexTanQuantized);
+		header.bvhNodesOffset = header.indicesOffset + header.nrOfIndices * header.indexSize;
+		header.bvhNodesOffset += (sizeof(UINT) - header.bvhNodesOffset % sizeof(UINT)) % sizeof(UINT); // Keep the rest aligned
+		header.bvhPrimitivesOffset = header.bvhNodesOffset + header.nrOfBVHNodes * sizeof(BVHNode);
+		header.occluderIndicesOffset = header.bvhPrimitivesOffset + header.nrOfBVHPrimitives * sizeof(UINT);
+		header.stringTableOffset = header.occluderIndicesOffset + header.nrOfOccluderIndices * sizeof(UINT);
+		header.fileSize = header.stringTableOffset + header.stringTableSize;
+		header.boundsMin = XMFLOAT3(model.boundingBox.Center.x - model.boundingBox.Extents.x, model.boundingBox.Center.y - model.boundingBox.Extents.y, model.boundingBox.Center.z - model.boundingBox.Extents.z);
+		header.boundsMax = XMFLOAT3(model.boundingBox.Center.x + model.boundingBox.Extents.x, model.boundingBox.Center.y + model.boundingBox.Extents.y, model.boundingBox.Center.z + model.boundingBox.Extents.z);
+
+		std::ofstream cookedFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!cookedFile.is_open())
+		{
+			OutputDebugStringA("Error, could not write cooked model file: ");
+			OutputDebugStringA(path.c_str());
+			OutputDebugStringA("\n");
+			return false;
+		}
+
+		const char padding[sizeof(UINT)] = {};
+		size_t indexBytes = (size_t)header.nrOfIndices * header.indexSize;
+		cookedFile.write((const char*)&header, sizeof(CookedMeshHeader));
+		cookedFile.write((const char*)meshes.data(), meshes.size() * sizeof(CookedMeshEntry));
+		cookedFile.write((const char*)materials.data(), materials.size() * sizeof(CookedMaterialEntry));
+		cookedFile.write((const char*)model.positions.data(), model.positions.size() * sizeof(XMFLOAT3));
+		cookedFile.write((const char*)model.quantizedVertices.data(), model.quantizedVertices.size() * sizeof(VertexPosNormTexTanQuantized));
+		if (use16BitIndices)
+			cookedFile.write((const char*)indices16.data(), indexBytes);
+		else
+			cookedFile.write((const char*)model.indices.data(), indexBytes);
+		cookedFile.write(padding, header.bvhNodesOffset - (header.indicesOffset + indexBytes));
+		cookedFile.write((const char*)bvhNodes.data(), bvhNodes.size() * sizeof(BVHNode));
+		cookedFile.write((const char*)bvhPrimitives.data(), bvhPrimitives.size() * sizeof(UINT));
+		cookedFile.write((const char*)occluderIndices.data(), occluderIndices.size() * sizeof(UINT));
+		cookedFile.write(stringData.data(), stringData.size());
+		cookedFile.close();
+
+		return !cookedFile.fail();
+	}
+	static bool readCookedModel(const std::string& path, UINT importFlags, ImportedModel& model)
+	{
+		std::ifstream cookedFile(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!cookedFile.is_open())
+			return false;
+
+		// Whole file in one read
+		std::vector<char> data((size_t)cookedFile.tellg());
+		cookedFile.seekg(0);
+		cookedFile.read(data.data(), data.size());
+		cookedFile.close();
+		if (data.size() < sizeof(CookedMeshHeader))
+			return false;
+
+		// Validate
+		const CookedMeshHeader* header = (const CookedMeshHeader*)data.data();
+		size_t size = data.size();
+		if (memcmp(header->magic, COOKED_MESH_MAGIC, sizeof(COOKED_MESH_MAGIC)) != 0 || header->version != COOKED_MESH_VERSION ||
+			header->fileSize != size || header->importFlags != importFlags || (header->indexSize != sizeof(USHORT) && header->indexSize != sizeof(UINT)))
+			return false;
+
+		if ((size_t)header->meshesOffset + (size_t)header->nrOfMeshes * sizeof(CookedMeshEntry) > size ||
+			(size_t)header->materialsOffset + (size_t)header->nrOfMaterials * sizeof(CookedMaterialEntry) > size ||
+			(size_t)header->positionsOffset + (size_t)header->nrOfVertices * sizeof(XMFLOAT3) > size ||
+			(size_t)header->quantizedVerticesOffset + (size_t)header->nrOfVertices * sizeof(VertexPosNormTexTanQuantized) > size ||
+			(size_t)header->indicesOffset + (size_t)header->nrOfIndices * header->indexSize > size ||
+			(size_t)header->bvhNodesOffset + (size_t)header->nrOfBVHNodes * sizeof(BVHNode) > size ||
+			(size_t)header->bvhPrimitivesOffset + (size_t)header->nrOfBVHPrimitives * sizeof(UINT) > size ||
+			(size_t)header->occluderIndicesOffset + (size_t)header->nrOfOccluderIndices * sizeof(UINT) > size ||
+			(size_t)header->stringTableOffset + (size_t)header->stringTableSize > size)
+			return false;
+
+		const CookedMeshEntry* meshes = (const CookedMeshEntry*)(data.data() + header->meshesOffset);
+		const CookedMaterialEntry* materials = (const CookedMaterialEntry*)(data.data() + header->materialsOffset);
+		const char* stringTable = data.data() + header->stringTableOffset;
+
+		bool validStrings = true;
+		auto getString = [&](const MapBinaryString& ref)
+		{
+			if ((size_t)ref.offset + ref.length > header->stringTableSize)
+			{
+				validStrings = false;
+				return std::string();
+			}
+			return std::string(stringTable + ref.offset, ref.length);
+		};
+		auto getWideString = [&](const MapBinaryString& ref)
+		{
+			if ((size_t)ref.offset + (size_t)ref.length * sizeof(wchar_t) > header->stringTableSize)
+			{
+				validStrings = false;
+				return std::wstring();
+			}
+			return std::wstring((const wchar_t*)(stringTable + ref.offset), ref.length);
+		};
+
+		// Vertices
+		model.positions.resize(header->nrOfVertices);
+		memcpy(model.positions.data(), data.data() + header->positionsOffset, model.positions.size() * sizeof(XMFLOAT3));
+		model.quantizedVertices.resize(header->nrOfVertices);
+		memcpy(model.quantizedVertices.data(), data.data() + header->quantizedVerticesOffset, model.quantizedVertices.size() * sizeof(VertexPosNormTexTanQuantized));
+
+		// Indices
+		model.indices.resize(header->nrOfIndices);
+		if (header->indexSize == sizeof(UINT))
+			memcpy(model.indices.data(), data.data() + header->indicesOffset, model.indices.size() * sizeof(UINT));
+		else
+		{
+			// Kept as they are for the index buffers, widened for picking
+			const USHORT* indices16 = (const USHORT*)(data.data() + header->indicesOffset);
+			model.indices16.assign(indices16, indices16 + header->nrOfIndices);
+			for (size_t i = 0; i < model.indices.size(); i++)
+				model.indices[i] = indices16[i];
+		}
+
+		// Meshes
+		size_t nrOfPickingVertices = 0;
+		size_t nrOfPickingTriangles = 0;
+		model.meshes.resize(header->nrOfMeshes);
+		for (UINT i = 0; i < header->nrOfMeshes; i++)
+		{
+			const CookedMeshEntry& src = meshes[i];
+			ImportedMesh& dst = model.meshes[i];
+
+			if ((size_t)src.vertexOffset + src.vertexCount > header->nrOfVertices ||
+				(size_t)src.indexOffset + src.indexCount > header->nrOfIndices ||
+				src.materialSlot >= header->nrOfMaterials ||
+				src.nrOfLods == 0 || src.nrOfLods > MAX_MESH_LODS || src.lods[0].indexOffset != 0 || src.lods[0].indexCount != src.indexCount)
+				return false;
+			// Indices are local to the mesh, every LOD has to stay inside its vertices
+			for (UINT lod = 0; lod < src.nrOfLods; lod++)
+			{
+				if ((size_t)src.indexOffset + src.lods[lod].indexOffset + src.lods[lod].indexCount > header->nrOfIndices)
+					return false;
+				const UINT* lodIndices = model.indices.data() + src.indexOffset + src.lods[lod].indexOffset;
+				for (UINT j = 0; j < src.lods[lod].indexCount; j++)
+				{
+					if (lodIndices[j] >= src.vertexCount)
+						return false;
+				}
+			}
+
+			dst.name = getString(src.name);
+			dst.vertexOffset = src.vertexOffset;
+			dst.vertexCount = src.vertexCount;
+			dst.indexOffset = src.indexOffset;
+			dst.indexCount = src.indexCount;
+			dst.materialSlot = src.materialSlot;
+			BoundingBox::CreateFromPoints(dst.boundingBox, XMLoadFloat3(&src.boundsMin), XMLoadFloat3(&src.boundsMax));
+			dst.nrOfLods = src.nrOfLods;
+			std::copy(src.lods, src.lods + MAX_MESH_LODS, dst.lods);
+			dst.quantization = src.quantization;
+			for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+				model.lodTriangles[lod] += dst.lods[std::min(lod, dst.nrOfLods - 1)].indexCount / 3;
+
+			nrOfPickingVertices += dst.vertexCount;
+			nrOfPickingTriangles += dst.indexCount / 3;
+		}
+
+		// Picking Hierarchy and Occluders, over the picking geometry getPickingGeometry() gives for these meshes
+		std::vector<BVHNode> bvhNodes(header->nrOfBVHNodes);
+		std::vector<UINT> bvhPrimitives(header->nrOfBVHPrimitives);
+		memcpy(bvhNodes.data(), data.data() + header->bvhNodesOffset, bvhNodes.size() * sizeof(BVHNode));
+		memcpy(bvhPrimitives.data(), data.data() + header->bvhPrimitivesOffset, bvhPrimitives.size() * sizeof(UINT));
+		if (!model.bvh.load(std::move(bvhNodes), std::move(bvhPrimitives), nrOfPickingTriangles))
+			return false;
+
+		const UINT* occluderIndices = (const UINT*)(data.data() + header->occluderIndicesOffset);
+		if (header->nrOfOccluderIndices % 3 != 0)
+			return false;
+		model.occluderIndices.assign(occluderIndices, occluderIndices + header->nrOfOccluderIndices);
+		for (UINT index : model.occluderIndices)
+		{
+			if (index >= nrOfPickingVertices)
+				return false;
+		}
+		model.hasPickingData = true;
+
+		// Materials
+		model.materials.resize(header->nrOfMaterials);
+		for (UINT i = 0; i < header->nrOfMaterials; i++)
+		{
+			const CookedMaterialEntry& src = materials[i];
+			ImportedMaterial& dst = model.materials[i];
+
+			dst.material = src.material;
+			dst.materialPBR = src.materialPBR;
+			dst.texturePaths.diffusePath = getWideString(src.diffusePath);
+			dst.texturePaths.specularPath = getWideString(src.specularPath);
+			dst.texturePaths.normalPath = getWideString(src.normalPath);
+			dst.texturePaths.displacementPath = getWideString(src.displacementPath);
+			dst.texturePathsPBR.albedoPath = getWideString(src.albedoPath);
+			dst.texturePathsPBR.normalPath = getWideString(src.normalPathPBR);
+			dst.texturePathsPBR.metallicPath = getWideString(src.metallicPath);
+			dst.texturePathsPBR.roughnessPath = getWideString(src.roughnessPath);
+			dst.texturePathsPBR.emissivePath = getWideString(src.emissivePath);
+			dst.texturePathsPBR.ambientOcclusionPath = getWideString(src.ambientOcclusionPath);
+			dst.texturePathsPBR.displacementPath = getWideString(src.displacementPathPBR);
+		}
+
+		BoundingBox::CreateFromPoints(model.boundingBox, XMLoadFloat3(&header->boundsMin), XMLoadFloat3(&header->boundsMax));
+		model.nrOfImportedVertices = header->nrOfVertices;
+
+		return validStrings;
+	}
+
+	// Load, prefers the cooked file when it is at least as new as the source model
+	static bool loadModel(const std::string& modelFile, UINT importFlags, ImportedModel& model)
+	{
+		if (isCookedModelUpToDate(modelFile) && readCookedModel(getCookedModelPath(modelFile), importFlags, model))
+		{
+			OutputDebugStringA("Cooked model loaded: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return true;
+		}
+
+		model = ImportedModel();
+		if (!importModel(modelFile, importFlags, model))
+			return false;
+
+		OutputDebugStringA("Model loaded: ");
+		OutputDebugStringA(modelFile.c_str());
+		OutputDebugStringA("\n");
+		return true;
+	}
+
+	// Cooking
+	static bool cookModel(const std::string& modelFile, UINT importFlags = MODEL_IMPORT_FLAGS)
+	{
+		ImportedModel model;
+		if (!importModel(modelFile, importFlags, model))
+		{
+			OutputDebugStringA("Error, could not import model for cooking: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return false;
+		}
+
+		bool cooked = writeCookedModel(getCookedModelPath(modelFile), model, importFlags);
+		if (cooked)
+		{
+			OutputDebugStringA("Model cooked: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+		}
+		return cooked;
+	}
+	static UINT cookModels(std::string directory = "")
+	{
+		UINT nrOfCookedModels = 0;
+		std::string name = "";
+		std::string fileExtension = "";
+		struct dirent* entry;
+		DIR* dir = opendir(("Models\\" + directory).c_str());
+
+		if (dir != NULL)
+		{
+			while ((entry = readdir(dir)) != NULL)
+			{
+				name = entry->d_name;
+				if (entry->d_type == DT_DIR)
+				{
+					if (name != "." && name != "..")
+						nrOfCookedModels += cookModels(directory + name + "\\");
+				}
+				else
+				{
+					size_t i = name.rfind('.', name.length());
+					if (i != std::string::npos)
+					{
+						fileExtension = name.substr(i + 1, name.length() - i);
+						if (fileExtension == "obj" || fileExtension == "FBX" || fileExtension == "fbx" || fileExtension == "glb" || fileExtension == "gltf")
+						{
+							if (cookModel(directory + name))
+								nrOfCookedModels++;
+						}
+					}
+				}
+			}
+			closedir(dir);
+		}
+
+		return nrOfCookedModels;
+	}
+
+	// Welding Benchmark, imports without welding once and then welds copies of every mesh
+	static VertexWeldBenchmarkResult benchmarkWelding(const std::string& modelFile, UINT iterations = 10, const VertexWeldSettings& weldSettings = VertexWeldSettings())
+	{
+		VertexWeldBenchmarkResult result;
+		VertexWeldSettings noWelding;
+		noWelding.enabled = false;
+		IndexOptimizeSettings noOptimizing;
+		noOptimizing.enabled = false;
+		MeshLodSettings noLods;
+		noLods.enabled = false;
+
+		ImportedModel sourceModel;
+		if (!importModel(modelFile, MODEL_IMPORT_FLAGS, sourceModel, noWelding, noOptimizing, noLods))
+		{
+			OutputDebugStringA("Error, could not import model for the welding benchmark: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return result;
+		}
+
+		float epsilons[sizeof(VertexPosNormTexTan) / sizeof(float)];
+		getWeldEpsilons(weldSettings, epsilons);
+
+		result.nrOfMeshes = (UINT)sourceModel.meshes.size();
+		result.verticesBefore = (UINT)sourceModel.vertices.size();
+		result.bytesBefore = sourceModel.vertices.size() * sizeof(VertexPosNormTexTan) + sourceModel.indices.size() * sizeof(UINT);
+		result.iterations = iterations;
+		for (const ImportedMesh& mesh : sourceModel.meshes)
+			result.scratchBytes = std::max(result.scratchBytes, VertexWelder::getScratchBytes(mesh.vertexCount));
+
+		// Meshes are welded in place one by one, so a copy of each mesh stands in for the end of the model
+		ImportedModel meshModel;
+		for (UINT i = 0; i < iterations; i++)
+		{
+			UINT nrOfVertices = 0;
+			double time = 0.0;
+			for (const ImportedMesh& sourceMesh : sourceModel.meshes)
+			{
+				meshModel.vertices.assign(sourceModel.vertices.begin() + sourceMesh.vertexOffset, sourceModel.vertices.begin() + sourceMesh.vertexOffset + sourceMesh.vertexCount);
+				meshModel.indices.assign(sourceModel.indices.begin() + sourceMesh.indexOffset, sourceModel.indices.begin() + sourceMesh.indexOffset + sourceMesh.indexCount);
+				ImportedMesh mesh = sourceMesh;
+				mesh.vertexOffset = mesh.indexOffset = 0;
+
+				auto startTime = std::chrono::steady_clock::now();
+				weldMesh(meshModel, mesh, epsilons);
+				time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+				nrOfVertices += mesh.vertexCount;
+			}
+			result.verticesAfter = nrOfVertices;
+			result.weldTime += time;
+		}
+		if (iterations)
+			result.weldTime /= iterations;
+
+		result.bytesAfter = (size_t)result.verticesAfter * sizeof(VertexPosNormTexTan) + sourceModel.indices.size() * sizeof(UINT);
+
+		return result;
+	}
+
+	// Index Optimization Benchmark, imports with welding only and then optimizes every mesh
+	static IndexOptimizeBenchmarkResult benchmarkIndexOptimization(const std::string& modelFile, const IndexOptimizeSettings& optimizeSettings = IndexOptimizeSettings())
+	{
+		IndexOptimizeBenchmarkResult result;
+		IndexOptimizeSettings noOptimizing;
+		noOptimizing.enabled = false;
+		MeshLodSettings noLods;
+		noLods.enabled = false;
+
+		ImportedModel sourceModel;
+		if (!importModel(modelFile, MODEL_IMPORT_FLAGS, sourceModel, VertexWeldSettings(), noOptimizing, noLods))
+		{
+			OutputDebugStringA("Error, could not import model for the index optimization benchmark: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return result;
+		}
+
+		// A copy of each mesh stands in for the end of the model, like in the welding benchmark
+		ImportedModel meshModel;
+		for (const ImportedMesh& sourceMesh : sourceModel.meshes)
+		{
+			if (sourceMesh.indexCount == 0)
+				continue;
+
+			meshModel.vertices.assign(sourceModel.vertices.begin() + sourceMesh.vertexOffset, sourceModel.vertices.begin() + sourceMesh.vertexOffset + sourceMesh.vertexCount);
+			meshModel.indices.assign(sourceModel.indices.begin() + sourceMesh.indexOffset, sourceModel.indices.begin() + sourceMesh.indexOffset + sourceMesh.indexCount);
+			ImportedMesh mesh = sourceMesh;
+			mesh.vertexOffset = mesh.indexOffset = 0;
+
+			auto startTime = std::chrono::steady_clock::now();
+			optimizeMesh(meshModel, mesh, optimizeSettings);
+			result.optimizeTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			result.indexBytesBefore += mesh.indexCount * sizeof(UINT);
+			result.indexBytesAfter += mesh.indexCount * (needs32BitIndices(mesh.vertexCount) ? sizeof(UINT) : sizeof(USHORT));
+		}
+
+		result.nrOfMeshes = (UINT)sourceModel.meshes.size();
+		result.nrOfTriangles = (UINT)(sourceModel.indices.size() / 3);
+		if (result.nrOfTriangles)
+		{
+			result.acmrBefore = meshModel.importedCacheMisses / (float)result.nrOfTriangles;
+			result.acmrAfter = meshModel.optimizedCacheMisses / (float)result.nrOfTriangles;
+		}
+
+		return result;
+	}
+
+	// Quantization Benchmark, quantizes every mesh against its own bounds and decodes it again to measure the errors
+	static VertexQuantizeBenchmarkResult benchmarkQuantization(const std::string& modelFile)
+	{
+		VertexQuantizeBenchmarkResult result;
+		ImportedModel model;
+		if (!importModel(modelFile, MODEL_IMPORT_FLAGS, model)) // Cooked files have no float vertices to compare with
+		{
+			OutputDebugStringA("Error, could not import model for the quantization benchmark: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return result;
+		}
+
+		std::vector<VertexPosNormTexTanQuantized> quantized;
+		std::vector<VertexQuantizer::VertexFloats> decoded;
+		for (const ImportedMesh& mesh : model.meshes)
+		{
+			const VertexPosNormTexTan* vertices = model.vertices.data() + mesh.vertexOffset;
+			quantized.resize(mesh.vertexCount);
+			decoded.resize(mesh.vertexCount);
+
+			auto startTime = std::chrono::steady_clock::now();
+			VertexQuantizationBounds bounds = VertexQuantizer::encode(vertices, mesh.vertexCount, quantized.data());
+			result.encodeTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			VertexQuantizer::decode(quantized.data(), quantized.size(), bounds, decoded.data());
+			for (UINT i = 0; i < mesh.vertexCount; i++)
+			{
+				VertexQuantizer::VertexFloats source;
+				memcpy(&source, &vertices[i], sizeof(source));
+				VertexQuantizer::measureErrors(source, decoded[i], bounds, result.errors);
+			}
+		}
+
+		result.nrOfMeshes = (UINT)model.meshes.size();
+		result.nrOfVertices = (UINT)model.vertices.size();
+		result.bytesBefore = model.vertices.size() * sizeof(VertexPosNormTexTan);
+		result.bytesAfter = model.vertices.size() * sizeof(VertexPosNormTexTanQuantized);
+
+		return result;
+	}
+
+	// LOD Benchmark, imports welded and optimized without LODs and then builds the LOD chain of every mesh
+	static MeshLodBenchmarkResult benchmarkLods(const std::string& modelFile, const MeshLodSettings& lodSettings = MeshLodSettings())
+	{
+		MeshLodBenchmarkResult result;
+		MeshLodSettings noLods;
+		noLods.enabled = false;
+
+		ImportedModel sourceModel;
+		if (!importModel(modelFile, MODEL_IMPORT_FLAGS, sourceModel, VertexWeldSettings(), IndexOptimizeSettings(), noLods))
+		{
+			OutputDebugStringA("Error, could not import model for the LOD benchmark: ");
+			OutputDebugStringA(modelFile.c_str());
+			OutputDebugStringA("\n");
+			return result;
+		}
+
+		// A copy of each mesh stands in for the end of the model, like in the welding benchmark
+		ImportedModel meshModel;
+		meshModel.vertices = sourceModel.vertices;
+		for (const ImportedMesh& sourceMesh : sourceModel.meshes)
+		{
+			if (sourceMesh.indexCount == 0)
+				continue;
+
+			meshModel.indices.assign(sourceModel.indices.begin() + sourceMesh.indexOffset, sourceModel.indices.begin() + sourceMesh.indexOffset + sourceMesh.indexCount);
+			ImportedMesh mesh = sourceMesh;
+			mesh.indexOffset = 0;
+
+			auto startTime = std::chrono::steady_clock::now();
+			generateLods(meshModel, mesh, lodSettings);
+			result.simplifyTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			result.nrOfLods = std::max(result.nrOfLods, mesh.nrOfLods);
+			for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+			{
+				const MeshLod& meshLod = mesh.lods[std::min(lod, mesh.nrOfLods - 1)];
+				result.nrOfTriangles[lod] += meshLod.indexCount / 3;
+				result.error[lod] = std::max(result.error[lod], meshLod.error);
+			}
+			result.indexBytesBefore += mesh.indexCount * sizeof(UINT);
+			result.indexBytesAfter += mesh.getLodIndexCount() * sizeof(UINT);
+		}
+		result.nrOfMeshes = (UINT)sourceModel.meshes.size();
+
+		return result;
+	}
+};
+
+#endif // !MESHCOOKER_H
@@ -0,0 +1,404 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+// Pure CPU reordering of indexed triangle lists, run once per mesh at import
+//   optimizeVertexCache, Tom Forsyth's linear speed vertex cache optimization, triangles are emitted by the scores their
+//   vertices get from their position in a simulated LRU cache and the number of triangles still using them
+//   optimizeOverdraw, splits the cache friendly order into clusters and draws the clusters facing away from the mesh center first
+//   optimizeVertexFetch, orders vertices by first use so the vertex fetch walks forwards through the vertex buffer
+// ACMR is the average number of vertex shader runs per triangle with a FIFO post transform cache, 3 is the worst and
+// around 0.5 the best a large regular mesh can get
+
+const unsigned int VERTEX_CACHE_FIFO_SIZE = 16;
+const unsigned int VERTEX_CACHE_LRU_SIZE = 32;
+const float OVERDRAW_THRESHOLD = 1.05f; // How much worse than the cache optimized order the ACMR may get from cluster splits
+
+struct VertexCacheStats
+{
+	unsigned int nrOfTriangles = 0;
+	unsigned int nrOfVertices = 0;
+	unsigned int cacheMisses = 0;
+	float acmr = 0.f; // Misses per triangle
+	float atvr = 0.f; // Misses per vertex, 1 is the best
+};
+
+struct MeshOptimizerBenchmarkResult
+{
+	unsigned int nrOfTriangles = 0;
+	float acmrBefore = 0.f;
+	float acmrAfterCache = 0.f;
+	float acmrAfterOverdraw = 0.f;
+	double vertexCacheTime = 0.0; // Milliseconds
+	double overdrawTime = 0.0;
+	double vertexFetchTime = 0.0;
+};
+
+class MeshOptimizer
+{
+private:
+	static constexpr unsigned int NONE = 0xFFFFFFFF;
+
+	// FIFO cache simulation through timestamps, a vertex is cached while fewer than cacheSize misses followed its own
+	class FifoCache
+	{
+	private:
+		std::vector<unsigned int> m_timestamps;
+		unsigned int m_time;
+		unsigned int m_cacheSize;
+
+	public:
+		FifoCache(unsigned int nrOfVertices, unsigned int cacheSize)
+			: m_timestamps(nrOfVertices, 0), m_time(cacheSize + 1), m_cacheSize(cacheSize) {}
+
+		unsigned int access(unsigned int a, unsigned int b, unsigned int c)
+		{
+			unsigned int misses = 0;
+			const unsigned int corners[3] = { a, b, c };
+			for (unsigned int vertex : corners)
+			{
+				if (m_time - m_timestamps[vertex] > m_cacheSize)
+				{
+					m_timestamps[vertex] = m_time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+		void reset()
+		{
+			m_time += m_cacheSize + 1;
+		}
+	};
+
+	// Forsyth Scores, tabled since every emitted triangle rescores the whole cache
+	static const unsigned int VALENCE_TABLE_SIZE = 32;
+
+	struct ScoreTables
+	{
+		float cache[VERTEX_CACHE_LRU_SIZE];
+		float valence[VALENCE_TABLE_SIZE];
+
+		ScoreTables()
+		{
+			// The last triangle's vertices get a fixed score so the same triangle is never picked twice
+			for (unsigned int i = 0; i < VERTEX_CACHE_LRU_SIZE; i++)
+				cache[i] = i < 3 ? 0.75f : std::pow(1.f - (i - 3) / (float)(VERTEX_CACHE_LRU_SIZE - 3), 1.5f);
+
+			// Vertices with few triangles left are finished first so they can leave the cache
+			for (unsigned int i = 1; i < VALENCE_TABLE_SIZE; i++)
+				valence[i] = 2.f / std::sqrt((float)i);
+			valence[0] = 0.f;
+		}
+	};
+	static float getVertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		static const ScoreTables tables;
+		if (remainingTriangles == 0)
+			return -1.f;
+
+		float score = cachePosition < 0 ? 0.f : tables.cache[cachePosition];
+		score += remainingTriangles < VALENCE_TABLE_SIZE ? tables.valence[remainingTriangles] : 2.f / std::sqrt((float)remainingTriangles);
+		return score;
+	}
+
+	// Overdraw
+	static const float* getPosition(const float* positions, size_t positionStride, unsigned int vertex)
+	{
+		return (const float*)((const char*)positions + positionStride * vertex);
+	}
+
+public:
+	// Cache Analysis
+	static VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t nrOfIndices, unsigned int nrOfVertices, unsigned int cacheSize = VERTEX_CACHE_FIFO_SIZE)
+	{
+		VertexCacheStats stats;
+		stats.nrOfTriangles = (unsigned int)(nrOfIndices / 3);
+		stats.nrOfVertices = nrOfVertices;
+
+		FifoCache cache(nrOfVertices, cacheSize);
+		for (size_t i = 0; i + 2 < nrOfIndices; i += 3)
+			stats.cacheMisses += cache.access(indices[i], indices[i + 1], indices[i + 2]);
+
+		if (stats.nrOfTriangles)
+			stats.acmr = stats.cacheMisses / (float)stats.nrOfTriangles;
+		if (stats.nrOfVertices)
+			stats.atvr = stats.cacheMisses / (float)stats.nrOfVertices;
+
+		return stats;
+	}
+
+	// Vertex Cache, reorders triangles in place, the winding of every triangle is kept
+	static void optimizeVertexCache(unsigned int* indices, size_t nrOfIndices, unsigned int nrOfVertices)
+	{
+		size_t nrOfTriangles = nrOfIndices / 3;
+		if (nrOfTriangles == 0)
+			return;
+
+		// Triangles of each vertex, the live part of a list shrinks as its triangles are emitted
+		std::vector<unsigned int> remaining(nrOfVertices, 0);
+		std::vector<unsigned int> offsets(nrOfVertices + 1, 0);
+		for (size_t i = 0; i < nrOfTriangles * 3; i++)
+			remaining[indices[i]]++;
+		for (unsigned int v = 0; v < nrOfVertices; v++)
+			offsets[v + 1] = offsets[v] + remaining[v];
+
+		std::vector<unsigned int> adjacency(nrOfTriangles * 3);
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < nrOfTriangles * 3; i++)
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+		// Scores
+		std::vector<int> cachePositions(nrOfVertices, -1);
+		std::vector<float> vertexScores(nrOfVertices);
+		for (unsigned int v = 0; v < nrOfVertices; v++)
+			vertexScores[v] = getVertexScore(-1, remaining[v]);
+
+		std::vector<float> triangleScores(nrOfTriangles);
+		std::vector<bool> emitted(nrOfTriangles, false);
+		unsigned int bestTriangle = 0;
+		for (size_t t = 0; t < nrOfTriangles; t++)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+			if (triangleScores[t] > triangleScores[bestTriangle])
+				bestTriangle = (unsigned int)t;
+		}
+
+		// Emit, the cache holds three extra entries for the vertices pushed out by the newest triangle
+		std::vector<unsigned int> output(nrOfTriangles * 3);
+		std::vector<unsigned int> cache, newCache;
+		cache.reserve(VERTEX_CACHE_LRU_SIZE + 3);
+		newCache.reserve(VERTEX_CACHE_LRU_SIZE + 3);
+		size_t scanPosition = 0;
+
+		for (size_t emittedTriangles = 0; emittedTriangles < nrOfTriangles; emittedTriangles++)
+		{
+			// Nothing in the cache scored, continue with the next triangle in the original order
+			if (bestTriangle == NONE)
+			{
+				while (emitted[scanPosition])
+					scanPosition++;
+				bestTriangle = (unsigned int)scanPosition;
+			}
+
+			const unsigned int* triangle = indices + (size_t)bestTriangle * 3;
+			memcpy(&output[emittedTriangles * 3], triangle, sizeof(unsigned int) * 3);
+			emitted[bestTriangle] = true;
+
+			newCache.clear();
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = triangle[corner];
+
+				// Swap the triangle out of the live part of the vertex's list
+				unsigned int* triangles = adjacency.data() + offsets[vertex];
+				for (unsigned int i = 0; i < remaining[vertex]; i++)
+				{
+					if (triangles[i] == bestTriangle)
+					{
+						std::swap(triangles[i], triangles[remaining[vertex] - 1]);
+						remaining[vertex]--;
+						break;
+					}
+				}
+
+				if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+					newCache.push_back(vertex);
+			}
+			for (unsigned int vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					newCache.push_back(vertex);
+			}
+
+			// Rescore every vertex that moved, entries past the cache size fell out
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				unsigned int vertex = newCache[i];
+				cachePositions[vertex] = i < VERTEX_CACHE_LRU_SIZE ? (int)i : -1;
+
+				float score = getVertexScore(cachePositions[vertex], remaining[vertex]);
+				float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const unsigned int* triangles = adjacency.data() + offsets[vertex];
+				for (unsigned int j = 0; j < remaining[vertex]; j++)
+					triangleScores[triangles[j]] += delta;
+			}
+
+			// Next triangle, the best one using a cached vertex
+			bestTriangle = NONE;
+			float bestScore = -1.f;
+			if (newCache.size() > VERTEX_CACHE_LRU_SIZE)
+				newCache.resize(VERTEX_CACHE_LRU_SIZE);
+			for (unsigned int vertex : newCache)
+			{
+				const unsigned int* triangles = adjacency.data() + offsets[vertex];
+				for (unsigned int j = 0; j < remaining[vertex]; j++)
+				{
+					if (triangleScores[triangles[j]] > bestScore)
+					{
+						bestScore = triangleScores[triangles[j]];
+						bestTriangle = triangles[j];
+					}
+				}
+			}
+			std::swap(cache, newCache);
+		}
+
+		memcpy(indices, output.data(), output.size() * sizeof(unsigned int));
+	}
+
+	// Overdraw, expects a cache optimized order. Clusters end where every vertex of a triangle misses the cache and, inside those,
+	// as soon as the ACMR so far is within threshold of the whole cluster's ACMR. Clusters facing out from the center go first
+	static void optimizeOverdraw(unsigned int* indices, size_t nrOfIndices, const float* positions, size_t positionStride, unsigned int nrOfVertices, float threshold = OVERDRAW_THRESHOLD)
+	{
+		size_t nrOfTriangles = nrOfIndices / 3;
+		if (nrOfTriangles < 2)
+			return;
+
+		// Hard boundaries
+		std::vector<unsigned int> hardClusters;
+		FifoCache cache(nrOfVertices, VERTEX_CACHE_FIFO_SIZE);
+		for (size_t t = 0; t < nrOfTriangles; t++)
+		{
+			if (cache.access(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]) == 3 || t == 0)
+				hardClusters.push_back((unsigned int)t);
+		}
+		hardClusters.push_back((unsigned int)nrOfTriangles);
+
+		// Soft boundaries
+		std::vector<unsigned int> clusters;
+		for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+		{
+			unsigned int start = hardClusters[c], end = hardClusters[c + 1];
+
+			cache.reset();
+			unsigned int clusterMisses = 0;
+			for (unsigned int t = start; t < end; t++)
+				clusterMisses += cache.access(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]);
+			float clusterThreshold = threshold * clusterMisses / (float)(end - start);
+
+			cache.reset();
+			unsigned int runningStart = start, runningMisses = 0;
+			clusters.push_back(start);
+			for (unsigned int t = start; t < end; t++)
+			{
+				runningMisses += cache.access(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]);
+				if (t + 1 < end && runningMisses <= clusterThreshold * (t + 1 - runningStart))
+				{
+					clusters.push_back(t + 1);
+					runningStart = t + 1;
+					runningMisses = 0;
+					cache.reset();
+				}
+			}
+		}
+		clusters.push_back((unsigned int)nrOfTriangles);
+
+		// Mesh center
+		double meshCenter[3] = {};
+		for (size_t i = 0; i < nrOfTriangles * 3; i++)
+		{
+			const float* position = getPosition(positions, positionStride, indices[i]);
+			for (int k = 0; k < 3; k++)
+				meshCenter[k] += position[k];
+		}
+		for (int k = 0; k < 3; k++)
+			meshCenter[k] /= (double)(nrOfTriangles * 3);
+
+		// Sort keys, area weighted cluster center and normal
+		size_t nrOfClusters = clusters.size() - 1;
+		std::vector<float> keys(nrOfClusters);
+		for (size_t c = 0; c < nrOfClusters; c++)
+		{
+			double center[3] = {}, normal[3] = {}, area = 0.0;
+			for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+			{
+				const float* p0 = getPosition(positions, positionStride, indices[t * 3]);
+				const float* p1 = getPosition(positions, positionStride, indices[t * 3 + 1]);
+				const float* p2 = getPosition(positions, positionStride, indices[t * 3 + 2]);
+				double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				double triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+				for (int k = 0; k < 3; k++)
+				{
+					center[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * triangleArea;
+					normal[k] += n[k];
+				}
+				area += triangleArea;
+			}
+
+			double normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (area <= 0.0 || normalLength <= 0.0)
+				continue;
+
+			double key = 0.0;
+			for (int k = 0; k < 3; k++)
+				key += (center[k] / area - meshCenter[k]) * (normal[k] / normalLength);
+			keys[c] = (float)key;
+		}
+
+		std::vector<unsigned int> order(nrOfClusters);
+		for (size_t c = 0; c < nrOfClusters; c++)
+			order[c] = (unsigned int)c;
+		std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+		std::vector<unsigned int> output;
+		output.reserve(nrOfTriangles * 3);
+		for (unsigned int c : order)
+			output.insert(output.end(), indices + (size_t)clusters[c] * 3, indices + (size_t)clusters[c + 1] * 3);
+
+		memcpy(indices, output.data(), output.size() * sizeof(unsigned int));
+	}
+
+	// Vertex Fetch, moves vertices into first use order and drops the unreferenced ones, returns the new number of vertices
+	template<typename Vertex>
+	static unsigned int optimizeVertexFetch(Vertex* vertices, unsigned int nrOfVertices, unsigned int* indices, size_t nrOfIndices)
+	{
+		static_assert(std::is_trivially_copyable<Vertex>::value, "Vertices are moved with plain copies");
+
+		std::vector<unsigned int> remap(nrOfVertices, NONE);
+		unsigned int nrOfUsed = 0;
+		for (size_t i = 0; i < nrOfIndices; i++)
+		{
+			unsigned int& newIndex = remap[indices[i]];
+			if (newIndex == NONE)
+				newIndex = nrOfUsed++;
+			indices[i] = newIndex;
+		}
+
+		std::vector<Vertex> reordered(nrOfUsed);
+		for (unsigned int v = 0; v < nrOfVertices; v++)
+		{
+			if (remap[v] != NONE)
+				reordered[remap[v]] = vertices[v];
+		}
+		if (nrOfUsed)
+			memcpy(vertices, reordered.data(), nrOfUsed * sizeof(Vertex));
+
+		return nrOfUsed;
+	}
+
+	// All three passes in order, positions are the first three floats at positionStride bytes apart
+	template<typename Vertex>
+	static unsigned int optimize(Vertex* vertices, unsigned int nrOfVertices, unsigned int* indices, size_t nrOfIndices, const float* positions, float overdrawThreshold = OVERDRAW_THRESHOLD)
+	{
+		optimizeVertexCache(indices, nrOfIndices, nrOfVertices);
+		optimizeOverdraw(indices, nrOfIndices, positions, sizeof(Vertex), nrOfVertices, overdrawThreshold);
+		return optimizeVertexFetch(vertices, nrOfVertices, indices, nrOfIndices);
+	}
+
+	// Test and Benchmark, in MeshOptimizerTests.cpp
+	static unsigned int test();
+	static MeshOptimizerBenchmarkResult benchmark(unsigned int gridSize = 256);
+};
+
+#endif // !MESHOPTIMIZER_H
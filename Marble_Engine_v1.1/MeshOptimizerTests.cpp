@@ -0,0 +1,149 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include "TestSupport.h"
+#include <chrono>
+
+// Triangles as sorted corner positions with the rotation that keeps the winding, to compare two orders of the same mesh
+static std::vector<std::vector<float>> getTriangleSet(const std::vector<TestVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	std::vector<std::vector<float>> triangles;
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		size_t first = t;
+		for (size_t i = t + 1; i < t + 3; i++)
+		{
+			if (memcmp(vertices[indices[i]].position, vertices[indices[first]].position, sizeof(float) * 3) < 0)
+				first = i;
+		}
+
+		std::vector<float> triangle;
+		for (size_t i = 0; i < 3; i++)
+		{
+			const TestVertex& vertex = vertices[indices[t + (first - t + i) % 3]];
+			triangle.insert(triangle.end(), vertex.position, vertex.position + 3);
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+unsigned int MeshOptimizer::test()
+{
+	unsigned int errors = 0;
+
+	// FIFO simulation, a strip of a long quad row misses once per triangle after the start, a repeated triangle never misses
+	{
+		std::vector<unsigned int> strip;
+		for (unsigned int i = 0; i < 100; i++)
+		{
+			const unsigned int quad[6] = { i, i + 101, i + 102, i, i + 102, i + 1 };
+			strip.insert(strip.end(), quad, quad + 6);
+		}
+		VertexCacheStats stats = analyzeVertexCache(strip.data(), strip.size(), 202);
+		errors += stats.cacheMisses != 202 || stats.nrOfTriangles != 200;
+
+		const unsigned int repeated[9] = { 0, 1, 2, 2, 1, 0, 0, 1, 2 };
+		errors += analyzeVertexCache(repeated, 9, 3).cacheMisses != 3;
+		errors += analyzeVertexCache(repeated, 9, 3, 2).cacheMisses != 6; // A cache of two never holds a whole triangle
+	}
+
+	// Passes keep every triangle and its winding, and the cache order gets close to the best a grid can do
+	for (unsigned int size : { 1u, 5u, 48u })
+	{
+		std::vector<TestVertex> vertices, sourceVertices;
+		std::vector<unsigned int> indices, sourceIndices;
+		TestGridSettings shuffled;
+		shuffled.shuffleSeed = size;
+		createTestGrid(size, vertices, indices, shuffled);
+		sourceVertices = vertices;
+		sourceIndices = indices;
+		unsigned int nrOfVertices = (unsigned int)vertices.size();
+		float acmrBefore = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+
+		optimizeVertexCache(indices.data(), indices.size(), nrOfVertices);
+		float acmrCache = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+		errors += getTriangleSet(vertices, indices) != getTriangleSet(sourceVertices, sourceIndices);
+		if (size >= 48)
+			errors += acmrCache > 0.8f || acmrCache >= acmrBefore;
+
+		optimizeOverdraw(indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), nrOfVertices);
+		float acmrOverdraw = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+		errors += getTriangleSet(vertices, indices) != getTriangleSet(sourceVertices, sourceIndices);
+		errors += acmrOverdraw > acmrCache * OVERDRAW_THRESHOLD * 1.1f;
+
+		nrOfVertices = optimizeVertexFetch(vertices.data(), nrOfVertices, indices.data(), indices.size());
+		vertices.resize(nrOfVertices);
+		errors += nrOfVertices != (size + 1) * (size + 1);
+		errors += getTriangleSet(vertices, indices) != getTriangleSet(sourceVertices, sourceIndices);
+		errors += analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr != acmrOverdraw;
+
+		// First use order, every index is at most one past the largest index before it
+		unsigned int next = 0;
+		for (unsigned int index : indices)
+		{
+			errors += index > next;
+			next = std::max(next, index + 1);
+		}
+	}
+
+	// Overdraw, two walls facing out from the center, the one behind the center draws last when it faces away
+	{
+		std::vector<TestVertex> vertices = {
+			{ { -1.f, -1.f, -1.f }, {}, {} }, { { -1.f, 1.f, -1.f }, {}, {} }, { { 1.f, 1.f, -1.f }, {}, {} }, // Normal -z at z -1, faces out
+			{ { -1.f, -1.f, 1.f }, {}, {} }, { { -1.f, 1.f, 1.f }, {}, {} }, { { 1.f, 1.f, 1.f }, {}, {} } }; // Normal -z at z 1, faces in
+		std::vector<unsigned int> indices = { 3, 4, 5, 0, 1, 2 };
+		optimizeOverdraw(indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size());
+		errors += indices != std::vector<unsigned int>({ 0, 1, 2, 3, 4, 5 });
+	}
+
+	// Unreferenced vertices are dropped, empty meshes are left alone
+	{
+		std::vector<TestVertex> vertices(4);
+		for (unsigned int i = 0; i < 4; i++)
+			vertices[i].position[0] = (float)i;
+		std::vector<unsigned int> indices = { 3, 1, 3 };
+		errors += optimizeVertexFetch(vertices.data(), 4, indices.data(), indices.size()) != 2;
+		errors += indices != std::vector<unsigned int>({ 0, 1, 0 }) || vertices[0].position[0] != 3.f || vertices[1].position[0] != 1.f;
+
+		optimizeVertexCache(nullptr, 0, 0);
+		optimizeOverdraw(nullptr, 0, nullptr, 0, 0);
+	}
+
+	return errors;
+}
+
+// Benchmark, a shuffled gridSize^2 quad grid through all three passes
+MeshOptimizerBenchmarkResult MeshOptimizer::benchmark(unsigned int gridSize)
+{
+	std::vector<TestVertex> vertices;
+	std::vector<unsigned int> indices;
+	TestGridSettings shuffled;
+	shuffled.shuffleSeed = 1;
+	createTestGrid(gridSize, vertices, indices, shuffled);
+	unsigned int nrOfVertices = (unsigned int)vertices.size();
+
+	MeshOptimizerBenchmarkResult result;
+	result.nrOfTriangles = (unsigned int)(indices.size() / 3);
+	result.acmrBefore = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+
+	auto startTime = std::chrono::steady_clock::now();
+	optimizeVertexCache(indices.data(), indices.size(), nrOfVertices);
+	auto cacheTime = std::chrono::steady_clock::now();
+	result.acmrAfterCache = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+
+	auto overdrawStartTime = std::chrono::steady_clock::now();
+	optimizeOverdraw(indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), nrOfVertices);
+	auto overdrawTime = std::chrono::steady_clock::now();
+	result.acmrAfterOverdraw = analyzeVertexCache(indices.data(), indices.size(), nrOfVertices).acmr;
+
+	auto fetchStartTime = std::chrono::steady_clock::now();
+	optimizeVertexFetch(vertices.data(), nrOfVertices, indices.data(), indices.size());
+	auto fetchTime = std::chrono::steady_clock::now();
+
+	result.vertexCacheTime = std::chrono::duration<double, std::milli>(cacheTime - startTime).count();
+	result.overdrawTime = std::chrono::duration<double, std::milli>(overdrawTime - overdrawStartTime).count();
+	result.vertexFetchTime = std::chrono::duration<double, std::milli>(fetchTime - fetchStartTime).count();
+
+	return result;
+}
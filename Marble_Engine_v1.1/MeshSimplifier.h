@@ -0,0 +1,577 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "LodSelector.h"
+
+// Pure CPU quadric error simplification of indexed triangle lists, run once per mesh at import to build its LOD chain
+//   Every position gets the plane quadrics of its triangles, collapsing an edge moves one vertex onto the other and costs the
+//   quadric error of the moved vertex at its new place. Collapses never add vertices, so LODs index the vertices of LOD 0
+//   Open edges and seams, where the same position has different normals or uvs, get quadrics of their own and their vertices
+//   only move along them. Vertices where more than two seams or borders meet never move
+// Errors are distances relative to half the diagonal of the mesh bounds
+
+const float LOD_TRIANGLE_RATIO = 0.5f; // Of the previous LOD
+const float LOD_MAX_ERROR = 0.05f;
+const float LOD_MIN_REDUCTION = 0.8f; // A LOD keeping more of the previous LOD's triangles ends the chain
+const unsigned int LOD_MIN_TRIANGLES = 32;
+
+struct MeshSimplifierBenchmarkResult
+{
+	unsigned int nrOfLods = 0;
+	unsigned int nrOfTriangles[MAX_MESH_LODS] = {};
+	float error[MAX_MESH_LODS] = {};
+	double simplifyTime = 0.0; // Milliseconds for the whole chain
+};
+
+class MeshSimplifier
+{
+private:
+	static constexpr unsigned int NONE = 0xFFFFFFFF;
+	static constexpr unsigned int MULTIPLE = 0xFFFFFFFE; // Vertex with more than one open edge in the same direction
+	static constexpr float FLIP_LIMIT = 0.25f; // Smallest cosine between a triangle's normal before and after a collapse
+	static constexpr float SLIVER_LIMIT = 0.001f; // Smallest sine of the corner a moved vertex gets
+
+	enum class VertexKind : unsigned char
+	{
+		MANIFOLD, // Moves anywhere
+		BORDER, // Moves along its open edges
+		SEAM, // Two vertices at one position, both move along the seam
+		LOCKED
+	};
+
+	struct Vector3
+	{
+		float x, y, z;
+	};
+
+	static Vector3 subtract(const Vector3& a, const Vector3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+	static Vector3 cross(const Vector3& a, const Vector3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+	static float dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+	static float length(const Vector3& a)
+	{
+		return std::sqrt(dot(a, a));
+	}
+
+	// Sum of squared distances to the planes of the source triangles a vertex stands for, never below the squared distance
+	// to the farthest of them
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+
+		// Unit normal, the plane holds every point p with dot(normal, p) + distance = 0
+		void addPlane(const Vector3& normal, float distance)
+		{
+			a00 += normal.x * normal.x;
+			a11 += normal.y * normal.y;
+			a22 += normal.z * normal.z;
+			a01 += normal.x * normal.y;
+			a02 += normal.x * normal.z;
+			a12 += normal.y * normal.z;
+			b0 += normal.x * distance;
+			b1 += normal.y * distance;
+			b2 += normal.z * distance;
+			c += distance * distance;
+		}
+		void add(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+		}
+		double getError(const Vector3& p) const
+		{
+			double error = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+				2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		unsigned int from;
+		unsigned int to;
+		unsigned int seamTo; // Where the other vertex of a seam goes
+		double error; // Squared
+	};
+
+	// Topology of the source mesh, remap is the first vertex at the same position and wedge links vertices at one position in
+	// a ring. openOut and openIn are the other ends of a vertex's edges without a twin in the opposite direction
+	struct Topology
+	{
+		std::vector<unsigned int> remap;
+		std::vector<unsigned int> wedge;
+		std::vector<unsigned int> openOut;
+		std::vector<unsigned int> openIn;
+		std::vector<VertexKind> kinds;
+	};
+
+	// Positions are moved into [0, 2] on their longest axis, returns half the diagonal of the bounds
+	static float normalizePositions(const float* positions, size_t positionStride, unsigned int nrOfVertices, std::vector<Vector3>& normalized)
+	{
+		normalized.resize(nrOfVertices);
+		const float largest = std::numeric_limits<float>::max();
+		Vector3 minimum = { largest, largest, largest };
+		Vector3 maximum = { -largest, -largest, -largest };
+		for (unsigned int i = 0; i < nrOfVertices; i++)
+		{
+			const float* position = (const float*)((const char*)positions + i * positionStride);
+			Vector3& vertex = normalized[i];
+			vertex = { position[0], position[1], position[2] };
+			if (!std::isfinite(vertex.x) || !std::isfinite(vertex.y) || !std::isfinite(vertex.z))
+				vertex = { 0.f, 0.f, 0.f };
+
+			minimum = { std::min(minimum.x, vertex.x), std::min(minimum.y, vertex.y), std::min(minimum.z, vertex.z) };
+			maximum = { std::max(maximum.x, vertex.x), std::max(maximum.y, vertex.y), std::max(maximum.z, vertex.z) };
+		}
+		if (nrOfVertices == 0)
+			return 1.f;
+
+		float scale = length(subtract(maximum, minimum)) * 0.5f;
+		if (!(scale > 0.f))
+			scale = 1.f;
+		for (Vector3& vertex : normalized)
+			vertex = { (vertex.x - minimum.x) / scale, (vertex.y - minimum.y) / scale, (vertex.z - minimum.z) / scale };
+
+		return scale;
+	}
+	static void buildTopology(const unsigned int* indices, size_t nrOfIndices, const std::vector<Vector3>& positions, Topology& topology)
+	{
+		unsigned int nrOfVertices = (unsigned int)positions.size();
+
+		// Referenced vertices sorted by position, runs of equal positions share a remap
+		std::vector<unsigned char> referenced(nrOfVertices, 0);
+		for (size_t i = 0; i < nrOfIndices; i++)
+			referenced[indices[i]] = 1;
+
+		std::vector<unsigned int> order;
+		order.reserve(nrOfVertices);
+		for (unsigned int i = 0; i < nrOfVertices; i++)
+		{
+			if (referenced[i])
+				order.push_back(i);
+		}
+		auto less = [&](unsigned int a, unsigned int b)
+		{
+			const Vector3& pa = positions[a];
+			const Vector3& pb = positions[b];
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		};
+		std::stable_sort(order.begin(), order.end(), less);
+
+		topology.remap.resize(nrOfVertices);
+		topology.wedge.resize(nrOfVertices);
+		std::iota(topology.remap.begin(), topology.remap.end(), 0);
+		std::iota(topology.wedge.begin(), topology.wedge.end(), 0);
+		for (size_t first = 0; first < order.size();)
+		{
+			size_t last = first + 1;
+			while (last < order.size() && !less(order[first], order[last]))
+				last++;
+
+			for (size_t i = first; i < last; i++)
+			{
+				topology.remap[order[i]] = order[first];
+				topology.wedge[order[i]] = order[i + 1 < last ? i + 1 : first];
+			}
+			first = last;
+		}
+
+		// Outgoing edges per vertex
+		std::vector<unsigned int> edgeOffsets(nrOfVertices + 1, 0);
+		for (size_t i = 0; i < nrOfIndices; i++)
+			edgeOffsets[indices[i] + 1]++;
+		for (unsigned int i = 0; i < nrOfVertices; i++)
+			edgeOffsets[i + 1] += edgeOffsets[i];
+
+		std::vector<unsigned int> edgeTargets(nrOfIndices);
+		std::vector<unsigned int> edgeFill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+		for (size_t i = 0; i < nrOfIndices; i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = indices[i + k], b = indices[i + (k + 1) % 3];
+				edgeTargets[edgeFill[a]++] = b;
+			}
+		}
+		auto hasEdge = [&](unsigned int a, unsigned int b)
+		{
+			for (unsigned int e = edgeOffsets[a]; e < edgeOffsets[a + 1]; e++)
+			{
+				if (edgeTargets[e] == b)
+					return true;
+			}
+			return false;
+		};
+
+		topology.openOut.assign(nrOfVertices, NONE);
+		topology.openIn.assign(nrOfVertices, NONE);
+		for (unsigned int a = 0; a < nrOfVertices; a++)
+		{
+			for (unsigned int e = edgeOffsets[a]; e < edgeOffsets[a + 1]; e++)
+			{
+				unsigned int b = edgeTargets[e];
+				if (hasEdge(b, a))
+					continue;
+
+				topology.openOut[a] = topology.openOut[a] == NONE || topology.openOut[a] == b ? b : MULTIPLE;
+				topology.openIn[b] = topology.openIn[b] == NONE || topology.openIn[b] == a ? a : MULTIPLE;
+			}
+		}
+
+		// Kinds, a seam needs both of its vertices to have one open edge each way and the edges of one side to end at the
+		// positions the other side's edges start from
+		auto isSingle = [](unsigned int vertex) { return vertex < MULTIPLE; };
+		topology.kinds.assign(nrOfVertices, VertexKind::LOCKED);
+		for (unsigned int v = 0; v < nrOfVertices; v++)
+		{
+			unsigned int sibling = topology.wedge[v];
+			unsigned int out = topology.openOut[v], in = topology.openIn[v];
+			if (sibling == v)
+			{
+				if (out == NONE && in == NONE)
+					topology.kinds[v] = VertexKind::MANIFOLD;
+				else if (isSingle(out) && isSingle(in))
+					topology.kinds[v] = VertexKind::BORDER;
+			}
+			else if (topology.wedge[sibling] == v)
+			{
+				unsigned int siblingOut = topology.openOut[sibling], siblingIn = topology.openIn[sibling];
+				if (isSingle(out) && isSingle(in) && isSingle(siblingOut) && isSingle(siblingIn) &&
+					topology.remap[out] == topology.remap[siblingIn] && topology.remap[in] == topology.remap[siblingOut])
+					topology.kinds[v] = VertexKind::SEAM;
+			}
+		}
+	}
+
+	static void fillQuadrics(const unsigned int* indices, size_t nrOfIndices, const std::vector<Vector3>& positions, const Topology& topology, std::vector<Quadric>& quadrics)
+	{
+		quadrics.assign(positions.size(), Quadric());
+		for (size_t i = 0; i < nrOfIndices; i += 3)
+		{
+			const unsigned int corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+			const Vector3& p0 = positions[corners[0]];
+			Vector3 normal = cross(subtract(positions[corners[1]], p0), subtract(positions[corners[2]], p0));
+			float normalLength = length(normal);
+			if (normalLength == 0.f)
+				continue;
+			normal = { normal.x / normalLength, normal.y / normalLength, normal.z / normalLength };
+
+			// Faces
+			for (unsigned int corner : corners)
+				quadrics[topology.remap[corner]].addPlane(normal, -dot(normal, p0));
+
+			// Open edges, a plane through the edge standing on the triangle keeps the outline in place
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = corners[k], b = corners[(k + 1) % 3];
+				if (topology.openOut[a] != b && topology.openOut[a] != MULTIPLE)
+					continue;
+
+				Vector3 edgeNormal = cross(subtract(positions[b], positions[a]), normal);
+				float edgeNormalLength = length(edgeNormal);
+				if (edgeNormalLength == 0.f)
+					continue;
+				edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+
+				float distance = -dot(edgeNormal, positions[a]);
+				quadrics[topology.remap[a]].addPlane(edgeNormal, distance);
+				quadrics[topology.remap[b]].addPlane(edgeNormal, distance);
+			}
+		}
+	}
+
+	// Where the other vertex of a seam goes when from moves to to, NONE when the move is not allowed
+	static bool canCollapse(const Topology& topology, unsigned int from, unsigned int to, unsigned int& seamTo)
+	{
+		seamTo = NONE;
+		switch (topology.kinds[from])
+		{
+		case VertexKind::MANIFOLD:
+			return true;
+		case VertexKind::BORDER:
+			return to == topology.openOut[from] || to == topology.openIn[from];
+		case VertexKind::SEAM:
+		{
+			unsigned int sibling = topology.wedge[from];
+			if (to == topology.openOut[from])
+				seamTo = topology.openIn[sibling];
+			else if (to == topology.openIn[from])
+				seamTo = topology.openOut[sibling];
+			else
+				return false;
+			return seamTo < MULTIPLE && topology.remap[seamTo] == topology.remap[to];
+		}
+		default:
+			return false;
+		}
+	}
+
+	// Triangles around every position, offsets index triangles by remap
+	static void buildTriangleAdjacency(const unsigned int* indices, size_t nrOfIndices, const Topology& topology, std::vector<unsigned int>& offsets, std::vector<unsigned int>& triangles)
+	{
+		offsets.assign(topology.remap.size() + 1, 0);
+		for (size_t i = 0; i < nrOfIndices; i++)
+			offsets[topology.remap[indices[i]] + 1]++;
+		for (size_t i = 0; i + 1 < offsets.size(); i++)
+			offsets[i + 1] += offsets[i];
+
+		triangles.resize(nrOfIndices);
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < nrOfIndices; i++)
+			triangles[fill[topology.remap[indices[i]]]++] = (unsigned int)(i / 3);
+	}
+
+	static bool hasTriangleFlips(const unsigned int* indices, const std::vector<Vector3>& positions, const Topology& topology, const unsigned int* triangles,
+		unsigned int nrOfTriangles, unsigned int fromPosition, unsigned int toPosition)
+	{
+		const Vector3& target = positions[toPosition];
+		for (unsigned int t = 0; t < nrOfTriangles; t++)
+		{
+			const unsigned int* corners = indices + triangles[t] * (size_t)3;
+			unsigned int r0 = topology.remap[corners[0]], r1 = topology.remap[corners[1]], r2 = topology.remap[corners[2]];
+			if (r0 == toPosition || r1 == toPosition || r2 == toPosition)
+				continue;
+
+			// Moved corner first
+			if (r1 == fromPosition)
+				std::swap(r0, r1), std::swap(r1, r2);
+			else if (r2 == fromPosition)
+				std::swap(r0, r2), std::swap(r1, r2);
+
+			Vector3 edge1 = subtract(positions[r1], target);
+			Vector3 edge2 = subtract(positions[r2], target);
+			Vector3 before = cross(subtract(positions[r1], positions[r0]), subtract(positions[r2], positions[r0]));
+			Vector3 after = cross(edge1, edge2);
+			float afterLength = length(after);
+			if (dot(before, after) <= FLIP_LIMIT * length(before) * afterLength || afterLength <= SLIVER_LIMIT * length(edge1) * length(edge2))
+				return true;
+		}
+		return false;
+	}
+
+	// State of one simplification, indices shrink in place and keep indexing the source vertices
+	struct Simplification
+	{
+		unsigned int* indices = nullptr;
+		size_t indexCount = 0;
+		std::vector<Vector3> positions;
+		Topology topology;
+		std::vector<Quadric> quadrics;
+		double maxError = 0.0; // Squared
+
+		// Scratch
+		std::vector<Collapse> collapses;
+		std::vector<unsigned int> collapseRemap;
+		std::vector<unsigned char> locked;
+		std::vector<unsigned int> triangleOffsets, triangles;
+	};
+
+	static void beginSimplification(Simplification& state, unsigned int* indices, size_t nrOfIndices, const float* positions, size_t positionStride, unsigned int nrOfVertices)
+	{
+		state.indices = indices;
+		state.indexCount = nrOfIndices - nrOfIndices % 3;
+		normalizePositions(positions, positionStride, nrOfVertices, state.positions);
+		buildTopology(indices, state.indexCount, state.positions, state.topology);
+		fillQuadrics(indices, state.indexCount, state.positions, state.topology, state.quadrics);
+		state.collapseRemap.resize(nrOfVertices);
+		state.locked.resize(nrOfVertices);
+	}
+
+	// Collapses in passes until targetIndexCount is reached or every collapse left costs more than errorLimit, squared
+	static void collapseTo(Simplification& state, size_t targetIndexCount, double errorLimit)
+	{
+		unsigned int* indices = state.indices;
+		Topology& topology = state.topology;
+		unsigned int nrOfVertices = (unsigned int)state.positions.size();
+		while (state.indexCount > targetIndexCount)
+		{
+			buildTriangleAdjacency(indices, state.indexCount, topology, state.triangleOffsets, state.triangles);
+
+			// Cheapest direction of every edge, closed edges are seen from both triangles and taken once
+			state.collapses.clear();
+			for (size_t i = 0; i < state.indexCount; i++)
+			{
+				unsigned int a = indices[i], b = indices[i % 3 == 2 ? i - 2 : i + 1];
+				if (topology.remap[a] > topology.remap[b] && topology.openOut[a] != b && topology.openOut[a] != MULTIPLE)
+					continue;
+
+				unsigned int seamToA, seamToB;
+				bool collapseA = canCollapse(topology, a, b, seamToA);
+				bool collapseB = canCollapse(topology, b, a, seamToB);
+				if (!collapseA && !collapseB)
+					continue;
+
+				double errorA = collapseA ? state.quadrics[topology.remap[a]].getError(state.positions[b]) : 0.0;
+				double errorB = collapseB ? state.quadrics[topology.remap[b]].getError(state.positions[a]) : 0.0;
+				if (collapseA && (!collapseB || errorA <= errorB))
+					state.collapses.push_back({ a, b, seamToA, errorA });
+				else
+					state.collapses.push_back({ b, a, seamToB, errorB });
+			}
+			if (state.collapses.empty())
+				break;
+			std::sort(state.collapses.begin(), state.collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+			// Cheapest collapses first, one per neighbourhood so every flip test sees the triangles as they end up
+			std::iota(state.collapseRemap.begin(), state.collapseRemap.end(), 0);
+			std::fill(state.locked.begin(), state.locked.end(), 0);
+			size_t trianglesToRemove = (state.indexCount - targetIndexCount) / 3;
+			size_t nrOfRemoved = 0;
+			unsigned int nrOfCollapses = 0;
+			for (const Collapse& collapse : state.collapses)
+			{
+				if (nrOfRemoved >= trianglesToRemove || collapse.error > errorLimit)
+					break;
+
+				unsigned int from = topology.remap[collapse.from], to = topology.remap[collapse.to];
+				if (state.locked[from] || state.locked[to])
+					continue;
+
+				const unsigned int* around = state.triangles.data() + state.triangleOffsets[from];
+				unsigned int nrAround = state.triangleOffsets[from + 1] - state.triangleOffsets[from];
+				if (hasTriangleFlips(indices, state.positions, topology, around, nrAround, from, to))
+					continue;
+
+				state.collapseRemap[collapse.from] = collapse.to;
+				if (collapse.seamTo != NONE)
+					state.collapseRemap[topology.wedge[collapse.from]] = collapse.seamTo;
+				state.quadrics[to].add(state.quadrics[from]);
+				state.maxError = std::max(state.maxError, collapse.error);
+				nrOfCollapses++;
+
+				// Open edges continue past the removed vertex
+				auto skipOpenEdge = [&](unsigned int vertex, unsigned int target)
+				{
+					if (target == topology.openOut[vertex])
+						topology.openIn[target] = topology.openIn[vertex];
+					else if (target == topology.openIn[vertex])
+						topology.openOut[target] = topology.openOut[vertex];
+				};
+				if (topology.kinds[collapse.from] != VertexKind::MANIFOLD)
+					skipOpenEdge(collapse.from, collapse.to);
+				if (collapse.seamTo != NONE)
+					skipOpenEdge(topology.wedge[collapse.from], collapse.seamTo);
+
+				for (unsigned int t = 0; t < nrAround; t++)
+				{
+					const unsigned int* corners = indices + around[t] * (size_t)3;
+					bool removed = false;
+					for (int k = 0; k < 3; k++)
+					{
+						state.locked[topology.remap[corners[k]]] = 1;
+						removed |= topology.remap[corners[k]] == to;
+					}
+					nrOfRemoved += removed;
+				}
+				state.locked[to] = 1;
+			}
+			if (nrOfCollapses == 0)
+				break;
+
+			// Open edges pointing at removed vertices point at where they went
+			for (unsigned int i = 0; i < nrOfVertices; i++)
+			{
+				if (topology.openOut[i] < MULTIPLE)
+					topology.openOut[i] = state.collapseRemap[topology.openOut[i]];
+				if (topology.openIn[i] < MULTIPLE)
+					topology.openIn[i] = state.collapseRemap[topology.openIn[i]];
+			}
+
+			// Collapsed triangles are dropped
+			size_t writeIndex = 0;
+			for (size_t i = 0; i < state.indexCount; i += 3)
+			{
+				unsigned int a = state.collapseRemap[indices[i]], b = state.collapseRemap[indices[i + 1]], c = state.collapseRemap[indices[i + 2]];
+				unsigned int ra = topology.remap[a], rb = topology.remap[b], rc = topology.remap[c];
+				if (ra == rb || rb == rc || ra == rc)
+					continue;
+
+				indices[writeIndex++] = a;
+				indices[writeIndex++] = b;
+				indices[writeIndex++] = c;
+			}
+			state.indexCount = writeIndex;
+		}
+	}
+
+public:
+	// Simplifies towards targetIndexCount without any collapse costing more than targetError, destination may be indices.
+	// Returns the number of indices written, resultError gets the largest relative error of the done collapses
+	static size_t simplify(unsigned int* destination, const unsigned int* indices, size_t nrOfIndices, const float* positions, size_t positionStride,
+		unsigned int nrOfVertices, size_t targetIndexCount, float targetError, float* resultError = nullptr)
+	{
+		if (destination != indices)
+			memmove(destination, indices, nrOfIndices * sizeof(unsigned int));
+
+		Simplification state;
+		beginSimplification(state, destination, nrOfIndices, positions, positionStride, nrOfVertices);
+		collapseTo(state, targetIndexCount, (double)targetError * targetError);
+
+		if (resultError)
+			*resultError = (float)std::sqrt(state.maxError);
+		return state.indexCount;
+	}
+
+	// LOD chain, LOD 0 is the last nrOfIndices of indices and every further LOD aims for LOD_TRIANGLE_RATIO of the triangles of
+	// the one before. One simplification runs through the whole chain and every LOD is a snapshot of it appended to indices,
+	// so the error of a LOD is measured against LOD 0. The chain ends early once a LOD saves too little or would need more than
+	// maxError. Returns the number of LODs written to lods, their offsets start at LOD 0
+	static unsigned int buildLodChain(std::vector<unsigned int>& indices, size_t nrOfIndices, const float* positions, size_t positionStride, unsigned int nrOfVertices,
+		MeshLod lods[MAX_MESH_LODS], unsigned int maxLods = MAX_MESH_LODS, float maxError = LOD_MAX_ERROR)
+	{
+		size_t sourceOffset = indices.size() - nrOfIndices;
+		lods[0] = MeshLod();
+		lods[0].indexCount = (unsigned int)nrOfIndices;
+
+		std::vector<unsigned int> lodIndices(indices.end() - nrOfIndices, indices.end());
+		Simplification state;
+		beginSimplification(state, lodIndices.data(), lodIndices.size(), positions, positionStride, nrOfVertices);
+
+		unsigned int nrOfLods = 1;
+		for (unsigned int lod = 1; lod < std::min(maxLods, MAX_MESH_LODS); lod++)
+		{
+			const MeshLod& previous = lods[lod - 1];
+			size_t targetTriangles = (size_t)(previous.indexCount / 3 * LOD_TRIANGLE_RATIO);
+			if (targetTriangles < LOD_MIN_TRIANGLES)
+				break;
+
+			collapseTo(state, targetTriangles * 3, (double)maxError * maxError);
+			if (state.indexCount == 0 || state.indexCount > previous.indexCount * LOD_MIN_REDUCTION)
+				break;
+
+			MeshLod& next = lods[nrOfLods++];
+			next.indexOffset = (unsigned int)(indices.size() - sourceOffset);
+			next.indexCount = (unsigned int)state.indexCount;
+			next.error = (float)std::sqrt(state.maxError);
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + state.indexCount);
+		}
+
+		return nrOfLods;
+	}
+
+	// Test and Benchmark, in MeshSimplifierTests.cpp
+	static unsigned int test();
+	static MeshSimplifierBenchmarkResult benchmark(unsigned int rings = 256, unsigned int segments = 512);
+};
+
+#endif // !MESHSIMPLIFIER_H
@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "TestSupport.h"
+#include <chrono>
+
+// Unit sphere with a uv seam where u wraps, the poles get one vertex per segment
+static void createTestSphere(unsigned int rings, unsigned int segments, std::vector<TestVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.clear();
+	indices.clear();
+	for (unsigned int ring = 0; ring <= rings; ring++)
+	{
+		float v = ring / (float)rings;
+		float theta = v * 3.14159265f;
+		for (unsigned int segment = 0; segment <= segments; segment++)
+		{
+			float u = segment / (float)segments;
+			float phi = (segment == segments ? 0.f : u) * 6.28318531f;
+			float y = ring == 0 ? 1.f : (ring == rings ? -1.f : std::cos(theta));
+			float radius = ring == 0 || ring == rings ? 0.f : std::sin(theta);
+			float x = radius * std::cos(phi), z = radius * std::sin(phi);
+			vertices.push_back({ { x, y, z }, { x, y, z }, { u, v } });
+		}
+	}
+	for (unsigned int ring = 0; ring < rings; ring++)
+	{
+		for (unsigned int segment = 0; segment < segments; segment++)
+		{
+			unsigned int corner = ring * (segments + 1) + segment;
+			unsigned int below = corner + segments + 1;
+			if (ring > 0)
+				indices.insert(indices.end(), { corner, corner + 1, below });
+			if (ring + 1 < rings)
+				indices.insert(indices.end(), { corner + 1, below + 1, below });
+		}
+	}
+}
+
+static float getArea(const std::vector<TestVertex>& vertices, const unsigned int* indices, size_t nrOfIndices)
+{
+	float area = 0.f;
+	for (size_t i = 0; i < nrOfIndices; i += 3)
+	{
+		const float* p0 = vertices[indices[i]].position;
+		const float* p1 = vertices[indices[i + 1]].position;
+		const float* p2 = vertices[indices[i + 2]].position;
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		area += std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]) * 0.5f;
+	}
+	return area;
+}
+
+unsigned int MeshSimplifier::test()
+{
+	unsigned int errors = 0;
+	std::vector<TestVertex> vertices;
+	std::vector<unsigned int> indices, simplified;
+
+	// A flat grid reaches any target for free and keeps its outline, so its area and facing stay the same
+	TestGridSettings grid;
+	grid.quadSize = 1.f / 32;
+	createTestGrid(32, vertices, indices, grid);
+	simplified.resize(indices.size());
+	float error = 1.f;
+	size_t count = simplify(simplified.data(), indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), 300, 0.001f, &error);
+	errors += count > 300 || count == 0 || count % 3 != 0;
+	errors += error > 0.0001f;
+	errors += std::fabs(getArea(vertices, simplified.data(), count) - 1.f) > 0.001f;
+	for (size_t i = 0; i < count; i += 3)
+	{
+		const float* p0 = vertices[simplified[i]].position;
+		const float* p1 = vertices[simplified[i + 1]].position;
+		const float* p2 = vertices[simplified[i + 2]].position;
+		float normalY = (p1[2] - p0[2]) * (p2[0] - p0[0]) - (p1[0] - p0[0]) * (p2[2] - p0[2]);
+		errors += normalY <= 0.f;
+	}
+
+	// A bent grid stops at the error limit, a zero limit only allows collapses along its straight lines
+	grid.height = 0.5f;
+	createTestGrid(32, vertices, indices, grid);
+	simplified.resize(indices.size());
+	count = simplify(simplified.data(), indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), 0, 0.02f, &error);
+	errors += count == 0 || count >= indices.size() || error > 0.02f;
+	count = simplify(simplified.data(), indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), 0, 0.f, &error);
+	errors += count == 0 || error != 0.f;
+
+	// A sphere keeps its shape and its seam, a triangle reaching across the seam would span most of the uv range
+	createTestSphere(32, 64, vertices, indices);
+	simplified.resize(indices.size());
+	size_t target = indices.size() / 4 / 3 * 3;
+	count = simplify(simplified.data(), indices.data(), indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), target, 0.1f, &error);
+	errors += count > target || count < target / 2;
+	errors += error > 0.1f;
+	for (size_t i = 0; i < count; i += 3)
+	{
+		float minU = 1.f, maxU = 0.f;
+		for (int k = 0; k < 3; k++)
+		{
+			const TestVertex& vertex = vertices[simplified[i + k]];
+			errors += simplified[i + k] >= vertices.size();
+			errors += std::fabs(length({ vertex.position[0], vertex.position[1], vertex.position[2] }) - 1.f) > 0.0001f;
+			minU = std::min(minU, vertex.texCoord[0]);
+			maxU = std::max(maxU, vertex.texCoord[0]);
+		}
+		errors += maxU - minU > 0.5f;
+		errors += simplified[i] == simplified[i + 1] || simplified[i + 1] == simplified[i + 2] || simplified[i] == simplified[i + 2];
+	}
+
+	// Chain, fewer triangles and no smaller errors with every LOD, all indexing LOD 0's vertices
+	MeshLod lods[MAX_MESH_LODS];
+	std::vector<unsigned int> chain = indices;
+	unsigned int nrOfLods = buildLodChain(chain, indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), lods);
+	errors += nrOfLods < 3;
+	errors += lods[0].indexOffset != 0 || lods[0].indexCount != indices.size() || lods[0].error != 0.f;
+	for (unsigned int lod = 1; lod < nrOfLods; lod++)
+	{
+		errors += lods[lod].indexCount >= lods[lod - 1].indexCount;
+		errors += lods[lod].error < lods[lod - 1].error;
+		errors += lods[lod].indexOffset != lods[lod - 1].indexOffset + lods[lod - 1].indexCount;
+	}
+	errors += chain.size() != lods[nrOfLods - 1].indexOffset + lods[nrOfLods - 1].indexCount;
+	for (unsigned int index : chain)
+		errors += index >= vertices.size();
+
+	// Tiny and empty meshes
+	const unsigned int triangle[3] = { 0, 1, 2 };
+	unsigned int destination[3];
+	count = simplify(destination, triangle, 3, vertices[0].position, sizeof(TestVertex), 3, 0, 1.f);
+	errors += count != 3 && count != 0;
+	errors += simplify(destination, triangle, 0, vertices[0].position, sizeof(TestVertex), 0, 0, 1.f) != 0;
+	std::vector<unsigned int> tinyChain(triangle, triangle + 3);
+	errors += buildLodChain(tinyChain, 3, vertices[0].position, sizeof(TestVertex), 3, lods) != 1 || tinyChain.size() != 3;
+
+	return errors;
+}
+
+// Benchmark, LOD chain of a noisy sphere
+MeshSimplifierBenchmarkResult MeshSimplifier::benchmark(unsigned int rings, unsigned int segments)
+{
+	std::vector<TestVertex> vertices;
+	std::vector<unsigned int> indices;
+	createTestSphere(rings, segments, vertices, indices);
+
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<float> noise(0.999f, 1.001f);
+	for (size_t i = 0; i < vertices.size(); i += segments + 1)
+	{
+		// The seam column keeps matching its twin
+		for (unsigned int segment = 0; segment < segments; segment++)
+		{
+			float scale = noise(generator);
+			for (int k = 0; k < 3; k++)
+				vertices[i + segment].position[k] *= scale;
+		}
+		for (int k = 0; k < 3; k++)
+			vertices[i + segments].position[k] = vertices[i].position[k];
+	}
+
+	MeshSimplifierBenchmarkResult result;
+	MeshLod lods[MAX_MESH_LODS];
+	auto startTime = std::chrono::steady_clock::now();
+	result.nrOfLods = buildLodChain(indices, indices.size(), vertices[0].position, sizeof(TestVertex), (unsigned int)vertices.size(), lods);
+	result.simplifyTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	for (unsigned int lod = 0; lod < result.nrOfLods; lod++)
+	{
+		result.nrOfTriangles[lod] = lods[lod].indexCount / 3;
+		result.error[lod] = lods[lod].error;
+	}
+
+	return result;
+}
@@ -2,7 +2,11 @@
 #ifndef MODEL_H
 #define MODEL_H
 
-#include "Mesh.h"
+#include "ModelCache.h"
+#include "InstanceBatcher.h"
+
+// Instances carry what the object would have written to its own constant buffer
+using ModelInstanceBatcher = InstanceBatcher<VS_WVP_CBUFFER>;
 
 class Model
 {
@@ -14,286 +18,54 @@ private:
 	// Name
 	std::string m_name;
 
-	// Vertices
-	std::vector<XMFLOAT3> m_vertices;
-	std::vector<UINT> m_indices;
+	// Shared Model Data
+	std::shared_ptr<const ModelData> m_modelData;
+
+	// Model Space Bounds
+	BoundingBox m_boundingBox;
 
 	// Meshes
-	std::vector<Mesh<VertexPosNormTexTan>*> m_meshes;
+	std::vector<Mesh<VertexPosNormTexTanQuantized>*> m_meshes;
 
 	// Helper Functions
-	Mesh<VertexPosNormTexTan>* processMesh(aiMesh* mesh, const aiScene* scene, int meshIndex = -1, std::vector<MeshData>* meshData = nullptr)
+	Mesh<VertexPosNormTexTanQuantized>* createMesh(const MeshGeometry& geometry, int meshIndex = -1, std::vector<MeshData>* meshData = nullptr)
 	{
-		std::vector<VertexPosNormTexTan> vertices;
-		std::vector<UINT> indices;
-
-		int indexOffset = (int)m_vertices.size(); // Vertex offset for indices index
-		m_vertices.reserve(m_vertices.size() + mesh->mNumVertices);
-		m_indices.reserve(m_indices.size() + mesh->mNumFaces * (unsigned int)3);
-
-		// Vertices
-		for (UINT i = 0; i < mesh->mNumVertices; i++)
-		{
-			VertexPosNormTexTan vertex;
-
-			vertex.position = { mesh->mVertices[i].x,
-								mesh->mVertices[i].y,
-								mesh->mVertices[i].z };
-
-			if (mesh->HasNormals())
-			{
-				vertex.normal = {	mesh->mNormals[i].x,
-									mesh->mNormals[i].y,
-									mesh->mNormals[i].z };
-			}
-			if (mesh->HasTangentsAndBitangents())
-			{
-				vertex.tangent = {	mesh->mTangents[i].x,
-									mesh->mTangents[i].y,
-									mesh->mTangents[i].z };
-
-				vertex.bitangent = {mesh->mBitangents[i].x,
-									mesh->mBitangents[i].y,
-									mesh->mBitangents[i].z };
-			}
-			if (mesh->mTextureCoords[0])
-				vertex.texCoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
-
-			vertices.push_back(vertex);
-			m_vertices.push_back(vertex.position);
-		}
-
-		// Indices
-		for (UINT i = 0; i < mesh->mNumFaces; i++)
-		{
-			aiFace face = mesh->mFaces[i];
-			for (UINT i = 0; i < face.mNumIndices; i++)
-			{
-				indices.push_back(face.mIndices[i]);
-				m_indices.push_back(indexOffset + face.mIndices[i]);
-			}
-		}
-
 		// Material Values
 		PS_MATERIAL_BUFFER material;
 		PS_MATERIAL_PBR_BUFFER materialPBR;
-		aiMaterial* aMaterial = scene->mMaterials[mesh->mMaterialIndex];
-		aiColor3D color(0.f, 0.f, 0.f);
 
 		TexturePaths texturePaths;
 		TexturePathsPBR texturePathsPBR;
 
-
+		// Imported Material, replaced by the map's mesh data when there is any
+		material = geometry.material;
+		materialPBR = geometry.materialPBR;
+		texturePaths = geometry.texturePaths;
+		texturePathsPBR = geometry.texturePathsPBR;
 		if (meshData) // not nullptr
-		{
-			switch (meshData->at(meshIndex).matType)
-			{
-			case PHONG:
-				texturePaths.diffusePath = meshData->at(meshIndex).matPhong.diffusePath;
-				texturePathsPBR.albedoPath = texturePaths.diffusePath;
-
-				texturePaths.normalPath = meshData->at(meshIndex).matPhong.normalPath;
-				texturePathsPBR.normalPath = texturePaths.normalPath;
-
-				texturePaths.specularPath = meshData->at(meshIndex).matPhong.specularPath;
-
-				texturePaths.displacementPath = meshData->at(meshIndex).matPhong.displacementPath;
-				texturePathsPBR.displacementPath = texturePaths.displacementPath;
-
-				material.emissive = meshData->at(meshIndex).matPhong.emissive;
-				material.ambient = meshData->at(meshIndex).matPhong.ambient;
-				material.diffuse = meshData->at(meshIndex).matPhong.diffuse;
-				material.specular = meshData->at(meshIndex).matPhong.specular;
-				material.shininess = meshData->at(meshIndex).matPhong.shininess;
-
-				material.diffTextureExists = meshData->at(meshIndex).matPhong.diffTextureExists;
-				material.specTextureExists = meshData->at(meshIndex).matPhong.specTextureExists;
-				material.normTextureExists = meshData->at(meshIndex).matPhong.normTextureExists;
-				break;
-			case PBR:
-				texturePathsPBR.albedoPath = meshData->at(meshIndex).matPBR.albedoPath;
-				texturePaths.diffusePath = texturePathsPBR.albedoPath;
-
-				texturePathsPBR.normalPath = meshData->at(meshIndex).matPBR.normalPath;
-				texturePaths.normalPath = texturePathsPBR.normalPath;
-
-				texturePathsPBR.metallicPath = meshData->at(meshIndex).matPBR.metallicPath;
-				texturePathsPBR.roughnessPath = meshData->at(meshIndex).matPBR.roughnessPath;
-				texturePathsPBR.emissivePath = meshData->at(meshIndex).matPBR.emissivePath;
-				texturePathsPBR.ambientOcclusionPath = meshData->at(meshIndex).matPBR.ambientOcclusionPath;
-
-				texturePathsPBR.displacementPath = meshData->at(meshIndex).matPBR.displacementPath;
-				texturePaths.displacementPath = texturePathsPBR.displacementPath;
-
-				materialPBR.albedo = meshData->at(meshIndex).matPBR.albedo;
-				materialPBR.metallic = meshData->at(meshIndex).matPBR.metallic;
-				materialPBR.roughness = meshData->at(meshIndex).matPBR.roughness;
-				materialPBR.emissiveStrength = meshData->at(meshIndex).matPBR.emissiveStrength;
-				materialPBR.materialTextured = meshData->at(meshIndex).matPBR.materialTextured;
-				materialPBR.emissiveTextured = meshData->at(meshIndex).matPBR.emissiveTextured;
-
-				break;
-			default:
-				break;
-			}
-		}
-		else
-		{
-			aMaterial->Get(AI_MATKEY_COLOR_EMISSIVE, color);
-			material.emissive = XMFLOAT4(color.r, color.g, color.b, 1.f);
-			XMVECTOR emVector = XMLoadFloat4(&material.emissive);
-			materialPBR.emissiveStrength = DirectX::XMVector3Length(emVector).m128_f32[0];
-
-			aMaterial->Get(AI_MATKEY_COLOR_AMBIENT, color);
-			material.ambient = XMFLOAT4(color.r, color.g, color.b, 1.f);
-
-			aMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-			material.diffuse = XMFLOAT4(color.r, color.g, color.b, 1.f);
-			materialPBR.albedo = XMFLOAT3(color.r, color.g, color.b);
-
-			if (material.ambient.x == material.diffuse.x &&
-				material.ambient.y == material.diffuse.y &&
-				material.ambient.z == material.diffuse.z)
-			{
-				material.ambient = XMFLOAT4(.1f, .1f, .1f, 1.f);
-				material.diffuse = XMFLOAT4(1.f, 1.f, 1.f, 1.f);
-				materialPBR.albedo = XMFLOAT3(1.f, 1.f, 1.f);
-			}
-			aMaterial->Get(AI_MATKEY_COLOR_SPECULAR, color);
-			material.specular = XMFLOAT4(color.r, color.g, color.b, 1.f);
-			XMVECTOR specVector = XMLoadFloat4(&material.specular);
-			materialPBR.metallic = DirectX::XMVector3Length(specVector).m128_f32[0];
-
-			aMaterial->Get(AI_MATKEY_SHININESS, material.shininess);
-			if (material.shininess == 0.f)
-				material.shininess = 30.f;
-			else
-				material.shininess /= 4.f; // Assimps scales by * 4, this reverses it
-			materialPBR.roughness = std::pow(1 - material.shininess, 2.f);
-
-
-			// Material Textures
-			aiString texturePath;
-
-			if (aMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0 && aMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePaths.diffusePath = texturePathsPBR.albedoPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_NORMALS) > 0 && aMaterial->GetTexture(aiTextureType_NORMALS, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePaths.normalPath = texturePathsPBR.normalPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_SPECULAR) > 0 && aMaterial->GetTexture(aiTextureType_SPECULAR, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePaths.specularPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_METALNESS) > 0 && aMaterial->GetTexture(aiTextureType_METALNESS, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePathsPBR.metallicPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_SHININESS) > 0 && aMaterial->GetTexture(aiTextureType_SHININESS, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePathsPBR.roughnessPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_AMBIENT) > 0 && aMaterial->GetTexture(aiTextureType_AMBIENT, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePathsPBR.ambientOcclusionPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
+			applyMeshData(meshData->at(meshIndex), material, materialPBR, texturePaths, texturePathsPBR);
 
-			if (aMaterial->GetTextureCount(aiTextureType_EMISSIVE) > 0 && aMaterial->GetTexture(aiTextureType_EMISSIVE, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePathsPBR.emissivePath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-			if (aMaterial->GetTextureCount(aiTextureType_DISPLACEMENT) > 0 && aMaterial->GetTexture(aiTextureType_DISPLACEMENT, 0, &texturePath) == AI_SUCCESS)
-			{
-				std::string strTexturePath(texturePath.C_Str());
-				size_t pos = strTexturePath.find("Textures\\");
-				strTexturePath.erase(0, pos);
-
-				texturePaths.displacementPath = texturePathsPBR.displacementPath = extractFileName(charToWchar(strTexturePath.c_str()).c_str());
-			}
-
-
-			aiString fileBaseColor, fileMetallicRoughness;
-			aMaterial->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_TEXTURE, &fileBaseColor);
-			aMaterial->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &fileMetallicRoughness);
-
-			if (fileMetallicRoughness.length > 0)
-			{
-				texturePathsPBR.metallicPath = extractFileName(charToWchar(fileMetallicRoughness.C_Str()).c_str());
-				texturePathsPBR.roughnessPath = extractFileName(charToWchar(fileMetallicRoughness.C_Str()).c_str());
-			}
-		}
-
-		Mesh<VertexPosNormTexTan>* finalMesh = new Mesh<VertexPosNormTexTan>(m_device, m_deviceContext, vertices, indices, material, texturePaths, mesh->mName.C_Str());
+		Mesh<VertexPosNormTexTanQuantized>* finalMesh = new Mesh<VertexPosNormTexTanQuantized>(m_device, m_deviceContext, geometry.vertexBuffer, geometry.indexBuffer, material, texturePaths, geometry.name);
+		finalMesh->setQuantization(geometry.quantizationBuffer);
+		finalMesh->setLods(geometry.lods, geometry.nrOfLods);
 		if (meshData && meshData->at(meshIndex).matType == PBR)
 			finalMesh->setMaterial(materialPBR);
 		finalMesh->setTextures(texturePathsPBR);
 
 		return finalMesh;
 	}
-	void processNodes(aiNode* node, const aiScene* scene, std::vector<MeshData>* meshData = nullptr)
-	{
-		for (UINT i = 0; i < node->mNumMeshes; i++)
-		{
-			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			m_meshes.push_back(processMesh(mesh, scene, (int)m_meshes.size(), meshData));
-		}
-
-		for (UINT i = 0; i < node->mNumChildren; i++)
-			processNodes(node->mChildren[i], scene, meshData);
-	}
 	bool loadModel(std::string& modelName, std::vector<MeshData>* meshData = nullptr)
 	{
-		std::string modelPath = "Models\\" + modelName;
-		Assimp::Importer importer;
-
-		const aiScene* pScene = importer.ReadFile(modelPath, aiProcess_Triangulate | aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace);
-		// Assimp tries to load gltf2 files with gltf1 importer first for some reason and throws a exception, 
-		// just ignore it as it will import with version 2 of the importer right after
-		
-		if (!pScene) // if nullptr
+		m_modelData = ModelCache::getInstance().getModel(modelName, MODEL_IMPORT_FLAGS);
+		if (!m_modelData) // if nullptr
 			return false;
+		m_boundingBox = m_modelData->boundingBox;
 
-		processNodes(pScene->mRootNode, pScene, meshData);
+		// Instance meshes share the cached geometry but get their own materials
+		m_meshes.reserve(m_modelData->meshes.size());
+		for (size_t i = 0; i < m_modelData->meshes.size(); i++)
+			m_meshes.push_back(createMesh(m_modelData->meshes[i], (int)i, meshData));
 
-		OutputDebugStringA("Model loaded: ");
-		OutputDebugStringA(modelName.c_str());
-		OutputDebugStringA("\n");
 		return true;
 	}
 
@@ -305,10 +77,78 @@ public:
 	}
 	Model(const Model& otherModel)
 	{
-		m_deviceContext = otherModel.m_deviceContext;
+		m_device = otherModel.m_device;
 		m_deviceContext = otherModel.m_deviceContext;
 		m_name = otherModel.m_name;
-		m_meshes = otherModel.m_meshes;
+		m_modelData = otherModel.m_modelData;
+		m_boundingBox = otherModel.m_boundingBox;
+		for (size_t i = 0; i < otherModel.m_meshes.size(); i++)
+			m_meshes.push_back(new Mesh<VertexPosNormTexTanQuantized>(*otherModel.m_meshes[i]));
+	}
+	~Model()
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+			delete m_meshes[i];
+	}
+
+	// Map mesh data replaces the imported material values and texture paths
+	static void applyMeshData(const MeshData& meshData, PS_MATERIAL_BUFFER& material, PS_MATERIAL_PBR_BUFFER& materialPBR, TexturePaths& texturePaths, TexturePathsPBR& texturePathsPBR)
+	{
+		material = PS_MATERIAL_BUFFER();
+		materialPBR = PS_MATERIAL_PBR_BUFFER();
+		texturePaths = TexturePaths();
+		texturePathsPBR = TexturePathsPBR();
+
+		switch (meshData.matType)
+		{
+		case PHONG:
+			texturePaths.diffusePath = meshData.matPhong.diffusePath;
+			texturePathsPBR.albedoPath = texturePaths.diffusePath;
+
+			texturePaths.normalPath = meshData.matPhong.normalPath;
+			texturePathsPBR.normalPath = texturePaths.normalPath;
+
+			texturePaths.specularPath = meshData.matPhong.specularPath;
+
+			texturePaths.displacementPath = meshData.matPhong.displacementPath;
+			texturePathsPBR.displacementPath = texturePaths.displacementPath;
+
+			material.emissive = meshData.matPhong.emissive;
+			material.ambient = meshData.matPhong.ambient;
+			material.diffuse = meshData.matPhong.diffuse;
+			material.specular = meshData.matPhong.specular;
+			material.shininess = meshData.matPhong.shininess;
+
+			material.diffTextureExists = meshData.matPhong.diffTextureExists;
+			material.specTextureExists = meshData.matPhong.specTextureExists;
+			material.normTextureExists = meshData.matPhong.normTextureExists;
+			break;
+		case PBR:
+			texturePathsPBR.albedoPath = meshData.matPBR.albedoPath;
+			texturePaths.diffusePath = texturePathsPBR.albedoPath;
+
+			texturePathsPBR.normalPath = meshData.matPBR.normalPath;
+			texturePaths.normalPath = texturePathsPBR.normalPath;
+
+			texturePathsPBR.metallicPath = meshData.matPBR.metallicPath;
+			texturePathsPBR.roughnessPath = meshData.matPBR.roughnessPath;
+			texturePathsPBR.emissivePath = meshData.matPBR.emissivePath;
+			texturePathsPBR.ambientOcclusionPath = meshData.matPBR.ambientOcclusionPath;
+
+			texturePathsPBR.displacementPath = meshData.matPBR.displacementPath;
+			texturePaths.displacementPath = texturePathsPBR.displacementPath;
+
+			materialPBR.albedo = meshData.matPBR.albedo;
+			materialPBR.metallic = meshData.matPBR.metallic;
+			materialPBR.roughness = meshData.matPBR.roughness;
+			materialPBR.emissiveStrength = meshData.matPBR.emissiveStrength;
+			materialPBR.materialTextured = meshData.matPBR.materialTextured;
+			materialPBR.emissiveTextured = meshData.matPBR.emissiveTextured;
+
+			break;
+		default:
+			break;
+		}
 	}
 
 	// Initialization
@@ -357,59 +197,63 @@ public:
 			material.diffuse = XMFLOAT4(0.13f, .25f, 0.004f, 1.f); // Forest Green
 			material.specular = XMFLOAT4(.1f, .1f, 0.1f, 1.f);
 			material.shininess = 32.f;
-			auto* finalMesh = new Mesh<VertexPosNormTexTan>(m_device, m_deviceContext, vertices, indices, material, TexturePaths(), "Plane");
+			// Quantized like the cached meshes so it draws with the same shaders
+			std::vector<VertexPosNormTexTanQuantized> quantizedVertices(vertices.size());
+			VertexQuantizationBounds bounds = VertexQuantizer::encode(vertices.data(), vertices.size(), quantizedVertices.data());
+			Buffer<VS_QUANTIZATION_CBUFFER> quantizationBuffer;
+			initializeQuantizationBuffer(m_device, m_deviceContext, bounds, quantizationBuffer);
+
+			auto* finalMesh = new Mesh<VertexPosNormTexTanQuantized>(m_device, m_deviceContext, quantizedVertices, indices, material, TexturePaths(), "Plane");
+			finalMesh->setQuantization(quantizationBuffer);
 			m_meshes.push_back(finalMesh);
 			m_meshes.back()->setName(id + "_Default");
+
+			BoundingBox::CreateFromPoints(m_boundingBox, vertices.size(), &vertices[0].position, sizeof(VertexPosNormTexTan));
 		}
 		else
 			if (!loadModel(modelName, meshData))
 				assert(!"Error, failed to load Model!");
 	}
 
+	// Getters
+	const BoundingBox& getBoundingBox() const { return m_boundingBox; }
+
 	// Picking
+	bool pickClosest(XMVECTOR rayOrigin, XMVECTOR rayDirection, float& distance) const
+	{
+		if (!m_modelData)
+			return false;
+
+		UINT triangle = 0;
+		return m_modelData->bvh.intersect(m_modelData->vertices, m_modelData->indices, rayOrigin, XMVector3Normalize(rayDirection), distance, triangle);
+	}
 	float pick(XMVECTOR rayOrigin, XMVECTOR rayDirection, char dimension = 'n')
 	{
-		UINT i0;
-		UINT i1;
-		UINT i2;
 		float distance = 0.f;
-		SimpleMath::Ray ray(rayOrigin, rayDirection);
-		size_t nrOfFaces = m_indices.size() / 3;
-		for (size_t i = 0; i < nrOfFaces; i++)
-		{
-			i0 = m_indices[i * 3 + 0];
-			i1 = m_indices[i * 3 + 1];
-			i2 = m_indices[i * 3 + 2];
-
-			if (ray.Intersects(m_vertices[i0], m_vertices[i1], m_vertices[i2], distance))
-			{
-				SimpleMath::Vector3 rayDirectionNorm = ray.direction;
-				rayDirectionNorm.Normalize();
+		if (!pickClosest(rayOrigin, rayDirection, distance))
+			return 0.f; // Not Hit
 
-				XMFLOAT3 hitPosition = (rayDirectionNorm * distance) + ray.position;
+		XMFLOAT3 hitPosition;
+		XMStoreFloat3(&hitPosition, rayOrigin + XMVector3Normalize(rayDirection) * distance);
 
-				switch (dimension)
-				{
-				case 'x':
-					return hitPosition.y;
-					break;
+		switch (dimension)
+		{
+		case 'x':
+			return hitPosition.x;
+			break;
 
-				case 'y':
-					return hitPosition.y;
-					break;
+		case 'y':
+			return hitPosition.y;
+			break;
 
-				case 'z':
-					return hitPosition.y;
-					break;
+		case 'z':
+			return hitPosition.z;
+			break;
 
-				default:
-					return 1.f; // Normal Hit without position in specific dimension
-					break;
-				}
-				return true;
-			}
+		default:
+			return 1.f; // Normal Hit without position in specific dimension
+			break;
 		}
-		return 0.f; // Not Hit
 	}
 
 	// Setters
@@ -475,12 +319,48 @@ public:
 			m_meshes[i]->fillMeshData(&meshes->at(i));
 	}
 
+	// LOD
+	UINT selectLod(float projectedRadius, UINT currentLod, float maxPixelError = LOD_MAX_PIXEL_ERROR) const
+	{
+		if (!m_modelData) // Models without cached data have no LODs
+			return 0;
+		return LodSelector::selectLod(projectedRadius, m_modelData->lodErrors, m_modelData->nrOfLods, currentLod, maxPixelError);
+	}
+
+	UINT getNrOfTriangles(UINT lod = 0) const
+	{
+		UINT nrOfTriangles = 0;
+		for (size_t i = 0; i < m_meshes.size(); i++)
+			nrOfTriangles += m_meshes[i]->getIndexCount(lod) / 3;
+		return nrOfTriangles;
+	}
+
 	// Render
 	void render()
 	{
 		for (size_t i = 0; i < m_meshes.size(); i++)
 			m_meshes[i]->render();
 	}
+
+	// Adds one draw per mesh for the given LOD, objectDraw holds the state shared by every mesh
+	void gatherDraws(ModelInstanceBatcher& batcher, RenderPass pass, const RenderDraw& objectDraw, const void* instancedShader, float depth, const VS_WVP_CBUFFER& instance, UINT lod = 0)
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			RenderDraw draw = objectDraw;
+			m_meshes[i]->fillDraw(draw, pass == RenderPass::SHADOW, lod);
+			batcher.add(draw, instancedShader, depth, instance);
+		}
+	}
+
+	// Occluder triangles, picked once per model, placed with the object's world matrix
+	void rasterizeOccluder(OcclusionCuller& culler, const XMFLOAT4X4& worldMatrix) const
+	{
+		if (!m_modelData || m_modelData->occluderIndices.empty())
+			return;
+
+		culler.rasterizeOccluder((const float*)m_modelData->vertices.data(), m_modelData->occluderIndices.data(), m_modelData->occluderIndices.size(), &worldMatrix.m[0][0]);
+	}
 };
 
 #endif // !MODEL_H
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "pch.h"
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include "Mesh.h"
+#include "MeshCooker.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+
+// Imported geometry of one mesh, shared between every instance of the model
+struct MeshGeometry
+{
+	std::string name;
+	std::shared_ptr< Buffer<VertexPosNormTexTanQuantized> > vertexBuffer;
+	Buffer<VS_QUANTIZATION_CBUFFER> quantizationBuffer; // Bounds the vertices are decoded with
+	Buffer<UINT> indexBuffer; // Every LOD, LOD 0 first
+	UINT nrOfLods = 1;
+	MeshLod lods[MAX_MESH_LODS];
+
+	// Imported Material, used when no mesh data is given
+	PS_MATERIAL_BUFFER material;
+	PS_MATERIAL_PBR_BUFFER materialPBR;
+	TexturePaths texturePaths;
+	TexturePathsPBR texturePathsPBR;
+};
+
+struct ModelData
+{
+	std::string modelFile;
+	UINT importFlags = 0;
+	std::vector<MeshGeometry> meshes;
+
+	// Picking
+	std::vector<XMFLOAT3> vertices;
+	std::vector<UINT> indices;
+	BVH bvh;
+
+	// Occlusion, the largest triangles indexing the picking vertices
+	std::vector<UINT> occluderIndices;
+
+	// Model Space Bounds
+	BoundingBox boundingBox;
+
+	// LODs, errors are relative to half the diagonal of the model bounds and meshes with fewer LODs stay at their last one
+	UINT nrOfLods = 1;
+	float lodErrors[MAX_MESH_LODS] = {};
+
+	// Vertex and index buffers plus the picking copies and hierarchy
+	size_t sizeInBytes = 0;
+};
+
+class ModelCache
+{
+private:
+	ModelCache() {};
+	// Device
+	ID3D11Device* m_device = nullptr;
+	ID3D11DeviceContext* m_deviceContext = nullptr;
+
+	// Models, entries expire when the last instance releases its model data
+	using ModelKey = std::pair<std::string, UINT>;
+	std::map<ModelKey, std::weak_ptr<const ModelData>> m_models;
+
+	// Stats
+	UINT m_cacheHits = 0;
+	UINT m_cacheMisses = 0;
+
+	// Helper Functions
+	std::shared_ptr<const ModelData> loadModel(const std::string& modelFile, UINT importFlags)
+	{
+		ImportedModel importedModel;
+		if (!MeshCooker::loadModel(modelFile, importFlags, importedModel))
+			return nullptr;
+
+		std::shared_ptr<ModelData> modelData = std::make_shared<ModelData>();
+		modelData->modelFile = modelFile;
+		modelData->importFlags = importFlags;
+		modelData->boundingBox = importedModel.boundingBox;
+		modelData->meshes.resize(importedModel.meshes.size());
+
+		// Picking, indices are offset into the model wide vertex list
+		MeshCooker::getPickingGeometry(importedModel, modelData->vertices, modelData->indices);
+		modelData->sizeInBytes += modelData->vertices.size() * sizeof(XMFLOAT3) + modelData->indices.size() * sizeof(UINT);
+
+		for (size_t i = 0; i < importedModel.meshes.size(); i++)
+		{
+			const ImportedMesh& importedMesh = importedModel.meshes[i];
+			const ImportedMaterial& importedMaterial = importedModel.materials[importedMesh.materialSlot];
+			MeshGeometry& geometry = modelData->meshes[i];
+
+			// Geometry
+			geometry.name = importedMesh.name;
+			geometry.vertexBuffer = std::make_shared< Buffer<VertexPosNormTexTanQuantized> >();
+			geometry.vertexBuffer->initialize(m_device, m_deviceContext, importedModel.quantizedVertices.data() + importedMesh.vertexOffset, BufferType::VERTEX, importedMesh.vertexCount);
+			initializeQuantizationBuffer(m_device, m_deviceContext, importedMesh.quantization, geometry.quantizationBuffer);
+			if (importedMesh.indexCount > 0 && !importedModel.indices16.empty())
+				geometry.indexBuffer.initializeIndices(m_device, m_deviceContext, importedModel.indices16.data() + importedMesh.indexOffset, importedMesh.getLodIndexCount());
+			else if (importedMesh.indexCount > 0)
+				geometry.indexBuffer.initializeIndices(m_device, m_deviceContext, importedModel.indices.data() + importedMesh.indexOffset, importedMesh.getLodIndexCount(), importedMesh.vertexCount);
+
+			modelData->sizeInBytes += importedMesh.vertexCount * sizeof(VertexPosNormTexTanQuantized) + importedMesh.getLodIndexCount() * (size_t)*geometry.indexBuffer.getStridePointer();
+
+			// LODs
+			geometry.nrOfLods = importedMesh.nrOfLods;
+			std::copy(importedMesh.lods, importedMesh.lods + MAX_MESH_LODS, geometry.lods);
+
+			float meshRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&importedMesh.boundingBox.Extents)));
+			float modelRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&importedModel.boundingBox.Extents)));
+			modelData->nrOfLods = std::max(modelData->nrOfLods, importedMesh.nrOfLods);
+			for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+			{
+				const MeshLod& meshLod = importedMesh.lods[std::min(lod, importedMesh.nrOfLods - 1)];
+				if (modelRadius > 0.f)
+					modelData->lodErrors[lod] = std::max(modelData->lodErrors[lod], meshLod.error * meshRadius / modelRadius);
+			}
+
+			// Imported Material
+			geometry.material = importedMaterial.material;
+			geometry.materialPBR = importedMaterial.materialPBR;
+			geometry.texturePaths = importedMaterial.texturePaths;
+			geometry.texturePathsPBR = importedMaterial.texturePathsPBR;
+		}
+
+		// Picking Hierarchy and Occluders, shared by every instance and taken from the cooked file when there is one
+		if (importedModel.hasPickingData)
+		{
+			modelData->bvh = std::move(importedModel.bvh);
+			modelData->occluderIndices = std::move(importedModel.occluderIndices);
+		}
+		else
+		{
+			modelData->bvh.build(modelData->vertices, modelData->indices);
+			OcclusionCuller::selectOccluderTriangles((const float*)modelData->vertices.data(), modelData->indices.data(), modelData->indices.size(), OCCLUDER_MAX_TRIANGLES, modelData->occluderIndices);
+		}
+		modelData->sizeInBytes += modelData->bvh.getSizeInBytes();
+		modelData->sizeInBytes += modelData->occluderIndices.size() * sizeof(UINT);
+
+		return modelData;
+	}
+
+public:
+	ModelCache(ModelCache const&) = delete;
+	void operator=(ModelCache const&) = delete;
+	static ModelCache& getInstance()
+	{
+		static ModelCache cacheInstance;
+		return cacheInstance;
+	}
+
+	void initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+	{
+		m_device = device;
+		m_deviceContext = deviceContext;
+	}
+
+	std::shared_ptr<const ModelData> getModel(const std::string& modelFile, UINT importFlags = MODEL_IMPORT_FLAGS)
+	{
+		ModelKey key(modelFile, importFlags);
+		auto it = m_models.find(key);
+		if (it != m_models.end())
+		{
+			std::shared_ptr<const ModelData> modelData = it->second.lock();
+			if (modelData)
+			{
+				m_cacheHits++;
+				return modelData;
+			}
+		}
+
+		m_cacheMisses++;
+		std::shared_ptr<const ModelData> modelData = loadModel(modelFile, importFlags);
+		if (modelData)
+			m_models[key] = modelData;
+
+		return modelData;
+	}
+
+	// Stats
+	UINT getCacheHits() const { return m_cacheHits; }
+	UINT getCacheMisses() const { return m_cacheMisses; }
+	UINT getNrOfUniqueModels() const
+	{
+		UINT nrOfModels = 0;
+		for (auto& model : m_models)
+		{
+			if (!model.second.expired())
+				nrOfModels++;
+		}
+		return nrOfModels;
+	}
+	size_t getResidentBytes() const
+	{
+		size_t residentBytes = 0;
+		for (auto& model : m_models)
+		{
+			std::shared_ptr<const ModelData> modelData = model.second.lock();
+			if (modelData)
+				residentBytes += modelData->sizeInBytes;
+		}
+		return residentBytes;
+	}
+
+	// UI
+	void updateUI()
+	{
+		ImGui::Text("Unique Models: %u", getNrOfUniqueModels());
+		ImGui::Text("Cache Hits: %u, Misses: %u", m_cacheHits, m_cacheMisses);
+		ImGui::Text("Resident Geometry: %.2f MB", (double)getResidentBytes() / (1024.0 * 1024.0));
+	}
+};
+
+#endif // !MODELCACHE_H
@@ -0,0 +1,558 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Pure CPU occlusion culling, occluder triangles are rasterized into a small depth buffer and bounds are tested against it.
+// Matrices are row major and transform row vectors, the DirectXMath layout, and depth is z / w in [0, 1]
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define OCCLUSIONCULLER_SSE
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+const unsigned int OCCLUSION_BUFFER_WIDTH = 256; // Multiple of the tile size
+const unsigned int OCCLUSION_BUFFER_HEIGHT = 128;
+const unsigned int OCCLUSION_TILE_SIZE = 8; // Pixels per side of a coarse level tile
+const unsigned int OCCLUSION_TILES_X = OCCLUSION_BUFFER_WIDTH / OCCLUSION_TILE_SIZE;
+const unsigned int OCCLUSION_TILES_Y = OCCLUSION_BUFFER_HEIGHT / OCCLUSION_TILE_SIZE;
+const unsigned int OCCLUDER_MAX_TRIANGLES = 256; // Per model, the largest ones
+const unsigned int OCCLUSION_MAX_OCCLUDERS = 16; // Per frame, the largest objects on screen
+const float OCCLUDER_MIN_SIZE = 0.01f; // Squared bounds radius over squared camera distance
+
+struct OcclusionStats
+{
+	unsigned int occluders = 0;
+	unsigned int occluderTriangles = 0; // Submitted
+	unsigned int rasterizedTriangles = 0; // Front facing and on screen
+	unsigned int tested = 0;
+	unsigned int rejected = 0;
+};
+
+struct OcclusionBenchmarkResult
+{
+	unsigned int nrOfObjects = 0;
+	unsigned int nrOfFrames = 0;
+	OcclusionStats stats; // Summed over all frames
+
+	// Average microseconds per frame
+	double rasterizeTime = 0.0;
+	double testTime = 0.0;
+	double scalarRasterizeTime = 0.0;
+	double scalarTestTime = 0.0;
+
+	unsigned int errors = 0; // Objects where the tile hierarchy and a per pixel test disagree, over all frames
+};
+
+class OcclusionCuller
+{
+private:
+	struct ClipVertex
+	{
+		float x, y, z, w;
+	};
+
+	std::vector<float> m_depth; // Per pixel, 1 where nothing has been rasterized
+	std::vector<float> m_tileMaxDepth; // Farthest depth per tile, an object nearer than it is not hidden by that tile
+	float m_viewProjection[4][4];
+	bool m_useSSE = true;
+	OcclusionStats m_stats;
+
+	// Helper Functions
+	static ClipVertex transform(const float m[4][4], float x, float y, float z)
+	{
+		ClipVertex v;
+		v.x = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+		v.y = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+		v.z = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+		v.w = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+		return v;
+	}
+	static void multiply(const float a[4][4], const float b[4][4], float result[4][4])
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+				result[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c] + a[r][3] * b[3][c];
+		}
+	}
+
+	// Keeps the part in front of the near plane, z >= 0, a triangle becomes up to 4 vertices
+	static int clipNear(const ClipVertex in[3], ClipVertex out[4])
+	{
+		int count = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const ClipVertex& a = in[i];
+			const ClipVertex& b = in[(i + 1) % 3];
+			if (a.z >= 0.f)
+				out[count++] = a;
+			if ((a.z >= 0.f) != (b.z >= 0.f))
+			{
+				float t = a.z / (a.z - b.z);
+				out[count++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.f, a.w + (b.w - a.w) * t };
+			}
+		}
+		return count;
+	}
+
+	static void toScreen(const ClipVertex& v, float screen[3])
+	{
+		float inverseW = 1.f / v.w;
+		screen[0] = (v.x * inverseW * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+		screen[1] = (0.5f - v.y * inverseW * 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+		screen[2] = v.z * inverseW;
+	}
+
+	// Edge functions and depth plane of a screen space triangle, pixels are covered when their center is inside every edge
+	struct TriangleSetup
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC;
+		int minX, maxX, minY, maxY;
+	};
+
+	static bool setupTriangle(const float* v0, const float* v1, const float* v2, TriangleSetup& setup)
+	{
+		// Clockwise on screen is front facing, like the rasterizer state, back faces and degenerates are skipped
+		float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+		if (!(area > 0.f))
+			return false;
+
+		float minX = std::max(std::ceil(std::min({ v0[0], v1[0], v2[0] }) - 0.5f), 0.f);
+		float maxX = std::min(std::floor(std::max({ v0[0], v1[0], v2[0] }) - 0.5f), (float)OCCLUSION_BUFFER_WIDTH - 1.f);
+		float minY = std::max(std::ceil(std::min({ v0[1], v1[1], v2[1] }) - 0.5f), 0.f);
+		float maxY = std::min(std::floor(std::max({ v0[1], v1[1], v2[1] }) - 0.5f), (float)OCCLUSION_BUFFER_HEIGHT - 1.f);
+		if (minX > maxX || minY > maxY)
+			return false;
+		setup.minX = (int)minX;
+		setup.maxX = (int)maxX;
+		setup.minY = (int)minY;
+		setup.maxY = (int)maxY;
+
+		const float* v[3] = { v0, v1, v2 };
+		for (int e = 0; e < 3; e++)
+		{
+			const float* a = v[e];
+			const float* b = v[(e + 1) % 3];
+			setup.edgeA[e] = a[1] - b[1];
+			setup.edgeB[e] = b[0] - a[0];
+			setup.edgeC[e] = (b[1] - a[1]) * a[0] - (b[0] - a[0]) * a[1];
+		}
+
+		float inverseArea = 1.f / area;
+		setup.depthA = ((v1[2] - v0[2]) * (v2[1] - v0[1]) - (v2[2] - v0[2]) * (v1[1] - v0[1])) * inverseArea;
+		setup.depthB = ((v1[0] - v0[0]) * (v2[2] - v0[2]) - (v2[0] - v0[0]) * (v1[2] - v0[2])) * inverseArea;
+		setup.depthC = v0[2] - setup.depthA * v0[0] - setup.depthB * v0[1];
+		return true;
+	}
+
+	void rasterizeTriangleScalar(const TriangleSetup& setup)
+	{
+		for (int y = setup.minY; y <= setup.maxY; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			float* row = &m_depth[y * OCCLUSION_BUFFER_WIDTH];
+			for (int x = setup.minX; x <= setup.maxX; x++)
+			{
+				float pixelX = (float)x + 0.5f;
+				float e0 = setup.edgeA[0] * pixelX + (setup.edgeB[0] * pixelY + setup.edgeC[0]);
+				float e1 = setup.edgeA[1] * pixelX + (setup.edgeB[1] * pixelY + setup.edgeC[1]);
+				float e2 = setup.edgeA[2] * pixelX + (setup.edgeB[2] * pixelY + setup.edgeC[2]);
+				if (e0 < 0.f || e1 < 0.f || e2 < 0.f)
+					continue;
+
+				float depth = setup.depthA * pixelX + (setup.depthB * pixelY + setup.depthC);
+				row[x] = std::min(row[x], depth);
+			}
+		}
+	}
+
+#ifdef OCCLUSIONCULLER_SSE
+	// 4 pixels per step, the coverage mask of each step selects which lanes take the nearer depth
+	void rasterizeTriangleSSE(const TriangleSetup& setup)
+	{
+		const __m128 laneCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		__m128 edgeA[3];
+		for (int e = 0; e < 3; e++)
+			edgeA[e] = _mm_set1_ps(setup.edgeA[e]);
+		__m128 depthA = _mm_set1_ps(setup.depthA);
+
+		int startX = setup.minX & ~3;
+		for (int y = setup.minY; y <= setup.maxY; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			__m128 rowEdge[3];
+			for (int e = 0; e < 3; e++)
+				rowEdge[e] = _mm_set1_ps(setup.edgeB[e] * pixelY + setup.edgeC[e]);
+			__m128 rowDepth = _mm_set1_ps(setup.depthB * pixelY + setup.depthC);
+
+			float* row = &m_depth[y * OCCLUSION_BUFFER_WIDTH];
+			for (int x = startX; x <= setup.maxX; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneCenters);
+				__m128 outside = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), rowEdge[0]), zero);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), rowEdge[1]), zero));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), rowEdge[2]), zero));
+				if (_mm_movemask_ps(outside) == 0xF)
+					continue;
+
+				__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, pixelX), rowDepth);
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(current, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(outside, current), _mm_andnot_ps(outside, nearest)));
+			}
+		}
+	}
+#endif
+
+	void rasterizeClipped(const ClipVertex in[3])
+	{
+		ClipVertex clipped[4];
+		int count = clipNear(in, clipped);
+		if (count < 3)
+			return;
+
+		float screen[4][3];
+		for (int i = 0; i < count; i++)
+			toScreen(clipped[i], screen[i]);
+
+		bool rasterized = false;
+		for (int i = 1; i + 1 < count; i++)
+		{
+			TriangleSetup setup;
+			if (!setupTriangle(screen[0], screen[i], screen[i + 1], setup))
+				continue;
+
+#ifdef OCCLUSIONCULLER_SSE
+			if (m_useSSE)
+				rasterizeTriangleSSE(setup);
+			else
+#endif
+				rasterizeTriangleScalar(setup);
+			rasterized = true;
+		}
+		m_stats.rasterizedTriangles += rasterized;
+	}
+
+	// Screen rectangle and nearest depth of a box, false when the box reaches behind the near plane. Corners are the
+	// projected center plus or minus the projected extents, the same sums on both paths
+	bool projectBounds(float centerX, float centerY, float centerZ, float extentX, float extentY, float extentZ, int rect[4], float& minDepth) const
+	{
+		const float(*m)[4] = m_viewProjection;
+		ClipVertex center = transform(m, centerX, centerY, centerZ);
+		float minX, maxX, minY, maxY;
+
+#ifdef OCCLUSIONCULLER_SSE
+		if (m_useSSE)
+		{
+			// Corners 0-3 in the low registers and 4-7 in the high ones, one component per register
+			const __m128 signX = _mm_setr_ps(-1.f, 1.f, -1.f, 1.f);
+			const __m128 signY = _mm_setr_ps(-1.f, -1.f, 1.f, 1.f);
+			__m128 corners[2][4];
+			const float centerClip[4] = { center.x, center.y, center.z, center.w };
+			for (int k = 0; k < 4; k++)
+			{
+				__m128 xy = _mm_add_ps(_mm_add_ps(_mm_set1_ps(centerClip[k]), _mm_mul_ps(_mm_set1_ps(extentX * m[0][k]), signX)), _mm_mul_ps(_mm_set1_ps(extentY * m[1][k]), signY));
+				__m128 z = _mm_set1_ps(extentZ * m[2][k]);
+				corners[0][k] = _mm_sub_ps(xy, z);
+				corners[1][k] = _mm_add_ps(xy, z);
+			}
+			if ((_mm_movemask_ps(_mm_cmpgt_ps(corners[0][2], _mm_setzero_ps())) & _mm_movemask_ps(_mm_cmpgt_ps(corners[1][2], _mm_setzero_ps()))) != 0xF)
+				return false;
+
+			const __m128 half = _mm_set1_ps(0.5f);
+			__m128 screenMin[3], screenMax[3];
+			for (int h = 0; h < 2; h++)
+			{
+				__m128 inverseW = _mm_div_ps(_mm_set1_ps(1.f), corners[h][3]);
+				__m128 screen[3] = {
+					_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(corners[h][0], inverseW), half), half), _mm_set1_ps((float)OCCLUSION_BUFFER_WIDTH)),
+					_mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(corners[h][1], inverseW), half)), _mm_set1_ps((float)OCCLUSION_BUFFER_HEIGHT)),
+					_mm_mul_ps(corners[h][2], inverseW) };
+				for (int k = 0; k < 3; k++)
+				{
+					screenMin[k] = h == 0 ? screen[k] : _mm_min_ps(screenMin[k], screen[k]);
+					screenMax[k] = h == 0 ? screen[k] : _mm_max_ps(screenMax[k], screen[k]);
+				}
+			}
+
+			float lanes[4];
+			auto reduceMin = [&](__m128 v) { _mm_storeu_ps(lanes, v); return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3])); };
+			auto reduceMax = [&](__m128 v) { _mm_storeu_ps(lanes, v); return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3])); };
+			minX = reduceMin(screenMin[0]);
+			maxX = reduceMax(screenMax[0]);
+			minY = reduceMin(screenMin[1]);
+			maxY = reduceMax(screenMax[1]);
+			minDepth = reduceMin(screenMin[2]);
+		}
+		else
+#endif
+		{
+			minX = minY = minDepth = std::numeric_limits<float>::max();
+			maxX = maxY = -std::numeric_limits<float>::max();
+			for (int c = 0; c < 8; c++)
+			{
+				float sx = (c & 1) ? 1.f : -1.f, sy = (c & 2) ? 1.f : -1.f;
+				ClipVertex v;
+				v.x = ((center.x + extentX * m[0][0] * sx) + extentY * m[1][0] * sy) + ((c & 4) ? extentZ * m[2][0] : -(extentZ * m[2][0]));
+				v.y = ((center.y + extentX * m[0][1] * sx) + extentY * m[1][1] * sy) + ((c & 4) ? extentZ * m[2][1] : -(extentZ * m[2][1]));
+				v.z = ((center.z + extentX * m[0][2] * sx) + extentY * m[1][2] * sy) + ((c & 4) ? extentZ * m[2][2] : -(extentZ * m[2][2]));
+				v.w = ((center.w + extentX * m[0][3] * sx) + extentY * m[1][3] * sy) + ((c & 4) ? extentZ * m[2][3] : -(extentZ * m[2][3]));
+				if (!(v.z > 0.f))
+					return false;
+
+				float screen[3];
+				toScreen(v, screen);
+				minX = std::min(minX, screen[0]);
+				maxX = std::max(maxX, screen[0]);
+				minY = std::min(minY, screen[1]);
+				maxY = std::max(maxY, screen[1]);
+				minDepth = std::min(minDepth, screen[2]);
+			}
+		}
+
+		// Every pixel the rectangle touches
+		minX = std::max(std::floor(minX), 0.f);
+		maxX = std::min(std::floor(maxX), (float)OCCLUSION_BUFFER_WIDTH - 1.f);
+		minY = std::max(std::floor(minY), 0.f);
+		maxY = std::min(std::floor(maxY), (float)OCCLUSION_BUFFER_HEIGHT - 1.f);
+		if (minX > maxX || minY > maxY)
+			return false;
+
+		rect[0] = (int)minX;
+		rect[1] = (int)minY;
+		rect[2] = (int)maxX;
+		rect[3] = (int)maxY;
+		return true;
+	}
+
+	// True when a pixel of the rectangle inside the tile is not in front of minDepth
+	bool isTileVisible(const int rect[4], int tileX, int tileY, float minDepth) const
+	{
+		int x0 = std::max(rect[0], tileX * (int)OCCLUSION_TILE_SIZE);
+		int x1 = std::min(rect[2], tileX * (int)OCCLUSION_TILE_SIZE + (int)OCCLUSION_TILE_SIZE - 1);
+		int y0 = std::max(rect[1], tileY * (int)OCCLUSION_TILE_SIZE);
+		int y1 = std::min(rect[3], tileY * (int)OCCLUSION_TILE_SIZE + (int)OCCLUSION_TILE_SIZE - 1);
+
+#ifdef OCCLUSIONCULLER_SSE
+		if (m_useSSE)
+		{
+			const __m128 laneOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+			__m128 depth = _mm_set1_ps(minDepth);
+			__m128 first = _mm_set1_ps((float)x0);
+			__m128 last = _mm_set1_ps((float)x1);
+			for (int y = y0; y <= y1; y++)
+			{
+				const float* row = &m_depth[y * OCCLUSION_BUFFER_WIDTH];
+				for (int x = x0 & ~3; x <= x1; x += 4)
+				{
+					__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+					__m128 inside = _mm_and_ps(_mm_cmpge_ps(pixelX, first), _mm_cmple_ps(pixelX, last));
+					if (_mm_movemask_ps(_mm_and_ps(inside, _mm_cmpge_ps(_mm_loadu_ps(row + x), depth))))
+						return true;
+				}
+			}
+			return false;
+		}
+#endif
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				if (m_depth[y * OCCLUSION_BUFFER_WIDTH + x] >= minDepth)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// Per pixel over the whole rectangle, what the tile hierarchy has to agree with
+	bool isOccludedReference(float centerX, float centerY, float centerZ, float extentX, float extentY, float extentZ) const
+	{
+		int rect[4];
+		float minDepth;
+		if (!projectBounds(centerX, centerY, centerZ, extentX, extentY, extentZ, rect, minDepth))
+			return false;
+
+		for (int y = rect[1]; y <= rect[3]; y++)
+		{
+			for (int x = rect[0]; x <= rect[2]; x++)
+			{
+				if (m_depth[y * OCCLUSION_BUFFER_WIDTH + x] >= minDepth)
+					return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	OcclusionCuller()
+	{
+		m_depth.resize(OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT, 1.f);
+		m_tileMaxDepth.resize(OCCLUSION_TILES_X * OCCLUSION_TILES_Y, 1.f);
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+				m_viewProjection[r][c] = r == c ? 1.f : 0.f;
+		}
+	}
+
+	// Scalar paths are kept for comparison
+	void useSSE(bool useSSE) { m_useSSE = useSSE; }
+
+	// Frame, clears the depth buffer and the stats
+	void beginFrame(const float* viewProjectionMatrix)
+	{
+		std::copy(viewProjectionMatrix, viewProjectionMatrix + 16, &m_viewProjection[0][0]);
+		std::fill(m_depth.begin(), m_depth.end(), 1.f);
+		std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), 1.f);
+		m_stats = OcclusionStats();
+	}
+
+	// Occluders, positions are 3 floats per vertex and every 3 indices make a triangle
+	void rasterizeOccluder(const float* positions, const unsigned int* indices, size_t nrOfIndices, const float* worldMatrix)
+	{
+		float worldViewProjection[4][4];
+		multiply((const float(*)[4])worldMatrix, m_viewProjection, worldViewProjection);
+
+		for (size_t i = 0; i + 2 < nrOfIndices; i += 3)
+		{
+			ClipVertex triangle[3];
+			for (int v = 0; v < 3; v++)
+			{
+				const float* position = &positions[indices[i + v] * 3];
+				triangle[v] = transform(worldViewProjection, position[0], position[1], position[2]);
+			}
+			rasterizeClipped(triangle);
+		}
+		m_stats.occluders++;
+		m_stats.occluderTriangles += (unsigned int)(nrOfIndices / 3);
+	}
+
+	// Builds the coarse level, call once every occluder is rasterized
+	void finishOccluders()
+	{
+		for (unsigned int tileY = 0; tileY < OCCLUSION_TILES_Y; tileY++)
+		{
+			for (unsigned int tileX = 0; tileX < OCCLUSION_TILES_X; tileX++)
+			{
+				const float* tile = &m_depth[tileY * OCCLUSION_TILE_SIZE * OCCLUSION_BUFFER_WIDTH + tileX * OCCLUSION_TILE_SIZE];
+				float maxDepth = 0.f;
+#ifdef OCCLUSIONCULLER_SSE
+				__m128 rowMax = _mm_setzero_ps();
+				for (unsigned int y = 0; y < OCCLUSION_TILE_SIZE; y++)
+				{
+					for (unsigned int x = 0; x < OCCLUSION_TILE_SIZE; x += 4)
+						rowMax = _mm_max_ps(rowMax, _mm_loadu_ps(tile + y * OCCLUSION_BUFFER_WIDTH + x));
+				}
+				rowMax = _mm_max_ps(rowMax, _mm_shuffle_ps(rowMax, rowMax, _MM_SHUFFLE(1, 0, 3, 2)));
+				rowMax = _mm_max_ps(rowMax, _mm_shuffle_ps(rowMax, rowMax, _MM_SHUFFLE(2, 3, 0, 1)));
+				maxDepth = _mm_cvtss_f32(rowMax);
+#else
+				for (unsigned int y = 0; y < OCCLUSION_TILE_SIZE; y++)
+				{
+					for (unsigned int x = 0; x < OCCLUSION_TILE_SIZE; x++)
+						maxDepth = std::max(maxDepth, tile[y * OCCLUSION_BUFFER_WIDTH + x]);
+				}
+#endif
+				m_tileMaxDepth[tileY * OCCLUSION_TILES_X + tileX] = maxDepth;
+			}
+		}
+	}
+
+	// Tests, a box is occluded when every pixel it touches holds a nearer occluder. Boxes crossing the near plane are visible
+	bool isOccluded(float centerX, float centerY, float centerZ, float extentX, float extentY, float extentZ) const
+	{
+		int rect[4];
+		float minDepth;
+		if (!projectBounds(centerX, centerY, centerZ, extentX, extentY, extentZ, rect, minDepth))
+			return false;
+
+		// Tiles entirely in front of the box need no pixel test
+		for (int tileY = rect[1] / (int)OCCLUSION_TILE_SIZE; tileY <= rect[3] / (int)OCCLUSION_TILE_SIZE; tileY++)
+		{
+			for (int tileX = rect[0] / (int)OCCLUSION_TILE_SIZE; tileX <= rect[2] / (int)OCCLUSION_TILE_SIZE; tileX++)
+			{
+				if (m_tileMaxDepth[tileY * OCCLUSION_TILES_X + tileX] < minDepth)
+					continue;
+				if (isTileVisible(rect, tileX, tileY, minDepth))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Removes the occluded boxes from visibleIndices, keeping the order. Bounds is any structure of arrays with
+	// centerX/Y/Z and extentX/Y/Z, like CullingBoundsSoA
+	template<class Bounds>
+	void cull(const Bounds& bounds, std::vector<unsigned int>& visibleIndices)
+	{
+		size_t nrOfVisible = 0;
+		for (unsigned int index : visibleIndices)
+		{
+			bool occluded = isOccluded(bounds.centerX[index], bounds.centerY[index], bounds.centerZ[index], bounds.extentX[index], bounds.extentY[index], bounds.extentZ[index]);
+			visibleIndices[nrOfVisible] = index;
+			nrOfVisible += !occluded;
+		}
+		m_stats.tested += (unsigned int)visibleIndices.size();
+		m_stats.rejected += (unsigned int)(visibleIndices.size() - nrOfVisible);
+		visibleIndices.resize(nrOfVisible);
+	}
+
+	// Occluder Selection, the largest triangles of a mesh stand in for it
+	static void selectOccluderTriangles(const float* positions, const unsigned int* indices, size_t nrOfIndices, unsigned int maxTriangles, std::vector<unsigned int>& occluderIndices)
+	{
+		std::vector<std::pair<float, unsigned int>> triangles;
+		triangles.reserve(nrOfIndices / 3);
+		for (size_t i = 0; i + 2 < nrOfIndices; i += 3)
+		{
+			const float* a = &positions[indices[i] * 3];
+			const float* b = &positions[indices[i + 1] * 3];
+			const float* c = &positions[indices[i + 2] * 3];
+			float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float cross[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+			float areaSquared = cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2];
+			if (areaSquared > 0.f)
+				triangles.push_back({ areaSquared, (unsigned int)i });
+		}
+
+		size_t nrOfTriangles = std::min((size_t)maxTriangles, triangles.size());
+		std::partial_sort(triangles.begin(), triangles.begin() + nrOfTriangles, triangles.end(),
+			[](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+		occluderIndices.clear();
+		occluderIndices.reserve(nrOfTriangles * 3);
+		for (size_t i = 0; i < nrOfTriangles; i++)
+		{
+			occluderIndices.push_back(indices[triangles[i].second]);
+			occluderIndices.push_back(indices[triangles[i].second + 1]);
+			occluderIndices.push_back(indices[triangles[i].second + 2]);
+		}
+	}
+
+	// Getters
+	const OcclusionStats& getStats() const { return m_stats; }
+	float getDepth(unsigned int x, unsigned int y) const { return m_depth[y * OCCLUSION_BUFFER_WIDTH + x]; }
+	const std::vector<float>& getDepthBuffer() const { return m_depth; }
+
+	// Test Scene, Test and Benchmark, in OcclusionCullerTests.cpp
+	static void createViewProjection(float yaw, float aspectRatio, float viewProjection[16]);
+
+	static void createBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ, std::vector<float>& positions, std::vector<unsigned int>& indices);
+
+	static unsigned int test();
+
+	static OcclusionBenchmarkResult benchmark(unsigned int nrOfObjects = 10000, unsigned int nrOfFrames = 100);
+};
+
+#endif // !OCCLUSIONCULLER_H
@@ -0,0 +1,274 @@
+#include "pch.h"
+#include "OcclusionCuller.h"
+#include <chrono>
+#include <random>
+
+// Test Scene, camera at the origin looking down +z with a 90 degree vertical field of view
+void OcclusionCuller::createViewProjection(float yaw, float aspectRatio, float viewProjection[16])
+{
+	const float nearZ = 0.1f, farZ = 1000.f;
+	float yScale = 1.f;
+	float xScale = yScale / aspectRatio;
+	float projection[4][4] = {
+		{ xScale, 0.f, 0.f, 0.f },
+		{ 0.f, yScale, 0.f, 0.f },
+		{ 0.f, 0.f, farZ / (farZ - nearZ), 1.f },
+		{ 0.f, 0.f, -nearZ * farZ / (farZ - nearZ), 0.f } };
+
+	// Inverse of a rotation by yaw around +y
+	float s = std::sin(yaw), c = std::cos(yaw);
+	float view[4][4] = {
+		{ c, 0.f, s, 0.f },
+		{ 0.f, 1.f, 0.f, 0.f },
+		{ -s, 0.f, c, 0.f },
+		{ 0.f, 0.f, 0.f, 1.f } };
+
+	multiply(view, projection, (float(*)[4])viewProjection);
+}
+
+// 12 front facing triangles seen from outside
+void OcclusionCuller::createBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ, std::vector<float>& positions, std::vector<unsigned int>& indices)
+{
+	unsigned int base = (unsigned int)positions.size() / 3;
+	for (int c = 0; c < 8; c++)
+	{
+		positions.push_back((c & 1) ? maxX : minX);
+		positions.push_back((c & 2) ? maxY : minY);
+		positions.push_back((c & 4) ? maxZ : minZ);
+	}
+	const unsigned int boxIndices[36] = {
+		0, 2, 3, 0, 3, 1, // -z
+		5, 7, 6, 5, 6, 4, // +z
+		4, 6, 2, 4, 2, 0, // -x
+		1, 3, 7, 1, 7, 5, // +x
+		2, 6, 7, 2, 7, 3, // +y
+		4, 0, 1, 4, 1, 5 }; // -y
+	for (unsigned int index : boxIndices)
+		indices.push_back(base + index);
+}
+
+// Test
+unsigned int OcclusionCuller::test()
+{
+	unsigned int errors = 0;
+	const float identity[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+	float viewProjection[16];
+	createViewProjection(0.f, 1.f, viewProjection);
+
+	// Wall facing the camera covering the middle half of the screen
+	std::vector<float> wall = { -5.f, 5.f, 10.f, 5.f, 5.f, 10.f, 5.f, -5.f, 10.f, -5.f, -5.f, 10.f };
+	std::vector<unsigned int> wallFront = { 0, 1, 2, 0, 2, 3 };
+	std::vector<unsigned int> wallBack = { 0, 2, 1, 0, 3, 2 };
+
+	for (int sse = 0; sse < 2; sse++)
+	{
+		OcclusionCuller culler;
+		culler.useSSE(sse == 1);
+		culler.beginFrame(viewProjection);
+		culler.rasterizeOccluder(wall.data(), wallFront.data(), wallFront.size(), identity);
+		culler.finishOccluders();
+
+		errors += culler.getStats().rasterizedTriangles != 2;
+		errors += !culler.isOccluded(0.f, 0.f, 20.f, 1.f, 1.f, 1.f); // Behind the wall
+		errors += culler.isOccluded(0.f, 0.f, 5.f, 1.f, 1.f, 1.f); // In front of it
+		errors += culler.isOccluded(15.f, 0.f, 20.f, 1.f, 1.f, 1.f); // Beside it
+		errors += culler.isOccluded(0.f, 0.f, 10.f, 1.f, 1.f, 1.f); // Through it
+		errors += culler.isOccluded(0.f, 0.f, 0.f, 1.f, 1.f, 1.f); // Across the near plane
+
+		// Back faces are not drawn by the renderer so they hide nothing
+		culler.beginFrame(viewProjection);
+		culler.rasterizeOccluder(wall.data(), wallBack.data(), wallBack.size(), identity);
+		culler.finishOccluders();
+		errors += culler.getStats().rasterizedTriangles != 0;
+		errors += culler.isOccluded(0.f, 0.f, 20.f, 1.f, 1.f, 1.f);
+
+		// World matrix, the wall moved 5 units to the right
+		float translation[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 5.f, 0.f, 0.f, 1.f };
+		culler.beginFrame(viewProjection);
+		culler.rasterizeOccluder(wall.data(), wallFront.data(), wallFront.size(), translation);
+		culler.finishOccluders();
+		errors += culler.isOccluded(0.f, 0.f, 20.f, 1.f, 1.f, 1.f);
+		errors += !culler.isOccluded(10.f, 0.f, 40.f, 1.f, 1.f, 1.f);
+
+		// Floor reaching behind the camera, clipped at the near plane
+		std::vector<float> floor = { -200.f, -1.f, 100.f, 200.f, -1.f, 100.f, 200.f, -1.f, -10.f, -200.f, -1.f, -10.f };
+		culler.beginFrame(viewProjection);
+		culler.rasterizeOccluder(floor.data(), wallFront.data(), wallFront.size(), identity);
+		culler.finishOccluders();
+		errors += culler.getStats().rasterizedTriangles != 2;
+		errors += !culler.isOccluded(0.f, -5.f, 20.f, 1.f, 1.f, 1.f); // Under the floor
+		errors += culler.isOccluded(0.f, 1.f, 20.f, 1.f, 1.f, 1.f); // Above it
+
+		// An occluder never hides its own bounds
+		std::vector<float> boxPositions;
+		std::vector<unsigned int> boxIndices;
+		createBox(-2.f, -2.f, 8.f, 2.f, 2.f, 12.f, boxPositions, boxIndices);
+		culler.beginFrame(viewProjection);
+		culler.rasterizeOccluder(boxPositions.data(), boxIndices.data(), boxIndices.size(), identity);
+		culler.finishOccluders();
+		errors += culler.getStats().rasterizedTriangles != 2; // Only the face towards the camera
+		errors += culler.isOccluded(0.f, 0.f, 10.f, 2.f, 2.f, 2.f);
+		errors += !culler.isOccluded(0.f, 0.f, 30.f, 1.f, 1.f, 1.f);
+	}
+
+	// Random Scenes, SSE and scalar rasterize the same depth, the tile hierarchy matches the per pixel test and nothing
+	// nearer than every occluder is rejected
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	for (int scene = 0; scene < 20; scene++)
+	{
+		std::vector<float> positions;
+		std::vector<unsigned int> indices;
+		for (int i = 0; i < 30; i++)
+		{
+			float x = unit(generator) * 80.f - 40.f, y = unit(generator) * 40.f - 20.f, z = 30.f + unit(generator) * 30.f;
+			float size = 1.f + unit(generator) * 10.f;
+			createBox(x, y, z, x + size, y + size, z + size, positions, indices);
+		}
+		float sceneViewProjection[16];
+		createViewProjection(unit(generator) - 0.5f, 2.f, sceneViewProjection);
+
+		OcclusionCuller scalarCuller;
+		scalarCuller.useSSE(false);
+		scalarCuller.beginFrame(sceneViewProjection);
+		scalarCuller.rasterizeOccluder(positions.data(), indices.data(), indices.size(), identity);
+		scalarCuller.finishOccluders();
+
+		OcclusionCuller culler;
+		culler.beginFrame(sceneViewProjection);
+		culler.rasterizeOccluder(positions.data(), indices.data(), indices.size(), identity);
+		culler.finishOccluders();
+		errors += culler.getDepthBuffer() != scalarCuller.getDepthBuffer();
+
+		for (int i = 0; i < 200; i++)
+		{
+			float x = unit(generator) * 120.f - 60.f, y = unit(generator) * 60.f - 30.f, z = 1.f + unit(generator) * 100.f;
+			float extent = 0.2f + unit(generator) * 3.f;
+			bool occluded = culler.isOccluded(x, y, z, extent, extent, extent);
+			errors += occluded != scalarCuller.isOccluded(x, y, z, extent, extent, extent);
+			errors += occluded != culler.isOccludedReference(x, y, z, extent, extent, extent);
+			errors += occluded && z + extent < 30.f;
+		}
+	}
+
+	// Occluder selection keeps the largest triangles
+	std::vector<float> positions;
+	std::vector<unsigned int> indices;
+	createBox(0.f, 0.f, 0.f, 10.f, 10.f, 10.f, positions, indices);
+	createBox(20.f, 0.f, 0.f, 21.f, 1.f, 1.f, positions, indices);
+	std::vector<unsigned int> occluderIndices;
+	selectOccluderTriangles(positions.data(), indices.data(), indices.size(), 12, occluderIndices);
+	errors += occluderIndices.size() != 36;
+	for (unsigned int index : occluderIndices)
+		errors += index >= 8;
+	selectOccluderTriangles(positions.data(), indices.data(), indices.size(), 100, occluderIndices);
+	errors += occluderIndices.size() != indices.size();
+
+	return errors;
+}
+
+// Benchmark, city blocks as occluders and small objects between them, the camera turns a full circle over the frames
+OcclusionBenchmarkResult OcclusionCuller::benchmark(unsigned int nrOfObjects, unsigned int nrOfFrames)
+{
+	const float identity[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+	const int NR_OF_BLOCKS = 8;
+	const float BLOCK_SPACING = 40.f;
+	const float BLOCK_SIZE = 25.f;
+
+	std::vector<float> positions;
+	std::vector<unsigned int> indices;
+	std::vector<size_t> blockOffsets;
+	for (int z = 0; z < NR_OF_BLOCKS; z++)
+	{
+		for (int x = 0; x < NR_OF_BLOCKS; x++)
+		{
+			float minX = (x - NR_OF_BLOCKS / 2) * BLOCK_SPACING + (BLOCK_SPACING - BLOCK_SIZE) * 0.5f;
+			float minZ = (z - NR_OF_BLOCKS / 2) * BLOCK_SPACING + (BLOCK_SPACING - BLOCK_SIZE) * 0.5f;
+			blockOffsets.push_back(indices.size());
+			createBox(minX, -2.f, minZ, minX + BLOCK_SIZE, 30.f, minZ + BLOCK_SIZE, positions, indices);
+		}
+	}
+
+	struct Bounds
+	{
+		std::vector<float> centerX, centerY, centerZ, extentX, extentY, extentZ;
+	} bounds;
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> positionDistribution(-NR_OF_BLOCKS * BLOCK_SPACING * 0.5f, NR_OF_BLOCKS * BLOCK_SPACING * 0.5f);
+	std::uniform_real_distribution<float> extentDistribution(0.25f, 2.f);
+	for (unsigned int i = 0; i < nrOfObjects; i++)
+	{
+		bounds.centerX.push_back(positionDistribution(generator));
+		bounds.centerY.push_back(extentDistribution(generator) - 1.f);
+		bounds.centerZ.push_back(positionDistribution(generator));
+		bounds.extentX.push_back(extentDistribution(generator));
+		bounds.extentY.push_back(extentDistribution(generator));
+		bounds.extentZ.push_back(extentDistribution(generator));
+	}
+
+	OcclusionBenchmarkResult result;
+	result.nrOfObjects = nrOfObjects;
+	result.nrOfFrames = nrOfFrames;
+
+	OcclusionCuller culler;
+	std::vector<unsigned int> visibleIndices;
+	for (int sse = 1; sse >= 0; sse--)
+	{
+		culler.useSSE(sse == 1);
+		double rasterizeTime = 0.0, testTime = 0.0;
+		for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+		{
+			float viewProjection[16];
+			createViewProjection(6.2831853f * frame / nrOfFrames, 16.f / 9.f, viewProjection);
+
+			auto startTime = std::chrono::steady_clock::now();
+			culler.beginFrame(viewProjection);
+			for (size_t block = 0; block < blockOffsets.size(); block++)
+				culler.rasterizeOccluder(positions.data(), indices.data() + blockOffsets[block], 36, identity);
+			culler.finishOccluders();
+			auto rasterizedTime = std::chrono::steady_clock::now();
+
+			visibleIndices.resize(nrOfObjects);
+			for (unsigned int i = 0; i < nrOfObjects; i++)
+				visibleIndices[i] = i;
+			culler.cull(bounds, visibleIndices);
+			auto endTime = std::chrono::steady_clock::now();
+
+			rasterizeTime += std::chrono::duration<double, std::micro>(rasterizedTime - startTime).count();
+			testTime += std::chrono::duration<double, std::micro>(endTime - rasterizedTime).count();
+
+			if (sse == 1)
+			{
+				const OcclusionStats& stats = culler.getStats();
+				result.stats.occluders += stats.occluders;
+				result.stats.occluderTriangles += stats.occluderTriangles;
+				result.stats.rasterizedTriangles += stats.rasterizedTriangles;
+				result.stats.tested += stats.tested;
+				result.stats.rejected += stats.rejected;
+
+				// Every rejection has to hold per pixel, and every kept object that the per pixel test rejects is a miss too
+				size_t next = 0;
+				for (unsigned int i = 0; i < nrOfObjects; i++)
+				{
+					bool kept = next < visibleIndices.size() && visibleIndices[next] == i;
+					next += kept;
+					result.errors += kept == culler.isOccludedReference(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i], bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+				}
+			}
+		}
+
+		if (sse == 1)
+		{
+			result.rasterizeTime = rasterizeTime / nrOfFrames;
+			result.testTime = testTime / nrOfFrames;
+		}
+		else
+		{
+			result.scalarRasterizeTime = rasterizeTime / nrOfFrames;
+			result.scalarTestTime = testTime / nrOfFrames;
+		}
+	}
+
+	return result;
+}
+
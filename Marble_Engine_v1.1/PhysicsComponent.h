@@ -3,9 +3,19 @@
 #define PHYSICSCOMPONENT_H
 
 #include "MovementComponent.h"
+#include "Broadphase.h"
 
 const float GRAVITY = 0.982f;
 
+// Simulated state of one component, used to snapshot and restore a physics world for replays
+struct PhysicsState
+{
+	XMFLOAT3 position;
+	XMFLOAT3 velocity;
+	bool isJumping;
+	bool isFalling;
+};
+
 class PhysicsComponent
 {
 private:
@@ -25,6 +35,15 @@ private:
 
 	BoundingBox* m_aabb;
 
+	// Broadphase, copies are not registered
+	Broadphase* m_broadphase = nullptr;
+	UINT m_broadphaseProxy = 0;
+	bool m_collisionEnabled = false;
+	std::vector<BoundingBox*> m_candidateBoxes;
+
+	// Interpolation, position before the last fixed step
+	XMVECTOR m_previousPosition;
+
 	// Movement Component
 	MovementComponent* m_moveComp;
 
@@ -39,6 +58,7 @@ public:
 		m_isFalling = true;
 		m_aabb = nullptr;
 		m_moveComp = nullptr;
+		m_previousPosition = XMVectorSet(0.f, 0.f, 0.f, 1.f);
 	}
 	PhysicsComponent(const PhysicsComponent& otherPhysicsComponent)
 	{
@@ -51,6 +71,7 @@ public:
 		m_mass = otherPhysicsComponent.m_mass;
 		m_isJumping = otherPhysicsComponent.m_isJumping;
 		m_isFalling = otherPhysicsComponent.m_isFalling;
+		m_previousPosition = otherPhysicsComponent.m_previousPosition;
 
 		// AABB
 		if (m_aabb)
@@ -66,6 +87,7 @@ public:
 	}
 	~PhysicsComponent()
 	{
+		unregisterFromBroadphase();
 		if (m_aabb)
 		{
 			delete m_aabb;
@@ -87,6 +109,7 @@ public:
 		m_mass = otherPhysicsComponent.m_mass;
 		m_isJumping = otherPhysicsComponent.m_isJumping;
 		m_isFalling = otherPhysicsComponent.m_isFalling;
+		m_previousPosition = otherPhysicsComponent.m_previousPosition;
 
 		// AABB
 		if (m_aabb)
@@ -112,6 +135,7 @@ public:
 		m_deceleration = deceleration;
 		m_maxSpeed = maxSpeed;
 		m_aabb = new BoundingBox();
+		m_previousPosition = m_moveComp->position;
 	}
 
 	// Getters
@@ -139,6 +163,23 @@ public:
 	{
 		return m_isFalling;
 	}
+	bool* getCollisionEnabledPtr()
+	{
+		return &m_collisionEnabled;
+	}
+	XMVECTOR getInterpolatedPosition(float alpha) const
+	{
+		return XMVectorLerp(m_previousPosition, m_moveComp->position, alpha);
+	}
+	PhysicsState getState() const
+	{
+		PhysicsState state;
+		state.position = m_moveComp->getPositionF3();
+		state.velocity = m_velocity;
+		state.isJumping = m_isJumping;
+		state.isFalling = m_isFalling;
+		return state;
+	}
 
 	// Setters
 	void setBoundingBox(XMFLOAT3 center, XMFLOAT3 extends)
@@ -166,6 +207,23 @@ public:
 	{
 		m_isFalling = isFalling;
 	}
+	void setCollisionEnabled(bool collisionEnabled)
+	{
+		m_collisionEnabled = collisionEnabled;
+	}
+	void setState(const PhysicsState& state)
+	{
+		m_moveComp->position = XMVectorSet(state.position.x, state.position.y, state.position.z, 1.f);
+		m_velocity = state.velocity;
+		m_isJumping = state.isJumping;
+		m_isFalling = state.isFalling;
+		m_aabb->Center = state.position;
+		resetInterpolation();
+	}
+	void resetInterpolation()
+	{
+		m_previousPosition = m_moveComp->position;
+	}
 
 	void addForce(XMFLOAT3 force, float dt)
 	{
@@ -244,8 +302,53 @@ public:
 		}
 	}
 
+	// Broadphase
+	void registerWithBroadphase(Broadphase* broadphase)
+	{
+		unregisterFromBroadphase();
+		m_broadphase = broadphase;
+		m_broadphaseProxy = m_broadphase->addProxy(*m_aabb, this);
+	}
+	void unregisterFromBroadphase()
+	{
+		if (m_broadphase)
+		{
+			m_broadphase->removeProxy(m_broadphaseProxy);
+			m_broadphase = nullptr;
+		}
+	}
+	void updateBroadphaseProxy(float dt)
+	{
+		if (!m_broadphase)
+			return;
+
+		// Swept over the coming step so handleCollision gets every box it can reach
+		BoundingBox AABBNextFrame = *(m_aabb);
+		AABBNextFrame.Center = XMFLOAT3(m_aabb->Center.x + m_velocity.x * dt, m_aabb->Center.y + m_velocity.y * dt, m_aabb->Center.z + m_velocity.z * dt);
+		BoundingBox sweptAABB;
+		BoundingBox::CreateMerged(sweptAABB, *m_aabb, AABBNextFrame);
+		m_broadphase->updateProxy(m_broadphaseProxy, sweptAABB);
+	}
+
 	// Update
-	void handleCollision(std::vector<BoundingBox*> boundingBoxes, float dt, std::vector<BoundingOrientedBox*> orientedBoundingBoxes)
+	void handleCollision(float dt)
+	{
+		if (!m_broadphase || !m_collisionEnabled)
+			return;
+
+		UINT nrOfCandidates = 0;
+		const UINT* candidates = m_broadphase->getCandidates(m_broadphaseProxy, nrOfCandidates);
+		m_candidateBoxes.clear();
+		for (UINT i = 0; i < nrOfCandidates; i++)
+		{
+			PhysicsComponent* other = static_cast<PhysicsComponent*>(m_broadphase->getUserData(candidates[i]));
+			if (other->m_collisionEnabled)
+				m_candidateBoxes.push_back(other->m_aabb);
+		}
+
+		handleCollision(m_candidateBoxes, dt);
+	}
+	void handleCollision(const std::vector<BoundingBox*>& boundingBoxes, float dt, const std::vector<BoundingOrientedBox*>& orientedBoundingBoxes = {})
 	{
 		BoundingBox AABBNextFrame = *(m_aabb);
 		AABBNextFrame.Center = XMFLOAT3(m_aabb->Center.x + m_velocity.x * dt, m_aabb->Center.y + m_velocity.y * dt, m_aabb->Center.z + m_velocity.z * dt);
@@ -0,0 +1,267 @@
+#include "pch.h"
+#ifndef PHYSICSWORLD_H
+#define PHYSICSWORLD_H
+
+#include "PhysicsComponent.h"
+
+// Force queued for a component, applied at the start of a fixed step
+struct PhysicsInputEvent
+{
+	UINT64 step; // Relative to the start of the recording
+	UINT component;
+	XMFLOAT3 force;
+};
+
+// Everything needed to replay a stretch of simulation without rendering
+struct PhysicsRecording
+{
+	std::vector<PhysicsState> initialStates;
+	std::vector<PhysicsInputEvent> events;
+	UINT64 nrOfSteps = 0;
+};
+
+struct PhysicsReplayResult
+{
+	UINT nrOfBodies = 0;
+	UINT nrOfFrames = 0;
+	UINT64 nrOfSteps = 0;
+	double stepsPerSecond = 0.0; // Headless replay
+	UINT mismatches = 0; // Bodies whose replayed state differs from the recorded run in any bit
+};
+
+class PhysicsWorld
+{
+private:
+	PhysicsWorld() {};
+
+	// Broadphase, every registered component owns one proxy
+	Broadphase m_broadphase;
+	std::vector<PhysicsComponent*> m_components;
+
+	// Fixed Timestep
+	int m_stepRate = 60;
+	float m_fixedTimeStep = 1.f / 60.f;
+	UINT m_maxSubSteps = 8;
+	double m_accumulator = 0.0;
+	float m_interpolationAlpha = 0.f;
+	bool m_deterministic = false;
+	UINT64 m_stepCount = 0;
+
+	// Input
+	std::vector<PhysicsInputEvent> m_pendingInputs;
+
+	// Recording
+	bool m_isRecording = false;
+	UINT64 m_recordingStartStep = 0;
+	PhysicsRecording m_recording;
+
+	// Stats
+	double m_broadphaseTime = 0.0;
+	UINT m_nrOfSubSteps = 0;
+	double m_droppedTime = 0.0;
+
+	// Helper Functions
+	void updateBroadphase(float dt)
+	{
+		for (size_t i = 0; i < m_components.size(); i++)
+			m_components[i]->updateBroadphaseProxy(dt);
+
+		auto startTime = std::chrono::steady_clock::now();
+		m_broadphase.update();
+		m_broadphaseTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	void applyInput(const PhysicsInputEvent& input)
+	{
+		m_components[input.component]->addForce(input.force, m_fixedTimeStep);
+	}
+	void step()
+	{
+		// Interpolation
+		for (size_t i = 0; i < m_components.size(); i++)
+			m_components[i]->resetInterpolation();
+
+		// Input, queued forces land on step boundaries so they do not depend on the frame rate
+		for (size_t i = 0; i < m_pendingInputs.size(); i++)
+		{
+			applyInput(m_pendingInputs[i]);
+			if (m_isRecording)
+			{
+				m_recording.events.push_back(m_pendingInputs[i]);
+				m_recording.events.back().step = m_stepCount - m_recordingStartStep;
+			}
+		}
+		m_pendingInputs.clear();
+
+		// Collision, every component resolves against the same candidates before anything moves
+		updateBroadphase(m_fixedTimeStep);
+		for (size_t i = 0; i < m_components.size(); i++)
+			m_components[i]->handleCollision(m_fixedTimeStep);
+
+		// Movement
+		for (size_t i = 0; i < m_components.size(); i++)
+			m_components[i]->updatePosition(m_fixedTimeStep);
+
+		m_stepCount++;
+	}
+
+public:
+	PhysicsWorld(PhysicsWorld const&) = delete;
+	void operator=(PhysicsWorld const&) = delete;
+	static PhysicsWorld& getInstance()
+	{
+		static PhysicsWorld worldInstance;
+		return worldInstance;
+	}
+
+	// Components
+	void addComponent(PhysicsComponent* component)
+	{
+		component->registerWithBroadphase(&m_broadphase);
+		m_components.push_back(component);
+	}
+	void removeComponent(PhysicsComponent* component)
+	{
+		component->unregisterFromBroadphase();
+		auto it = std::find(m_components.begin(), m_components.end(), component);
+		if (it == m_components.end())
+			return;
+
+		// A recording holds every component by index and the removed one took part in every recorded step, so the recording
+		// ends here and stays replayable with the components it started with
+		if (m_isRecording)
+			stopRecording();
+
+		// Queued input refers to components by index
+		UINT index = (UINT)(it - m_components.begin());
+		m_pendingInputs.erase(std::remove_if(m_pendingInputs.begin(), m_pendingInputs.end(),
+			[index](const PhysicsInputEvent& input) { return input.component == index; }), m_pendingInputs.end());
+		for (size_t i = 0; i < m_pendingInputs.size(); i++)
+		{
+			if (m_pendingInputs[i].component > index)
+				m_pendingInputs[i].component--;
+		}
+		m_components.erase(it);
+	}
+
+	// Getters
+	float getInterpolationAlpha() const { return m_interpolationAlpha; }
+	float getFixedTimeStep() const { return m_fixedTimeStep; }
+	UINT64 getStepCount() const { return m_stepCount; }
+	bool isRecording() const { return m_isRecording; }
+	void getStates(std::vector<PhysicsState>& states) const
+	{
+		states.resize(m_components.size());
+		for (size_t i = 0; i < m_components.size(); i++)
+			states[i] = m_components[i]->getState();
+	}
+
+	// Setters
+	void setStepRate(int stepRate)
+	{
+		m_stepRate = std::max(stepRate, 1);
+		m_fixedTimeStep = 1.f / (float)m_stepRate;
+	}
+	void setMaxSubSteps(UINT maxSubSteps) { m_maxSubSteps = std::max(maxSubSteps, 1u); }
+	void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+	void setStates(const std::vector<PhysicsState>& states)
+	{
+		assert(states.size() == m_components.size());
+		for (size_t i = 0; i < m_components.size() && i < states.size(); i++)
+			m_components[i]->setState(states[i]);
+	}
+
+	// Input
+	void addForce(PhysicsComponent* component, XMFLOAT3 force)
+	{
+		auto it = std::find(m_components.begin(), m_components.end(), component);
+		if (it != m_components.end())
+			m_pendingInputs.push_back({ 0, (UINT)(it - m_components.begin()), force });
+	}
+
+	// Update, steps as many fixed steps as the frame time covers, returns the number of steps taken
+	UINT update(double dt)
+	{
+		m_accumulator += dt;
+		m_nrOfSubSteps = 0;
+		while (m_accumulator >= m_fixedTimeStep && m_nrOfSubSteps < m_maxSubSteps)
+		{
+			step();
+			m_accumulator -= m_fixedTimeStep;
+			m_nrOfSubSteps++;
+		}
+
+		// Over the sub step cap, a long frame would otherwise cause an even longer one.
+		// Deterministic mode keeps the time and catches up over the coming frames instead
+		if (!m_deterministic && m_accumulator >= m_fixedTimeStep)
+		{
+			double remainder = fmod(m_accumulator, (double)m_fixedTimeStep);
+			m_droppedTime += m_accumulator - remainder;
+			m_accumulator = remainder;
+		}
+
+		m_interpolationAlpha = (float)std::min(m_accumulator / m_fixedTimeStep, 1.0);
+
+		return m_nrOfSubSteps;
+	}
+
+	// Recording
+	void startRecording()
+	{
+		m_recording = PhysicsRecording();
+		getStates(m_recording.initialStates);
+		m_recordingStartStep = m_stepCount;
+		m_isRecording = true;
+	}
+	// Also returns a recording that was already ended by removing a component
+	PhysicsRecording stopRecording()
+	{
+		if (m_isRecording)
+		{
+			m_recording.nrOfSteps = m_stepCount - m_recordingStartStep;
+			m_isRecording = false;
+		}
+		return m_recording;
+	}
+
+	// Replay, restores the recorded start state and steps with the recorded input, no frame time involved
+	void replay(const PhysicsRecording& recording)
+	{
+		assert(!m_isRecording);
+		setStates(recording.initialStates);
+		m_pendingInputs.clear();
+		m_accumulator = 0.0;
+
+		size_t nextEvent = 0;
+		for (UINT64 i = 0; i < recording.nrOfSteps; i++)
+		{
+			while (nextEvent < recording.events.size() && recording.events[nextEvent].step == i)
+				m_pendingInputs.push_back(recording.events[nextEvent++]);
+			step();
+		}
+		m_interpolationAlpha = 0.f;
+	}
+
+	// UI
+	void updateUI()
+	{
+		ImGui::PushItemWidth(90);
+		if (ImGui::DragInt("Step Rate", &m_stepRate, 1.f, 10, 240))
+			setStepRate(m_stepRate);
+		int maxSubSteps = (int)m_maxSubSteps;
+		if (ImGui::DragInt("Max Sub Steps", &maxSubSteps, 1.f, 1, 32))
+			setMaxSubSteps((UINT)maxSubSteps);
+		ImGui::PopItemWidth();
+		ImGui::Checkbox("Deterministic", &m_deterministic);
+
+		ImGui::Text("Bodies: %u", m_broadphase.getNrOfProxies());
+		ImGui::Text("Steps: %u this frame, alpha %.2f", m_nrOfSubSteps, m_interpolationAlpha);
+		ImGui::Text("Dropped Time: %.2f s", m_droppedTime);
+		ImGui::Text("Candidate Pairs: %u", (UINT)m_broadphase.getPairs().size());
+		ImGui::Text("Broadphase: %.3f ms", m_broadphaseTime);
+	}
+
+	// Replay Test, in PhysicsWorldTests.cpp
+	static PhysicsReplayResult replayTest(UINT nrOfBodies = 1000, UINT nrOfFrames = 600);
+};
+
+#endif // !PHYSICSWORLD_H
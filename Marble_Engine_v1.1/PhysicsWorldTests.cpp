@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "PhysicsWorld.h"
+#include <chrono>
+#include <random>
+
+// Replay Test, records bodies driven by random input at random frame times, replays headless and compares bit for bit
+PhysicsReplayResult PhysicsWorld::replayTest(UINT nrOfBodies, UINT nrOfFrames)
+{
+	PhysicsWorld& world = getInstance();
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> positionDistribution(-50.f, 50.f);
+	std::uniform_real_distribution<float> forceDistribution(-5.f, 5.f);
+	std::uniform_real_distribution<double> frameTimeDistribution(1.0 / 240.0, 1.0 / 15.0);
+	std::uniform_int_distribution<UINT> bodyDistribution(0, nrOfBodies - 1);
+
+	std::vector< std::unique_ptr<MovementComponent> > movementComponents(nrOfBodies);
+	std::vector< std::unique_ptr<PhysicsComponent> > physicsComponents(nrOfBodies);
+	for (UINT i = 0; i < nrOfBodies; i++)
+	{
+		movementComponents[i] = std::make_unique<MovementComponent>();
+		movementComponents[i]->position = XMVectorSet(positionDistribution(generator), positionDistribution(generator), positionDistribution(generator), 1.f);
+		physicsComponents[i] = std::make_unique<PhysicsComponent>();
+		physicsComponents[i]->initialize(movementComponents[i].get(), 10.f, XMFLOAT3(.1f, .1f, .1f), XMFLOAT3(.99f, .99f, .99f));
+		physicsComponents[i]->setBoundingBox(movementComponents[i]->getPositionF3(), XMFLOAT3(1.f, 1.f, 1.f));
+		physicsComponents[i]->setCollisionEnabled(true);
+		world.addComponent(physicsComponents[i].get());
+	}
+
+	bool deterministic = world.m_deterministic;
+	world.setDeterministic(true);
+	world.m_accumulator = 0.0;
+
+	// Record
+	world.startRecording();
+	for (UINT i = 0; i < nrOfFrames; i++)
+	{
+		for (UINT j = 0; j < 8; j++)
+			world.addForce(physicsComponents[bodyDistribution(generator)].get(), XMFLOAT3(forceDistribution(generator), forceDistribution(generator), forceDistribution(generator)));
+		world.update(frameTimeDistribution(generator));
+	}
+	PhysicsRecording recording = world.stopRecording();
+	std::vector<PhysicsState> recordedStates;
+	world.getStates(recordedStates);
+
+	// Replay
+	auto startTime = std::chrono::steady_clock::now();
+	world.replay(recording);
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::vector<PhysicsState> replayedStates;
+	world.getStates(replayedStates);
+
+	PhysicsReplayResult result;
+	result.nrOfBodies = nrOfBodies;
+	result.nrOfFrames = nrOfFrames;
+	result.nrOfSteps = recording.nrOfSteps;
+	result.stepsPerSecond = elapsed > 0.0 ? (double)recording.nrOfSteps / elapsed : 0.0;
+	auto countMismatches = [&]()
+	{
+		world.getStates(replayedStates);
+		for (UINT i = 0; i < nrOfBodies; i++)
+		{
+			if (memcmp(&recordedStates[i].position, &replayedStates[i].position, sizeof(XMFLOAT3)) != 0 ||
+				memcmp(&recordedStates[i].velocity, &replayedStates[i].velocity, sizeof(XMFLOAT3)) != 0)
+				result.mismatches++;
+		}
+	};
+	countMismatches();
+
+	// Removing a body ends the recording at that step, with the body back in place the recording still replays exactly
+	world.startRecording();
+	for (UINT i = 0; i < nrOfFrames / 4; i++)
+	{
+		for (UINT j = 0; j < 8; j++)
+			world.addForce(physicsComponents[bodyDistribution(generator)].get(), XMFLOAT3(forceDistribution(generator), forceDistribution(generator), forceDistribution(generator)));
+		world.update(frameTimeDistribution(generator));
+	}
+	world.getStates(recordedStates);
+	UINT64 nrOfRecordedSteps = world.getStepCount() - world.m_recordingStartStep;
+	world.addForce(physicsComponents[nrOfBodies - 1].get(), XMFLOAT3(1.f, 0.f, 0.f));
+	world.removeComponent(physicsComponents[nrOfBodies - 1].get());
+	world.update(1.0 / 30.0);
+	recording = world.stopRecording();
+	result.mismatches += world.isRecording() || recording.nrOfSteps != nrOfRecordedSteps || recording.initialStates.size() != nrOfBodies;
+
+	world.addComponent(physicsComponents[nrOfBodies - 1].get());
+	world.replay(recording);
+	countMismatches();
+
+	for (UINT i = 0; i < nrOfBodies; i++)
+		world.removeComponent(physicsComponents[i].get());
+	world.setDeterministic(deterministic);
+
+	return result;
+}
+
@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "RenderHandler.h"
+#include "AllocationCounter.h"
+#include "JobSystem.h"
 
 RenderHandler::RenderHandler()
 {
@@ -811,14 +813,18 @@ void RenderHandler::lightPass()
 	srvIndex++;
 	m_sky.setSkyTextures(srvIndex, srvIndex - 1);
 
-	// Set Light Pass Shaders
-	m_lightPassShaders.setShaders();
+	// Set Lights and the Cluster Light Lists, after the sky textures
+	m_lightManager.bindClusters(CLUSTER_SRV_SLOT);
+
+	// Set Light Pass Shaders, the variant follows the lighting toggles
+	m_lightPassPermutations.select(getLightPassKey())->setShaders();
 
 	// Draw Fullscreen Quad
 	m_deviceContext->Draw(4, 0);
 
 	// Unbind Shader Resource Views
 	m_deviceContext->PSSetShaderResources(0, srvIndex, m_shaderResourcesNullptr);
+	m_deviceContext->PSSetShaderResources(CLUSTER_SRV_SLOT, 3, m_shaderResourcesNullptr);
 }
 
 void RenderHandler::downsamplePass()
@@ -1132,10 +1138,15 @@ void RenderHandler::initialize(HWND* window, Settings* settings)
 	initCamera();
 	ImGui_ImplDX11_Init(m_device.Get(), m_deviceContext.Get());
 	ResourceHandler::getInstance().initialize(m_device.Get(), m_deviceContext.Get());
+	ModelCache::getInstance().initialize(m_device.Get(), m_deviceContext.Get());
+	ShaderProgramRegistry::getInstance().initialize(m_device.Get(), m_deviceContext.Get());
 
 	// Lighting
 	m_lightManager.initialize(m_device.Get(), m_deviceContext.Get(), m_camera.getViewMatrixPtr(), m_camera.getProjectionMatrixPtr());
 	m_shadowInstance.initialize(m_device.Get(), m_deviceContext.Get(), SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+
+	// Render Queue
+	m_renderQueueContext.initialize(m_deviceContext.Get(), [this](const void* shaders) { setPassShaders((Shaders*)shaders); });
 	
 	// Sky
 	Light sunLight;
@@ -1164,22 +1175,43 @@ void RenderHandler::initialize(HWND* window, Settings* settings)
 	// Timer
 	m_timer.restart();
 
-	// Shader States
+	// Shader States, model meshes have quantized vertices
 	m_shaderStates.resize(ShaderStates::NUM);
 	ShaderFiles shaderFiles;
+	shaderFiles.defines = { { "QUANTIZED" } };
 	// - Phong
 	shaderFiles.vs = L"GeneralVS.hlsl";
 	shaderFiles.ps = L"GBufferPS.hlsl";
-	m_shaderStates[ShaderStates::PHONG].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN);
+	m_shaderStates[ShaderStates::PHONG].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED);
 	// - PBR
 	shaderFiles.vs = L"GeneralVS.hlsl";
 	shaderFiles.ps = L"GBufferPBR_PS.hlsl";
-	m_shaderStates[ShaderStates::PBR].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN);
+	m_shaderStates[ShaderStates::PBR].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED);
+	// - Instanced Phong and PBR
+	m_instancedShaderStates.resize(ShaderStates::NUM);
+	shaderFiles.defines = { { "INSTANCED" }, { "QUANTIZED" } };
+	shaderFiles.ps = L"GBufferPS.hlsl";
+	m_instancedShaderStates[ShaderStates::PHONG].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED_INSTANCED);
+	shaderFiles.ps = L"GBufferPBR_PS.hlsl";
+	m_instancedShaderStates[ShaderStates::PBR].initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED_INSTANCED);
+	shaderFiles.defines.clear();
 
-	// - Light pass Shaders
-	shaderFiles.vs = L"FullscreenQuadVS.hlsl";
-	shaderFiles.ps = L"LightPassPS.hlsl";
-	m_lightPassShaders.initialize(m_device.Get(), m_deviceContext.Get(), shaderFiles, LayoutType::POS);
+	// - Light pass Shaders, one variant per feature set
+	m_lightPassPermutations.initialize({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY", "ENVIRONMENT_DIFFUSE", "ENVIRONMENT_SPECULAR" },
+		[](const std::vector<ShaderDefine>& defines)
+		{
+			ShaderFiles lightPassFiles;
+			lightPassFiles.vs = L"FullscreenQuadVS.hlsl";
+			lightPassFiles.ps = L"LightPassPS.hlsl";
+			lightPassFiles.defines = defines;
+			return ShaderProgramRegistry::getInstance().getProgram(lightPassFiles, LayoutType::POS);
+		});
+	// Checkbox toggles are precompiled, environment contributions at zero compile on demand
+	UINT environmentKey = m_lightPassPermutations.makeKey({ "ENVIRONMENT_DIFFUSE", "ENVIRONMENT_SPECULAR" });
+	std::vector<UINT> lightPassKeys = ShaderPermutations<Shaders>::enumerate(m_lightPassPermutations.makeKey({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY" }));
+	for (UINT& key : lightPassKeys)
+		key |= environmentKey;
+	m_lightPassPermutations.precompile(lightPassKeys);
 
 	// SSAO
 	m_HBAOInstance.initialize(m_device.Get(), m_deviceContext.Get(), m_clientWidth, m_clientHeight, m_camera.getFarZ(), m_camera.getFov(), m_camera.getViewMatrix(), m_camera.getProjectionMatrix());
@@ -1265,8 +1297,7 @@ void RenderHandler::initialize(HWND* window, Settings* settings)
 	
 	// - Buffer
 	m_selectionAnimationData.colorOpacity = 0.f;
-	PS_COLOR_ANIMATION_BUFFER* selectionAnimationData = new PS_COLOR_ANIMATION_BUFFER(m_selectionAnimationData);
-	m_selectionCBuffer.initialize(m_device.Get(), m_deviceContext.Get(), selectionAnimationData, BufferType::CONSTANT);
+	m_selectionCBuffer.initialize(m_device.Get(), m_deviceContext.Get(), &m_selectionAnimationData, BufferType::CONSTANT);
 
 	// Adaptive Exposure
 	initAdaptiveExposurePass();
@@ -1330,12 +1361,14 @@ RenderObjectKey RenderHandler::newRenderObject(std::string modelName, ShaderStat
 	(*objects)[key] = new RenderObject();
 	objects->at(key)->initialize(m_device.Get(), m_deviceContext.Get(), (int)objects->size(), modelName, meshData);
 	objects->at(key)->setShaderState(shaderState);
-	if (m_camera.isInitialized())
-	{
-		XMMATRIX viewMatrix = m_camera.getViewMatrix();
-		XMMATRIX projMatrix = m_camera.getProjectionMatrix();
-		objects->at(key)->updateWCPBuffer(XMMatrixIdentity(), viewMatrix, projMatrix);
-	}
+
+	// Transform, identity until the object is moved
+	UINT transformIndex = m_transforms.add();
+	if (transformIndex >= m_transformObjects.size())
+		m_transformObjects.resize(transformIndex + 1);
+	m_transformObjects[transformIndex] = objects->at(key);
+	objects->at(key)->setTransformIndex(transformIndex);
+	m_sceneBVHRebuild = true;
 
 	return key;
 }
@@ -1353,6 +1386,7 @@ void RenderHandler::setRenderObjectEnabled(RenderObjectKey key, bool enabled)
 	default:
 		break;
 	}
+	m_sceneBVHRebuild = true;
 }
 
 void RenderHandler::setRenderObjectTextures(RenderObjectKey key, TexturePaths textures)
@@ -1403,17 +1437,15 @@ void RenderHandler::setRenderObjectMaterialPBR(RenderObjectKey key, PS_MATERIAL_
 	}
 }
 
-void RenderHandler::updateRenderObjectWorld(RenderObjectKey key, XMMATRIX worldMatrix)
+void RenderHandler::updateRenderObjectTransform(RenderObjectKey key, XMFLOAT3 scale, XMFLOAT3 localRotation, XMFLOAT3 rotation, XMFLOAT3 position)
 {
-	XMMATRIX viewMatrix = m_camera.getViewMatrix();
-	XMMATRIX projMatrix = m_camera.getProjectionMatrix();
 	switch (key.objectType)
 	{
 	case PHONG:
-		m_renderObjects[key]->updateWCPBuffer(worldMatrix, viewMatrix, projMatrix);
+		m_transforms.set(m_renderObjects[key]->getTransformIndex(), scale, localRotation, rotation, position);
 		break;
 	case PBR:
-		m_renderObjectsPBR[key]->updateWCPBuffer(worldMatrix, viewMatrix, projMatrix);
+		m_transforms.set(m_renderObjectsPBR[key]->getTransformIndex(), scale, localRotation, rotation, position);
 		break;
 	default:
 		break;
@@ -1425,19 +1457,30 @@ void RenderHandler::deleteRenderObject(RenderObjectKey key)
 	switch (key.objectType)
 	{
 	case PHONG:
+		m_transforms.remove(m_renderObjects[key]->getTransformIndex());
+		m_transformObjects[m_renderObjects[key]->getTransformIndex()] = nullptr;
+		delete m_renderObjects[key];
 		m_renderObjects.erase(key);
 		break;
 	case PBR:
+		m_transforms.remove(m_renderObjectsPBR[key]->getTransformIndex());
+		m_transformObjects[m_renderObjectsPBR[key]->getTransformIndex()] = nullptr;
+		delete m_renderObjectsPBR[key];
 		m_renderObjectsPBR.erase(key);
 		break;
 	default:
 		break;
 	}
+	m_sceneBVHRebuild = true;
 	OutputDebugString(L"RenderObject Removed! \n");
 }
 
 RenderObjectKey RenderHandler::setShaderState(RenderObjectKey key, ShaderStates shaderState)
 {
+	// Objects changing state get a new key
+	if (shaderState != key.objectType)
+		m_sceneBVHRebuild = true;
+
 	switch (key.objectType)
 	{
 	case PHONG:
@@ -1658,8 +1701,68 @@ float RenderHandler::selectionArrowPicking(UINT pointX, UINT pointY, char dimens
 	return m_modelSelectionHandler.picking(rayOrigin, rayDirection, dimension);
 }
 
+bool RenderHandler::pickRenderObject(UINT pointX, UINT pointY, RenderObjectKey& key)
+{
+	// Scene Hierarchy, only objects whose bounds are hit test their triangles
+	if (m_sceneBVHRebuild)
+	{
+		m_pickKeys.clear();
+		m_pickObjects.clear();
+		m_pickBounds.clear();
+		for (auto& object : m_renderObjects)
+		{
+			if (object.second->isEnabled())
+			{
+				m_pickKeys.push_back(object.first);
+				m_pickObjects.push_back(object.second);
+				m_pickBounds.push_back(object.second->getWorldBoundingBox());
+			}
+		}
+		for (auto& object : m_renderObjectsPBR)
+		{
+			if (object.second->isEnabled())
+			{
+				m_pickKeys.push_back(object.first);
+				m_pickObjects.push_back(object.second);
+				m_pickBounds.push_back(object.second->getWorldBoundingBox());
+			}
+		}
+		m_sceneBVH.build(m_pickBounds);
+		m_sceneBVHRebuild = false;
+		m_sceneBVHRefit = false;
+	}
+	else if (m_sceneBVHRefit)
+	{
+		for (size_t i = 0; i < m_pickObjects.size(); i++)
+			m_pickBounds[i] = m_pickObjects[i]->getWorldBoundingBox();
+		m_sceneBVH.refit(m_pickBounds);
+		m_sceneBVHRefit = false;
+	}
+
+	// World Space Ray
+	XMVECTOR rayOrigin = m_camera.getCameraPosition();
+	XMFLOAT3 rayDirectionF3 = getRayWorldDirection(pointX, pointY);
+	XMVECTOR rayDirection = XMLoadFloat3(&rayDirectionF3);
+	XMFLOAT3 rayOriginF3;
+	XMStoreFloat3(&rayOriginF3, rayOrigin);
+
+	float distance = 0.f;
+	UINT objectIndex = 0;
+	bool hit = m_sceneBVH.intersect(rayOriginF3, rayDirectionF3, distance, objectIndex, [&](UINT object, float& objectDistance)
+	{
+		return m_pickObjects[object]->pickClosest(rayOrigin, rayDirection, objectDistance);
+	});
+
+	if (hit)
+		key = m_pickKeys[objectIndex];
+	return hit;
+}
+
 void RenderHandler::update(double dt)
 {
+	// Texture Streaming
+	ResourceHandler::getInstance().updateStreaming();
+
 	// Sky
 	m_sky.update(dt);
 
@@ -1701,8 +1804,7 @@ void RenderHandler::update(double dt)
 			m_selectionAnimationData.colorOpacity = 0.2f;
 		}
 
-		PS_COLOR_ANIMATION_BUFFER* selectionAnimationData = new PS_COLOR_ANIMATION_BUFFER(m_selectionAnimationData);
-		m_selectionCBuffer.update(&selectionAnimationData);
+		m_selectionCBuffer.update(&m_selectionAnimationData);
 	}
 }
 
@@ -1715,12 +1817,13 @@ void RenderHandler::resetParticles()
 void RenderHandler::updateShaderState(ShaderStates shaderState)
 {
 	m_shaderStates[shaderState].updateShaders();
+	m_instancedShaderStates[shaderState].updateShaders();
 }
 
 void RenderHandler::updatePassShaders()
 {
-	m_lightPassShaders.updateShaders();
 	m_tonemapShaders.updateShaders();
+	ShaderProgramRegistry::getInstance().updateShaders();
 
 	/*for (auto& object : m_particleSystems)
 		object.second.updateShaders();*/
@@ -2027,6 +2130,85 @@ void RenderHandler::UILensFlareSettings()
 	ImGui::Checkbox("Lens Flare", &m_lensFlareToggle);
 }
 
+void RenderHandler::UIStatistics()
+{
+	if (ImGui::CollapsingHeader("Statistics"))
+	{
+		ImGui::Text("Model Cache");
+		ModelCache::getInstance().updateUI();
+
+		ImGui::Text("Culling");
+		ImGui::Checkbox("Frustum Culling", &m_frustumCullingToggle);
+		ImGui::Text("Shadow Pass: %u / %u visible", m_shadowCullingStats.visible, m_shadowCullingStats.tested);
+		ImGui::Text("G-Buffer Pass: %u / %u visible", m_gBufferCullingStats.visible, m_gBufferCullingStats.tested);
+		ImGui::Checkbox("Occlusion Culling", &m_occlusionCullingToggle);
+		ImGui::Text("Occluders: %u (%u / %u triangles)", m_occlusionStats.occluders, m_occlusionStats.rasterizedTriangles, m_occlusionStats.occluderTriangles);
+		ImGui::Text("Occluded: %u / %u, %.0f us", m_occlusionStats.rejected, m_occlusionStats.tested, m_occlusionTime);
+
+		ImGui::Text("Render Queue");
+		ImGui::Checkbox("Sort Draws", &m_renderQueueSortToggle);
+		ImGui::Text("Shadow Pass: %u draws, %u binds (%u skipped)", m_shadowQueueStats.nrOfDraws, m_shadowQueueStats.getNrOfBinds(), m_shadowQueueStats.nrOfSkippedBinds);
+		ImGui::Text("G-Buffer Pass: %u draws, %u binds (%u skipped)", m_gBufferQueueStats.nrOfDraws, m_gBufferQueueStats.getNrOfBinds(), m_gBufferQueueStats.nrOfSkippedBinds);
+		ImGui::Text("Shaders: %u, Textures: %u, Buffers: %u", m_gBufferQueueStats.nrOfShaderBinds, m_gBufferQueueStats.nrOfTextureBinds,
+			m_gBufferQueueStats.nrOfVertexBufferBinds + m_gBufferQueueStats.nrOfIndexBufferBinds + m_gBufferQueueStats.nrOfConstantBufferBinds);
+
+		ImGui::Text("Instancing");
+		ImGui::Checkbox("Instance Repeated Models", &m_instancingToggle);
+		ImGui::Text("Shadow Pass: %u -> %u draws, %u instanced (%u instances)", m_shadowInstancingStats.nrOfDraws, m_shadowInstancingStats.nrOfBatchedDraws,
+			m_shadowInstancingStats.nrOfInstancedDraws, m_shadowInstancingStats.nrOfInstances);
+		ImGui::Text("G-Buffer Pass: %u -> %u draws, %u instanced (%u instances)", m_gBufferInstancingStats.nrOfDraws, m_gBufferInstancingStats.nrOfBatchedDraws,
+			m_gBufferInstancingStats.nrOfInstancedDraws, m_gBufferInstancingStats.nrOfInstances);
+
+		ImGui::Text("LODs");
+		ImGui::Checkbox("Screen Size LODs", &m_lodToggle);
+		ImGui::DragFloat("Max Pixel Error", &m_lodMaxPixelError, 0.05f, 0.1f, 16.f);
+		ImGui::Text("Objects per LOD: %u, %u, %u, %u, %u switched", m_lodStats.nrOfObjects[0], m_lodStats.nrOfObjects[1], m_lodStats.nrOfObjects[2],
+			m_lodStats.nrOfObjects[3], m_lodStats.nrOfSwitches);
+		ImGui::Text("Triangles: %u / %u", m_lodStats.nrOfTriangles, m_lodStats.nrOfFullTriangles);
+
+		ImGui::Text("Transforms");
+		ImGui::Text("Moved: %u, Uploaded: %u / %u", (UINT)m_transforms.getMovedTransforms().size(), (UINT)m_transforms.getUpdatedTransforms().size(), m_transforms.getNrOfTransforms());
+
+		ImGui::Text("Light Clusters");
+		ImGui::Text("Lights: %u / %u, Indices: %u", m_lightManager.getLightData().nrOfLights, (UINT)m_lightManager.getNrOfLights(), m_lightManager.getNrOfClusterLightIndices());
+		ImGui::Text("Binning: %.3f ms", m_lightManager.getClusterTime());
+
+		ImGui::Text("Shader Programs");
+		ShaderProgramRegistry::getInstance().updateUI();
+
+		ImGui::Text("Light Pass Variants: %u (%u on demand), Key: 0x%02X", m_lightPassPermutations.getNrOfVariants(),
+			m_lightPassPermutations.getNrOfOnDemandCompiles(), m_lightPassPermutations.getActiveKey());
+
+		ImGui::Text("Shader Cache");
+		ShaderCache& shaderCache = Shaders::getCache();
+		ImGui::Text("Memory: %u, Disk: %u, Compiled: %u", shaderCache.getMemoryHits(), shaderCache.getDiskHits(), shaderCache.getCompiles());
+
+		ImGui::Text("Texture Streaming");
+		TextureStreamerStats streamingStats = ResourceHandler::getInstance().getStreamingStats();
+		ImGui::Text("Requests: %u (%u merged), In Flight: %u, Uploaded: %u, Failed: %u", streamingStats.nrOfRequests, streamingStats.nrOfDeduplicated,
+			ResourceHandler::getInstance().getNrOfStreamingTextures(), streamingStats.nrOfUploaded, streamingStats.nrOfFailed);
+
+		ImGui::Text("Texture Cache");
+		ResourceHandler& resourceHandler = ResourceHandler::getInstance();
+		const TextureCacheStats& cacheStats = resourceHandler.getCacheStats();
+		ImGui::Text("Resident: %.1f MB, Textures: %u", resourceHandler.getResidentBytes() / (1024.f * 1024.f), resourceHandler.getNrOfTextures());
+		ImGui::Text("Hits: %u, Misses: %u, Evictions: %u (%.1f MB)", cacheStats.nrOfHits, cacheStats.nrOfMisses, cacheStats.nrOfEvictions, cacheStats.evictedBytes / (1024.f * 1024.f));
+		int budgetMegabytes = (int)(resourceHandler.getMemoryBudget() / (1024 * 1024));
+		if (ImGui::SliderInt("Budget (MB)", &budgetMegabytes, 16, 4096))
+			resourceHandler.setMemoryBudget((size_t)budgetMegabytes * 1024 * 1024);
+
+		ImGui::Text("Memory");
+		if (AllocationCounter::isCounting())
+			ImGui::Text("Heap Allocations: %llu last frame", AllocationCounter::getInstance().getLastFrameAllocations());
+		else
+			ImGui::Text("Heap Allocations: not counted in this build");
+
+		ImGui::Text("Jobs");
+		JobSystem& jobSystem = JobSystem::getInstance();
+		ImGui::Text("Threads: %u, Executed: %llu, Stolen: %llu", jobSystem.getNrOfThreads(), jobSystem.getNrOfExecutedJobs(), jobSystem.getNrOfStolenJobs());
+	}
+}
+
 void RenderHandler::UIEnviormentPanel()
 {
 	if (ImGui::CollapsingHeader("Enviorment Panel", ImGuiTreeNodeFlags_DefaultOpen))
@@ -2209,6 +2391,226 @@ void RenderHandler::UIEnviormentPanel()
 	}
 }
 
+void RenderHandler::gatherCullObjects()
+{
+	m_cullObjects.clear();
+	m_cullBounds.clear();
+
+	// Disabled objects are never drawn so they are left out of the culling
+	for (auto& object : m_renderObjects)
+	{
+		if (object.second->isEnabled())
+		{
+			m_cullObjects.push_back(object.second);
+			m_cullBounds.push_back(object.second->getWorldBoundingBox());
+		}
+	}
+	m_nrOfPhongCullObjects = m_cullObjects.size();
+
+	for (auto& object : m_renderObjectsPBR)
+	{
+		if (object.second->isEnabled())
+		{
+			m_cullObjects.push_back(object.second);
+			m_cullBounds.push_back(object.second->getWorldBoundingBox());
+		}
+	}
+}
+
+void RenderHandler::selectLods(const std::vector<UINT>& visibleIndices)
+{
+	XMFLOAT3 cameraPosition = m_camera.getCameraPositionF3();
+	XMFLOAT4X4 projectionMatrix;
+	XMStoreFloat4x4(&projectionMatrix, m_camera.getProjectionMatrix());
+
+	for (UINT index : visibleIndices)
+	{
+		// Already picked this frame by the other pass
+		if (m_lodFrames[index] == m_lodFrame)
+			continue;
+		m_lodFrames[index] = m_lodFrame;
+
+		// Bounding sphere of the world bounds, everything stays at LOD 0 when LODs are off
+		float projectedRadius = std::numeric_limits<float>::max();
+		if (m_lodToggle)
+		{
+			float x = m_cullBounds.centerX[index] - cameraPosition.x;
+			float y = m_cullBounds.centerY[index] - cameraPosition.y;
+			float z = m_cullBounds.centerZ[index] - cameraPosition.z;
+			float radius = std::sqrt(m_cullBounds.extentX[index] * m_cullBounds.extentX[index] + m_cullBounds.extentY[index] * m_cullBounds.extentY[index] +
+				m_cullBounds.extentZ[index] * m_cullBounds.extentZ[index]);
+			projectedRadius = LodSelector::getProjectedRadius(radius, std::sqrt(x * x + y * y + z * z), projectionMatrix._22, m_viewport.Height);
+		}
+
+		RenderObject* object = m_cullObjects[index];
+		UINT lastLod = object->getLod();
+		UINT lod = object->selectLod(projectedRadius, m_lodMaxPixelError);
+		m_lodStats.nrOfObjects[lod]++;
+		m_lodStats.nrOfSwitches += lod != lastLod;
+		m_lodStats.nrOfTriangles += object->getNrOfTriangles(lod);
+		m_lodStats.nrOfFullTriangles += object->getNrOfTriangles(0);
+	}
+}
+
+void RenderHandler::cullOccludedObjects()
+{
+	auto startTime = std::chrono::steady_clock::now();
+	m_occlusionCuller.beginFrame(&m_transforms.getViewProjectionMatrix().m[0][0]);
+
+	// Occluders, the largest visible objects relative to their distance
+	XMFLOAT3 cameraPosition = m_camera.getCameraPositionF3();
+	m_occluderCandidates.clear();
+	for (UINT index : m_visibleIndices)
+	{
+		float x = m_cullBounds.centerX[index] - cameraPosition.x;
+		float y = m_cullBounds.centerY[index] - cameraPosition.y;
+		float z = m_cullBounds.centerZ[index] - cameraPosition.z;
+		float radiusSquared = m_cullBounds.extentX[index] * m_cullBounds.extentX[index] + m_cullBounds.extentY[index] * m_cullBounds.extentY[index] +
+			m_cullBounds.extentZ[index] * m_cullBounds.extentZ[index];
+		float size = radiusSquared / std::max(x * x + y * y + z * z, 0.0001f);
+		if (size > OCCLUDER_MIN_SIZE)
+			m_occluderCandidates.push_back({ size, index });
+	}
+
+	size_t nrOfOccluders = std::min(m_occluderCandidates.size(), (size_t)OCCLUSION_MAX_OCCLUDERS);
+	std::partial_sort(m_occluderCandidates.begin(), m_occluderCandidates.begin() + nrOfOccluders, m_occluderCandidates.end(), std::greater<std::pair<float, UINT>>());
+	for (size_t i = 0; i < nrOfOccluders; i++)
+		m_cullObjects[m_occluderCandidates[i].second]->rasterizeOccluder(m_occlusionCuller);
+	m_occlusionCuller.finishOccluders();
+
+	// Objects stay in culling order
+	m_occlusionCuller.cull(m_cullBounds, m_visibleIndices);
+	m_occlusionStats = m_occlusionCuller.getStats();
+	m_occlusionTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void RenderHandler::setPassShaders(Shaders* shaders)
+{
+	// Shadow pass shaders need nothing besides themselves
+	if (shaders == &m_shaderStates[ShaderStates::PHONG] || shaders == &m_instancedShaderStates[ShaderStates::PHONG])
+	{
+		m_deviceContext->PSSetShaderResources(3, 1, m_shadowInstance.getShadowMapSRV()); // 3th register slot in PHONG Pixel Shader
+	}
+	else if (shaders == &m_shaderStates[ShaderStates::PBR] || shaders == &m_instancedShaderStates[ShaderStates::PBR])
+	{
+		m_deviceContext->PSSetShaderResources(5, 1, &m_shaderResourceNullptr); // 6th register slot in PBR Pixel Shader
+		m_deviceContext->PSSetShaderResources(6, 1, m_shadowInstance.getShadowMapSRV()); // 6th register slot in PBR Pixel Shader
+	}
+	shaders->setShaders();
+}
+
+const RenderQueueStats& RenderHandler::renderVisibleObjects(RenderPass pass, const std::vector<UINT>& visibleIndices, InstanceBatcherStats& instancingStats)
+{
+	XMFLOAT3 cameraPosition = m_camera.getCameraPositionF3();
+	float inverseFarZ = 1.f / m_camera.getFarZ();
+
+	m_instanceBatcher.clear();
+	for (UINT index : visibleIndices)
+	{
+		// Shadow pass depth is left at 0, only the state is sorted on there
+		Shaders* shaders = m_shadowInstance.getShaders();
+		Shaders* instancedShaders = m_shadowInstance.getInstancedShaders();
+		float depth = 0.f;
+		if (pass == RenderPass::GBUFFER)
+		{
+			ShaderStates shaderState = index < m_nrOfPhongCullObjects ? ShaderStates::PHONG : ShaderStates::PBR;
+			shaders = &m_shaderStates[shaderState];
+			instancedShaders = &m_instancedShaderStates[shaderState];
+
+			float x = m_cullBounds.centerX[index] - cameraPosition.x;
+			float y = m_cullBounds.centerY[index] - cameraPosition.y;
+			float z = m_cullBounds.centerZ[index] - cameraPosition.z;
+			depth = std::sqrt(x * x + y * y + z * z) * inverseFarZ;
+		}
+
+		// Same matrices the object's own constant buffer holds
+		UINT transform = m_cullObjects[index]->getTransformIndex();
+		VS_WVP_CBUFFER instance;
+		instance.wvp = XMLoadFloat4x4A(&m_transforms.getWVPMatrix(transform));
+		instance.worldMatrix = XMMatrixTranspose(XMLoadFloat4x4A(&m_transforms.getWorldMatrix(transform)));
+		instance.normalMatrix = XMLoadFloat4x4A(&m_transforms.getNormalMatrix(transform));
+		m_cullObjects[index]->gatherDraws(m_instanceBatcher, pass, shaders, m_instancingToggle ? instancedShaders : nullptr, depth, instance);
+	}
+	m_instanceBatcher.build();
+	instancingStats = m_instanceBatcher.getStats();
+	uploadInstances();
+
+	m_renderQueue.clear();
+	for (const BatchedDraw& batchedDraw : m_instanceBatcher.getDraws())
+		m_renderQueue.add(pass, batchedDraw.draw, batchedDraw.depth);
+
+	// Unsorted draws are submitted in culling order with every bind issued, like rendering the objects one by one
+	if (m_renderQueueSortToggle)
+		m_renderQueue.sort();
+	return m_renderQueue.submit(m_renderQueueContext, m_renderQueueSortToggle);
+}
+
+void RenderHandler::uploadInstances()
+{
+	const std::vector<VS_WVP_CBUFFER>& instances = m_instanceBatcher.getInstances();
+	if (instances.empty())
+		return;
+
+	// Grown to fit the frame, never shrunk
+	if (instances.size() > m_instanceBufferCapacity)
+	{
+		m_instanceBufferCapacity = std::max((UINT)instances.size(), m_instanceBufferCapacity * 2);
+
+		D3D11_BUFFER_DESC bufferDesc;
+		ZeroMemory(&bufferDesc, sizeof(D3D11_BUFFER_DESC));
+		bufferDesc.ByteWidth = m_instanceBufferCapacity * sizeof(VS_WVP_CBUFFER);
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		m_instanceBuffer.Reset();
+		HRESULT hr = m_device->CreateBuffer(&bufferDesc, nullptr, m_instanceBuffer.GetAddressOf());
+		assert(SUCCEEDED(hr) && "Error, failed to create instance buffer!");
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+	HRESULT hr = m_deviceContext->Map(m_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
+	assert(SUCCEEDED(hr) && "Error, failed to map instance buffer!");
+	memcpy(mappedSubresource.pData, instances.data(), instances.size() * sizeof(VS_WVP_CBUFFER));
+	m_deviceContext->Unmap(m_instanceBuffer.Get(), 0);
+
+	// Slot 1, read per instance starting at each draw's start instance
+	UINT stride = sizeof(VS_WVP_CBUFFER);
+	UINT offset = 0;
+	m_deviceContext->IASetVertexBuffers(1, 1, m_instanceBuffer.GetAddressOf(), &stride, &offset);
+}
+
+void RenderHandler::updateTransforms()
+{
+	m_transforms.update(m_camera.getViewMatrix() * m_camera.getProjectionMatrix());
+
+	// Bounds follow the world, the constant buffers follow the world and the camera
+	for (UINT transform : m_transforms.getMovedTransforms())
+		m_transformObjects[transform]->updateWorld(m_transforms.getWorldMatrix(transform));
+	if (!m_transforms.getMovedTransforms().empty())
+		m_sceneBVHRefit = true;
+	for (UINT transform : m_transforms.getUpdatedTransforms())
+		m_transformObjects[transform]->updateWCPBuffer(m_transforms.getWVPMatrix(transform), m_transforms.getWorldMatrix(transform), m_transforms.getNormalMatrix(transform));
+}
+
+UINT RenderHandler::getLightPassKey() const
+{
+	const PS_LIGHT_BUFFER& lightData = m_lightManager.getLightData();
+	UINT key = 0;
+	if (lightData.fog)
+		key |= m_lightPassPermutations.getFeatureBit("FOG");
+	if (lightData.volumetricSunScattering)
+		key |= m_lightPassPermutations.getFeatureBit("VOLUMETRIC_SUN");
+	if (lightData.procederualSky)
+		key |= m_lightPassPermutations.getFeatureBit("PROCEDURAL_SKY");
+	if (lightData.enviormentDiffContribution > 0.f)
+		key |= m_lightPassPermutations.getFeatureBit("ENVIRONMENT_DIFFUSE");
+	if (lightData.enviormentSpecContribution > 0.f)
+		key |= m_lightPassPermutations.getFeatureBit("ENVIRONMENT_SPECULAR");
+
+	return key;
+}
+
 void RenderHandler::render(double dt)
 {
 	// Clear Frame
@@ -2241,18 +2643,58 @@ void RenderHandler::render(double dt)
 	// - Adaptive Exposure Histogram
 	m_deviceContext->ClearUnorderedAccessViewUint(m_histogramUAV.Get(), clearBlackUint);
 
+	// Transforms, only moved objects or all of them when the camera moved
+	updateTransforms();
+
+	// Culling Bounds
+	gatherCullObjects();
+
+	// Culling, both passes before any LOD is picked
+	// - Shadow Map
+	if (!m_shadowMappingEnabled)
+	{
+		m_shadowVisibleIndices.clear();
+		m_shadowCullingStats = CullingStats();
+	}
+	else if (m_frustumCullingToggle)
+		m_shadowCullingStats = FrustumCuller::cull(m_cullBounds, FrustumCuller::createPlanes(m_shadowInstance.getLightVolume()), m_shadowVisibleIndices);
+	else
+		m_shadowCullingStats = FrustumCuller::passThrough(m_cullBounds.size(), m_shadowVisibleIndices);
+
+	// - Camera
+	if (m_frustumCullingToggle)
+		m_gBufferCullingStats = FrustumCuller::cull(m_cullBounds, FrustumCuller::createPlanes(m_camera.getFrustum()), m_visibleIndices);
+	else
+		m_gBufferCullingStats = FrustumCuller::passThrough(m_cullBounds.size(), m_visibleIndices);
+
+	if (m_occlusionCullingToggle)
+		cullOccludedObjects();
+	else
+		m_occlusionStats = OcclusionStats();
+
+	// LODs, only for objects one of the passes draws and once for objects both passes draw, so they draw the same geometry
+	m_lodStats = LodStats();
+	m_lodFrame++;
+	if (m_lodFrames.size() < m_cullObjects.size())
+		m_lodFrames.resize(m_cullObjects.size(), m_lodFrame - 1);
+	selectLods(m_shadowVisibleIndices);
+	selectLods(m_visibleIndices);
+
+	// Light Clusters, follow the camera and the lights every frame
+	m_lightManager.updateClusters();
+
 	// Render Shadow Map
 	if (m_shadowMappingEnabled)
 	{
 		m_shadowInstance.bindViewsAndRenderTarget(); // Also sets Shadow Comparison Sampler
-
-		for (auto& object : m_renderObjects)
-			object.second->render(true);
-		for (auto& object : m_renderObjectsPBR)
-			object.second->render(true);
+		m_shadowQueueStats = renderVisibleObjects(RenderPass::SHADOW, m_shadowVisibleIndices, m_shadowInstancingStats);
 	}
 	else
+	{
 		m_shadowInstance.clearShadowMap();
+		m_shadowQueueStats = RenderQueueStats();
+		m_shadowInstancingStats = InstanceBatcherStats();
+	}
 
 	// Set Viewport
 	m_deviceContext->RSSetViewports(1, &m_viewport);
@@ -2273,22 +2715,12 @@ void RenderHandler::render(double dt)
 	m_deviceContext->OMSetRenderTargets(GBufferType::GB_NUM - 1, renderTargets, m_depthStencilView.Get());
 
 	// Draw
-	
-	// - PHONG
-	m_deviceContext->PSSetShaderResources(3, 1, m_shadowInstance.getShadowMapSRV()); // 3th register slot in PHONG Pixel Shader
-	m_shaderStates[ShaderStates::PHONG].setShaders();
-	for (auto &object : m_renderObjects)
-		object.second->render(true);
+	// - PHONG and PBR, shaders are set by the queue
+	m_gBufferQueueStats = renderVisibleObjects(RenderPass::GBUFFER, m_visibleIndices, m_gBufferInstancingStats);
 
 	// - Light Indicators
+	setPassShaders(&m_shaderStates[ShaderStates::PHONG]);
 	m_lightManager.renderLightIndicators();
-	
-	// - PBR
-	m_deviceContext->PSSetShaderResources(5, 1, &m_shaderResourceNullptr); // 6th register slot in PBR Pixel Shader
-	m_deviceContext->PSSetShaderResources(6, 1, m_shadowInstance.getShadowMapSRV()); // 6th register slot in PBR Pixel Shader
-	m_shaderStates[ShaderStates::PBR].setShaders();
-	for (auto& object : m_renderObjectsPBR)
-		object.second->render(true);
 
 	// Volumetric Sun Scattering
 	m_sky.setSkyLight(); // Used by Light Pass and Proceural Skybox Shader too
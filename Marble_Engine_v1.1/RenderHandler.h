@@ -10,6 +10,12 @@
 #include "GBuffer.h"
 #include "SSAOInstance.h"
 #include "HBAOInstance.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "BVH.h"
+#include "TransformStore.h"
+#include "ShaderPermutations.h"
+#include "RenderQueueContext.h"
 
 struct Settings
 {
@@ -31,6 +37,7 @@ private:
 public:
     RenderObjectKey() { key = -1; valid = false; objectType = ShaderStates::PHONG; }
     bool isValid() { return valid; }
+    bool operator==(const RenderObjectKey& other) const { return key == other.key && objectType == other.objectType; }
 };
 
 struct keyComp
@@ -192,13 +199,58 @@ private:
 
     // Shader States
     std::vector<Shaders> m_shaderStates;
-    Shaders m_lightPassShaders;
+    std::vector<Shaders> m_instancedShaderStates; // Object matrices read from the instance buffer
+    ShaderPermutations<Shaders> m_lightPassPermutations; // Variant picked from the lighting toggles
 
     // Render Objects
     using RenderObjectList = std::map<RenderObjectKey, RenderObject*, keyComp>;
     RenderObjectList m_renderObjects;
     RenderObjectList m_renderObjectsPBR;
 
+    // Culling, PHONG objects first followed by PBR objects
+    bool m_frustumCullingToggle = true;
+    std::vector<RenderObject*> m_cullObjects;
+    CullingBoundsSoA m_cullBounds;
+    std::vector<UINT> m_visibleIndices;
+    std::vector<UINT> m_shadowVisibleIndices;
+    size_t m_nrOfPhongCullObjects = 0;
+    CullingStats m_shadowCullingStats;
+    CullingStats m_gBufferCullingStats;
+
+    // Occlusion Culling, the visible objects covering the most of the screen hide the rest from the G-buffer pass
+    bool m_occlusionCullingToggle = true;
+    OcclusionCuller m_occlusionCuller;
+    std::vector<std::pair<float, UINT>> m_occluderCandidates;
+    OcclusionStats m_occlusionStats;
+    double m_occlusionTime = 0.0; // Microseconds
+
+    // Render Queue, draws of the visible objects sorted by state
+    bool m_renderQueueSortToggle = true;
+    RenderQueue m_renderQueue;
+    RenderQueueContext m_renderQueueContext;
+    RenderQueueStats m_shadowQueueStats;
+    RenderQueueStats m_gBufferQueueStats;
+
+    // Instancing, visible objects sharing a mesh and material values are drawn together
+    bool m_instancingToggle = true;
+    ModelInstanceBatcher m_instanceBatcher;
+    ComPtr< ID3D11Buffer > m_instanceBuffer;
+    UINT m_instanceBufferCapacity = 0;
+    InstanceBatcherStats m_shadowInstancingStats;
+    InstanceBatcherStats m_gBufferInstancingStats;
+
+    // LODs, picked once per frame from the projected size of every visible object, both passes draw the picked LOD.
+    // The frame an object's LOD was last picked in is kept by culling index so objects in both passes are picked once
+    bool m_lodToggle = true;
+    float m_lodMaxPixelError = LOD_MAX_PIXEL_ERROR;
+    LodStats m_lodStats;
+    std::vector<UINT> m_lodFrames;
+    UINT m_lodFrame = 0;
+
+    // Transforms, render objects by transform index
+    TransformStore m_transforms;
+    std::vector<RenderObject*> m_transformObjects;
+
     // Null Pointer Views
     ID3D11RenderTargetView* m_renderTargetNullptr = nullptr;
     ID3D11ShaderResourceView* m_shaderResourceNullptr = nullptr;
@@ -215,6 +267,7 @@ private:
 
     // Lighting
     LightManager m_lightManager;
+    static const UINT CLUSTER_SRV_SLOT = 8; // Lights, Cluster Ranges and Cluster Light Indices in t8 - t10 of the Light Pass
 
     // Timer
     Timer m_timer;
@@ -230,6 +283,15 @@ private:
     PS_COLOR_ANIMATION_BUFFER m_selectionAnimationData;
     Buffer<PS_COLOR_ANIMATION_BUFFER> m_selectionCBuffer;
 
+    // Object Picking, scene hierarchy over the world bounds of every enabled object. Kept between picks, rebuilt when objects
+    // are added, removed or enabled and refit when transforms moved
+    BVH m_sceneBVH;
+    bool m_sceneBVHRebuild = true;
+    bool m_sceneBVHRefit = false;
+    std::vector<RenderObjectKey> m_pickKeys;
+    std::vector<RenderObject*> m_pickObjects;
+    std::vector<BoundingBox> m_pickBounds;
+
     // UI
     ImGui::FileBrowser m_fileDialog;
     WCHAR tempName[64];
@@ -250,6 +312,14 @@ private:
 
     // Helper Functions
     void calculateBlurWeights(CS_BLUR_CBUFFER* bufferData, int radius, float sigma);
+    void gatherCullObjects();
+    void selectLods(const std::vector<UINT>& visibleIndices);
+    void cullOccludedObjects();
+    void setPassShaders(Shaders* shaders);
+    const RenderQueueStats& renderVisibleObjects(RenderPass pass, const std::vector<UINT>& visibleIndices, InstanceBatcherStats& instancingStats);
+    void uploadInstances();
+    void updateTransforms();
+    UINT getLightPassKey() const;
 
     // Pass Functions
     void lightPass();
@@ -290,7 +360,7 @@ public:
     void setRenderObjectTextures(RenderObjectKey key, TexturePathsPBR textures);
     void setRenderObjectMaterial(RenderObjectKey key, PS_MATERIAL_BUFFER material);
     void setRenderObjectMaterialPBR(RenderObjectKey key, PS_MATERIAL_PBR_BUFFER material);
-    void updateRenderObjectWorld(RenderObjectKey key, XMMATRIX worldMatrix);
+    void updateRenderObjectTransform(RenderObjectKey key, XMFLOAT3 scale, XMFLOAT3 localRotation, XMFLOAT3 rotation, XMFLOAT3 position);
     void deleteRenderObject(RenderObjectKey key);
     RenderObjectKey setShaderState(RenderObjectKey key, ShaderStates shaderState);
     void modelTextureUIUpdate(RenderObjectKey key);
@@ -312,6 +382,7 @@ public:
     void deselectObject();
     XMFLOAT3 getRayWorldDirection(UINT pointX, UINT pointY);
     float selectionArrowPicking(UINT pointX, UINT pointY, char dimension);
+    bool pickRenderObject(UINT pointX, UINT pointY, RenderObjectKey& key);
 
     // Update
     void update(double dt);
@@ -329,6 +400,7 @@ public:
     void UIVolumetricSunSettings();
     void UIbloomSettings();
     void UILensFlareSettings();
+    void UIStatistics();
     void UIEnviormentPanel();
 
     // Render
@@ -4,8 +4,8 @@
 RenderObject::RenderObject()
 {
 	m_deviceContext = nullptr;
-	m_model = nullptr;
 	m_id = 0;
+	XMStoreFloat4x4(&m_worldMatrix, XMMatrixIdentity());
 }
 
 RenderObject::~RenderObject() {}
@@ -18,15 +18,17 @@ void RenderObject::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceC
 	// ID
 	m_id = id;
 
-	// Shaders
+	// Shaders, model meshes have quantized vertices
 	ShaderFiles shaders;
 	shaders.vs = L"GeneralVS.hlsl";
 	shaders.ps = L"GeneralPS.hlsl";
-	m_shaders.initialize(device, m_deviceContext, shaders, LayoutType::POS_NOR_TEX_TAN);
+	shaders.defines = { { "QUANTIZED" } };
+	m_shaders = ShaderProgramRegistry::getInstance().getProgram(shaders, LayoutType::POS_NOR_TEX_TAN_QUANTIZED);
 
 	// Model
-	m_model = new Model();
+	m_model = std::make_shared<Model>();
 	m_model->initialize(device, deviceContext, m_id, modelName, meshData);
+	m_worldBoundingBox = m_model->getBoundingBox();
 
 	// Constant Buffer
 	m_wvpCBuffer.initialize(device, deviceContext, nullptr, BufferType::CONSTANT);
@@ -37,11 +39,55 @@ float RenderObject::pick(XMVECTOR rayOrigin, XMVECTOR rayDirection, char dimensi
 	return m_model->pick(rayOrigin, rayDirection, dimension);
 }
 
+bool RenderObject::pickClosest(XMVECTOR rayOrigin, XMVECTOR rayDirection, float& distance)
+{
+	// Ray to Model Space
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&m_worldMatrix);
+	XMMATRIX worldInverse = XMMatrixInverse(nullptr, worldMatrix);
+	XMVECTOR localOrigin = XMVector3TransformCoord(rayOrigin, worldInverse);
+	XMVECTOR localDirection = XMVector3Normalize(XMVector3TransformNormal(rayDirection, worldInverse));
+
+	float localDistance = 0.f;
+	if (!m_model->pickClosest(localOrigin, localDirection, localDistance))
+		return false;
+
+	// Hit back to World Space, scaling changes the distance
+	XMVECTOR hitPosition = XMVector3TransformCoord(localOrigin + localDirection * localDistance, worldMatrix);
+	distance = XMVectorGetX(XMVector3Length(hitPosition - rayOrigin));
+
+	return true;
+}
+
 void RenderObject::materialUIUpdate()
 {
 	m_model->updateUI();
 }
 
+const BoundingBox& RenderObject::getWorldBoundingBox() const
+{
+	return m_worldBoundingBox;
+}
+
+bool RenderObject::isEnabled() const
+{
+	return m_enabled;
+}
+
+UINT RenderObject::getTransformIndex() const
+{
+	return m_transformIndex;
+}
+
+UINT RenderObject::getLod() const
+{
+	return m_lod;
+}
+
+UINT RenderObject::getNrOfTriangles(UINT lod) const
+{
+	return m_model ? m_model->getNrOfTriangles(lod) : 0;
+}
+
 void RenderObject::setShaderState(ShaderStates shaderState)
 {
 	m_model->setShaderState(shaderState);
@@ -82,16 +128,40 @@ void RenderObject::setEnabled(bool enabled)
 	m_enabled = enabled;
 }
 
+void RenderObject::setTransformIndex(UINT transformIndex)
+{
+	m_transformIndex = transformIndex;
+}
+
+void RenderObject::updateWorld(const XMFLOAT4X4A& worldMatrix)
+{
+	// Bounds
+	m_worldMatrix = worldMatrix;
+	m_model->getBoundingBox().Transform(m_worldBoundingBox, XMLoadFloat4x4A(&worldMatrix));
+}
+
 void RenderObject::updateWCPBuffer(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX ProjMatrix)
 {
-	VS_WVP_CBUFFER* wvpData = new VS_WVP_CBUFFER();
-	wvpData->wvp = XMMatrixTranspose(worldMatrix * viewMatrix * ProjMatrix);
-	wvpData->worldMatrix = XMMatrixTranspose(worldMatrix);
+	XMFLOAT4X4A wvpMatrix, worldMatrixA, normalMatrix;
+	XMStoreFloat4x4A(&wvpMatrix, XMMatrixTranspose(worldMatrix * viewMatrix * ProjMatrix));
+	XMStoreFloat4x4A(&worldMatrixA, worldMatrix);
+	XMStoreFloat4x4A(&normalMatrix, XMMatrixInverse(nullptr, worldMatrix));
 
-	wvpData->normalMatrix = DirectX::XMMatrixInverse(nullptr, worldMatrix);
+	updateWorld(worldMatrixA);
+	updateWCPBuffer(wvpMatrix, worldMatrixA, normalMatrix);
+}
+
+void RenderObject::updateWCPBuffer(const XMFLOAT4X4A& wvpMatrix, const XMFLOAT4X4A& worldMatrix, const XMFLOAT4X4A& normalMatrix)
+{
+	// Written straight into the mapped buffer
+	VS_WVP_CBUFFER* wvpData = m_wvpCBuffer.map();
+	wvpData->wvp = XMLoadFloat4x4A(&wvpMatrix);
+	wvpData->worldMatrix = XMMatrixTranspose(XMLoadFloat4x4A(&worldMatrix));
+
+	wvpData->normalMatrix = XMLoadFloat4x4A(&normalMatrix);
 	//wvpData->normalMatrix = XMMatrixTranspose(wvpData->normalMatrix/* * viewMatrix*/); // Normals wrong when mesh is rotated.
 
-	m_wvpCBuffer.update(&wvpData);
+	m_wvpCBuffer.unmap();
 }
 
 void RenderObject::fillMeshData(std::vector<MeshData>* meshes)
@@ -99,13 +169,20 @@ void RenderObject::fillMeshData(std::vector<MeshData>* meshes)
 	m_model->fillMeshData(meshes);
 }
 
+UINT RenderObject::selectLod(float projectedRadius, float maxPixelError)
+{
+	if (m_model)
+		m_lod = m_model->selectLod(projectedRadius, m_lod, maxPixelError);
+	return m_lod;
+}
+
 void RenderObject::render(bool disableModelShaders)
 {
 	if (m_enabled)
 	{
 		// Shaders
-		if (!disableModelShaders)
-			m_shaders.setShaders();
+		if (!disableModelShaders && m_shaders)
+			m_shaders->setShaders();
 	
 		// Constant Buffer
 		m_deviceContext->VSSetConstantBuffers(0, 1, m_wvpCBuffer.GetAddressOf());
@@ -114,4 +191,21 @@ void RenderObject::render(bool disableModelShaders)
 		if (m_model)
 			m_model->render();
 	}
+}
+
+void RenderObject::gatherDraws(ModelInstanceBatcher& batcher, RenderPass pass, const void* shader, const void* instancedShader, float depth, const VS_WVP_CBUFFER& instance)
+{
+	if (m_enabled && m_model)
+	{
+		RenderDraw objectDraw;
+		objectDraw.shader = shader;
+		objectDraw.objectBuffer = m_wvpCBuffer.Get();
+		m_model->gatherDraws(batcher, pass, objectDraw, instancedShader, depth, instance, m_lod);
+	}
+}
+
+void RenderObject::rasterizeOccluder(OcclusionCuller& culler) const
+{
+	if (m_enabled && m_model)
+		m_model->rasterizeOccluder(culler, m_worldMatrix);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef RENDEROBJECT_H
 #define RENDEROBJECT_H
 
-#include "Shaders.h"
+#include "ShaderProgramRegistry.h"
 #include "Model.h"
 
 class RenderObject
@@ -12,15 +12,21 @@ private:
 
 	// ID
 	int m_id;
+	UINT m_transformIndex = 0;
 
 	// Model
-	Model* m_model;
+	std::shared_ptr<Model> m_model;
+	UINT m_lod = 0; // Drawn LOD, kept between frames for the selection hysteresis
+
+	// World Space Bounds
+	XMFLOAT4X4 m_worldMatrix;
+	BoundingBox m_worldBoundingBox;
 
 	// Buffers
 	Buffer<VS_WVP_CBUFFER> m_wvpCBuffer;
 
-	// Shaders
-	Shaders m_shaders;
+	// Shaders, shared with every object using the same program
+	std::shared_ptr<Shaders> m_shaders;
 
 	// Enabled
 	bool m_enabled = true;
@@ -34,9 +40,15 @@ public:
 
 	// Picking
 	float pick(XMVECTOR rayOrigin, XMVECTOR rayDirection, char dimension = 'n');
+	bool pickClosest(XMVECTOR rayOrigin, XMVECTOR rayDirection, float& distance); // World space ray and distance
 
 	// Getters
 	void materialUIUpdate();
+	const BoundingBox& getWorldBoundingBox() const;
+	bool isEnabled() const;
+	UINT getTransformIndex() const;
+	UINT getLod() const;
+	UINT getNrOfTriangles(UINT lod) const;
 
 	// Setters
 	void setShaderState(ShaderStates shaderState);
@@ -47,13 +59,19 @@ public:
 	void setTextures(TexturePaths textures);
 	void setTextures(TexturePathsPBR textures);
 	void setEnabled(bool enabled);
+	void setTransformIndex(UINT transformIndex);
 
 	// Update
-	void updateWCPBuffer(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX ProjMatrix);
+	void updateWorld(const XMFLOAT4X4A& worldMatrix);
+	void updateWCPBuffer(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX ProjMatrix); // Objects outside the transform store
+	void updateWCPBuffer(const XMFLOAT4X4A& wvpMatrix, const XMFLOAT4X4A& worldMatrix, const XMFLOAT4X4A& normalMatrix); // wvp already transposed
 	void fillMeshData(std::vector<MeshData>* meshes);
+	UINT selectLod(float projectedRadius, float maxPixelError = LOD_MAX_PIXEL_ERROR); // Returns the LOD drawn from now on
 
 	// Render
 	void render(bool disableModelShaders = false);
+	void gatherDraws(ModelInstanceBatcher& batcher, RenderPass pass, const void* shader, const void* instancedShader, float depth, const VS_WVP_CBUFFER& instance); // Model shaders are not used, like render(true), draws the selected LOD
+	void rasterizeOccluder(OcclusionCuller& culler) const;
 };
 
 #endif // !RENDEROBJECT_H
\ No newline at end of file
@@ -0,0 +1,356 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+// Draws of one pass collected per frame, radix sorted on a packed 64 bit key so draws sharing a shader, textures, geometry
+// and material are submitted back to back, and submitted through a context that only sees the binds that change something.
+// Handles are opaque pointers that are only compared, the context passed to submit() turns them into device calls
+
+const unsigned int RENDER_QUEUE_MAX_TEXTURES = 6; // Pixel shader material slots, t0 - t5
+
+enum class RenderPass : unsigned int
+{
+	SHADOW,
+	GBUFFER
+};
+
+// Material textures of a draw, slots outside the mask are left as they are
+struct RenderTextureSet
+{
+	const void* textures[RENDER_QUEUE_MAX_TEXTURES] = {};
+	unsigned int mask = 0;
+	const void* displacement = nullptr; // Domain shader slot 0, nullptr leaves it as it is
+
+	void setTexture(unsigned int slot, const void* texture)
+	{
+		textures[slot] = texture;
+		mask |= 1u << slot;
+	}
+
+	bool operator<(const RenderTextureSet& other) const
+	{
+		if (mask != other.mask)
+			return mask < other.mask;
+		if (displacement != other.displacement)
+			return std::less<const void*>()(displacement, other.displacement);
+		for (unsigned int i = 0; i < RENDER_QUEUE_MAX_TEXTURES; i++)
+		{
+			if (textures[i] != other.textures[i])
+				return std::less<const void*>()(textures[i], other.textures[i]);
+		}
+		return false;
+	}
+};
+
+// State and draw arguments of one draw
+struct RenderDraw
+{
+	const void* shader = nullptr;
+	const void* vertexBuffer = nullptr;
+	unsigned int vertexStride = 0;
+	const void* geometryBuffer = nullptr; // Vertex shader constant buffer the vertices are decoded with, nullptr leaves it as it is
+	const void* indexBuffer = nullptr; // nullptr draws without indices
+	unsigned int indexSize = 4; // 2 or 4 bytes
+	const void* objectBuffer = nullptr; // Vertex shader constant buffer, nullptr leaves it as it is
+	const void* materialBuffer = nullptr; // Pixel shader constant buffer, nullptr leaves it as it is
+	RenderTextureSet textureSet;
+	unsigned int startIndex = 0; // First index, or vertex without an index buffer, LODs are ranges of one index buffer
+	unsigned int count = 0; // Indices, or vertices without an index buffer
+	unsigned int instanceCount = 0; // 0 draws without instancing
+	unsigned int startInstance = 0;
+
+	// CPU copy of the material buffer, draws with equal values can share one buffer
+	const void* materialData = nullptr;
+	unsigned int materialSize = 0;
+};
+
+struct RenderQueueStats
+{
+	unsigned int nrOfDraws = 0;
+	unsigned int nrOfShaderBinds = 0;
+	unsigned int nrOfVertexBufferBinds = 0;
+	unsigned int nrOfIndexBufferBinds = 0;
+	unsigned int nrOfConstantBufferBinds = 0;
+	unsigned int nrOfTextureBinds = 0;
+	unsigned int nrOfSkippedBinds = 0;
+
+	unsigned int getNrOfBinds() const { return nrOfShaderBinds + nrOfVertexBufferBinds + nrOfIndexBufferBinds + nrOfConstantBufferBinds + nrOfTextureBinds; }
+};
+
+struct RenderQueueBenchmarkResult
+{
+	unsigned int nrOfDraws = 0;
+	unsigned int nrOfFrames = 0;
+	double buildTime = 0.0; // Average milliseconds per frame, adding the draws and building their keys
+	double sortTime = 0.0;
+	double stdSortTime = 0.0; // Same keys with std::stable_sort
+	RenderQueueStats unsorted; // Submission order, every bind issued
+	RenderQueueStats sorted; // Sorted, redundant binds skipped
+	unsigned int errors = 0; // Draws that saw the wrong state, over all frames
+};
+
+class RenderQueue
+{
+public:
+	// Key layout from the most significant bit, a shader change costs the most so it is sorted on first. Depth is
+	// front to back and only orders draws with the same state
+	static const unsigned int PASS_BITS = 4;
+	static const unsigned int SHADER_BITS = 8;
+	static const unsigned int TEXTURE_SET_BITS = 14;
+	static const unsigned int GEOMETRY_BITS = 12;
+	static const unsigned int MATERIAL_BITS = 14;
+	static const unsigned int DEPTH_BITS = 12;
+
+	static const unsigned int DEPTH_SHIFT = 0;
+	static const unsigned int MATERIAL_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	static const unsigned int GEOMETRY_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+	static const unsigned int TEXTURE_SET_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+	static const unsigned int SHADER_SHIFT = TEXTURE_SET_SHIFT + TEXTURE_SET_BITS;
+	static const unsigned int PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+
+private:
+	struct SortItem
+	{
+		uint64_t key;
+		unsigned int index;
+	};
+
+	std::vector<RenderDraw> m_draws;
+	std::vector<SortItem> m_items;
+	std::vector<SortItem> m_sortScratch;
+
+	// Ids handed out in the order handles are first seen this frame, they only group draws so wrapping is harmless
+	std::unordered_map<const void*, unsigned int> m_shaderIds;
+	std::unordered_map<const void*, unsigned int> m_geometryIds;
+	std::unordered_map<const void*, unsigned int> m_materialIds;
+	std::map<RenderTextureSet, unsigned int> m_textureSetIds;
+
+	// Stats
+	RenderQueueStats m_stats;
+
+	// Helper Functions
+	static unsigned int getId(std::unordered_map<const void*, unsigned int>& ids, const void* handle)
+	{
+		return ids.try_emplace(handle, (unsigned int)ids.size()).first->second;
+	}
+
+	static uint64_t field(uint64_t value, unsigned int bits, unsigned int shift)
+	{
+		return (value & ((1ull << bits) - 1)) << shift;
+	}
+
+	// Least significant digit first, stable, digits every key shares are skipped
+	static void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+	{
+		scratch.resize(items.size());
+		for (unsigned int shift = 0; shift < 64; shift += 8)
+		{
+			size_t offsets[256] = {};
+			for (const SortItem& item : items)
+				offsets[(item.key >> shift) & 0xff]++;
+			if (offsets[(items.empty() ? 0 : items[0].key >> shift) & 0xff] == items.size())
+				continue;
+
+			size_t offset = 0;
+			for (size_t& count : offsets)
+			{
+				size_t digitCount = count;
+				count = offset;
+				offset += digitCount;
+			}
+			for (const SortItem& item : items)
+				scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+			items.swap(scratch);
+		}
+	}
+
+public:
+	static uint64_t buildKey(RenderPass pass, unsigned int shaderId, unsigned int textureSetId, unsigned int geometryId, unsigned int materialId, float depth)
+	{
+		float clampedDepth = std::min(std::max(depth, 0.f), 1.f);
+		uint64_t quantizedDepth = (uint64_t)(clampedDepth * ((1u << DEPTH_BITS) - 1) + 0.5f);
+
+		return field((uint64_t)pass, PASS_BITS, PASS_SHIFT) |
+			field(shaderId, SHADER_BITS, SHADER_SHIFT) |
+			field(textureSetId, TEXTURE_SET_BITS, TEXTURE_SET_SHIFT) |
+			field(geometryId, GEOMETRY_BITS, GEOMETRY_SHIFT) |
+			field(materialId, MATERIAL_BITS, MATERIAL_SHIFT) |
+			field(quantizedDepth, DEPTH_BITS, DEPTH_SHIFT);
+	}
+
+	// Starts a new frame, handle ids are reset
+	void clear()
+	{
+		m_draws.clear();
+		m_items.clear();
+		m_shaderIds.clear();
+		m_geometryIds.clear();
+		m_materialIds.clear();
+		m_textureSetIds.clear();
+	}
+
+	// Depth is 0 at the camera and 1 at the far plane
+	void add(RenderPass pass, const RenderDraw& draw, float depth)
+	{
+		unsigned int textureSetId = m_textureSetIds.try_emplace(draw.textureSet, (unsigned int)m_textureSetIds.size()).first->second;
+		uint64_t key = buildKey(pass, getId(m_shaderIds, draw.shader), textureSetId, getId(m_geometryIds, draw.vertexBuffer), getId(m_materialIds, draw.materialBuffer), depth);
+
+		m_items.push_back({ key, (unsigned int)m_draws.size() });
+		m_draws.push_back(draw);
+	}
+
+	void sort()
+	{
+		radixSort(m_items, m_sortScratch);
+	}
+
+	// Context needs setShader(shader), setVertexBuffer(buffer, stride), setGeometryBuffer(buffer), setIndexBuffer(buffer, size),
+	// setObjectBuffer(buffer), setMaterialBuffer(buffer), setTexture(slot, texture), setDisplacement(texture) and draw(count,
+	// startIndex, indexed, instanceCount, startInstance). Every bind is issued when skipRedundant is false
+	template<typename Context>
+	const RenderQueueStats& submit(Context& context, bool skipRedundant = true)
+	{
+		// Nothing is known to be bound when submission starts
+		static const char unknownHandle = 0;
+		const void* const unknown = &unknownHandle;
+
+		const void* shader = unknown;
+		const void* vertexBuffer = unknown;
+		const void* geometryBuffer = unknown;
+		const void* indexBuffer = unknown;
+		const void* objectBuffer = unknown;
+		const void* materialBuffer = unknown;
+		const void* textures[RENDER_QUEUE_MAX_TEXTURES];
+		const void* displacement = unknown;
+		std::fill(textures, textures + RENDER_QUEUE_MAX_TEXTURES, unknown);
+
+		m_stats = RenderQueueStats();
+		for (const SortItem& item : m_items)
+		{
+			const RenderDraw& draw = m_draws[item.index];
+
+			if (!skipRedundant || draw.shader != shader)
+			{
+				context.setShader(draw.shader);
+				shader = draw.shader;
+				m_stats.nrOfShaderBinds++;
+
+				// Shader setup may bind pass resources into material slots
+				std::fill(textures, textures + RENDER_QUEUE_MAX_TEXTURES, unknown);
+			}
+			else
+				m_stats.nrOfSkippedBinds++;
+
+			if (!skipRedundant || draw.vertexBuffer != vertexBuffer)
+			{
+				context.setVertexBuffer(draw.vertexBuffer, draw.vertexStride);
+				vertexBuffer = draw.vertexBuffer;
+				m_stats.nrOfVertexBufferBinds++;
+			}
+			else
+				m_stats.nrOfSkippedBinds++;
+
+			if (draw.geometryBuffer)
+			{
+				if (!skipRedundant || draw.geometryBuffer != geometryBuffer)
+				{
+					context.setGeometryBuffer(draw.geometryBuffer);
+					geometryBuffer = draw.geometryBuffer;
+					m_stats.nrOfConstantBufferBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			if (draw.indexBuffer)
+			{
+				if (!skipRedundant || draw.indexBuffer != indexBuffer)
+				{
+					context.setIndexBuffer(draw.indexBuffer, draw.indexSize);
+					indexBuffer = draw.indexBuffer;
+					m_stats.nrOfIndexBufferBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			if (draw.objectBuffer)
+			{
+				if (!skipRedundant || draw.objectBuffer != objectBuffer)
+				{
+					context.setObjectBuffer(draw.objectBuffer);
+					objectBuffer = draw.objectBuffer;
+					m_stats.nrOfConstantBufferBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			if (draw.materialBuffer)
+			{
+				if (!skipRedundant || draw.materialBuffer != materialBuffer)
+				{
+					context.setMaterialBuffer(draw.materialBuffer);
+					materialBuffer = draw.materialBuffer;
+					m_stats.nrOfConstantBufferBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			const RenderTextureSet& textureSet = draw.textureSet;
+			for (unsigned int slot = 0; slot < RENDER_QUEUE_MAX_TEXTURES; slot++)
+			{
+				if (!(textureSet.mask & (1u << slot)))
+					continue;
+
+				if (!skipRedundant || textureSet.textures[slot] != textures[slot])
+				{
+					context.setTexture(slot, textureSet.textures[slot]);
+					textures[slot] = textureSet.textures[slot];
+					m_stats.nrOfTextureBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			if (textureSet.displacement)
+			{
+				if (!skipRedundant || textureSet.displacement != displacement)
+				{
+					context.setDisplacement(textureSet.displacement);
+					displacement = textureSet.displacement;
+					m_stats.nrOfTextureBinds++;
+				}
+				else
+					m_stats.nrOfSkippedBinds++;
+			}
+
+			context.draw(draw.count, draw.startIndex, draw.indexBuffer != nullptr, draw.instanceCount, draw.startInstance);
+			m_stats.nrOfDraws++;
+		}
+
+		return m_stats;
+	}
+
+	// Getters
+	size_t getNrOfDraws() const { return m_draws.size(); }
+	uint64_t getKey(size_t order) const { return m_items[order].key; }
+	const RenderDraw& getDraw(size_t order) const { return m_draws[m_items[order].index]; }
+
+	// Stats, last submit
+	const RenderQueueStats& getStats() const { return m_stats; }
+
+	// Test and Benchmark, in RenderQueueTests.cpp
+	static unsigned int test();
+	static RenderQueueBenchmarkResult benchmark(unsigned int nrOfObjects = 4000, unsigned int nrOfFrames = 100);
+};
+
+#endif // !RENDERQUEUE_H
@@ -0,0 +1,86 @@
+#ifndef RENDERQUEUECONTEXT_H
+#define RENDERQUEUECONTEXT_H
+
+#include "pch.h"
+#include "RenderQueue.h"
+
+// Device context side of RenderQueue::submit(), buffer and texture handles are the D3D11 objects themselves. Shader handles
+// are owned by the renderer, which binds them together with the resources its pass needs
+class RenderQueueContext
+{
+private:
+	ID3D11DeviceContext* m_deviceContext = nullptr;
+	std::function<void(const void* shader)> m_setShader;
+
+public:
+	void initialize(ID3D11DeviceContext* deviceContext, std::function<void(const void* shader)> setShader)
+	{
+		m_deviceContext = deviceContext;
+		m_setShader = setShader;
+	}
+
+	void setShader(const void* shader)
+	{
+		if (shader && m_setShader)
+			m_setShader(shader);
+	}
+
+	void setVertexBuffer(const void* buffer, unsigned int stride)
+	{
+		ID3D11Buffer* vertexBuffer = (ID3D11Buffer*)buffer;
+		UINT vertexOffset = 0;
+		m_deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &vertexOffset);
+	}
+
+	void setIndexBuffer(const void* buffer, unsigned int size)
+	{
+		m_deviceContext->IASetIndexBuffer((ID3D11Buffer*)buffer, size == 2 ? DXGI_FORMAT::DXGI_FORMAT_R16_UINT : DXGI_FORMAT::DXGI_FORMAT_R32_UINT, 0);
+	}
+
+	void setGeometryBuffer(const void* buffer)
+	{
+		ID3D11Buffer* constantBuffer = (ID3D11Buffer*)buffer;
+		m_deviceContext->VSSetConstantBuffers(2, 1, &constantBuffer);
+	}
+
+	void setObjectBuffer(const void* buffer)
+	{
+		ID3D11Buffer* constantBuffer = (ID3D11Buffer*)buffer;
+		m_deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer);
+	}
+
+	void setMaterialBuffer(const void* buffer)
+	{
+		ID3D11Buffer* constantBuffer = (ID3D11Buffer*)buffer;
+		m_deviceContext->PSSetConstantBuffers(0, 1, &constantBuffer);
+	}
+
+	void setTexture(unsigned int slot, const void* texture)
+	{
+		ID3D11ShaderResourceView* shaderResourceView = (ID3D11ShaderResourceView*)texture;
+		m_deviceContext->PSSetShaderResources(slot, 1, &shaderResourceView);
+	}
+
+	void setDisplacement(const void* texture)
+	{
+		ID3D11ShaderResourceView* shaderResourceView = (ID3D11ShaderResourceView*)texture;
+		m_deviceContext->DSSetShaderResources(0, 1, &shaderResourceView);
+	}
+
+	void draw(unsigned int count, unsigned int startIndex, bool indexed, unsigned int instanceCount, unsigned int startInstance)
+	{
+		if (instanceCount == 0)
+		{
+			if (indexed)
+				m_deviceContext->DrawIndexed(count, startIndex, 0);
+			else
+				m_deviceContext->Draw(count, startIndex);
+		}
+		else if (indexed)
+			m_deviceContext->DrawIndexedInstanced(count, instanceCount, startIndex, 0, startInstance);
+		else
+			m_deviceContext->DrawInstanced(count, instanceCount, startIndex, startInstance);
+	}
+};
+
+#endif // !RENDERQUEUECONTEXT_H
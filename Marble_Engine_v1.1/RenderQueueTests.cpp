@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "RenderQueue.h"
+#include "TestSupport.h"
+#include <chrono>
+
+// Test, checks key order, the sort against std::stable_sort and the bound state of every draw, returns the number of failed checks
+unsigned int RenderQueue::test()
+{
+	unsigned int errors = 0;
+
+	// Key fields, more significant fields win regardless of the rest
+	if (buildKey(RenderPass::SHADOW, 255, 0, 0, 0, 1.f) >= buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, 0.f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, (1u << TEXTURE_SET_BITS) - 1, 0, 0, 1.f) >= buildKey(RenderPass::GBUFFER, 1, 0, 0, 0, 0.f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, 0, (1u << GEOMETRY_BITS) - 1, 0, 1.f) >= buildKey(RenderPass::GBUFFER, 0, 1, 0, 0, 0.f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, 0, 0, (1u << MATERIAL_BITS) - 1, 1.f) >= buildKey(RenderPass::GBUFFER, 0, 0, 1, 0, 0.f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, 1.f) >= buildKey(RenderPass::GBUFFER, 0, 0, 0, 1, 0.f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, 0.25f) >= buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, 0.5f))
+		errors++;
+	if (buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, -1.f) != buildKey(RenderPass::GBUFFER, 0, 0, 0, 0, 0.f))
+		errors++;
+
+	// Radix sort against std::stable_sort, few distinct high bits like real keys and full random keys
+	{
+		std::mt19937_64 generator(7);
+		for (unsigned int round = 0; round < 2; round++)
+		{
+			std::vector<SortItem> items(5000), scratch;
+			for (unsigned int i = 0; i < items.size(); i++)
+				items[i] = { round ? generator() : (generator() % 64) << 40 | (generator() % 8), i };
+			std::vector<SortItem> reference = items;
+			std::stable_sort(reference.begin(), reference.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+			radixSort(items, scratch);
+			for (size_t i = 0; i < items.size(); i++)
+			{
+				if (items[i].key != reference[i].key || items[i].index != reference[i].index)
+				{
+					errors++;
+					break;
+				}
+			}
+		}
+	}
+
+	// Submission, every draw is checked against its own state with and without skipping
+	TestScene scene;
+	fillTestScene(800, 11, scene);
+	const size_t nrOfDraws = scene.draws.size();
+	RenderQueue queue;
+	for (const TestSceneDraw& sceneDraw : scene.draws)
+		queue.add(RenderPass::GBUFFER, sceneDraw.draw, sceneDraw.depth);
+
+	RenderRecordingContext unsorted;
+	errors += submitRecorded(queue, unsorted, false);
+	RenderQueueStats unsortedStats = queue.getStats();
+
+	RenderRecordingContext unsortedSkipped;
+	errors += submitRecorded(queue, unsortedSkipped);
+	RenderQueueStats unsortedSkippedStats = queue.getStats();
+
+	queue.sort();
+	RenderRecordingContext sorted;
+	errors += submitRecorded(queue, sorted);
+	RenderQueueStats sortedStats = queue.getStats();
+
+	if (unsorted.nrOfDraws != nrOfDraws || sorted.nrOfDraws != nrOfDraws || sortedStats.nrOfDraws != nrOfDraws)
+		errors++;
+	if (unsorted.nrOfCalls != unsortedStats.getNrOfBinds() || sorted.nrOfCalls != sortedStats.getNrOfBinds())
+		errors++;
+	if (unsortedStats.nrOfSkippedBinds != 0 || unsortedSkippedStats.getNrOfBinds() >= unsortedStats.getNrOfBinds())
+		errors++;
+	if (sortedStats.getNrOfBinds() >= unsortedSkippedStats.getNrOfBinds())
+		errors++;
+	if (sortedStats.getNrOfBinds() + sortedStats.nrOfSkippedBinds != unsortedStats.getNrOfBinds())
+		errors++;
+
+	// Sorted, one bind per shader and texture binds bounded by the distinct texture sets
+	if (sortedStats.nrOfShaderBinds != 2 || sortedStats.nrOfTextureBinds > 16 * (RENDER_QUEUE_MAX_TEXTURES + 1) * 2)
+		errors++;
+
+	// Keys ascend and draws with equal state come front to back
+	for (size_t i = 1; i < queue.getNrOfDraws(); i++)
+	{
+		if (queue.getKey(i - 1) > queue.getKey(i))
+		{
+			errors++;
+			break;
+		}
+	}
+
+	// Every draw submitted exactly once
+	std::vector<const RenderDraw*> drawOrder = sorted.drawOrder;
+	std::sort(drawOrder.begin(), drawOrder.end());
+	if (std::adjacent_find(drawOrder.begin(), drawOrder.end()) != drawOrder.end() || drawOrder.size() != nrOfDraws)
+		errors++;
+
+	// Clearing starts over
+	queue.clear();
+	RenderRecordingContext empty;
+	queue.submit(empty);
+	if (empty.nrOfCalls != 0 || queue.getStats().nrOfDraws != 0)
+		errors++;
+
+	return errors;
+}
+
+// Benchmark, builds and sorts a scene of draws every frame and counts the binds before and after sorting and skipping
+RenderQueueBenchmarkResult RenderQueue::benchmark(unsigned int nrOfObjects, unsigned int nrOfFrames)
+{
+	RenderQueueBenchmarkResult result;
+	result.nrOfFrames = nrOfFrames;
+
+	TestScene scene;
+	RenderQueue queue;
+	auto addScene = [&]()
+	{
+		queue.clear();
+		for (const TestSceneDraw& sceneDraw : scene.draws)
+			queue.add(RenderPass::GBUFFER, sceneDraw.draw, sceneDraw.depth);
+	};
+
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		fillTestScene(nrOfObjects, frame, scene);
+		result.nrOfDraws = (unsigned int)scene.draws.size();
+		auto startTime = std::chrono::steady_clock::now();
+		addScene();
+		result.buildTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		std::vector<SortItem> items = queue.m_items;
+		startTime = std::chrono::steady_clock::now();
+		queue.sort();
+		result.sortTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		startTime = std::chrono::steady_clock::now();
+		std::stable_sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+		result.stdSortTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		RenderRecordingContext sorted;
+		result.errors += submitRecorded(queue, sorted);
+		result.sorted = queue.getStats();
+	}
+
+	// Submission order of the last frame with every bind issued
+	addScene();
+	RenderRecordingContext unsorted;
+	result.errors += submitRecorded(queue, unsorted, false);
+	result.unsorted = queue.getStats();
+
+	result.buildTime /= std::max(nrOfFrames, 1u);
+	result.sortTime /= std::max(nrOfFrames, 1u);
+	result.stdSortTime /= std::max(nrOfFrames, 1u);
+
+	return result;
+}
@@ -3,80 +3,174 @@
 #define RESOURCEHANDLER_H
 
 #include "WICTextureLoader.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include <filesystem>
+
+// Cooked textures sit next to their source, see TextureCooker
+const std::wstring COOKED_TEXTURE_EXTENSION = L".cooked.dds";
+
+// Keeps the texture resident, points at a slot that holds the placeholder until the texture has streamed in so bind it
+// through the handle every time
+using TextureHandle = TextureCache<ID3D11ShaderResourceView*>::Handle;
+
+struct TextureStreamingBenchmarkResult
+{
+	UINT nrOfTextures = 0;
+	UINT nrOfFailed = 0;
+	double megabytes = 0.0; // Decoded, mips included
+	double serialTime = 0.0; // Milliseconds, one thread
+	double streamedTime = 0.0; // Milliseconds, every job system thread
+	UINT nrOfThreads = 0;
+};
 
 class ResourceHandler
 {
 private:
-	ResourceHandler() {};
+	ResourceHandler() : m_textures(512 * 1024 * 1024, &ResourceHandler::releaseTexture), m_streamer(JobSystem::getInstance(), &ResourceHandler::decodeTexture) {};
 	// Device
 	ID3D11Device* m_device = nullptr;
 	ID3D11DeviceContext* m_deviceContext = nullptr;
 
-	// Textures
-	std::map<const std::wstring, ID3D11ShaderResourceView*> m_textures;
+	// Textures, loaded views are accounted with their size and owned, placeholders and fallbacks are borrowed with size 0
+	TextureCache<ID3D11ShaderResourceView*> m_textures;
+
+	// Streaming
+	TextureStreamer<DirectX::ScratchImage> m_streamer;
+	size_t m_uploadBudget = 32 * 1024 * 1024; // Bytes per frame
 
 	const std::wstring rootTexturePath = L"Textures\\";
 
 	// Helper Functions
-	bool createTextureFromFile(const WCHAR* texturePath, bool isCubeMap = false)
+	static std::wstring getFileExtension(const std::wstring& path)
 	{
-		HRESULT hr;
-		bool couldLoad = true;
-		m_textures[texturePath] = nullptr;
-		std::wstring path = texturePath;
-		path = rootTexturePath + path;
-
 		size_t i = path.rfind('.', path.length());
-		std::wstring fileExtension = path.substr(i + 1, path.length() - i);
+		return path.substr(i + 1, path.length() - i);
+	}
+
+	// Thread safe, runs on the job system workers
+	static bool decodeTexture(const std::wstring& path, DirectX::ScratchImage& image, size_t& size)
+	{
+		// WIC needs COM on every thread that decodes
+		static thread_local bool comInitialized = (CoInitializeEx(nullptr, COINIT_MULTITHREADED), true);
+		(void)comInitialized;
+
+		// Cooked textures already have their mips and block compression, preferred while they are at least as new as the source
+		if (isCookedTextureUpToDate(path) && SUCCEEDED(DirectX::LoadFromDDSFile(getCookedTexturePath(path).c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image)))
+		{
+			size = image.GetPixelsSize();
+			return true;
+		}
+
+		HRESULT hr;
+		std::wstring fileExtension = getFileExtension(path);
 		if (fileExtension == L"dds" || fileExtension == L"DDS")
-			hr = CreateDDSTextureFromFile(m_device, m_deviceContext, path.c_str(), nullptr, &m_textures[texturePath]);
+			hr = DirectX::LoadFromDDSFile(path.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image);
 		else if (fileExtension == L"hdr")
+			hr = DirectX::LoadFromHDRFile(path.c_str(), nullptr, image);
+		else
 		{
-			DirectX::TexMetadata metadata;
 			DirectX::ScratchImage scratchImage;
-			hr = LoadFromHDRFile(path.c_str(), &metadata, scratchImage);
-			assert(SUCCEEDED(hr) && "Error, failed to load HDR texture file!");
+			if (fileExtension == L"tga" || fileExtension == L"TGA")
+				hr = DirectX::LoadFromTGAFile(path.c_str(), nullptr, scratchImage);
+			else
+				hr = DirectX::LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, scratchImage);
+			if (FAILED(hr))
+				return false;
 
-			hr = CreateShaderResourceView(m_device, scratchImage.GetImages(), scratchImage.GetImageCount(), metadata, &m_textures[texturePath]);
+			// Mip chain on the CPU, formats the filter can not handle keep their single level
+			hr = DirectX::GenerateMipMaps(scratchImage.GetImages(), scratchImage.GetImageCount(), scratchImage.GetMetadata(), DirectX::TEX_FILTER_DEFAULT, 0, image);
+			if (FAILED(hr))
+			{
+				image = std::move(scratchImage);
+				hr = S_OK;
+			}
 		}
-		else if (fileExtension == L"tga" || fileExtension == L"TGA")
-		{
-			DirectX::TexMetadata metadata;
-			DirectX::ScratchImage scratchImage;
-			DirectX::LoadFromTGAFile(path.c_str(), &metadata, scratchImage);
-			DirectX::ScratchImage mipChain;
-
-			hr = GenerateMipMaps(scratchImage.GetImages(), scratchImage.GetImageCount(),
-				scratchImage.GetMetadata(), TEX_FILTER_DEFAULT, 0, mipChain);
-			assert(SUCCEEDED(hr) && "Error, failed to generate mipmaps for TGA texture file!");
+		if (FAILED(hr))
+			return false;
 
-			hr = CreateShaderResourceView(m_device, mipChain.GetImages(), mipChain.GetImageCount(), metadata, &m_textures[texturePath]);
-		}
-		else
-			hr = CreateWICTextureFromFile(m_device, m_deviceContext, path.c_str(), nullptr, &m_textures[texturePath]);
-		
+		size = image.GetPixelsSize();
+		return true;
+	}
 
+	ID3D11ShaderResourceView* createView(const std::wstring& texturePath, const DirectX::ScratchImage& image)
+	{
+		ID3D11ShaderResourceView* view = nullptr;
+		HRESULT hr = DirectX::CreateShaderResourceView(m_device, image.GetImages(), image.GetImageCount(), image.GetMetadata(), &view);
 		if (FAILED(hr))
-		{
-			OutputDebugString(L"Failed to load: '");
-			OutputDebugString(texturePath);
-			OutputDebugString(L"'\n");
-			path = rootTexturePath + L"Empty_Texture.jpg";
-			hr = CreateWICTextureFromFile(m_device, m_deviceContext, path.c_str(), nullptr, &m_textures[texturePath]);
-			couldLoad = false;
-		}
-		else
+			return nullptr;
+
+		// Named by the handler so materials never rename a shared view, the UI reads 64 bytes
+		WCHAR name[32] = {};
+		wcsncpy_s(name, texturePath.c_str(), _TRUNCATE);
+		view->SetPrivateData(WKPDID_D3DDebugObjectNameW, sizeof(name), name);
+		return view;
+	}
+
+	static void releaseTexture(const std::wstring& texturePath, ID3D11ShaderResourceView*& view, size_t size)
+	{
+		if (view && size > 0)
+			view->Release();
+		view = nullptr;
+	}
+
+	// Failed loads borrow the empty texture and are accounted with size 0
+	ID3D11ShaderResourceView* getLoadedTexture(const std::wstring& texturePath, ID3D11ShaderResourceView* view, size_t& size)
+	{
+		if (view)
 		{
 			OutputDebugString(L"Texture loaded: '");
-			OutputDebugString(texturePath);
+			OutputDebugString(texturePath.c_str());
 			OutputDebugString(L"'\n");
+			return view;
 		}
-		//assert(SUCCEEDED(hr) && "Error, failed to load texture file!");
 
-		/*if (FAILED(hr))
-			m_textures[texturePath] = getTexture(L"Empty_Texture.jpg");*/
-		
-		return couldLoad;
+		OutputDebugString(L"Failed to load: '");
+		OutputDebugString(texturePath.c_str());
+		OutputDebugString(L"'\n");
+		size = 0;
+		return texturePath != L"Empty_Texture.jpg" ? getTexture(L"Empty_Texture.jpg") : nullptr;
+	}
+
+	TextureHandle createTextureFromFile(const std::wstring& texturePath, bool isCubeMap = false)
+	{
+		DirectX::ScratchImage image;
+		size_t size = 0;
+		ID3D11ShaderResourceView* view = nullptr;
+		if (decodeTexture(rootTexturePath + texturePath, image, size))
+			view = createView(texturePath, image);
+
+		// Size includes every mip and array slice
+		ID3D11ShaderResourceView* resource = getLoadedTexture(texturePath, view, size);
+		return m_textures.insert(texturePath, resource, size);
+	}
+
+	void uploadStreamedTextures(size_t byteBudget)
+	{
+		m_streamer.processUploads(byteBudget, [this](const std::wstring& path, DirectX::ScratchImage& image, bool decoded)
+			{
+				// Evicted while decoding, nothing is waiting for it
+				std::wstring texturePath = path.substr(rootTexturePath.length());
+				if (!m_textures.contains(texturePath))
+					return;
+
+				size_t size = image.GetPixelsSize();
+				ID3D11ShaderResourceView* resource = getLoadedTexture(texturePath, decoded ? createView(texturePath, image) : nullptr, size);
+				m_textures.update(texturePath, resource, size);
+			});
+	}
+
+	bool isStreaming(const std::wstring& texturePath)
+	{
+		return m_streamer.isInFlight(rootTexturePath + texturePath);
+	}
+
+	std::wstring getRelativePath(const WCHAR* texturePath) const
+	{
+		std::wstring path(texturePath);
+		if (path.find(rootTexturePath) == 0)
+			path.erase(0, rootTexturePath.length());
+		return path;
 	}
 
 public:
@@ -84,8 +178,8 @@ public:
 	void operator=(ResourceHandler const&) = delete;
 	~ResourceHandler()
 	{
-		for (auto& texture : m_textures)
-			texture.second->Release();
+		m_streamer.waitForDecodes();
+		m_textures.clear();
 	}
 	static ResourceHandler& getInstance()
 	{
@@ -99,21 +193,141 @@ public:
 		m_deviceContext = deviceContext;
 	}
 
+	// Cooked Textures, paths include the texture root
+	static std::wstring getCookedTexturePath(const std::wstring& path)
+	{
+		return path + COOKED_TEXTURE_EXTENSION;
+	}
+	static bool isCookedTexture(const std::wstring& path)
+	{
+		return path.length() > COOKED_TEXTURE_EXTENSION.length() &&
+			path.compare(path.length() - COOKED_TEXTURE_EXTENSION.length(), COOKED_TEXTURE_EXTENSION.length(), COOKED_TEXTURE_EXTENSION) == 0;
+	}
+	static bool isCookedTextureUpToDate(const std::wstring& path)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA cookedAttributes;
+		WIN32_FILE_ATTRIBUTE_DATA sourceAttributes;
+
+		if (isCookedTexture(path) || !GetFileAttributesExW(getCookedTexturePath(path).c_str(), GetFileExInfoStandard, &cookedAttributes))
+			return false;
+
+		if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &sourceAttributes))
+			return true;
+
+		return CompareFileTime(&cookedAttributes.ftLastWriteTime, &sourceAttributes.ftLastWriteTime) >= 0;
+	}
+
+	// Loads on the calling thread the first time, streaming textures are finished right away. The texture is pinned for
+	// the lifetime of the handler since the caller keeps the raw view
 	ID3D11ShaderResourceView* getTexture(const WCHAR* texturePath, bool isCubeMap = false)
 	{
-		std::wstring path(texturePath);
-		if (path.find(rootTexturePath) == 0)
-			path.erase(0, rootTexturePath.length());
+		TextureHandle handle = getTextureHandle(texturePath, isCubeMap);
+		if (handle == nullptr)
+			return nullptr;
 
-		if (!m_textures.count(path.c_str()))
+		m_textures.pin(handle.getKey());
+		return *handle;
+	}
+
+	// Loads on the calling thread like getTexture(), the texture can be evicted once the last handle is gone
+	TextureHandle getTextureHandle(const WCHAR* texturePath, bool isCubeMap = false)
+	{
+		std::wstring path = getRelativePath(texturePath);
+
+		TextureHandle handle = m_textures.acquire(path);
+		if (handle != nullptr)
 		{
-			if (m_device != nullptr)
-				createTextureFromFile(path.c_str(), isCubeMap);
+			if (isStreaming(path))
+				finishStreaming();
+			return handle;
+		}
 
-			return m_textures[path.c_str()];
+		if (m_device == nullptr)
+			return handle;
+		return createTextureFromFile(path, isCubeMap);
+	}
+
+	// Returns at once, the handle points at the placeholder until the decoded texture is uploaded by updateStreaming()
+	TextureHandle getTextureAsync(const WCHAR* texturePath, const WCHAR* placeholderPath = L"DefaultGrey.bmp")
+	{
+		std::wstring path = getRelativePath(texturePath);
+		if (path == getRelativePath(placeholderPath))
+			return getTextureHandle(texturePath);
+
+		TextureHandle handle = m_textures.acquire(path);
+		if (handle != nullptr || m_device == nullptr)
+			return handle;
+
+		handle = m_textures.insert(path, getTexture(placeholderPath), 0);
+		m_streamer.request(rootTexturePath + path);
+
+		return handle;
+	}
+
+	// Once per frame on the render thread, swaps in decoded textures within the upload budget
+	void updateStreaming()
+	{
+		uploadStreamedTextures(m_uploadBudget);
+	}
+	void finishStreaming()
+	{
+		m_streamer.waitForDecodes();
+		uploadStreamedTextures((size_t)-1);
+	}
+	void setUploadBudget(size_t bytesPerFrame) { m_uploadBudget = bytesPerFrame; }
+
+	// Unreferenced textures are evicted least recently used first while the resident size is over the budget
+	void setMemoryBudget(size_t bytes) { m_textures.setBudget(bytes); }
+
+	// Stats
+	TextureStreamerStats getStreamingStats() const { return m_streamer.getStats(); }
+	UINT getNrOfStreamingTextures() { return m_streamer.getNrOfInFlight(); }
+	UINT getNrOfTextures() const { return m_textures.getNrOfEntries(); }
+	const TextureCacheStats& getCacheStats() const { return m_textures.getStats(); }
+	size_t getResidentBytes() const { return m_textures.getResidentBytes(); }
+	size_t getMemoryBudget() const { return m_textures.getBudget(); }
+
+	// Benchmark, decodes every texture in the Textures folder on one thread and then through the streamer
+	static TextureStreamingBenchmarkResult benchmarkStreaming()
+	{
+		TextureStreamingBenchmarkResult result;
+
+		std::vector<std::wstring> paths;
+		std::error_code error;
+		for (auto& file : std::filesystem::recursive_directory_iterator(L"Textures", error))
+		{
+			if (file.is_regular_file() && !isCookedTexture(file.path().wstring()))
+				paths.push_back(file.path().wstring());
 		}
-		else
-			return m_textures[path.c_str()];
+		result.nrOfTextures = (UINT)paths.size();
+
+		// Serial
+		auto startTime = std::chrono::steady_clock::now();
+		unsigned long long bytes = 0;
+		for (const std::wstring& path : paths)
+		{
+			DirectX::ScratchImage image;
+			size_t size = 0;
+			if (decodeTexture(path, image, size))
+				bytes += size;
+			else
+				result.nrOfFailed++;
+		}
+		result.serialTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		result.megabytes = bytes / (1024.0 * 1024.0);
+
+		// Streamed, uploads are dropped so only decoding and queueing is measured
+		JobSystem& jobSystem = JobSystem::getInstance();
+		result.nrOfThreads = jobSystem.getNrOfThreads();
+		TextureStreamer<DirectX::ScratchImage> streamer(jobSystem, &ResourceHandler::decodeTexture);
+		startTime = std::chrono::steady_clock::now();
+		for (const std::wstring& path : paths)
+			streamer.request(path);
+		streamer.waitForDecodes();
+		streamer.processUploads((size_t)-1, [](const std::wstring&, DirectX::ScratchImage&, bool) {});
+		result.streamedTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		return result;
 	}
 
 	/*const uint8_t* getBytesFromImage(const WCHAR* texturePath)
@@ -128,4 +342,4 @@ public:
 	}*/
 };
 
-#endif // !RESOURCEHANDLER_H
\ No newline at end of file
+#endif // !RESOURCEHANDLER_H
@@ -345,8 +345,7 @@ public:
     {
         m_SSAOCameraData.viewMatrix = XMMatrixTranspose(viewMatrix);
 
-        PS_SSAO_CAMERA_BUFFER* SSAOCameraData = new PS_SSAO_CAMERA_BUFFER(m_SSAOCameraData);
-        m_SSAOCameraBuffer.update(&SSAOCameraData);
+        m_SSAOCameraBuffer.update(&m_SSAOCameraData);
     }
     void updateShaders()
     {
@@ -0,0 +1,332 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdio>
+
+// Content addressed shader bytecode cache, keyed by the source, its include closure, entry point, profile, defines and flags.
+// The compiler sits behind ShaderCompiler so the cache runs without the D3D compiler
+
+// Cache File Layout
+// [ShaderCacheHeader][Bytecode]
+
+const char SHADER_CACHE_MAGIC[4] = { 'M', 'S', 'C', 'H' };
+const unsigned int SHADER_CACHE_VERSION = 2;
+const std::string SHADER_CACHE_EXTENSION = ".cso";
+
+struct ShaderCacheHeader
+{
+	char magic[4] = { SHADER_CACHE_MAGIC[0], SHADER_CACHE_MAGIC[1], SHADER_CACHE_MAGIC[2], SHADER_CACHE_MAGIC[3] };
+	unsigned int version = SHADER_CACHE_VERSION;
+	unsigned long long key = 0;
+	unsigned long long size = 0;
+	unsigned long long checksum = 0;
+};
+
+struct ShaderDefine
+{
+	std::string name;
+	std::string value = "1";
+};
+
+struct ShaderRequest
+{
+	std::filesystem::path file;
+	std::string entryPoint = "main";
+	std::string profile;
+	unsigned int flags = 0;
+	std::vector<ShaderDefine> defines; // Order is part of the key
+};
+
+class ShaderCompiler
+{
+public:
+	virtual ~ShaderCompiler() {}
+	virtual bool compile(const ShaderRequest& request, std::vector<char>& bytecode, std::string& errors) = 0;
+};
+
+struct ShaderCacheBenchmarkResult
+{
+	unsigned int nrOfShaders = 0;
+	double coldTime = 0.0; // Milliseconds, empty cache directory
+	double warmTime = 0.0; // Milliseconds, new process state reading the cache directory
+	unsigned int coldCompiles = 0;
+	unsigned int warmCompiles = 0;
+};
+
+using ShaderBytecode = std::shared_ptr<const std::vector<char>>;
+
+class ShaderCache
+{
+private:
+	struct SourceFile
+	{
+		std::filesystem::file_time_type writeTime;
+		unsigned long long hash = 0;
+		std::vector<std::filesystem::path> includes; // Resolved
+	};
+
+	ShaderCompiler* m_compiler;
+	std::filesystem::path m_directory;
+
+	// Guards the maps below, compiles and disk access run outside of it
+	std::mutex m_mutex;
+	std::map<std::filesystem::path, SourceFile> m_sourceFiles;
+	std::map<unsigned long long, ShaderBytecode> m_bytecode;
+
+	// Stats
+	std::atomic<unsigned int> m_memoryHits;
+	std::atomic<unsigned int> m_diskHits;
+	std::atomic<unsigned int> m_compiles;
+	std::atomic<unsigned int> m_tempFileCounter;
+
+	// Helper Functions
+	static unsigned long long hash(const void* data, size_t size, unsigned long long seed = 14695981039346656037ull) // FNV-1a
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		unsigned long long result = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			result ^= bytes[i];
+			result *= 1099511628211ull;
+		}
+		return result;
+	}
+	static unsigned long long hash(const std::string& text, unsigned long long seed)
+	{
+		// Length first so neighbouring strings can not shift into each other
+		unsigned long long length = text.size();
+		return hash(text.data(), text.size(), hash(&length, sizeof(length), seed));
+	}
+
+	static std::vector<std::filesystem::path> parseIncludes(const std::string& source, const std::filesystem::path& directory)
+	{
+		// Resolved relative to the including file like D3D_COMPILE_STANDARD_FILE_INCLUDE, missing files are left to the compiler
+		std::vector<std::filesystem::path> includes;
+		std::istringstream lines(source);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+				continue;
+
+			size_t open = line.find_first_of("\"<", start + 8);
+			if (open == std::string::npos)
+				continue;
+			size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+			if (close == std::string::npos)
+				continue;
+
+			std::filesystem::path include = directory / line.substr(open + 1, close - open - 1);
+			std::error_code error;
+			if (std::filesystem::exists(include, error))
+				includes.push_back(include.lexically_normal());
+		}
+		return includes;
+	}
+
+	// Hash of one file, re-read only when its write time changes
+	bool getSourceFile(const std::filesystem::path& file, SourceFile& sourceFile)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file, error);
+		if (error)
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_sourceFiles.find(file);
+			if (it != m_sourceFiles.end() && it->second.writeTime == writeTime)
+			{
+				sourceFile = it->second;
+				return true;
+			}
+		}
+
+		std::ifstream sourceStream(file, std::ios::in | std::ios::binary);
+		if (!sourceStream.is_open())
+			return false;
+		std::string source((std::istreambuf_iterator<char>(sourceStream)), std::istreambuf_iterator<char>());
+
+		sourceFile.writeTime = writeTime;
+		sourceFile.hash = hash(source, hash(file.generic_string(), 14695981039346656037ull));
+		sourceFile.includes = parseIncludes(source, file.parent_path());
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_sourceFiles[file] = sourceFile;
+		return true;
+	}
+
+	bool computeKey(const ShaderRequest& request, unsigned long long& key)
+	{
+		key = hash(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+		key = hash(request.entryPoint, key);
+		key = hash(request.profile, key);
+		key = hash(&request.flags, sizeof(request.flags), key);
+		unsigned long long nrOfDefines = request.defines.size();
+		key = hash(&nrOfDefines, sizeof(nrOfDefines), key);
+		for (const ShaderDefine& define : request.defines)
+		{
+			key = hash(define.name, key);
+			key = hash(define.value, key);
+		}
+
+		// Include Closure, depth first in include order so the key is stable
+		std::vector<std::filesystem::path> stack = { request.file.lexically_normal() };
+		std::set<std::filesystem::path> visited;
+		while (!stack.empty())
+		{
+			std::filesystem::path file = stack.back();
+			stack.pop_back();
+			if (!visited.insert(file).second)
+				continue;
+
+			SourceFile sourceFile;
+			if (!getSourceFile(file, sourceFile))
+				return false;
+			key = hash(&sourceFile.hash, sizeof(sourceFile.hash), key);
+			for (auto it = sourceFile.includes.rbegin(); it != sourceFile.includes.rend(); ++it)
+				stack.push_back(*it);
+		}
+		return true;
+	}
+
+	std::filesystem::path getCachePath(unsigned long long key) const
+	{
+		char name[17];
+		snprintf(name, sizeof(name), "%016llx", key);
+		return m_directory / (std::string(name) + SHADER_CACHE_EXTENSION);
+	}
+
+	bool readCacheFile(unsigned long long key, std::vector<char>& bytecode) const
+	{
+		std::ifstream cacheFile(getCachePath(key), std::ios::in | std::ios::binary);
+		if (!cacheFile.is_open())
+			return false;
+
+		ShaderCacheHeader header;
+		if (!cacheFile.read((char*)&header, sizeof(ShaderCacheHeader)))
+			return false;
+		if (memcmp(header.magic, SHADER_CACHE_MAGIC, sizeof(SHADER_CACHE_MAGIC)) != 0 || header.version != SHADER_CACHE_VERSION || header.key != key)
+			return false;
+
+		bytecode.resize((size_t)header.size);
+		if (!cacheFile.read(bytecode.data(), bytecode.size()))
+			return false;
+
+		// Truncated or partially written files are recompiled
+		return hash(bytecode.data(), bytecode.size()) == header.checksum;
+	}
+
+	void writeCacheFile(unsigned long long key, const std::vector<char>& bytecode)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+
+		// Written to a unique temporary file and renamed over, readers never see a partial file
+		std::filesystem::path cachePath = getCachePath(key);
+		std::filesystem::path tempPath = cachePath;
+		tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." + std::to_string(m_tempFileCounter++) + ".tmp";
+		{
+			std::ofstream cacheFile(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!cacheFile.is_open())
+				return;
+
+			ShaderCacheHeader header;
+			header.key = key;
+			header.size = bytecode.size();
+			header.checksum = hash(bytecode.data(), bytecode.size());
+			cacheFile.write((const char*)&header, sizeof(ShaderCacheHeader));
+			cacheFile.write(bytecode.data(), bytecode.size());
+			if (!cacheFile.good())
+			{
+				cacheFile.close();
+				std::filesystem::remove(tempPath, error);
+				return;
+			}
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error)
+			std::filesystem::remove(tempPath, error);
+	}
+
+public:
+	ShaderCache(ShaderCompiler* compiler, const std::filesystem::path& directory)
+	{
+		m_compiler = compiler;
+		m_directory = directory;
+		m_memoryHits = 0;
+		m_diskHits = 0;
+		m_compiles = 0;
+		m_tempFileCounter = 0;
+	}
+
+	// Memory, then disk, then the compiler. Returns nullptr and the compiler errors if compiling fails
+	ShaderBytecode getBytecode(const ShaderRequest& request, std::string& errors)
+	{
+		unsigned long long key = 0;
+		if (!computeKey(request, key))
+		{
+			errors = "Error, could not read shader source " + request.file.string() + "\n";
+			return nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_bytecode.find(key);
+			if (it != m_bytecode.end())
+			{
+				m_memoryHits++;
+				return it->second;
+			}
+		}
+
+		std::shared_ptr<std::vector<char>> bytecode = std::make_shared<std::vector<char>>();
+		if (readCacheFile(key, *bytecode))
+			m_diskHits++;
+		else
+		{
+			bytecode->clear();
+			m_compiles++;
+			if (!m_compiler || !m_compiler->compile(request, *bytecode, errors))
+				return nullptr;
+			writeCacheFile(key, *bytecode);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto inserted = m_bytecode.insert({ key, bytecode });
+		return inserted.first->second; // Another thread may have finished first, both results are equal
+	}
+
+	void clearMemory()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_sourceFiles.clear();
+		m_bytecode.clear();
+	}
+
+	// Stats
+	unsigned int getMemoryHits() const { return m_memoryHits; }
+	unsigned int getDiskHits() const { return m_diskHits; }
+	unsigned int getCompiles() const { return m_compiles; }
+	const std::filesystem::path& getDirectory() const { return m_directory; }
+
+	// Test and Benchmark, in ShaderCacheTests.cpp
+	static unsigned int test(const std::filesystem::path& directory);
+	static ShaderCacheBenchmarkResult benchmark(ShaderCompiler* compiler, const std::vector<ShaderRequest>& requests, const std::filesystem::path& directory);
+};
+
+#endif // !SHADERCACHE_H
@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "ShaderCache.h"
+#include "TestSupport.h"
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+
+static bool hasBytecode(const ShaderBytecode& bytecode, const ShaderRequest& request)
+{
+	std::string expected = TestShaderCompiler::getExpectedBytecode(request);
+	return bytecode && !expected.empty() && std::string(bytecode->begin(), bytecode->end()) == expected;
+}
+
+unsigned int ShaderCache::test(const std::filesystem::path& directory)
+{
+	unsigned int errors = 0;
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	std::filesystem::path sourceDirectory = directory / "Sources";
+	std::filesystem::path cacheDirectory = directory / "Cache";
+	std::filesystem::create_directories(sourceDirectory / "Include", error);
+
+	// a includes common, common includes deep and a cycle back through loop, b stands alone
+	writeTestSource(sourceDirectory / "a.hlsl", "#include \"Include/common.hlsli\"\nfloat4 main() : SV_TARGET { return COLOR; }\n");
+	writeTestSource(sourceDirectory / "Include" / "common.hlsli", "#include \"deep.hlsli\"\n#define COLOR float4(1, 0, 0, 1)\n");
+	writeTestSource(sourceDirectory / "Include" / "deep.hlsli", "static const float DEEP = 1.0;\n");
+	writeTestSource(sourceDirectory / "b.hlsl", "float4 main() : SV_TARGET { return 0; }\n");
+	writeTestSource(sourceDirectory / "loop.hlsli", "#include \"loop.hlsli\"\n");
+
+	ShaderRequest requestA;
+	requestA.file = sourceDirectory / "a.hlsl";
+	requestA.profile = "ps_5_0";
+	ShaderRequest requestB = requestA;
+	requestB.file = sourceDirectory / "b.hlsl";
+
+	// Hashing, every part of the request is in the key and an equal request gives an equal key
+	{
+		TestShaderCompiler compiler;
+		ShaderCache cache(&compiler, cacheDirectory);
+		std::vector<ShaderRequest> requests(8, requestA);
+		requests[1].file = requestB.file;
+		requests[2].entryPoint = "other";
+		requests[3].profile = "vs_5_0";
+		requests[4].flags = 1;
+		requests[5].defines = { { "AB", "C" } };
+		requests[6].defines = { { "A", "BC" } };
+		requests[7].defines = { { "X" }, { "Y" } };
+		ShaderRequest reordered = requestA;
+		reordered.defines = { { "Y" }, { "X" } };
+		requests.push_back(reordered);
+
+		std::vector<unsigned long long> keys;
+		for (const ShaderRequest& request : requests)
+		{
+			unsigned long long key = 0;
+			errors += !cache.computeKey(request, key);
+			keys.push_back(key);
+		}
+		std::sort(keys.begin(), keys.end());
+		errors += std::adjacent_find(keys.begin(), keys.end()) != keys.end();
+
+		ShaderRequest sameA = requestA;
+		sameA.file = sourceDirectory / "Include" / ".." / "a.hlsl";
+		unsigned long long keyA = 0, keySameA = 0;
+		errors += !cache.computeKey(requestA, keyA) || !cache.computeKey(sameA, keySameA) || keyA != keySameA;
+
+		// One compile per distinct request, the rest come from memory
+		std::string compileErrors;
+		for (int round = 0; round < 2; round++)
+		{
+			for (const ShaderRequest& request : requests)
+				errors += !hasBytecode(cache.getBytecode(request, compileErrors), request);
+		}
+		errors += compiler.nrOfCompiles != requests.size() || cache.getCompiles() != requests.size() || cache.getMemoryHits() != requests.size();
+
+		// Include cycles end
+		ShaderRequest loop = requestA;
+		loop.file = sourceDirectory / "loop.hlsli";
+		unsigned long long loopKey = 0;
+		errors += !cache.computeKey(loop, loopKey);
+	}
+
+	// #include Invalidation, an edit anywhere in the closure recompiles and an edit outside of it does not
+	{
+		TestShaderCompiler compiler;
+		ShaderCache cache(&compiler, cacheDirectory);
+		std::string compileErrors;
+		errors += !hasBytecode(cache.getBytecode(requestA, compileErrors), requestA);
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		errors += compiler.nrOfCompiles != 0 || cache.getDiskHits() != 2;
+
+		writeTestSource(sourceDirectory / "Include" / "deep.hlsli", "static const float DEEP = 2.0;\n");
+		errors += !hasBytecode(cache.getBytecode(requestA, compileErrors), requestA);
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		errors += compiler.nrOfCompiles != 1;
+
+		writeTestSource(sourceDirectory / "Include" / "common.hlsli", "#include \"deep.hlsli\"\n#define COLOR float4(0, 1, 0, 1)\n");
+		errors += !hasBytecode(cache.getBytecode(requestA, compileErrors), requestA);
+		errors += compiler.nrOfCompiles != 2;
+
+		// Touching a file without changing it keeps the key
+		writeTestSource(sourceDirectory / "b.hlsl", "float4 main() : SV_TARGET { return 0; }\n");
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		errors += compiler.nrOfCompiles != 2;
+
+		// A new include of an existing file joins the closure
+		writeTestSource(sourceDirectory / "b.hlsl", "#include \"Include/deep.hlsli\"\nfloat4 main() : SV_TARGET { return DEEP; }\n");
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		writeTestSource(sourceDirectory / "Include" / "deep.hlsli", "static const float DEEP = 3.0;\n");
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		errors += compiler.nrOfCompiles != 4;
+	}
+
+	// Corrupt Files, anything but a complete file for the same key is recompiled and written again
+	{
+		TestShaderCompiler compiler;
+		ShaderCache cache(&compiler, cacheDirectory);
+		std::string compileErrors;
+		errors += !hasBytecode(cache.getBytecode(requestA, compileErrors), requestA);
+		errors += !hasBytecode(cache.getBytecode(requestB, compileErrors), requestB);
+		unsigned long long keyA = 0, keyB = 0;
+		errors += !cache.computeKey(requestA, keyA) || !cache.computeKey(requestB, keyB);
+		std::filesystem::path pathA = cache.getCachePath(keyA);
+		std::filesystem::path pathB = cache.getCachePath(keyB);
+
+		std::vector<std::function<void(std::vector<char>&)>> corruptions = {
+			[](std::vector<char>& file) { file.resize(sizeof(ShaderCacheHeader) / 2); }, // Torn header
+			[](std::vector<char>& file) { file.resize(file.size() - 1); }, // Torn bytecode
+			[](std::vector<char>& file) { file.back() ^= 0x20; }, // Flipped bit
+			[](std::vector<char>& file) { file[0] = 'X'; }, // Magic
+			[](std::vector<char>& file) { file[offsetof(ShaderCacheHeader, version)]++; }, // Version
+			[](std::vector<char>& file) { file.clear(); }, // Empty
+			[&](std::vector<char>& file) // Complete file of another key
+			{
+				std::ifstream otherFile(pathB, std::ios::in | std::ios::binary);
+				file.assign(std::istreambuf_iterator<char>(otherFile), std::istreambuf_iterator<char>());
+			}
+		};
+		for (auto& corrupt : corruptions)
+		{
+			std::vector<char> file;
+			{
+				std::ifstream cacheFile(pathA, std::ios::in | std::ios::binary);
+				file.assign(std::istreambuf_iterator<char>(cacheFile), std::istreambuf_iterator<char>());
+			}
+			errors += file.size() <= sizeof(ShaderCacheHeader);
+			if (file.size() <= sizeof(ShaderCacheHeader))
+				break;
+			corrupt(file);
+			{
+				std::ofstream cacheFile(pathA, std::ios::out | std::ios::binary | std::ios::trunc);
+				cacheFile.write(file.data(), file.size());
+			}
+
+			TestShaderCompiler recompiler;
+			ShaderCache recompiling(&recompiler, cacheDirectory);
+			errors += !hasBytecode(recompiling.getBytecode(requestA, compileErrors), requestA);
+			errors += recompiler.nrOfCompiles != 1;
+
+			TestShaderCompiler reloader;
+			ShaderCache reloading(&reloader, cacheDirectory);
+			errors += !hasBytecode(reloading.getBytecode(requestA, compileErrors), requestA);
+			errors += reloader.nrOfCompiles != 0 || reloading.getDiskHits() != 1;
+		}
+	}
+
+	// Failures, a missing source or a failed compile returns nothing and leaves nothing behind
+	{
+		TestShaderCompiler compiler;
+		ShaderCache cache(&compiler, cacheDirectory);
+		std::string compileErrors;
+		ShaderRequest missing = requestA;
+		missing.file = sourceDirectory / "missing.hlsl";
+		errors += cache.getBytecode(missing, compileErrors) != nullptr || compileErrors.empty() || compiler.nrOfCompiles != 0;
+
+		writeTestSource(sourceDirectory / "broken.hlsl", "#error broken\n");
+		ShaderRequest broken = requestA;
+		broken.file = sourceDirectory / "broken.hlsl";
+		compileErrors.clear();
+		errors += cache.getBytecode(broken, compileErrors) != nullptr || compileErrors.empty();
+		compileErrors.clear();
+		errors += cache.getBytecode(broken, compileErrors) != nullptr || compileErrors.empty();
+		unsigned long long brokenKey = 0;
+		errors += !cache.computeKey(broken, brokenKey) || std::filesystem::exists(cache.getCachePath(brokenKey)) || compiler.nrOfCompiles != 2;
+	}
+
+	// Concurrent Access, threads of one cache and a second cache on the same directory like a second process
+	{
+		std::vector<ShaderRequest> requests;
+		for (unsigned int i = 0; i < 24; i++)
+		{
+			ShaderRequest request = i % 2 ? requestA : requestB;
+			request.defines = { { "VARIANT", std::to_string(i / 2) } };
+			requests.push_back(request);
+		}
+		std::filesystem::remove_all(cacheDirectory, error);
+
+		TestShaderCompiler compiler, otherCompiler;
+		compiler.slow = true;
+		otherCompiler.slow = true;
+		ShaderCache cache(&compiler, cacheDirectory);
+		ShaderCache otherCache(&otherCompiler, cacheDirectory);
+		std::atomic<unsigned int> threadErrors{ 0 };
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < 8; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				ShaderCache& threadCache = t % 4 == 3 ? otherCache : cache;
+				std::string compileErrors;
+				for (unsigned int i = 0; i < 200; i++)
+				{
+					const ShaderRequest& request = requests[(i * (t + 1) + t) % requests.size()];
+					if (!hasBytecode(threadCache.getBytecode(request, compileErrors), request))
+						threadErrors++;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		errors += threadErrors;
+		errors += compiler.nrOfCompiles + otherCompiler.nrOfCompiles < requests.size();
+
+		// Every file complete and no temporary files left
+		for (const auto& entry : std::filesystem::directory_iterator(cacheDirectory, error))
+			errors += entry.path().extension() != SHADER_CACHE_EXTENSION;
+		TestShaderCompiler reloader;
+		ShaderCache reloading(&reloader, cacheDirectory);
+		std::string compileErrors;
+		for (const ShaderRequest& request : requests)
+			errors += !hasBytecode(reloading.getBytecode(request, compileErrors), request);
+		errors += reloader.nrOfCompiles != 0 || reloading.getDiskHits() != requests.size();
+	}
+
+	std::filesystem::remove_all(directory, error);
+	return errors;
+}
+
+// Benchmark, compiles every request into an empty directory, then loads them again with a fresh cache
+ShaderCacheBenchmarkResult ShaderCache::benchmark(ShaderCompiler* compiler, const std::vector<ShaderRequest>& requests, const std::filesystem::path& directory)
+{
+	ShaderCacheBenchmarkResult result;
+	result.nrOfShaders = (unsigned int)requests.size();
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	for (int warm = 0; warm < 2; warm++)
+	{
+		ShaderCache cache(compiler, directory);
+		std::string errors;
+		auto startTime = std::chrono::steady_clock::now();
+		for (const ShaderRequest& request : requests)
+			cache.getBytecode(request, errors);
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		if (warm)
+		{
+			result.warmTime = elapsed;
+			result.warmCompiles = cache.getCompiles();
+		}
+		else
+		{
+			result.coldTime = elapsed;
+			result.coldCompiles = cache.getCompiles();
+		}
+	}
+
+	return result;
+}
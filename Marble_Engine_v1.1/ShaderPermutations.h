@@ -0,0 +1,149 @@
+#ifndef SHADERPERMUTATIONS_H
+#define SHADERPERMUTATIONS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <cassert>
+#include "ShaderCache.h"
+
+// Compile time feature permutations of one program. Every feature is a define and a bit in the key,
+// features that are off are left undefined so the shader strips their code with #if
+
+template<typename Program>
+class ShaderPermutations
+{
+public:
+	using CreateProgram = std::function<std::shared_ptr<Program>(const std::vector<ShaderDefine>& defines)>;
+
+private:
+	// Features, bit i is m_features[i]
+	std::vector<std::string> m_features;
+	unsigned int m_featureMask = 0;
+
+	// Variants
+	CreateProgram m_createProgram;
+	std::map<unsigned int, std::shared_ptr<Program>> m_variants;
+	unsigned int m_activeKey = 0;
+	std::shared_ptr<Program> m_activeProgram;
+
+	// Stats
+	unsigned int m_nrOfOnDemandCompiles = 0;
+	unsigned int m_nrOfSwitches = 0;
+
+	// Helper Functions
+	std::shared_ptr<Program> getVariant(unsigned int key, bool onDemand)
+	{
+		auto it = m_variants.find(key);
+		if (it != m_variants.end())
+			return it->second;
+
+		std::shared_ptr<Program> program = m_createProgram(getDefines(key));
+		if (onDemand)
+			m_nrOfOnDemandCompiles++;
+		m_variants[key] = program;
+		return program;
+	}
+
+public:
+	void initialize(const std::vector<std::string>& features, CreateProgram createProgram)
+	{
+		assert(features.size() <= 32);
+		m_features = features;
+		m_featureMask = features.size() >= 32 ? ~0u : (1u << features.size()) - 1u;
+		m_createProgram = createProgram;
+		m_variants.clear();
+		m_activeKey = 0;
+		m_activeProgram = nullptr;
+	}
+
+	// Keys
+	unsigned int getFeatureBit(const std::string& feature) const
+	{
+		for (size_t i = 0; i < m_features.size(); i++)
+		{
+			if (m_features[i] == feature)
+				return 1u << i;
+		}
+		return 0;
+	}
+	unsigned int makeKey(const std::vector<std::string>& enabledFeatures) const
+	{
+		unsigned int key = 0;
+		for (const std::string& feature : enabledFeatures)
+			key |= getFeatureBit(feature);
+		return key;
+	}
+	std::vector<ShaderDefine> getDefines(unsigned int key) const
+	{
+		// Feature order, so equal keys always give equal cache keys
+		std::vector<ShaderDefine> defines;
+		for (size_t i = 0; i < m_features.size(); i++)
+		{
+			if (key & (1u << i))
+				defines.push_back({ m_features[i], "1" });
+		}
+		return defines;
+	}
+
+	// Every subset of the mask in ascending order, the mask itself included
+	static std::vector<unsigned int> enumerate(unsigned int mask)
+	{
+		std::vector<unsigned int> keys;
+		unsigned int key = 0;
+		while (true)
+		{
+			keys.push_back(key);
+			if (key == mask)
+				break;
+			key = (key - mask) & mask;
+		}
+		return keys;
+	}
+
+	// Variants
+	void precompile(const std::vector<unsigned int>& keys)
+	{
+		for (unsigned int key : keys)
+			getVariant(key & m_featureMask, false);
+	}
+	Program* select(unsigned int key)
+	{
+		// Bits for features this program does not declare are stripped
+		key &= m_featureMask;
+		if (m_activeProgram && key == m_activeKey)
+			return m_activeProgram.get();
+
+		if (m_activeProgram)
+			m_nrOfSwitches++;
+		m_activeKey = key;
+		m_activeProgram = getVariant(key, true);
+		return m_activeProgram.get();
+	}
+	void forEachVariant(const std::function<void(Program&)>& function)
+	{
+		for (auto& variant : m_variants)
+		{
+			if (variant.second)
+				function(*variant.second);
+		}
+	}
+
+	// Getters
+	Program* getActiveProgram() const { return m_activeProgram.get(); }
+	unsigned int getActiveKey() const { return m_activeKey; }
+	unsigned int getFeatureMask() const { return m_featureMask; }
+	const std::vector<std::string>& getFeatures() const { return m_features; }
+
+	// Stats
+	unsigned int getNrOfVariants() const { return (unsigned int)m_variants.size(); }
+	unsigned int getNrOfOnDemandCompiles() const { return m_nrOfOnDemandCompiles; }
+	unsigned int getNrOfSwitches() const { return m_nrOfSwitches; }
+
+	// Test, in ShaderPermutationsTests.cpp
+	static unsigned int test(const std::filesystem::path& directory);
+};
+
+#endif // !SHADERPERMUTATIONS_H
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "ShaderPermutations.h"
+#include "Shaders.h"
+#include "TestSupport.h"
+#include <set>
+
+// Program of the test, the bytecode the cache handed out and the defines it was created with
+struct TestProgram
+{
+	ShaderBytecode bytecode;
+	std::vector<ShaderDefine> defines;
+};
+
+static bool hasDefines(const TestProgram* program, const std::vector<std::string>& names)
+{
+	if (!program || program->defines.size() != names.size())
+		return false;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (program->defines[i].name != names[i] || program->defines[i].value != "1")
+			return false;
+	}
+	return true;
+}
+
+template<typename Program>
+unsigned int ShaderPermutations<Program>::test(const std::filesystem::path& directory)
+{
+	unsigned int errors = 0;
+
+	// Enumeration, every subset of the mask once and in ascending order
+	for (unsigned int mask : { 0u, 1u, 0x5u, 0xBu, 0xF0u, 0x1FFu })
+	{
+		std::vector<unsigned int> keys = ShaderPermutations<TestProgram>::enumerate(mask);
+		std::vector<unsigned int> expected;
+		for (unsigned int key = 0; key <= mask; key++)
+		{
+			if ((key & ~mask) == 0)
+				expected.push_back(key);
+		}
+		errors += keys != expected;
+	}
+	errors += ShaderPermutations<TestProgram>::enumerate(0x80000001u).size() != 4;
+
+	// Variants are compiled through a shader cache with a stub compiler
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	std::filesystem::create_directories(directory, error);
+	writeTestSource(directory / "LightPassPS.hlsl", "float4 main() : SV_TARGET { return 0; }\n");
+
+	TestShaderCompiler compiler;
+	ShaderCache cache(&compiler, directory / "Cache");
+	auto createProgram = [&](const std::vector<ShaderDefine>& defines)
+	{
+		ShaderRequest request;
+		request.file = directory / "LightPassPS.hlsl";
+		request.profile = "ps_5_0";
+		request.defines = defines;
+
+		std::shared_ptr<TestProgram> program = std::make_shared<TestProgram>();
+		std::string compileErrors;
+		program->bytecode = cache.getBytecode(request, compileErrors);
+		program->defines = defines;
+		return program;
+	};
+
+	// Keys, one bit per feature in declaration order and undeclared features are ignored
+	ShaderPermutations<TestProgram> permutations;
+	permutations.initialize({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY" }, createProgram);
+	errors += permutations.getFeatureMask() != 0x7;
+	errors += permutations.getFeatureBit("FOG") != 1 || permutations.getFeatureBit("PROCEDURAL_SKY") != 4 || permutations.getFeatureBit("SHADOWS") != 0;
+	errors += permutations.makeKey({ "PROCEDURAL_SKY", "FOG" }) != permutations.makeKey({ "FOG", "PROCEDURAL_SKY", "SHADOWS" });
+	errors += permutations.makeKey({}) != 0 || permutations.makeKey({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY" }) != 0x7;
+	std::vector<ShaderDefine> defines = permutations.getDefines(permutations.makeKey({ "PROCEDURAL_SKY", "FOG" }));
+	errors += defines.size() != 2 || defines[0].name != "FOG" || defines[1].name != "PROCEDURAL_SKY";
+
+	// Precompiling, one compile per variant and every variant gets its own bytecode
+	std::vector<unsigned int> keys = ShaderPermutations<TestProgram>::enumerate(permutations.getFeatureMask());
+	permutations.precompile(keys);
+	errors += permutations.getNrOfVariants() != 8 || compiler.nrOfCompiles != 8 || permutations.getNrOfOnDemandCompiles() != 0;
+	std::set<std::string> bytecodes;
+	permutations.forEachVariant([&](TestProgram& program)
+	{
+		if (program.bytecode)
+			bytecodes.insert(std::string(program.bytecode->begin(), program.bytecode->end()));
+	});
+	errors += bytecodes.size() != 8;
+
+	// Equal keys give equal cache keys, a second program with the same features compiles nothing
+	ShaderPermutations<TestProgram> samePermutations;
+	samePermutations.initialize({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY" }, createProgram);
+	samePermutations.precompile(keys);
+	errors += compiler.nrOfCompiles != 8 || cache.getMemoryHits() != 8;
+
+	// Selection, the variant with exactly the selected features and bits outside the mask stripped
+	TestProgram* program = permutations.select(permutations.makeKey({ "VOLUMETRIC_SUN" }));
+	errors += !hasDefines(program, { "VOLUMETRIC_SUN" }) || permutations.getActiveKey() != 2;
+	errors += permutations.select(2 | 0x100) != program || permutations.getNrOfSwitches() != 0;
+	program = permutations.select(permutations.makeKey({ "PROCEDURAL_SKY", "FOG" }));
+	errors += !hasDefines(program, { "FOG", "PROCEDURAL_SKY" }) || permutations.getActiveProgram() != program || permutations.getNrOfSwitches() != 1;
+	errors += !hasDefines(permutations.select(0), {}) || permutations.getNrOfSwitches() != 2;
+	errors += permutations.getNrOfOnDemandCompiles() != 0 || compiler.nrOfCompiles != 8;
+
+	// On demand, a key that was not precompiled is compiled once on first use
+	ShaderPermutations<TestProgram> onDemand;
+	onDemand.initialize({ "FOG", "VOLUMETRIC_SUN", "PROCEDURAL_SKY", "SHADOWS" }, createProgram);
+	onDemand.precompile({ 0 });
+	program = onDemand.select(onDemand.makeKey({ "SHADOWS", "FOG" }));
+	errors += !hasDefines(program, { "FOG", "SHADOWS" }) || onDemand.getNrOfOnDemandCompiles() != 1;
+	onDemand.select(0);
+	errors += onDemand.select(onDemand.makeKey({ "SHADOWS", "FOG" })) != program || onDemand.getNrOfOnDemandCompiles() != 1 || onDemand.getNrOfVariants() != 2;
+
+	// Initializing again starts over
+	onDemand.initialize({ "FOG" }, createProgram);
+	errors += onDemand.getNrOfVariants() != 0 || onDemand.getActiveProgram() != nullptr || onDemand.getFeatureMask() != 1;
+
+	std::filesystem::remove_all(directory, error);
+	return errors;
+}
+
+template unsigned int ShaderPermutations<Shaders>::test(const std::filesystem::path& directory);
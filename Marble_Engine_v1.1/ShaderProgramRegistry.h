@@ -0,0 +1,149 @@
+#include "pch.h"
+#ifndef SHADERPROGRAMREGISTRY_H
+#define SHADERPROGRAMREGISTRY_H
+
+#include "Shaders.h"
+
+struct ShaderProgramBenchmarkResult
+{
+	UINT nrOfObjects = 0;
+	double perObjectTime = 0.0; // Milliseconds, one Shaders per object like the old render objects
+	double registryTime = 0.0; // Milliseconds, handles from the registry
+	UINT perObjectDriverObjects = 0;
+	UINT registryDriverObjects = 0;
+	UINT errors = 0; // Equal keys on different programs, differing keys on one program or wrong live program counts
+};
+
+// Interns shader programs by files, defines, layout, topology and stream output so identical objects share one set of shaders and input layout
+class ShaderProgramRegistry
+{
+private:
+	ShaderProgramRegistry() {};
+	// Device
+	ID3D11Device* m_device = nullptr;
+	ID3D11DeviceContext* m_deviceContext = nullptr;
+
+	// Programs, entries expire when the last handle is released
+	struct ProgramKey
+	{
+		std::wstring files[6];
+		std::string defines;
+		LayoutType layoutType;
+		D3D_PRIMITIVE_TOPOLOGY topology;
+		bool streamOutput;
+
+		bool operator<(const ProgramKey& other) const
+		{
+			for (int i = 0; i < 6; i++)
+			{
+				if (files[i] != other.files[i])
+					return files[i] < other.files[i];
+			}
+			if (defines != other.defines)
+				return defines < other.defines;
+			if (layoutType != other.layoutType)
+				return layoutType < other.layoutType;
+			if (topology != other.topology)
+				return topology < other.topology;
+			return streamOutput < other.streamOutput;
+		}
+	};
+	std::map<ProgramKey, std::weak_ptr<Shaders>> m_programs;
+
+	// Stats
+	UINT m_cacheHits = 0;
+	UINT m_cacheMisses = 0;
+
+public:
+	ShaderProgramRegistry(ShaderProgramRegistry const&) = delete;
+	void operator=(ShaderProgramRegistry const&) = delete;
+	static ShaderProgramRegistry& getInstance()
+	{
+		static ShaderProgramRegistry registryInstance;
+		return registryInstance;
+	}
+
+	void initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+	{
+		m_device = device;
+		m_deviceContext = deviceContext;
+	}
+
+	std::shared_ptr<Shaders> getProgram(ShaderFiles files, LayoutType layoutType = LayoutType::POS_NOR_TEX, D3D_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY::D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, bool streamOutput = false)
+	{
+		ProgramKey key = { { files.vs, files.hs, files.ds, files.gs, files.ps, files.cs }, "", layoutType, topology, streamOutput };
+		for (const ShaderDefine& define : files.defines)
+			key.defines += define.name + "=" + define.value + ";";
+		auto it = m_programs.find(key);
+		if (it != m_programs.end())
+		{
+			std::shared_ptr<Shaders> program = it->second.lock();
+			if (program)
+			{
+				m_cacheHits++;
+				return program;
+			}
+		}
+
+		m_cacheMisses++;
+		std::shared_ptr<Shaders> program = std::make_shared<Shaders>();
+		program->initialize(m_device, m_deviceContext, files, layoutType, topology, streamOutput);
+		m_programs[key] = program;
+
+		return program;
+	}
+
+	// Hot Reload, every live program recompiles once no matter how many objects share it
+	void updateShaders()
+	{
+		for (auto& program : m_programs)
+		{
+			std::shared_ptr<Shaders> shaders = program.second.lock();
+			if (shaders)
+				shaders->updateShaders();
+		}
+	}
+
+	// Stats
+	UINT getCacheHits() const { return m_cacheHits; }
+	UINT getCacheMisses() const { return m_cacheMisses; }
+	UINT getNrOfUniquePrograms() const
+	{
+		UINT nrOfPrograms = 0;
+		for (auto& program : m_programs)
+		{
+			if (!program.second.expired())
+				nrOfPrograms++;
+		}
+		return nrOfPrograms;
+	}
+	void getHandleStats(UINT& nrOfHandles, UINT& nrOfDriverObjects) const
+	{
+		nrOfHandles = 0;
+		nrOfDriverObjects = 0;
+		for (auto& program : m_programs)
+		{
+			std::shared_ptr<Shaders> shaders = program.second.lock();
+			if (shaders)
+			{
+				nrOfHandles += (UINT)shaders.use_count() - 1;
+				nrOfDriverObjects += shaders->getNrOfDriverObjects();
+			}
+		}
+	}
+
+	// UI
+	void updateUI()
+	{
+		UINT nrOfHandles, nrOfDriverObjects;
+		getHandleStats(nrOfHandles, nrOfDriverObjects);
+		ImGui::Text("Unique Programs: %u, Handles: %u", getNrOfUniquePrograms(), nrOfHandles);
+		ImGui::Text("Cache Hits: %u, Misses: %u", m_cacheHits, m_cacheMisses);
+		ImGui::Text("Driver Objects: %u", nrOfDriverObjects);
+	}
+
+	// Benchmark, in ShaderProgramRegistryTests.cpp
+	static ShaderProgramBenchmarkResult benchmark(UINT nrOfObjects = 5000);
+};
+
+#endif // !SHADERPROGRAMREGISTRY_H
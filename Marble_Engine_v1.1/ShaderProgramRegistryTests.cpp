@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "ShaderProgramRegistry.h"
+#include <chrono>
+
+// Benchmark, creates the render object program for every object with and without the registry. The registry run then
+// checks that equal keys share one program, that every differing key gets its own and that programs expire with their handles
+ShaderProgramBenchmarkResult ShaderProgramRegistry::benchmark(UINT nrOfObjects)
+{
+	ShaderProgramBenchmarkResult result;
+	result.nrOfObjects = nrOfObjects;
+
+	// Device, no window or swap chain needed
+	ComPtr< ID3D11Device > device;
+	ComPtr< ID3D11DeviceContext > deviceContext;
+	HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, device.GetAddressOf(), nullptr, deviceContext.GetAddressOf());
+	if (FAILED(hr))
+		hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, device.GetAddressOf(), nullptr, deviceContext.GetAddressOf());
+	if (FAILED(hr))
+	{
+		OutputDebugStringA("Error, failed to create device for the shader program benchmark!\n");
+		result.errors++;
+		return result;
+	}
+
+	// The program RenderObject asks for
+	ShaderFiles files;
+	files.vs = L"GeneralVS.hlsl";
+	files.ps = L"GeneralPS.hlsl";
+	files.defines = { { "QUANTIZED" } };
+	const LayoutType layoutType = LayoutType::POS_NOR_TEX_TAN_QUANTIZED;
+
+	// Warm the bytecode cache so both runs only measure object creation
+	Shaders warmUp;
+	warmUp.initialize(device.Get(), deviceContext.Get(), files, layoutType);
+
+	// Per Object
+	{
+		std::vector< std::unique_ptr<Shaders> > programs(nrOfObjects);
+		auto startTime = std::chrono::steady_clock::now();
+		for (UINT i = 0; i < nrOfObjects; i++)
+		{
+			programs[i] = std::make_unique<Shaders>();
+			programs[i]->initialize(device.Get(), deviceContext.Get(), files, layoutType);
+		}
+		result.perObjectTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+		for (UINT i = 0; i < nrOfObjects; i++)
+			result.perObjectDriverObjects += programs[i]->getNrOfDriverObjects();
+	}
+
+	// Registry
+	{
+		ShaderProgramRegistry registry;
+		registry.initialize(device.Get(), deviceContext.Get());
+		std::vector< std::shared_ptr<Shaders> > programs(nrOfObjects);
+		auto startTime = std::chrono::steady_clock::now();
+		for (UINT i = 0; i < nrOfObjects; i++)
+			programs[i] = registry.getProgram(files, layoutType);
+		result.registryTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		UINT nrOfHandles;
+		registry.getHandleStats(nrOfHandles, result.registryDriverObjects);
+
+		// Equal keys
+		for (UINT i = 1; i < nrOfObjects; i++)
+			result.errors += programs[i] != programs[0];
+		result.errors += nrOfObjects > 0 && (registry.getNrOfUniquePrograms() != 1 || nrOfHandles != nrOfObjects || registry.getCacheMisses() != 1);
+
+		// Keys differing in one part each, asked for twice so the second handle has to be the first one
+		ShaderFiles otherFiles = files;
+		otherFiles.ps = L"PBR_PS.hlsl";
+		ShaderFiles otherDefines = files;
+		otherDefines.defines = { { "QUANTIZED", "2" } };
+		ShaderFiles streamOutputFiles;
+		streamOutputFiles.vs = L"ParticleSoVS.hlsl";
+		streamOutputFiles.gs = L"ParticleSoGS.hlsl";
+
+		std::vector< std::shared_ptr<Shaders> > variants;
+		auto addVariant = [&](ShaderFiles variantFiles, LayoutType variantLayoutType, D3D_PRIMITIVE_TOPOLOGY topology, bool streamOutput)
+		{
+			std::shared_ptr<Shaders> program = registry.getProgram(variantFiles, variantLayoutType, topology, streamOutput);
+			result.errors += registry.getProgram(variantFiles, variantLayoutType, topology, streamOutput) != program;
+			for (const std::shared_ptr<Shaders>& variant : variants)
+				result.errors += variant == program;
+			result.errors += nrOfObjects > 0 && program == programs[0];
+			variants.push_back(program);
+		};
+		addVariant(otherFiles, layoutType, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, false);
+		addVariant(otherDefines, layoutType, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, false);
+		addVariant(files, LayoutType::POS_NOR_TEX_TAN_QUANTIZED_INSTANCED, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, false);
+		addVariant(files, layoutType, D3D11_PRIMITIVE_TOPOLOGY_LINELIST, false);
+		addVariant(streamOutputFiles, LayoutType::PARTICLE, D3D11_PRIMITIVE_TOPOLOGY_POINTLIST, false);
+		addVariant(streamOutputFiles, LayoutType::PARTICLE, D3D11_PRIMITIVE_TOPOLOGY_POINTLIST, true);
+		result.errors += registry.getNrOfUniquePrograms() != (nrOfObjects > 0 ? 1 : 0) + (UINT)variants.size();
+
+		// Programs expire with their last handle and are created again on the next request
+		programs.clear();
+		result.errors += registry.getNrOfUniquePrograms() != (UINT)variants.size();
+		variants.clear();
+		result.errors += registry.getNrOfUniquePrograms() != 0;
+		UINT nrOfMisses = registry.getCacheMisses();
+		std::shared_ptr<Shaders> program = registry.getProgram(files, layoutType);
+		result.errors += registry.getCacheMisses() != nrOfMisses + 1 || registry.getNrOfUniquePrograms() != 1;
+	}
+
+	return result;
+}
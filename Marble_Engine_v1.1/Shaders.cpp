@@ -1,16 +1,81 @@
 #include "pch.h"
 #include "Shaders.h"
 
+bool D3DShaderCompiler::compile(const ShaderRequest& request, std::vector<char>& bytecode, std::string& errors)
+{
+	// Defines, null terminated
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (const ShaderDefine& define : request.defines)
+		macros.push_back({ define.name.c_str(), define.value.c_str() });
+	macros.push_back({ nullptr, nullptr });
+
+	ID3DBlob* blob = nullptr;
+	ID3DBlob* errorBlob = nullptr;
+	HRESULT hr = D3DCompileFromFile(
+		request.file.c_str(),
+		macros.data(),
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		request.entryPoint.c_str(),
+		request.profile.c_str(),
+		request.flags,
+		0,
+		&blob,
+		&errorBlob
+	);
+
+	if (errorBlob)
+	{
+		errors = (char*)errorBlob->GetBufferPointer();
+		errorBlob->Release();
+	}
+	if (FAILED(hr))
+	{
+		if (blob)
+			blob->Release();
+		return false;
+	}
+
+	bytecode.assign((char*)blob->GetBufferPointer(), (char*)blob->GetBufferPointer() + blob->GetBufferSize());
+	blob->Release();
+	return true;
+}
+
 Shaders::Shaders()
 {
 	m_device = nullptr;
 	m_deviceContext = nullptr;
 
 	m_topology = D3D_PRIMITIVE_TOPOLOGY::D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	m_streamOutput = false;
 }
 
 Shaders::~Shaders() {}
 
+ShaderCache& Shaders::getCache()
+{
+	static D3DShaderCompiler compiler;
+	static ShaderCache cache(&compiler, L"Shaders\\Cache");
+	return cache;
+}
+
+ShaderBytecode Shaders::loadBytecode(LPCWSTR file, LPCSTR profile, UINT flags, const std::vector<ShaderDefine>& defines)
+{
+	ShaderRequest request;
+	request.file = std::wstring(L"Shaders\\") + file;
+	request.profile = profile;
+	request.flags = flags;
+	request.defines = defines;
+
+	std::string errors;
+	ShaderBytecode bytecode = getCache().getBytecode(request, errors);
+	if (!bytecode && !errors.empty())
+	{
+		OutputDebugStringA(errors.c_str());
+		OutputDebugStringA("\n");
+	}
+	return bytecode;
+}
+
 
 void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ShaderFiles names, LayoutType layoutType, D3D_PRIMITIVE_TOPOLOGY topology, bool streamOutput)
 {
@@ -20,6 +85,7 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 
 	// Topology
 	m_topology = topology;
+	m_streamOutput = streamOutput;
 
 	// Layout Type
 	m_layoutType = layoutType;
@@ -27,12 +93,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Files
 	m_files = names;
 
-	// Error Blob
-	ID3DBlob* errorBlob = nullptr;
-	
 	// Helper Varables
 	HRESULT hr;
-	LPCWSTR path = L"";
 
 	// Flags
 	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
@@ -43,32 +105,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Vertex Shader
 	if (names.vs != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.vs;
-		path = temp.c_str();
-
-		ID3DBlob* vsBlob = nullptr;
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"vs_5_0",
-			flags,
-			0,
-			&vsBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode vsBytecode = loadBytecode(names.vs, "vs_5_0", flags, names.defines);
+		if (!vsBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (vsBlob)
-				vsBlob->Release();
 			OutputDebugStringA("Error, Vertex shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Vertex shaders could not be created!");
 		}
@@ -78,8 +117,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				m_vertexShader.ReleaseAndGetAddressOf();
 
 			hr = m_device->CreateVertexShader(
-				vsBlob->GetBufferPointer(),
-				vsBlob->GetBufferSize(),
+				vsBytecode->data(),
+				vsBytecode->size(),
 				nullptr,
 				&m_vertexShader
 			);
@@ -91,8 +130,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosNormTexDesc,
 					VertexPosNormTexElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -100,8 +139,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosTexFrustumIndexDesc,
 					VertexPosTexFrustumIndexElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -110,8 +149,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosTexDesc,
 					VertexPosTexElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -120,8 +159,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosColDesc,
 					VertexPosColElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -130,8 +169,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosDesc,
 					VertexPosElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -140,8 +179,38 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexPosNormTexTanDesc,
 					VertexPosNormTexTanElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
+					&m_layout
+				);
+			}
+			else if (layoutType == LayoutType::POS_NOR_TEX_TAN_INSTANCED)
+			{
+				hr = device->CreateInputLayout(
+					VertexPosNormTexTanInstancedDesc,
+					VertexPosNormTexTanInstancedElementCount,
+					vsBytecode->data(),
+					vsBytecode->size(),
+					&m_layout
+				);
+			}
+			else if (layoutType == LayoutType::POS_NOR_TEX_TAN_QUANTIZED)
+			{
+				hr = device->CreateInputLayout(
+					VertexPosNormTexTanQuantizedDesc,
+					VertexPosNormTexTanQuantizedElementCount,
+					vsBytecode->data(),
+					vsBytecode->size(),
+					&m_layout
+				);
+			}
+			else if (layoutType == LayoutType::POS_NOR_TEX_TAN_QUANTIZED_INSTANCED)
+			{
+				hr = device->CreateInputLayout(
+					VertexPosNormTexTanQuantizedInstancedDesc,
+					VertexPosNormTexTanQuantizedInstancedElementCount,
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -150,8 +219,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				hr = device->CreateInputLayout(
 					VertexParticleDesc,
 					VertexParticleElementCount,
-					vsBlob->GetBufferPointer(),
-					vsBlob->GetBufferSize(),
+					vsBytecode->data(),
+					vsBytecode->size(),
 					&m_layout
 				);
 			}
@@ -163,34 +232,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Hull Shader
 	if (names.hs != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.hs;
-		path = temp.c_str();
-		ID3DBlob* hsBlob = nullptr;
-		if (errorBlob) errorBlob->Release();
-		errorBlob = nullptr;
-
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"hs_5_0",
-			flags,
-			0,
-			&hsBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode hsBytecode = loadBytecode(names.hs, "hs_5_0", flags, names.defines);
+		if (!hsBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (hsBlob)
-				hsBlob->Release();
 			OutputDebugStringA("Error, Hull shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Hull shaders could not be created!");
 		}
@@ -200,13 +244,12 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				m_hullShader.ReleaseAndGetAddressOf();
 
 			hr = m_device->CreateHullShader(
-				hsBlob->GetBufferPointer(),
-				hsBlob->GetBufferSize(),
+				hsBytecode->data(),
+				hsBytecode->size(),
 				nullptr,
 				&m_hullShader
 			);
 			assert(SUCCEEDED(hr) && "Error, Hull shaders could not be created!");
-			hsBlob->Release();
 		}
 	}
 
@@ -214,34 +257,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Domain Shader
 	if (names.ds != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.ds;
-		path = temp.c_str();
-		ID3DBlob* dsBlob = nullptr;
-		if (errorBlob) errorBlob->Release();
-		errorBlob = nullptr;
-
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"ds_5_0",
-			flags,
-			0,
-			&dsBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode dsBytecode = loadBytecode(names.ds, "ds_5_0", flags, names.defines);
+		if (!dsBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (dsBlob)
-				dsBlob->Release();
 			OutputDebugStringA("Error, Domain shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Domain shaders could not be created!");
 		}
@@ -251,13 +269,12 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				m_domainShader.ReleaseAndGetAddressOf();
 
 			hr = m_device->CreateDomainShader(
-				dsBlob->GetBufferPointer(),
-				dsBlob->GetBufferSize(),
+				dsBytecode->data(),
+				dsBytecode->size(),
 				nullptr,
 				&m_domainShader
 			);
 			assert(SUCCEEDED(hr) && "Error, Domain shaders could not be created!");
-			dsBlob->Release();
 		}
 	}
 
@@ -265,34 +282,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Geometry Shader
 	if (names.gs != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.gs;
-		path = temp.c_str();
-		ID3DBlob* gsBlob = nullptr;
-		if (errorBlob) errorBlob->Release();
-		errorBlob = nullptr;
-
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"gs_5_0",
-			flags,
-			0,
-			&gsBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode gsBytecode = loadBytecode(names.gs, "gs_5_0", flags, names.defines);
+		if (!gsBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (gsBlob)
-				gsBlob->Release();
 			OutputDebugStringA("Error, Geometry shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Geometry shaders could not be created!");
 		}
@@ -304,8 +296,8 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 			if (streamOutput)
 			{
 				hr = m_device->CreateGeometryShaderWithStreamOutput(
-					gsBlob->GetBufferPointer(),
-					gsBlob->GetBufferSize(),
+					gsBytecode->data(),
+					gsBytecode->size(),
 					VertexParticleSoDecl,
 					VertexParticleElementCount,
 					nullptr,
@@ -317,14 +309,13 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 			else
 			{
 				hr = m_device->CreateGeometryShader(
-					gsBlob->GetBufferPointer(),
-					gsBlob->GetBufferSize(),
+					gsBytecode->data(),
+					gsBytecode->size(),
 					nullptr,
 					&m_geometryShader);
 			}
 
 			assert(SUCCEEDED(hr) && "Error, Geometry shaders could not be created!");
-			gsBlob->Release();
 		}
 	}
 
@@ -332,34 +323,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Pixel Shader
 	if (names.ps != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.ps;
-		path = temp.c_str();
-		ID3DBlob* psBlob = nullptr;
-		if (errorBlob) errorBlob->Release();
-		errorBlob = nullptr;
-
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"ps_5_0",
-			flags,
-			0,
-			&psBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode psBytecode = loadBytecode(names.ps, "ps_5_0", flags, names.defines);
+		if (!psBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (psBlob)
-				psBlob->Release();
 			OutputDebugStringA("Error, Pixel shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Pixel shaders could not be created!");
 		}
@@ -369,13 +335,12 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				m_pixelShader.ReleaseAndGetAddressOf();
 
 			hr = m_device->CreatePixelShader(
-				psBlob->GetBufferPointer(),
-				psBlob->GetBufferSize(),
+				psBytecode->data(),
+				psBytecode->size(),
 				nullptr,
 				&m_pixelShader
 			);
 			assert(SUCCEEDED(hr) && "Error, Pixel shaders could not be created!");
-			psBlob->Release();
 		}
 	}
 
@@ -383,34 +348,9 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 	// Create Compute Shader
 	if (names.cs != L"")
 	{
-		std::wstring temp = std::wstring(L"Shaders\\") + names.cs;
-		path = temp.c_str();
-		ID3DBlob* csBlob = nullptr;
-		if (errorBlob) errorBlob->Release();
-		errorBlob = nullptr;
-
-		hr = D3DCompileFromFile(
-			path,
-			nullptr,
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			"main",
-			"cs_5_0",
-			flags,
-			0,
-			&csBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr))
+		ShaderBytecode csBytecode = loadBytecode(names.cs, "cs_5_0", flags, names.defines);
+		if (!csBytecode)
 		{
-			if (errorBlob)
-			{
-				OutputDebugStringA((char*)errorBlob->GetBufferPointer());
-				OutputDebugStringA("\n");
-				errorBlob->Release();
-			}
-			if (csBlob)
-				csBlob->Release();
 			OutputDebugStringA("Error, Compute shaders could not be compiled!\n");
 			//assert(SUCCEEDED(hr) && "Error, Compute shaders could not be created!");
 		}
@@ -420,20 +360,53 @@ void Shaders::initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 				m_computeShader.ReleaseAndGetAddressOf();
 
 			hr = m_device->CreateComputeShader(
-				csBlob->GetBufferPointer(),
-				csBlob->GetBufferSize(),
+				csBytecode->data(),
+				csBytecode->size(),
 				nullptr,
 				&m_computeShader
 			);
 			assert(SUCCEEDED(hr) && "Error, Compute shaders could not be created!");
-			csBlob->Release();
 		}
 	}
 }
 
+ShaderCacheBenchmarkResult Shaders::benchmark()
+{
+	// Every shader in the Shaders folder, the stage is taken from the file name suffix
+	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+	#if defined( DEBUG ) || defined( _DEBUG )
+		flags |= D3DCOMPILE_DEBUG;
+	#endif
+
+	std::vector<ShaderRequest> requests;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(L"Shaders", error))
+	{
+		std::wstring stem = entry.path().stem().wstring();
+		if (entry.path().extension() != L".hlsl" || stem.size() < 2)
+			continue;
+
+		std::wstring stage = stem.substr(stem.size() - 2);
+		ShaderRequest request;
+		request.file = entry.path();
+		request.flags = flags;
+		if (stage == L"VS") request.profile = "vs_5_0";
+		else if (stage == L"HS") request.profile = "hs_5_0";
+		else if (stage == L"DS") request.profile = "ds_5_0";
+		else if (stage == L"GS") request.profile = "gs_5_0";
+		else if (stage == L"PS") request.profile = "ps_5_0";
+		else if (stage == L"CS") request.profile = "cs_5_0";
+		else continue;
+		requests.push_back(request);
+	}
+
+	D3DShaderCompiler compiler;
+	return ShaderCache::benchmark(&compiler, requests, L"Shaders\\Cache\\Benchmark");
+}
+
 void Shaders::updateShaders()
 {
-	initialize(m_device, m_deviceContext, m_files, m_layoutType, m_topology);
+	initialize(m_device, m_deviceContext, m_files, m_layoutType, m_topology, m_streamOutput);
 }
 
 void Shaders::setShaders()
@@ -449,6 +422,19 @@ void Shaders::setShaders()
 	m_deviceContext->CSSetShader(m_computeShader.Get(), nullptr, 0);
 }
 
+UINT Shaders::getNrOfDriverObjects() const
+{
+	UINT nrOfObjects = 0;
+	nrOfObjects += m_vertexShader ? 1 : 0;
+	nrOfObjects += m_hullShader ? 1 : 0;
+	nrOfObjects += m_domainShader ? 1 : 0;
+	nrOfObjects += m_geometryShader ? 1 : 0;
+	nrOfObjects += m_pixelShader ? 1 : 0;
+	nrOfObjects += m_computeShader ? 1 : 0;
+	nrOfObjects += m_layout ? 1 : 0;
+	return nrOfObjects;
+}
+
 void Shaders::unbindShaders()
 {
 	m_deviceContext->VSSetShader(nullptr, nullptr, 0);
@@ -1,6 +1,8 @@
 #ifndef SHADERS_H
 #define SHADERS_H
 
+#include "ShaderCache.h"
+
 struct ShaderFiles
 {
 	LPCWSTR vs = L""; // Vertex Shader
@@ -9,6 +11,15 @@ struct ShaderFiles
 	LPCWSTR gs = L""; // Geometry Shader
 	LPCWSTR ps = L""; // Pixel Shader
 	LPCWSTR cs = L""; // Compute Shader
+
+	std::vector<ShaderDefine> defines; // Applied to every stage
+};
+
+// D3DCompileFromFile behind the shader cache
+class D3DShaderCompiler : public ShaderCompiler
+{
+public:
+	bool compile(const ShaderRequest& request, std::vector<char>& bytecode, std::string& errors);
 };
 
 class Shaders
@@ -34,6 +45,10 @@ private:
 
 	// Topology
 	D3D_PRIMITIVE_TOPOLOGY m_topology;
+	bool m_streamOutput;
+
+	// Helper Functions
+	static ShaderBytecode loadBytecode(LPCWSTR file, LPCSTR profile, UINT flags, const std::vector<ShaderDefine>& defines);
 
 public:
 	Shaders();
@@ -45,6 +60,13 @@ public:
 
 	void setShaders();
 	void unbindShaders();
+
+	// Stats
+	UINT getNrOfDriverObjects() const; // Shaders and input layout
+
+	// Cache
+	static ShaderCache& getCache();
+	static ShaderCacheBenchmarkResult benchmark();
 };
 
 #endif // !SHADERS_H
\ No newline at end of file
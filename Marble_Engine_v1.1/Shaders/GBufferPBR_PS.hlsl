@@ -45,7 +45,10 @@ SamplerComparisonState  shadowSampler   : register(s2);
 // Functions
 float3 computeNormal(PS_IN input)
 {
-    float3 normalTex = normalize(NormalTexture.Sample(sampState, input.texCoord).xyz * 2 - 1);
+    // Z is rebuilt from XY so two channel BC5 normal maps read the same as full ones
+    float3 normalTex;
+    normalTex.xy = NormalTexture.Sample(sampState, input.texCoord).xy * 2 - 1;
+    normalTex.z = sqrt(saturate(1 - dot(normalTex.xy, normalTex.xy)));
     //normalTex.z *= -1;
     //normalTex.y *= -1;
     
@@ -45,7 +45,9 @@ SamplerComparisonState  shadowSampler   : SAMPLER : register(s2);
 // Functions
 float3 computeNormal(PS_IN input)
 {
-    float3 normalTex = normalize(NormalTexture.Sample(sampState, input.texCoord).xyz * 2 - 1);
+    float3 normalTex;
+    normalTex.xy = NormalTexture.Sample(sampState, input.texCoord).xy * 2 - 1;
+    normalTex.z = sqrt(saturate(1 - dot(normalTex.xy, normalTex.xy)));
     float3 normal = input.normal;
     float3 tangent = normalize(input.tangent);
     float3 bitangent = normalize(input.biTangent);
@@ -271,11 +271,11 @@ float4 main(PS_IN input) : SV_TARGET
     [flatten]
     if (normTextureExist)
     {
-        float3 normalTex = normalTexture.Sample(sampState, input.texCoord).xyz;
-        normalTex = normalize(normalTex);
+        float3 normalTex;
+        normalTex.xy = normalTexture.Sample(sampState, input.texCoord).xy;
         normalTex.x = normalTex.x * 2.f - 1.f;
         normalTex.y = -normalTex.y * 2.f + 1.f;
-        normalTex.z = normalTex.z;
+        normalTex.z = sqrt(saturate(1.f - dot(normalTex.xy, normalTex.xy))); // Rebuilt so BC5 normal maps work
         
         float3x3 TBNMatrix = float3x3(input.tangent, input.biTangent, input.normal);
         input.normal = normalize(mul(normalTex, TBNMatrix));
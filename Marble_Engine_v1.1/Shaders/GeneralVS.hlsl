@@ -1,10 +1,21 @@
 struct VS_IN
 {
+#ifdef QUANTIZED
+    float4 position     : POSITION; // Inside the mesh bounds, w is the bitangent sign
+    float2 normal       : NORMAL;
+    float2 tangent      : TANGENT;
+#else
     float3 position     : POSITION;
     float3 normal       : NORMAL;
     float3 tangent      : TANGENT;
     float3 biTangent    : BITANGENT;
+#endif
     float2 texCoord     : TEXCOORD;
+#ifdef INSTANCED
+    float4x4 instanceWvp    : INSTANCE_WVP;
+    float4x4 instanceWorld  : INSTANCE_WORLD;
+    float4x4 instanceNormal : INSTANCE_NORMAL;
+#endif
 };
 
 struct VS_OUT
@@ -18,12 +29,14 @@ struct VS_OUT
     float2 texCoord         : TEXCOORD;
 };
 
+#ifndef INSTANCED
 cbuffer WVPBuffer : register(b0)
 {
     matrix wvpMatrix;
     matrix worldMatrix;
     matrix normalMatrix;
 };
+#endif
 
 cbuffer lightSpaceMatrices : register(b1)
 {
@@ -31,20 +44,55 @@ cbuffer lightSpaceMatrices : register(b1)
     matrix lightProjectionMatrix;
 };
 
+#ifdef QUANTIZED
+cbuffer QuantizationBuffer : register(b2)
+{
+    float4 positionOffset;
+    float4 positionScale;
+};
+
+float3 decodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+    if (direction.z < 0.f)
+        direction.xy = (1.f - abs(direction.yx)) * (direction.xy >= 0.f ? 1.f : -1.f);
+    return normalize(direction);
+}
+#endif
+
 VS_OUT main(VS_IN input)
 {
     VS_OUT output;
     
-    output.position = mul(float4(input.position, 1.f), wvpMatrix);
-    output.wPosition = mul(float4(input.position, 1.f), worldMatrix);
+#ifdef INSTANCED
+    // Instance rows hold what the constant buffer reads as columns
+    matrix wvpMatrix = transpose(input.instanceWvp);
+    matrix worldMatrix = transpose(input.instanceWorld);
+    matrix normalMatrix = transpose(input.instanceNormal);
+#endif
+    
+#ifdef QUANTIZED
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+    float3 normal = decodeOctahedral(input.normal);
+    float3 tangent = decodeOctahedral(input.tangent);
+    float3 biTangent = cross(normal, tangent) * (input.position.w * 2.f - 1.f);
+#else
+    float3 position = input.position;
+    float3 normal = input.normal;
+    float3 tangent = input.tangent;
+    float3 biTangent = input.biTangent;
+#endif
+    
+    output.position = mul(float4(position, 1.f), wvpMatrix);
+    output.wPosition = mul(float4(position, 1.f), worldMatrix);
     
-    output.shadowPosition = mul(float4(input.position, 1.f), worldMatrix);
+    output.shadowPosition = mul(float4(position, 1.f), worldMatrix);
     output.shadowPosition = mul(output.shadowPosition, lightViewMatrix);
     output.shadowPosition = mul(output.shadowPosition, lightProjectionMatrix);
     
-    output.normal = normalize(mul(input.normal, (float3x3) normalMatrix).xyz);
-    output.tangent = normalize(mul(input.tangent, (float3x3) normalMatrix).xyz);
-    output.biTangent = normalize(mul(input.biTangent, (float3x3) normalMatrix).xyz);
+    output.normal = normalize(mul(normal, (float3x3) normalMatrix).xyz);
+    output.tangent = normalize(mul(tangent, (float3x3) normalMatrix).xyz);
+    output.biTangent = normalize(mul(biTangent, (float3x3) normalMatrix).xyz);
     output.texCoord = input.texCoord;
     
     return output;
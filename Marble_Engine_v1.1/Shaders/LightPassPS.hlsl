@@ -1,5 +1,7 @@
 // Globals
-#define LIGHT_CAP 40
+#define CLUSTER_GRID_X 16 // Must match LightClusters.h
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
 
 #define POINT_LIGHT 0
 #define SPOT_LIGHT 1
@@ -8,6 +10,9 @@ static const float PI = 3.14159265359;
 static const float MAX_REFLECTION_LOD = 6.0;
 static const float EPSILON = 0.000001f;
 
+// Features, defined by the permutation key in RenderHandler
+// FOG, VOLUMETRIC_SUN, PROCEDURAL_SKY, ENVIRONMENT_DIFFUSE, ENVIRONMENT_SPECULAR
+
 // - Fog
 static const float FOG_DENSITIY = 0.004;
 static const float HEIGHT_FACTOR = 0.05f;
@@ -40,13 +45,15 @@ struct Light
 };
 cbuffer lightBuffer : register(b1)
 {
-    Light lights[LIGHT_CAP];
     uint nrOfLights;
+    uint nrOfDirectionalLights;
     float enviormentDiffContribution;
     float enviormentSpecContribution;
     bool volumetricSunScattering;
     bool fog;
     bool procederualSky;
+    float clusterSliceScale;
+    float clusterSliceBias;
 };
 
 cbuffer shadowBuffer : register(b2)
@@ -76,6 +83,11 @@ Texture2D VolumetricSunTexture : register(t5);
 TextureCube IrradianceMap : register(t6);
 TextureCube SpecularIBLMap : register(t7);
 
+// Lights, directional lights first. Each cluster holds an offset and a count into ClusterLightIndices
+StructuredBuffer<Light> Lights : register(t8);
+StructuredBuffer<uint2> ClusterRanges : register(t9);
+StructuredBuffer<uint> ClusterLightIndices : register(t10);
+
 // Sampler
 SamplerState sampState : register(s1); // Imgui uses slot 0, use 1 for default
 
@@ -251,23 +263,29 @@ float4 main(PS_IN input) : SV_TARGET
         }
         Lo += sunMoonLightContribution;
         
-        // Scene Lights
-        for (i = 0; i < nrOfLights; ++i)
+        // Scene Lights, directional lights reach every pixel
+        for (i = 0; i < nrOfDirectionalLights; ++i)
+        {
+            direction = Lights[i].direction.xyz;
+            L = normalize(-direction);
+            H = normalize(V + L);
+            radiance = Lights[i].color.xyz * Lights[i].intensity;
+            
+            Lo += lightCommon(N, H, V, NDotV, L, F0, roughness, metallic, radiance, albedo);
+        }
+        
+        // - Point and spot lights binned into this pixel's cluster
+        uint2 clusterTile = min(uint2(input.TexCoord * float2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uint2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+        uint clusterSlice = (uint) clamp(floor(log(max(viewPosition.z, EPSILON)) * clusterSliceScale + clusterSliceBias), 0.f, CLUSTER_GRID_Z - 1.f);
+        uint2 clusterRange = ClusterRanges[(clusterSlice * CLUSTER_GRID_Y + clusterTile.y) * CLUSTER_GRID_X + clusterTile.x];
+        for (uint c = 0; c < clusterRange.y; ++c)
         {
-            L = lights[i].position.xyz - worldPosition;
-            radiance = lights[i].color.xyz * lights[i].intensity;
+            Light light = Lights[nrOfDirectionalLights + ClusterLightIndices[clusterRange.x + c]];
+            L = light.position.xyz - worldPosition;
+            radiance = light.color.xyz * light.intensity;
             
-            switch (lights[i].type)
+            switch (light.type)
             {
-                case DIRECTIONAL_LIGHT:
-                {
-                    direction = lights[i].direction.xyz;
-                    L = normalize(-direction);
-                    H = normalize(V + L);
-                    
-                    Lo += lightCommon(N, H, V, NDotV, L, F0, roughness, metallic, radiance, albedo);
-                }
-                break;
                 case POINT_LIGHT:
                 {
                     float3 lightDir = normalize(L);
@@ -276,7 +294,7 @@ float4 main(PS_IN input) : SV_TARGET
                     float lightDistSq = dot(L, L);
                     float invLightDist = rsqrt(lightDistSq);
                     
-                    float radiusSq = lights[i].range * lights[i].range;
+                    float radiusSq = light.range * light.range;
                     float distanceFalloff = radiusSq * (invLightDist * invLightDist);
                     float attenuation = max(0, distanceFalloff - rsqrt(distanceFalloff));
                     
@@ -287,23 +305,23 @@ float4 main(PS_IN input) : SV_TARGET
                 {
                     float3 lightDir = normalize(L);
                     H = normalize(V + lightDir);
-                    direction = normalize(lights[i].direction.xyz);
+                    direction = normalize(light.direction.xyz);
                     
                     float lightDistSq = dot(L, L);
                     float invLightDist = rsqrt(lightDistSq);
                     
-                    float radiusSq = lights[i].range * lights[i].range;
+                    float radiusSq = light.range * light.range;
                     float distanceFalloff = radiusSq * (invLightDist * invLightDist);
                     float attenuation = max(0, distanceFalloff - rsqrt(distanceFalloff));
                     
-                    //float minCos = cos((lights[i].spotAngle + 1.f) * 0.5f);
-                    //float maxCos = cos(lights[i].spotAngle);
+                    //float minCos = cos((light.spotAngle + 1.f) * 0.5f);
+                    //float maxCos = cos(light.spotAngle);
                     //float maxCos = (minCos + 1.f) / 2.f;
                     //float cosAngle = dot(direction, -L);
                     //float spotAttenuation = smoothstep(minCos, maxCos, cosAngle);
                     
                     float coneFalloff = dot(-lightDir, direction);
-                    float spotAttenuation = saturate((coneFalloff - lights[i].spotAngles.y) * lights[i].spotAngles.x);
+                    float spotAttenuation = saturate((coneFalloff - light.spotAngles.y) * light.spotAngles.x);
                     
                     Lo += lightCommon(N, H, V, NDotV, lightDir, F0, roughness, metallic, radiance, albedo) * spotAttenuation * attenuation;
                 }
@@ -319,26 +337,27 @@ float4 main(PS_IN input) : SV_TARGET
         // Diffuse IBL
         float3 diffuse = (float3)0;
         float lod = roughness * MAX_REFLECTION_LOD;
-        if (enviormentDiffContribution > 0.f)
+#if ENVIRONMENT_DIFFUSE
         {
-            float3 irradiance;
-            if (procederualSky)
-                irradiance = ambientColor;
-            else
-                irradiance = IrradianceMap.Sample(sampState, N).rgb;
+#if PROCEDURAL_SKY
+            float3 irradiance = ambientColor;
+#else
+            float3 irradiance = IrradianceMap.Sample(sampState, N).rgb;
+#endif
             diffuse = irradiance * albedo * enviormentDiffContribution;
             
         }
+#endif
 
         // Specular IBL
         float3 specular = (float3)0;
-        if (enviormentSpecContribution > 0.f)
+#if ENVIRONMENT_SPECULAR
         {
-            float3 prefilteredColor;
-            if (procederualSky)
-                prefilteredColor = ambientColor;
-            else 
-                prefilteredColor = SpecularIBLMap.SampleLevel(sampState, R, lod).rgb;
+#if PROCEDURAL_SKY
+            float3 prefilteredColor = ambientColor;
+#else
+            float3 prefilteredColor = SpecularIBLMap.SampleLevel(sampState, R, lod).rgb;
+#endif
     
             const float4 c0 = float4(-1, -0.0275, -0.572, 0.022);
             const float4 c1 = float4(1, 0.0425, 1.04, -0.04);
@@ -347,6 +366,7 @@ float4 main(PS_IN input) : SV_TARGET
             float2 envBRDF = float2(-1.04, 1.04) * a004 + r.zw;
             specular = prefilteredColor * (F * envBRDF.x + envBRDF.y) * enviormentSpecContribution;
         }
+#endif
         
         float3 ambient = (kD * diffuse + specular);
 
@@ -356,12 +376,13 @@ float4 main(PS_IN input) : SV_TARGET
         finalColor += emissive;
     
     // Volumetric Sun Scattering
-    if (volumetricSunScattering)
-        finalColor += VolumetricSunTexture.Sample(sampState, input.TexCoord).xyz;
-        //finalColor += getUppsampledVolumetricScattering(input.TexCoord);
+#if VOLUMETRIC_SUN
+    finalColor += VolumetricSunTexture.Sample(sampState, input.TexCoord).xyz;
+    //finalColor += getUppsampledVolumetricScattering(input.TexCoord);
+#endif
 
     // Fog
-    if (fog)
+#if FOG
     {
         float3 fogOrigin = cameraPosition.xyz;
         float3 fogDirection = normalize(worldPosition - fogOrigin);
@@ -372,6 +393,7 @@ float4 main(PS_IN input) : SV_TARGET
     
         finalColor = lerp(finalColor, fogColor, saturate(fogFactor));
     }
+#endif
     
     return float4(finalColor, 1.f);
 }
\ No newline at end of file
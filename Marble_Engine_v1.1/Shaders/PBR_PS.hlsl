@@ -135,7 +135,10 @@ float GeometrySmith(float3 N, float3 V, float3 L, float roughness)
 
 float3 computeNormal(PS_IN input)
 {
-    float3 normalTex = normalize(NormalTexture.Sample(sampState, input.texCoord).xyz * 2 - 1);
+    // BC5 only stores XY
+    float3 normalTex;
+    normalTex.xy = NormalTexture.Sample(sampState, input.texCoord).xy * 2 - 1;
+    normalTex.z = sqrt(saturate(1 - dot(normalTex.xy, normalTex.xy)));
     
     float3 normal = input.normal;
     float3 tangent = normalize(input.tangent);
@@ -1,15 +1,24 @@
 struct VS_IN
 {
+#ifdef QUANTIZED
+    float4 position : POSITION; // Inside the mesh bounds
+#else
     float3 position : POSITION;
     float3 normal : NORMAL;
+#endif
     float2 texCoord : TEXCOORD;
+#ifdef INSTANCED
+    float4x4 instanceWorld : INSTANCE_WORLD;
+#endif
 };
 
+#ifndef INSTANCED
 cbuffer WVPBuffer : register(b0)
 {
     matrix wvpMatrix;
     matrix worldMatrix;
 };
+#endif
 
 cbuffer lightSpaceMatrices : register(b1)
 {
@@ -17,6 +26,14 @@ cbuffer lightSpaceMatrices : register(b1)
     matrix lightProjectionMatrix;
 };
 
+#ifdef QUANTIZED
+cbuffer QuantizationBuffer : register(b2)
+{
+    float4 positionOffset;
+    float4 positionScale;
+};
+#endif
+
 struct VS_OUT
 {
     float4 position : SV_POSITION;
@@ -27,12 +44,22 @@ VS_OUT main(VS_IN input)
 {
     VS_OUT output;
     
+#ifdef INSTANCED
+    matrix worldMatrix = transpose(input.instanceWorld); // Rows hold the constant buffer columns
+#endif
+    
     // Transform the vertex position into projected space.
     //matrix lightWVPMatrix = worldMatrix * lightViewMatrix * lightProjectionMatrix;
     //output.position = mul(lightWVPMatrix, float4(input.position, 1.0f));
     //output.position = mul(wvpMatrix, float4(input.position, 1.f));
     
-    output.position = mul(float4(input.position, 1.f), worldMatrix);
+#ifdef QUANTIZED
+    float3 position = positionOffset.xyz + input.position.xyz * positionScale.xyz;
+#else
+    float3 position = input.position;
+#endif
+    
+    output.position = mul(float4(position, 1.f), worldMatrix);
     output.position = mul(output.position, lightViewMatrix);
     output.position = mul(output.position, lightProjectionMatrix);
     
@@ -129,11 +129,14 @@ void ShadowMapInstance::initialize(ID3D11Device* device, ID3D11DeviceContext* de
 	hr = device->CreateRasterizerState(&rasterizerDesc, m_rasterizerState.GetAddressOf());
 	assert(SUCCEEDED(hr) && "Error, failed to create shadow map rasterizer state!");
 
-	// Shaders
+	// Shaders, model meshes have quantized vertices
 	ShaderFiles shaderFiles;
 	shaderFiles.vs = L"ShadowMapVS.hlsl";
 	shaderFiles.ps = L"ShadowMapPS.hlsl";
-	m_shadowMapShaders.initialize(device, deviceContext, shaderFiles);
+	shaderFiles.defines = { { "QUANTIZED" } };
+	m_shadowMapShaders.initialize(device, deviceContext, shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED);
+	shaderFiles.defines = { { "INSTANCED" }, { "QUANTIZED" } };
+	m_shadowMapInstancedShaders.initialize(device, deviceContext, shaderFiles, LayoutType::POS_NOR_TEX_TAN_QUANTIZED_INSTANCED);
 
 	// World Bounding Sphere
 	m_worldBoundingSphere.Center = { 0.f, 0.f, 0.f };
@@ -182,6 +185,32 @@ float ShadowMapInstance::getLightShadowRadius() const
 	return m_worldBoundingSphere.Radius;
 }
 
+const BoundingOrientedBox& ShadowMapInstance::getLightVolume() const
+{
+	return m_lightVolume;
+}
+
+Shaders* ShadowMapInstance::getShaders()
+{
+	return &m_shadowMapShaders;
+}
+
+Shaders* ShadowMapInstance::getInstancedShaders()
+{
+	return &m_shadowMapInstancedShaders;
+}
+
+void ShadowMapInstance::updateLightVolume(XMMATRIX lightViewMatrix, float l, float r, float b, float t, float n, float f)
+{
+	// Orthographic Frustum is a Box in Light View Space
+	BoundingOrientedBox lightSpaceVolume(
+		XMFLOAT3((l + r) * 0.5f, (b + t) * 0.5f, (n + f) * 0.5f),
+		XMFLOAT3((r - l) * 0.5f, (t - b) * 0.5f, (f - n) * 0.5f),
+		XMFLOAT4(0.f, 0.f, 0.f, 1.f)
+	);
+	lightSpaceVolume.Transform(m_lightVolume, XMMatrixInverse(nullptr, lightViewMatrix));
+}
+
 void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotationRad, XMFLOAT3 centerPosition)
 {
 	m_directionalLight = directionalLight;
@@ -192,8 +221,8 @@ void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotati
 	m_lightRotationRad = rotationRad;
 
 	// Light View Matrix
-	VS_SHADOW_C_BUFFER* lightMatrices = new VS_SHADOW_C_BUFFER();
-	VS_SHADOW_C_BUFFER* invLightMatrices = new VS_SHADOW_C_BUFFER();
+	VS_SHADOW_C_BUFFER lightMatrices;
+	VS_SHADOW_C_BUFFER invLightMatrices;
 	XMVECTOR lightDirection = XMLoadFloat3(&directionalLight.direction);
 	XMVECTOR position = XMLoadFloat3(&m_worldBoundingSphere.Center);
 	position = XMVectorSetW(position, 1.f);
@@ -202,12 +231,12 @@ void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotati
 	XMVECTOR lookAt = position;
 	XMVECTOR up = DirectX::XMVectorSet(0.f, 1.f, 0.f, 0.f);
 
-	lightMatrices->lightViewMatrix = XMMatrixTranspose(XMMatrixLookAtLH(m_lightPosition, lookAt, up));
-	invLightMatrices->lightViewMatrix = XMMatrixInverse(nullptr, lightMatrices->lightViewMatrix);
+	lightMatrices.lightViewMatrix = XMMatrixTranspose(XMMatrixLookAtLH(m_lightPosition, lookAt, up));
+	invLightMatrices.lightViewMatrix = XMMatrixInverse(nullptr, lightMatrices.lightViewMatrix);
 
 	// Transform World Bounding Sphere to Light Local View Space
 	XMFLOAT3 worldSphereCenterLightSpace;
-	XMStoreFloat3(&worldSphereCenterLightSpace, DirectX::XMVector3TransformCoord(lookAt, lightMatrices->lightViewMatrix));
+	XMStoreFloat3(&worldSphereCenterLightSpace, DirectX::XMVector3TransformCoord(lookAt, lightMatrices.lightViewMatrix));
 
 	// Construct Orthographic Frustum in Light View Space
 	float l = worldSphereCenterLightSpace.x - m_worldBoundingSphere.Radius;
@@ -220,8 +249,9 @@ void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotati
 	float f = m_worldBoundingSphere.Radius * 6.f;
 
 	// Local Projection Matrix
-	lightMatrices->lightProjectionMatrix = XMMatrixTranspose(XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f));
-	invLightMatrices->lightProjectionMatrix = XMMatrixInverse(nullptr, lightMatrices->lightProjectionMatrix);
+	lightMatrices.lightProjectionMatrix = XMMatrixTranspose(XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f));
+	invLightMatrices.lightProjectionMatrix = XMMatrixInverse(nullptr, lightMatrices.lightProjectionMatrix);
+	updateLightVolume(XMMatrixLookAtLH(m_lightPosition, lookAt, up), l, r, b, t, n, f);
 
 	// Shadow Texture Space Transformation
 	XMMATRIX textureSpaceMatrix
@@ -231,7 +261,7 @@ void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotati
 		0.0f, 0.0f, 1.0f, 0.0f,
 		0.5f, 0.5f, 0.0f, 1.0f
 	);
-	XMMATRIX* textureTransformMatrix = new XMMATRIX(lightMatrices->lightViewMatrix * lightMatrices->lightProjectionMatrix * XMMatrixTranspose(textureSpaceMatrix));
+	XMMATRIX textureTransformMatrix = lightMatrices.lightViewMatrix * lightMatrices.lightProjectionMatrix * XMMatrixTranspose(textureSpaceMatrix);
 
 	//lightMatrices->lightProjectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 100.f);
 	//// Point light at (20, 15, 20), pointed at the origin. POV up-vector is along the y-axis.
@@ -242,7 +272,7 @@ void ShadowMapInstance::buildLightMatrix(Light directionalLight, XMFLOAT3 rotati
 	//lightMatrices->lightViewMatrix = XMMatrixLookAtLH(position, lookAt, up);
 	//lightMatrices->textureTransformMatrix = XMMatrixIdentity();
 
-	XMMATRIX inverseVpMatrix = XMMatrixInverse(nullptr, lightMatrices->lightViewMatrix) * XMMatrixInverse(nullptr, lightMatrices->lightProjectionMatrix);
+	XMMATRIX inverseVpMatrix = XMMatrixInverse(nullptr, lightMatrices.lightViewMatrix) * XMMatrixInverse(nullptr, lightMatrices.lightProjectionMatrix);
 
 	// Update data
 	m_lightMatrixCBuffer.update(&lightMatrices);
@@ -257,8 +287,8 @@ void ShadowMapInstance::buildLightMatrix(XMFLOAT3 centerPosition)
 	m_worldBoundingSphere.Center.y = 0;
 
 	// Light View Matrix
-	VS_SHADOW_C_BUFFER* lightMatrices = new VS_SHADOW_C_BUFFER();
-	VS_SHADOW_C_BUFFER* invLightMatrices = new VS_SHADOW_C_BUFFER();
+	VS_SHADOW_C_BUFFER lightMatrices;
+	VS_SHADOW_C_BUFFER invLightMatrices;
 	XMVECTOR lightDirection = XMLoadFloat3(&m_directionalLight.direction);
 	XMVECTOR position = XMLoadFloat3(&m_worldBoundingSphere.Center);
 	position = XMVectorSetW(position, 1.f);
@@ -267,11 +297,11 @@ void ShadowMapInstance::buildLightMatrix(XMFLOAT3 centerPosition)
 	XMVECTOR lookAt = XMLoadFloat3(&m_worldBoundingSphere.Center);
 	XMVECTOR up = XMVectorSet(0.f, 1.f, 0.f, 0.f);
 
-	lightMatrices->lightViewMatrix = XMMatrixTranspose(XMMatrixLookAtLH(m_lightPosition, lookAt, up));
+	lightMatrices.lightViewMatrix = XMMatrixTranspose(XMMatrixLookAtLH(m_lightPosition, lookAt, up));
 
 	// Transform World Bounding Sphere to Light Local View Space
 	XMFLOAT3 worldSphereCenterLightSpace;
-	XMStoreFloat3(&worldSphereCenterLightSpace, XMVector3TransformCoord(lookAt, lightMatrices->lightViewMatrix));
+	XMStoreFloat3(&worldSphereCenterLightSpace, XMVector3TransformCoord(lookAt, lightMatrices.lightViewMatrix));
 
 	// Construct Orthographic Frustum in Light View Space
 	float l = worldSphereCenterLightSpace.x - m_worldBoundingSphere.Radius;
@@ -282,9 +312,10 @@ void ShadowMapInstance::buildLightMatrix(XMFLOAT3 centerPosition)
 	float f = worldSphereCenterLightSpace.z + m_worldBoundingSphere.Radius;
 
 	// Local Projection Matrix
-	lightMatrices->lightProjectionMatrix = XMMatrixTranspose(XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f));
-	invLightMatrices->lightProjectionMatrix = XMMatrixInverse(nullptr, lightMatrices->lightProjectionMatrix);
-	XMMATRIX inverseVpMatrix = XMMatrixInverse(nullptr, lightMatrices->lightViewMatrix) * XMMatrixInverse(nullptr, lightMatrices->lightProjectionMatrix);
+	lightMatrices.lightProjectionMatrix = XMMatrixTranspose(XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f));
+	invLightMatrices.lightProjectionMatrix = XMMatrixInverse(nullptr, lightMatrices.lightProjectionMatrix);
+	updateLightVolume(XMMatrixLookAtLH(m_lightPosition, lookAt, up), l, r, b, t, n, f);
+	XMMATRIX inverseVpMatrix = XMMatrixInverse(nullptr, lightMatrices.lightViewMatrix) * XMMatrixInverse(nullptr, lightMatrices.lightProjectionMatrix);
 
 	// Update data
 	m_lightMatrixCBuffer.update(&lightMatrices);
@@ -38,6 +38,7 @@ private:
 
 	// Shaders
 	Shaders m_shadowMapShaders;
+	Shaders m_shadowMapInstancedShaders;
 
 	// Light
 	Light m_directionalLight;
@@ -50,11 +51,17 @@ private:
 	BoundingSphere m_worldBoundingSphere;
 	float m_zOffset;
 
+	// Orthographic Light Volume in World Space, used for Culling
+	BoundingOrientedBox m_lightVolume;
+
 	// Constant Buffers
 	Buffer<VS_SHADOW_C_BUFFER> m_lightMatrixCBuffer;
 	Buffer<XMMATRIX> m_invLightVpMatrixCBuffer; // Used for Volumetric Sun Scattering
 	Buffer<XMMATRIX> m_shadowTextureMatrixCBuffer;
 
+	// Helper Functions
+	void updateLightVolume(XMMATRIX lightViewMatrix, float l, float r, float b, float t, float n, float f);
+
 public:
 	ShadowMapInstance();
 	~ShadowMapInstance();
@@ -70,6 +77,9 @@ public:
 	XMVECTOR getLightDirection() const;
 	XMVECTOR getLightRotation() const;
 	float getLightShadowRadius() const;
+	const BoundingOrientedBox& getLightVolume() const;
+	Shaders* getShaders();
+	Shaders* getInstancedShaders();
 
 	// Update
 	void buildLightMatrix(Light directionalLight, XMFLOAT3 rotationRad = XMFLOAT3(0.f, 0.f, 0.f), XMFLOAT3 centerPosition = XMFLOAT3(0.f, 0.f, 0.f));
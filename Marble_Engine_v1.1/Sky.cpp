@@ -390,10 +390,10 @@ void Sky::updateMatrices(const XMMATRIX& viewMatrix, const XMMATRIX& projectionM
 	}
 	else
 	{
-		VS_SKYBOX_MATRIX_CBUFFER* vpData = new VS_SKYBOX_MATRIX_CBUFFER();
+		VS_SKYBOX_MATRIX_CBUFFER vpData;
 
 		XMMATRIX worldMatrix = XMMatrixRotationRollPitchYawFromVector(m_rotation); // Rotation only
-		vpData->vpMatrix = XMMatrixTranspose(worldMatrix * viewMatrix * projectionMatrix);
+		vpData.vpMatrix = XMMatrixTranspose(worldMatrix * viewMatrix * projectionMatrix);
 		m_vpCBuffer.update(&vpData);
 	}
 }
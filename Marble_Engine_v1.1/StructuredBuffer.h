@@ -0,0 +1,101 @@
+#include "pch.h"
+#ifndef STRUCTUREDBUFFER_H
+#define STRUCTUREDBUFFER_H
+
+// Dynamic structured buffer read by shaders through a SRV, recreated with a larger capacity when the data outgrows it
+template<class T>
+class StructuredBuffer
+{
+private:
+	// Device
+	ID3D11Device* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+
+	// Buffer
+	Microsoft::WRL::ComPtr< ID3D11Buffer > m_buffer;
+	Microsoft::WRL::ComPtr< ID3D11ShaderResourceView > m_shaderResourceView;
+
+	// Meta Data
+	UINT m_capacity;
+	UINT m_nrOf;
+
+	void create(UINT capacity)
+	{
+		m_capacity = capacity;
+		m_shaderResourceView.Reset();
+		m_buffer.Reset();
+
+		// Buffer Description
+		D3D11_BUFFER_DESC bufferDesc;
+		ZeroMemory(&bufferDesc, sizeof(D3D11_BUFFER_DESC));
+		bufferDesc.ByteWidth = UINT(sizeof(T)) * m_capacity;
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride = UINT(sizeof(T));
+
+		HRESULT hr = m_device->CreateBuffer(&bufferDesc, nullptr, m_buffer.GetAddressOf());
+		assert(SUCCEEDED(hr) && "Error, failed to create structured buffer!");
+
+		// Shader Resource View
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		ZeroMemory(&srvDesc, sizeof(D3D11_SHADER_RESOURCE_VIEW_DESC));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = m_capacity;
+
+		hr = m_device->CreateShaderResourceView(m_buffer.Get(), &srvDesc, m_shaderResourceView.GetAddressOf());
+		assert(SUCCEEDED(hr) && "Error, failed to create structured buffer shader resource view!");
+	}
+
+public:
+	StructuredBuffer()
+	{
+		m_device = nullptr;
+		m_deviceContext = nullptr;
+		m_capacity = 0;
+		m_nrOf = 0;
+	}
+	~StructuredBuffer() {}
+
+	// Initialization
+	void initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, UINT capacity)
+	{
+		m_device = device;
+		m_deviceContext = deviceContext;
+		m_nrOf = 0;
+		create(std::max(capacity, 1u));
+	}
+
+	// Accessors
+	ID3D11ShaderResourceView* getSRV() const { return m_shaderResourceView.Get(); }
+	ID3D11ShaderResourceView* const* getSRVAddressOf() const { return m_shaderResourceView.GetAddressOf(); }
+	UINT getCapacity() const { return m_capacity; }
+	UINT getSize() const { return m_nrOf; }
+
+	// Update, grows by doubling so the views are only recreated when the data outgrows them
+	void update(const T* data, UINT nrOf)
+	{
+		if (nrOf > m_capacity)
+		{
+			UINT capacity = m_capacity;
+			while (capacity < nrOf)
+				capacity *= 2;
+			create(capacity);
+		}
+		m_nrOf = nrOf;
+		if (nrOf == 0)
+			return;
+
+		D3D11_MAPPED_SUBRESOURCE mapSubresource;
+		HRESULT hr = m_deviceContext->Map(m_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapSubresource);
+		assert(SUCCEEDED(hr) && "Error, failed to map structured buffer!");
+		CopyMemory(mapSubresource.pData, data, sizeof(T) * nrOf);
+
+		m_deviceContext->Unmap(m_buffer.Get(), 0);
+	}
+};
+
+#endif // !STRUCTUREDBUFFER_H
@@ -0,0 +1,344 @@
+#ifndef TESTSUPPORT_H
+#define TESTSUPPORT_H
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include "RenderQueue.h"
+#include "ShaderCache.h"
+
+// Fixtures shared by the module tests and benchmarks, only the *Tests.cpp files include this
+
+// Mesh Fixtures
+struct TestVertex
+{
+	float position[3];
+	float normal[3];
+	float texCoord[2];
+};
+
+struct TestGridSettings
+{
+	float quadSize = 1.f;
+	float height = 0.f; // Bends the grid into a ridge along x
+	bool faceByFace = false; // Every quad gets 4 vertices of its own, like a face by face import
+	unsigned int shuffleSeed = 0; // Shuffles the quads into the order an unoptimized import can end up in, 0 keeps them in rows
+};
+
+// size x size quads on the xz plane, two triangles per quad facing up
+static void createTestGrid(unsigned int size, std::vector<TestVertex>& vertices, std::vector<unsigned int>& indices, const TestGridSettings& settings = TestGridSettings())
+{
+	vertices.clear();
+	indices.clear();
+	auto addVertex = [&](unsigned int x, unsigned int y)
+	{
+		float u = x / (float)size, v = y / (float)size;
+		vertices.push_back({ { x * settings.quadSize, settings.height * std::sin(u * 3.14159265f), y * settings.quadSize }, { 0.f, 1.f, 0.f }, { u, v } });
+	};
+
+	if (!settings.faceByFace)
+	{
+		for (unsigned int y = 0; y <= size; y++)
+		{
+			for (unsigned int x = 0; x <= size; x++)
+				addVertex(x, y);
+		}
+	}
+
+	std::vector<unsigned int> quads(size * size);
+	std::iota(quads.begin(), quads.end(), 0);
+	if (settings.shuffleSeed)
+		std::shuffle(quads.begin(), quads.end(), std::mt19937(settings.shuffleSeed));
+
+	for (unsigned int quad : quads)
+	{
+		unsigned int x = quad % size, y = quad / size;
+		unsigned int corners[4]; // x, x + 1, then the same one row further
+		if (settings.faceByFace)
+		{
+			for (unsigned int corner = 0; corner < 4; corner++)
+			{
+				corners[corner] = (unsigned int)vertices.size();
+				addVertex(x + (corner & 1), y + (corner >> 1));
+			}
+		}
+		else
+		{
+			unsigned int corner = y * (size + 1) + x;
+			corners[0] = corner;
+			corners[1] = corner + 1;
+			corners[2] = corner + size + 1;
+			corners[3] = corner + size + 2;
+		}
+
+		const unsigned int triangles[6] = { corners[0], corners[2], corners[3], corners[0], corners[3], corners[1] };
+		indices.insert(indices.end(), triangles, triangles + 6);
+	}
+}
+
+// Render Fixtures
+// Stand in for the device context, simulates the bound state, counts the calls and checks every draw sees the state it asked for.
+// A shader change clobbers one material slot the way the pass setup does
+class RenderRecordingContext
+{
+private:
+	const void* m_shader = nullptr;
+	const void* m_vertexBuffer = nullptr;
+	unsigned int m_vertexStride = 0;
+	const void* m_geometryBuffer = nullptr;
+	const void* m_indexBuffer = nullptr;
+	unsigned int m_indexSize = 0;
+	const void* m_objectBuffer = nullptr;
+	const void* m_materialBuffer = nullptr;
+	const void* m_textures[RENDER_QUEUE_MAX_TEXTURES] = {};
+	const void* m_displacement = nullptr;
+
+	const RenderDraw* m_expected = nullptr;
+
+public:
+	unsigned int nrOfCalls = 0;
+	unsigned int nrOfDraws = 0;
+	unsigned int errors = 0;
+	std::vector<const RenderDraw*> drawOrder;
+
+	// The draw the next draw() call is checked against, without one only the bound state is recorded
+	void expect(const RenderDraw* draw) { m_expected = draw; }
+
+	void setShader(const void* shader)
+	{
+		m_shader = shader;
+		m_textures[RENDER_QUEUE_MAX_TEXTURES - 1] = nullptr;
+		nrOfCalls++;
+	}
+	void setVertexBuffer(const void* buffer, unsigned int stride) { m_vertexBuffer = buffer; m_vertexStride = stride; nrOfCalls++; }
+	void setGeometryBuffer(const void* buffer) { m_geometryBuffer = buffer; nrOfCalls++; }
+	void setIndexBuffer(const void* buffer, unsigned int size) { m_indexBuffer = buffer; m_indexSize = size; nrOfCalls++; }
+	void setObjectBuffer(const void* buffer) { m_objectBuffer = buffer; nrOfCalls++; }
+	void setMaterialBuffer(const void* buffer) { m_materialBuffer = buffer; nrOfCalls++; }
+	void setTexture(unsigned int slot, const void* texture) { m_textures[slot] = texture; nrOfCalls++; }
+	void setDisplacement(const void* texture) { m_displacement = texture; nrOfCalls++; }
+
+	void draw(unsigned int count, unsigned int startIndex, bool indexed, unsigned int instanceCount, unsigned int startInstance)
+	{
+		nrOfDraws++;
+		if (!m_expected)
+			return;
+
+		const RenderDraw& draw = *m_expected;
+		bool valid = m_shader == draw.shader && m_vertexBuffer == draw.vertexBuffer && m_vertexStride == draw.vertexStride && count == draw.count &&
+			startIndex == draw.startIndex && indexed == (draw.indexBuffer != nullptr) && instanceCount == draw.instanceCount && startInstance == draw.startInstance;
+		if (draw.geometryBuffer && m_geometryBuffer != draw.geometryBuffer)
+			valid = false;
+		if (draw.objectBuffer && m_objectBuffer != draw.objectBuffer)
+			valid = false;
+		if (draw.indexBuffer && (m_indexBuffer != draw.indexBuffer || m_indexSize != draw.indexSize))
+			valid = false;
+		if (draw.materialBuffer && m_materialBuffer != draw.materialBuffer)
+			valid = false;
+		if (draw.textureSet.displacement && m_displacement != draw.textureSet.displacement)
+			valid = false;
+		for (unsigned int slot = 0; slot < RENDER_QUEUE_MAX_TEXTURES; slot++)
+		{
+			if ((draw.textureSet.mask & (1u << slot)) && m_textures[slot] != draw.textureSet.textures[slot])
+				valid = false;
+		}
+
+		if (!valid)
+			errors++;
+		drawOrder.push_back(m_expected);
+		m_expected = nullptr;
+	}
+};
+
+// Submits the queue through a recording context that checks each draw against its own state, returns the number of wrong draws
+static unsigned int submitRecorded(RenderQueue& queue, RenderRecordingContext& context, bool skipRedundant = true)
+{
+	struct CheckingContext
+	{
+		RenderRecordingContext* recorder;
+		const RenderQueue* queue;
+		size_t order = 0;
+
+		void setShader(const void* shader) { recorder->setShader(shader); }
+		void setVertexBuffer(const void* buffer, unsigned int stride) { recorder->setVertexBuffer(buffer, stride); }
+		void setGeometryBuffer(const void* buffer) { recorder->setGeometryBuffer(buffer); }
+		void setIndexBuffer(const void* buffer, unsigned int size) { recorder->setIndexBuffer(buffer, size); }
+		void setObjectBuffer(const void* buffer) { recorder->setObjectBuffer(buffer); }
+		void setMaterialBuffer(const void* buffer) { recorder->setMaterialBuffer(buffer); }
+		void setTexture(unsigned int slot, const void* texture) { recorder->setTexture(slot, texture); }
+		void setDisplacement(const void* texture) { recorder->setDisplacement(texture); }
+		void draw(unsigned int count, unsigned int startIndex, bool indexed, unsigned int instanceCount, unsigned int startInstance)
+		{
+			recorder->expect(&queue->getDraw(order++));
+			recorder->draw(count, startIndex, indexed, instanceCount, startInstance);
+		}
+	};
+
+	unsigned int errors = context.errors;
+	CheckingContext checkingContext{ &context, &queue };
+	queue.submit(checkingContext, skipRedundant);
+	return context.errors - errors;
+}
+
+// Draw of the test scene and what the instance batcher needs to group it
+struct TestSceneDraw
+{
+	RenderDraw draw;
+	const void* instancedShader = nullptr;
+	float depth = 0.f;
+	unsigned int object = 0;
+};
+
+struct TestScene
+{
+	std::vector<char> handles; // Every handle is the address of a distinct byte
+	std::vector<float> materials; // Four floats per mesh material, the model default or an override
+	std::vector<TestSceneDraw> draws;
+};
+
+// Objects placed from a few models in random order, sharing shaders, texture sets and geometry the way models loaded through
+// the caches do. Some objects have a material changed on their own and the objects of one model are split between two LODs
+static void fillTestScene(unsigned int nrOfObjects, unsigned int seed, TestScene& scene)
+{
+	const unsigned int NR_OF_SHADERS = 2;
+	const unsigned int NR_OF_MODELS = 8;
+	const unsigned int MAX_MESHES = 4;
+	const unsigned int NR_OF_GEOMETRIES = NR_OF_MODELS * MAX_MESHES;
+	const unsigned int NR_OF_TEXTURE_SETS = 16;
+	const unsigned int NR_OF_TEXTURES = NR_OF_TEXTURE_SETS * RENDER_QUEUE_MAX_TEXTURES;
+
+	scene.handles.assign(NR_OF_SHADERS * 2 + NR_OF_TEXTURES + NR_OF_GEOMETRIES * 3 + nrOfObjects * (MAX_MESHES + 1), 0);
+	const char* shaders = scene.handles.data();
+	const char* instancedShaders = shaders + NR_OF_SHADERS;
+	const char* textures = instancedShaders + NR_OF_SHADERS;
+	const char* geometries = textures + NR_OF_TEXTURES;
+	const char* materialBuffers = geometries + NR_OF_GEOMETRIES * 3;
+	const char* objectBuffers = materialBuffers + nrOfObjects * MAX_MESHES;
+	scene.materials.assign(nrOfObjects * MAX_MESHES * 4, 0.f);
+	scene.draws.clear();
+
+	std::mt19937 generator(seed);
+	for (unsigned int object = 0; object < nrOfObjects; object++)
+	{
+		unsigned int model = generator() % NR_OF_MODELS;
+		unsigned int nrOfMeshes = 1 + model % MAX_MESHES;
+		unsigned int shader = model % NR_OF_SHADERS;
+		bool overridden = generator() % 8 == 0;
+		float depth = (generator() % 1000) / 1000.f;
+		for (unsigned int mesh = 0; mesh < nrOfMeshes; mesh++)
+		{
+			unsigned int geometry = model * MAX_MESHES + mesh;
+			unsigned int textureSet = geometry % NR_OF_TEXTURE_SETS;
+			unsigned int materialIndex = object * MAX_MESHES + mesh;
+			float* material = &scene.materials[materialIndex * 4];
+			material[0] = (float)geometry;
+			material[1] = overridden ? (float)(generator() % 3 + 1) : 0.f;
+
+			TestSceneDraw sceneDraw;
+			RenderDraw& draw = sceneDraw.draw;
+			draw.shader = shaders + shader;
+			draw.vertexBuffer = geometries + geometry * 3;
+			draw.vertexStride = 20;
+			draw.geometryBuffer = geometries + geometry * 3 + 2;
+			draw.indexBuffer = model % 3 ? geometries + geometry * 3 + 1 : nullptr;
+			draw.indexSize = geometry % 2 ? 2 : 4;
+			draw.startIndex = object % 2 ? 36 * (geometry + 1) : 0;
+			draw.count = 36 * (geometry + 1) >> (object % 2);
+			draw.objectBuffer = objectBuffers + object;
+			draw.materialBuffer = materialBuffers + materialIndex;
+			draw.materialData = material;
+			draw.materialSize = 4 * sizeof(float);
+			unsigned int nrOfSlots = shader ? RENDER_QUEUE_MAX_TEXTURES : 3;
+			for (unsigned int slot = 0; slot < nrOfSlots; slot++)
+				draw.textureSet.setTexture(slot, textures + textureSet * RENDER_QUEUE_MAX_TEXTURES + slot);
+			if (textureSet % 4 == 0)
+				draw.textureSet.displacement = draw.textureSet.textures[0];
+
+			// Every fifth model has no instanced shader
+			sceneDraw.instancedShader = model % 5 == 4 ? nullptr : instancedShaders + shader;
+			sceneDraw.depth = depth;
+			sceneDraw.object = object;
+			scene.draws.push_back(sceneDraw);
+		}
+	}
+}
+
+// Shader Fixtures
+// Stand in for the D3D compiler, the bytecode is the request followed by the source with its quoted includes pasted in.
+// A source containing #error fails to compile
+class TestShaderCompiler : public ShaderCompiler
+{
+private:
+	static bool preprocess(const std::filesystem::path& file, std::string& output, unsigned int depth)
+	{
+		std::ifstream sourceStream(file, std::ios::in | std::ios::binary);
+		if (!sourceStream.is_open() || depth > 8)
+			return false;
+
+		std::string line;
+		while (std::getline(sourceStream, line))
+		{
+			if (line.find("#error") != std::string::npos)
+				return false;
+
+			size_t open = line.find("#include \"");
+			if (open == std::string::npos)
+			{
+				output += line + "\n";
+				continue;
+			}
+			size_t close = line.find('"', open + 10);
+			if (close == std::string::npos || !preprocess(file.parent_path() / line.substr(open + 10, close - open - 10), output, depth + 1))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	std::atomic<unsigned int> nrOfCompiles{ 0 };
+	bool slow = false; // Widens the window between the cache lookup and the insert
+
+	static std::string getExpectedBytecode(const ShaderRequest& request)
+	{
+		std::string bytecode = request.entryPoint + "|" + request.profile + "|" + std::to_string(request.flags) + "|";
+		for (const ShaderDefine& define : request.defines)
+			bytecode += define.name + "=" + define.value + ";";
+		if (!preprocess(request.file, bytecode, 0))
+			return "";
+		return bytecode;
+	}
+
+	bool compile(const ShaderRequest& request, std::vector<char>& bytecode, std::string& errors)
+	{
+		nrOfCompiles++;
+		if (slow)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		std::string output = getExpectedBytecode(request);
+		if (output.empty())
+		{
+			errors = "Error, " + request.file.string() + " failed to compile\n";
+			return false;
+		}
+		bytecode.assign(output.begin(), output.end());
+		return true;
+	}
+};
+
+// Writes a source file and moves its write time forward, the cache only re-reads files whose write time changed
+static void writeTestSource(const std::filesystem::path& file, const std::string& source)
+{
+	std::error_code error;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file, error);
+	{
+		std::ofstream sourceStream(file, std::ios::out | std::ios::binary | std::ios::trunc);
+		sourceStream << source;
+	}
+	if (!error)
+		std::filesystem::last_write_time(file, writeTime + std::chrono::seconds(2), error);
+}
+
+#endif // !TESTSUPPORT_H
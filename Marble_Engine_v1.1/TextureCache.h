@@ -0,0 +1,292 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <string>
+#include <map>
+#include <list>
+#include <functional>
+#include <cstddef>
+
+// Reference counted cache of loaded textures. Entries stay resident while a handle points at them, unreferenced entries
+// are kept in least recently used order and evicted once the resident bytes go over the budget. Pinned entries are never
+// evicted. Render thread only
+
+struct TextureCacheStats
+{
+	unsigned int nrOfHits = 0;
+	unsigned int nrOfMisses = 0;
+	unsigned int nrOfEvictions = 0;
+	unsigned long long evictedBytes = 0;
+};
+
+template<typename Resource>
+class TextureCache
+{
+public:
+	// Called when an entry is evicted or the cache is cleared, size is what the entry was accounted with
+	using EvictFunction = std::function<void(const std::wstring& key, Resource& resource, size_t size)>;
+
+private:
+	struct Entry
+	{
+		const std::wstring* key = nullptr;
+		Resource resource{};
+		size_t size = 0;
+		unsigned int nrOfReferences = 0;
+		bool pinned = false;
+		bool inLRU = false;
+		typename std::list<Entry*>::iterator lruPosition;
+	};
+
+public:
+	// Keeps its entry resident, get() points at the entry's resource so a swapped resource is seen by every handle
+	class Handle
+	{
+	private:
+		friend class TextureCache;
+		TextureCache* m_cache = nullptr;
+		Entry* m_entry = nullptr;
+
+		Handle(TextureCache* cache, Entry* entry)
+		{
+			m_cache = cache;
+			m_entry = entry;
+			m_cache->addReference(m_entry);
+		}
+
+	public:
+		Handle() {}
+		Handle(std::nullptr_t) {}
+		Handle(const Handle& other)
+		{
+			if (other.m_entry)
+			{
+				m_cache = other.m_cache;
+				m_entry = other.m_entry;
+				m_cache->addReference(m_entry);
+			}
+		}
+		Handle(Handle&& other) noexcept
+		{
+			m_cache = other.m_cache;
+			m_entry = other.m_entry;
+			other.m_cache = nullptr;
+			other.m_entry = nullptr;
+		}
+		~Handle() { reset(); }
+		Handle& operator=(const Handle& other)
+		{
+			if (this != &other)
+			{
+				Handle copy(other);
+				*this = std::move(copy);
+			}
+			return *this;
+		}
+		Handle& operator=(Handle&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_cache = other.m_cache;
+				m_entry = other.m_entry;
+				other.m_cache = nullptr;
+				other.m_entry = nullptr;
+			}
+			return *this;
+		}
+		Handle& operator=(std::nullptr_t)
+		{
+			reset();
+			return *this;
+		}
+
+		void reset()
+		{
+			if (m_entry)
+				m_cache->release(m_entry);
+			m_cache = nullptr;
+			m_entry = nullptr;
+		}
+
+		// Getters
+		const Resource* get() const { return m_entry ? &m_entry->resource : nullptr; }
+		operator const Resource*() const { return get(); }
+		const Resource& operator*() const { return m_entry->resource; }
+		const std::wstring& getKey() const { return *m_entry->key; }
+	};
+
+private:
+	std::map<std::wstring, Entry> m_entries;
+	std::list<Entry*> m_lru; // Unreferenced entries, least recently used first
+	EvictFunction m_onEvict;
+
+	// Budget
+	size_t m_budget;
+	size_t m_residentBytes = 0;
+
+	// Stats
+	TextureCacheStats m_stats;
+
+	// Helper Functions
+	void addReference(Entry* entry)
+	{
+		if (entry->inLRU)
+		{
+			m_lru.erase(entry->lruPosition);
+			entry->inLRU = false;
+		}
+		entry->nrOfReferences++;
+	}
+
+	void release(Entry* entry)
+	{
+		entry->nrOfReferences--;
+		if (entry->nrOfReferences == 0 && !entry->pinned)
+		{
+			entry->lruPosition = m_lru.insert(m_lru.end(), entry);
+			entry->inLRU = true;
+			trim();
+		}
+	}
+
+	void evict(Entry* entry)
+	{
+		auto it = m_entries.find(*entry->key);
+		m_residentBytes -= entry->size;
+		m_stats.nrOfEvictions++;
+		m_stats.evictedBytes += entry->size;
+		if (m_onEvict)
+			m_onEvict(it->first, entry->resource, entry->size);
+		m_entries.erase(it);
+	}
+
+public:
+	TextureCache(size_t budget, EvictFunction onEvict = nullptr)
+	{
+		m_budget = budget;
+		m_onEvict = onEvict;
+	}
+	~TextureCache() { clear(); }
+	TextureCache(const TextureCache&) = delete;
+	void operator=(const TextureCache&) = delete;
+
+	// Returns a handle to a resident entry and counts a hit, or an empty handle and counts a miss
+	Handle acquire(const std::wstring& key)
+	{
+		auto it = m_entries.find(key);
+		if (it == m_entries.end())
+		{
+			m_stats.nrOfMisses++;
+			return Handle();
+		}
+		m_stats.nrOfHits++;
+		return Handle(this, &it->second);
+	}
+
+	// Adds or replaces an entry, the old resource of a replaced entry is handed to the evict function
+	Handle insert(const std::wstring& key, Resource resource, size_t size)
+	{
+		auto result = m_entries.try_emplace(key);
+		Entry& entry = result.first->second;
+		if (result.second)
+			entry.key = &result.first->first;
+		else if (m_onEvict)
+			m_onEvict(key, entry.resource, entry.size);
+
+		m_residentBytes = m_residentBytes - entry.size + size;
+		entry.resource = resource;
+		entry.size = size;
+
+		Handle handle(this, &entry);
+		trim();
+		return handle;
+	}
+
+	// Swaps the resource of a resident entry without touching its references, false if the entry was evicted
+	bool update(const std::wstring& key, Resource resource, size_t size)
+	{
+		auto it = m_entries.find(key);
+		if (it == m_entries.end())
+			return false;
+
+		Entry& entry = it->second;
+		m_residentBytes = m_residentBytes - entry.size + size;
+		entry.resource = resource;
+		entry.size = size;
+		trim();
+		return true;
+	}
+
+	// Keeps an entry resident until the cache is cleared, for users that hold the raw resource
+	void pin(const std::wstring& key)
+	{
+		auto it = m_entries.find(key);
+		if (it == m_entries.end())
+			return;
+
+		Entry& entry = it->second;
+		entry.pinned = true;
+		if (entry.inLRU)
+		{
+			m_lru.erase(entry.lruPosition);
+			entry.inLRU = false;
+		}
+	}
+
+	// Evicts unreferenced entries, least recently used first, until the resident bytes fit the budget
+	void trim()
+	{
+		while (m_residentBytes > m_budget && !m_lru.empty())
+		{
+			Entry* entry = m_lru.front();
+			m_lru.pop_front();
+			entry->inLRU = false;
+			evict(entry);
+		}
+	}
+
+	// Releases every entry, handles must not outlive this
+	void clear()
+	{
+		if (m_onEvict)
+		{
+			for (auto& entry : m_entries)
+				m_onEvict(entry.first, entry.second.resource, entry.second.size);
+		}
+		m_entries.clear();
+		m_lru.clear();
+		m_residentBytes = 0;
+	}
+
+	void setBudget(size_t budget)
+	{
+		m_budget = budget;
+		trim();
+	}
+
+	// Getters
+	bool contains(const std::wstring& key) const { return m_entries.count(key) > 0; }
+	const Resource* find(const std::wstring& key) const
+	{
+		auto it = m_entries.find(key);
+		return it != m_entries.end() ? &it->second.resource : nullptr;
+	}
+	unsigned int getNrOfReferences(const std::wstring& key) const
+	{
+		auto it = m_entries.find(key);
+		return it != m_entries.end() ? it->second.nrOfReferences : 0;
+	}
+	size_t getBudget() const { return m_budget; }
+	size_t getResidentBytes() const { return m_residentBytes; }
+	unsigned int getNrOfEntries() const { return (unsigned int)m_entries.size(); }
+	unsigned int getNrOfUnreferenced() const { return (unsigned int)m_lru.size(); }
+
+	// Stats
+	const TextureCacheStats& getStats() const { return m_stats; }
+
+	// Test, in TextureCacheTests.cpp
+	static unsigned int test();
+};
+
+#endif // !TEXTURECACHE_H
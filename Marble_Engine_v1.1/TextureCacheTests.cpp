@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "TextureCache.h"
+
+// Test, runs the policy on integer resources and returns the number of failed checks
+template<typename Resource>
+unsigned int TextureCache<Resource>::test()
+{
+	unsigned int errors = 0;
+	std::wstring evictedKeys;
+	auto onEvict = [&evictedKeys](const std::wstring& key, int&, size_t) { evictedKeys += key; };
+
+	// Hits, misses and references
+	{
+		TextureCache<int> cache(100, onEvict);
+		if (cache.acquire(L"a") != nullptr || cache.getStats().nrOfMisses != 1)
+			errors++;
+
+		TextureCache<int>::Handle a = cache.insert(L"a", 1, 40);
+		TextureCache<int>::Handle a2 = cache.acquire(L"a");
+		if (a2 == nullptr || *a2 != 1 || a2.get() != a.get() || cache.getStats().nrOfHits != 1)
+			errors++;
+		if (cache.getNrOfReferences(L"a") != 2)
+			errors++;
+
+		TextureCache<int>::Handle a3 = a2;
+		TextureCache<int>::Handle a4 = std::move(a3);
+		if (cache.getNrOfReferences(L"a") != 3 || a3 != nullptr)
+			errors++;
+		a4 = nullptr;
+		a2.reset();
+		if (cache.getNrOfReferences(L"a") != 1 || cache.getNrOfUnreferenced() != 0)
+			errors++;
+	}
+	if (evictedKeys != L"a") // Cleared on destruction
+		errors++;
+
+	// Referenced entries are never evicted, even over budget
+	evictedKeys.clear();
+	{
+		TextureCache<int> cache(100, onEvict);
+		TextureCache<int>::Handle a = cache.insert(L"a", 1, 60);
+		TextureCache<int>::Handle b = cache.insert(L"b", 2, 60);
+		if (cache.getResidentBytes() != 120 || !evictedKeys.empty())
+			errors++;
+
+		// Released entries go once the budget is exceeded
+		b.reset();
+		if (evictedKeys != L"b" || cache.contains(L"b") || cache.getResidentBytes() != 60)
+			errors++;
+	}
+
+	// Least recently used order, re-acquired entries leave the list
+	evictedKeys.clear();
+	{
+		TextureCache<int> cache(1000, onEvict);
+		{
+			TextureCache<int>::Handle a = cache.insert(L"a", 1, 100);
+			TextureCache<int>::Handle b = cache.insert(L"b", 2, 100);
+			TextureCache<int>::Handle c = cache.insert(L"c", 3, 100);
+			TextureCache<int>::Handle d = cache.insert(L"d", 4, 100);
+			a.reset();
+			c.reset();
+			b.reset();
+			d.reset();
+		}
+		if (cache.getNrOfUnreferenced() != 4 || cache.getResidentBytes() != 400 || !evictedKeys.empty())
+			errors++;
+
+		TextureCache<int>::Handle c = cache.acquire(L"c");
+		cache.setBudget(250);
+		if (evictedKeys != L"ab" || !cache.contains(L"c") || !cache.contains(L"d"))
+			errors++;
+
+		// Pinned entries survive a zero budget
+		cache.pin(L"d");
+		cache.setBudget(0);
+		if (evictedKeys != L"ab" || cache.getNrOfUnreferenced() != 0)
+			errors++;
+		c.reset();
+		if (evictedKeys != L"abc" || cache.getResidentBytes() != 100 || cache.getStats().nrOfEvictions != 3)
+			errors++;
+	}
+
+	// Updates swap the resource behind every handle and keep the size accounting
+	evictedKeys.clear();
+	{
+		TextureCache<int> cache(1000, onEvict);
+		TextureCache<int>::Handle a = cache.insert(L"a", 0, 0);
+		const int* slot = a.get();
+		if (!cache.update(L"a", 7, 300) || *slot != 7 || *a != 7 || cache.getResidentBytes() != 300)
+			errors++;
+		if (cache.update(L"missing", 1, 1))
+			errors++;
+
+		// Replacing an entry hands the old resource to the evict function
+		TextureCache<int>::Handle a2 = cache.insert(L"a", 8, 200);
+		if (evictedKeys != L"a" || *slot != 8 || cache.getResidentBytes() != 200 || cache.getNrOfReferences(L"a") != 2)
+			errors++;
+	}
+
+	return errors;
+}
+
+
+// The test caches int resources whatever the resource type is, -cachetest runs this instantiation
+template unsigned int TextureCache<int>::test();
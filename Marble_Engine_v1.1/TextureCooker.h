@@ -0,0 +1,432 @@
+#include "pch.h"
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+
+#include "MeshCooker.h"
+#include "JobSystem.h"
+#include <filesystem>
+
+// Material slot a texture is cooked for, decides the block compression format and how the mips are filtered
+enum class TextureCookSlot
+{
+	ALBEDO,
+	NORMAL,
+	METALLIC,
+	ROUGHNESS,
+	EMISSIVE,
+	AMBIENT_OCCLUSION,
+	DISPLACEMENT,
+	SPECULAR
+};
+
+const float TEXTURE_COOK_MIN_PSNR = 30.f; // dB on the top mip, cooks below it are not written
+const UINT TEXTURE_COOK_STRIP_ROWS = 64; // Rows per encode job, a multiple of the 4 row block height
+
+struct CookedTextureResult
+{
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	UINT width = 0;
+	UINT height = 0;
+	UINT mipLevels = 0;
+	size_t sourceSize = 0; // Uncompressed with mips
+	size_t cookedSize = 0;
+	float psnr = 0.f;
+	double encodeTime = 0.0; // Milliseconds
+};
+
+struct TextureCookBenchmarkFormat
+{
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	double singleThreadMegapixelsPerSecond = 0.0;
+	double megapixelsPerSecond = 0.0;
+	float averagePSNR = 0.f;
+	float minPSNR = 0.f;
+	UINT nrBelowMinPSNR = 0;
+};
+
+struct TextureCookBenchmarkResult
+{
+	UINT nrOfTextures = 0;
+	double megapixels = 0.0; // Per format, top mips only
+	UINT nrOfThreads = 0;
+	std::vector<TextureCookBenchmarkFormat> formats;
+};
+
+class TextureCooker
+{
+private:
+	// Helper Functions
+	static std::wstring getFileExtension(const std::wstring& path)
+	{
+		size_t i = path.rfind('.', path.length());
+		return i != std::wstring::npos ? path.substr(i + 1, path.length() - i) : L"";
+	}
+
+	static bool loadSource(const std::wstring& path, DirectX::ScratchImage& image)
+	{
+		// WIC needs COM on every thread that decodes
+		static thread_local bool comInitialized = (CoInitializeEx(nullptr, COINIT_MULTITHREADED), true);
+		(void)comInitialized;
+
+		std::wstring fileExtension = getFileExtension(path);
+		if (fileExtension == L"tga" || fileExtension == L"TGA")
+			return SUCCEEDED(DirectX::LoadFromTGAFile(path.c_str(), nullptr, image));
+		return SUCCEEDED(DirectX::LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, image));
+	}
+
+	static bool isColorSlot(TextureCookSlot slot)
+	{
+		return slot == TextureCookSlot::ALBEDO || slot == TextureCookSlot::EMISSIVE || slot == TextureCookSlot::SPECULAR;
+	}
+
+	static bool isGrey(const DirectX::Image& image)
+	{
+		bool grey = true;
+		DirectX::EvaluateImage(image, [&grey](const XMVECTOR* pixels, size_t width, size_t y)
+			{
+				for (size_t x = 0; x < width && grey; x++)
+				{
+					XMVECTOR difference = XMVectorAbs(XMVectorSubtract(XMVectorSplatX(pixels[x]), pixels[x]));
+					grey = XMVector3LessOrEqual(difference, XMVectorReplicate(1.f / 255.f));
+				}
+			});
+		return grey;
+	}
+
+	// Shaders sample metallic and roughness from .g and .b as well as .r, so grey masks only go to BC4 where .r is all that is
+	// read. Single channel sources read the same from BC4 in every slot
+	static DXGI_FORMAT chooseFormat(TextureCookSlot slot, const DirectX::ScratchImage& source)
+	{
+		const DirectX::Image& image = *source.GetImage(0, 0, 0);
+		bool singleChannel = image.format == DXGI_FORMAT_R8_UNORM || image.format == DXGI_FORMAT_R16_UNORM;
+		DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM;
+		switch (slot)
+		{
+		case TextureCookSlot::ALBEDO:
+			format = DXGI_FORMAT_BC7_UNORM;
+			break;
+		case TextureCookSlot::NORMAL:
+			format = DXGI_FORMAT_BC5_UNORM;
+			break;
+		case TextureCookSlot::METALLIC:
+		case TextureCookSlot::ROUGHNESS:
+			format = singleChannel ? DXGI_FORMAT_BC4_UNORM : isGrey(image) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC7_UNORM;
+			break;
+		case TextureCookSlot::AMBIENT_OCCLUSION:
+		case TextureCookSlot::DISPLACEMENT:
+			format = singleChannel || isGrey(image) ? DXGI_FORMAT_BC4_UNORM : DXGI_FORMAT_BC7_UNORM;
+			break;
+		case TextureCookSlot::EMISSIVE:
+		case TextureCookSlot::SPECULAR:
+			format = source.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+			break;
+		}
+
+		// Sources loaded as sRGB keep being read as sRGB, BC4 has no sRGB format so those stay in BC1
+		if (DirectX::IsSRGB(image.format) && slot != TextureCookSlot::NORMAL)
+		{
+			if (format == DXGI_FORMAT_BC4_UNORM)
+				format = DXGI_FORMAT_BC1_UNORM;
+			format = DirectX::MakeSRGB(format);
+		}
+		return format;
+	}
+
+	// Box filtered normals get shorter, the shaders rebuild z from xy so every mip is brought back to unit length
+	static bool renormalize(DirectX::ScratchImage& mipChain)
+	{
+		DirectX::ScratchImage normalized;
+		HRESULT hr = DirectX::TransformImage(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(),
+			[](XMVECTOR* outPixels, const XMVECTOR* inPixels, size_t width, size_t y)
+			{
+				for (size_t x = 0; x < width; x++)
+				{
+					XMVECTOR normal = XMVector3Normalize(XMVectorSubtract(XMVectorScale(inPixels[x], 2.f), XMVectorReplicate(1.f)));
+					outPixels[x] = XMVectorSelect(inPixels[x], XMVectorMultiplyAdd(normal, XMVectorReplicate(.5f), XMVectorReplicate(.5f)), g_XMSelect1110);
+				}
+			}, normalized);
+		if (FAILED(hr))
+			return false;
+
+		mipChain = std::move(normalized);
+		return true;
+	}
+
+	// Whole block rows encode independently, so every image is split into strips that run as jobs
+	static bool compress(const DirectX::ScratchImage& source, DXGI_FORMAT format, DirectX::ScratchImage& compressed, bool parallel)
+	{
+		DirectX::TexMetadata metadata = source.GetMetadata();
+		metadata.format = format;
+		if (FAILED(compressed.Initialize(metadata)))
+			return false;
+
+		struct Strip
+		{
+			size_t image;
+			size_t row;
+			size_t nrOfRows;
+		};
+		std::vector<Strip> strips;
+		for (size_t i = 0; i < source.GetImageCount(); i++)
+		{
+			size_t height = source.GetImages()[i].height;
+			for (size_t row = 0; row < height; row += TEXTURE_COOK_STRIP_ROWS)
+				strips.push_back({ i, row, std::min((size_t)TEXTURE_COOK_STRIP_ROWS, height - row) });
+		}
+
+		// Quick BC7 mode, the full search is over a hundred times slower for a fraction of a dB
+		DirectX::TEX_COMPRESS_FLAGS flags = DirectX::TEX_COMPRESS_DEFAULT;
+		if (format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB)
+			flags = DirectX::TEX_COMPRESS_BC7_QUICK;
+
+		std::atomic<bool> failed(false);
+		auto encode = [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				const Strip& strip = strips[i];
+				const DirectX::Image& sourceImage = source.GetImages()[strip.image];
+				const DirectX::Image& compressedImage = compressed.GetImages()[strip.image];
+
+				DirectX::Image stripImage = sourceImage;
+				stripImage.height = strip.nrOfRows;
+				stripImage.pixels = sourceImage.pixels + strip.row * sourceImage.rowPitch;
+				stripImage.slicePitch = strip.nrOfRows * sourceImage.rowPitch;
+
+				DirectX::ScratchImage encoded;
+				if (FAILED(DirectX::Compress(stripImage, format, flags, DirectX::TEX_THRESHOLD_DEFAULT, encoded)))
+				{
+					failed = true;
+					continue;
+				}
+				const DirectX::Image* encodedImage = encoded.GetImage(0, 0, 0);
+				memcpy(compressedImage.pixels + (strip.row / 4) * compressedImage.rowPitch, encodedImage->pixels, encodedImage->slicePitch);
+			}
+		};
+
+		if (parallel)
+			JobSystem::getInstance().parallelFor((unsigned int)strips.size(), 1, encode);
+		else
+			encode(0, (unsigned int)strips.size());
+
+		return !failed;
+	}
+
+	// Compares only the channels the format keeps
+	static float computePSNR(const DirectX::Image& source, const DirectX::Image& compressed)
+	{
+		DirectX::ScratchImage decompressed;
+		if (FAILED(DirectX::Decompress(compressed, DXGI_FORMAT_UNKNOWN, decompressed)))
+			return 0.f;
+
+		DirectX::CMSE_FLAGS flags = DirectX::CMSE_DEFAULT;
+		switch (compressed.format)
+		{
+		case DXGI_FORMAT_BC4_UNORM:
+			flags |= DirectX::CMSE_IGNORE_GREEN | DirectX::CMSE_IGNORE_BLUE | DirectX::CMSE_IGNORE_ALPHA;
+			break;
+		case DXGI_FORMAT_BC5_UNORM:
+			flags |= DirectX::CMSE_IGNORE_BLUE | DirectX::CMSE_IGNORE_ALPHA;
+			break;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			flags |= DirectX::CMSE_IGNORE_ALPHA;
+			break;
+		default:
+			break;
+		}
+
+		float mse = 0.f;
+		if (FAILED(DirectX::ComputeMSE(source, *decompressed.GetImage(0, 0, 0), mse, nullptr, flags)))
+			return 0.f;
+		return mse > 0.f ? 10.f * log10f(1.f / mse) : 99.f;
+	}
+
+	static void addTextureSlot(std::map<std::wstring, TextureCookSlot>& slots, std::wstring path, TextureCookSlot slot)
+	{
+		if (path.empty())
+			return;
+		if (path.find(L"Textures\\") == 0)
+			path.erase(0, wcslen(L"Textures\\"));
+
+		// The first slot a texture is used in decides its format
+		slots.emplace(path, slot);
+	}
+	static void addTextureSlots(std::map<std::wstring, TextureCookSlot>& slots, const TexturePathsPBR& texturePaths)
+	{
+		addTextureSlot(slots, texturePaths.albedoPath, TextureCookSlot::ALBEDO);
+		addTextureSlot(slots, texturePaths.normalPath, TextureCookSlot::NORMAL);
+		addTextureSlot(slots, texturePaths.metallicPath, TextureCookSlot::METALLIC);
+		addTextureSlot(slots, texturePaths.roughnessPath, TextureCookSlot::ROUGHNESS);
+		addTextureSlot(slots, texturePaths.emissivePath, TextureCookSlot::EMISSIVE);
+		addTextureSlot(slots, texturePaths.ambientOcclusionPath, TextureCookSlot::AMBIENT_OCCLUSION);
+		addTextureSlot(slots, texturePaths.displacementPath, TextureCookSlot::DISPLACEMENT);
+	}
+
+public:
+	static const char* getFormatName(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: return "BC1";
+		case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1 sRGB";
+		case DXGI_FORMAT_BC3_UNORM: return "BC3";
+		case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3 sRGB";
+		case DXGI_FORMAT_BC4_UNORM: return "BC4";
+		case DXGI_FORMAT_BC5_UNORM: return "BC5";
+		case DXGI_FORMAT_BC7_UNORM: return "BC7";
+		case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7 sRGB";
+		default: return "Unknown";
+		}
+	}
+
+	// Slots of every texture used by a model material or a map, paths are relative to the texture root
+	static std::map<std::wstring, TextureCookSlot> gatherTextureSlots()
+	{
+		std::map<std::wstring, TextureCookSlot> slots;
+		std::error_code error;
+
+		// Models, cooked models are read when they are up to date
+		for (auto& file : std::filesystem::recursive_directory_iterator(L"Models", error))
+		{
+			std::wstring fileExtension = getFileExtension(file.path().wstring());
+			if (!file.is_regular_file() || (fileExtension != L"obj" && fileExtension != L"FBX" && fileExtension != L"fbx" && fileExtension != L"glb" && fileExtension != L"gltf"))
+				continue;
+
+			ImportedModel model;
+			if (!MeshCooker::loadModel(std::filesystem::relative(file.path(), L"Models", error).string(), MODEL_IMPORT_FLAGS, model))
+				continue;
+			for (const ImportedMaterial& material : model.materials)
+			{
+				addTextureSlots(slots, material.texturePathsPBR);
+				addTextureSlot(slots, material.texturePaths.specularPath, TextureCookSlot::SPECULAR);
+			}
+		}
+
+		// Maps
+		const std::map<std::string, TextureCookSlot> mapPrefixes =
+		{
+			{ MAT_DIFF_PATH_PREFIX, TextureCookSlot::ALBEDO },
+			{ MAT_NORM_PATH_PREFIX, TextureCookSlot::NORMAL },
+			{ MAT_DISP_PATH_PREFIX, TextureCookSlot::DISPLACEMENT },
+			{ PH_SPEC_PATH_PREFIX, TextureCookSlot::SPECULAR },
+			{ PB_META_PATH_PREFIX, TextureCookSlot::METALLIC },
+			{ PB_ROUG_PATH_PREFIX, TextureCookSlot::ROUGHNESS },
+			{ PB_EMIS_PATH_PREFIX, TextureCookSlot::EMISSIVE },
+			{ PB_AMOC_PATH_PREFIX, TextureCookSlot::AMBIENT_OCCLUSION }
+		};
+		for (auto& file : std::filesystem::directory_iterator(L"Maps", error))
+		{
+			std::ifstream mapFile(file.path());
+			std::string line;
+			while (std::getline(mapFile, line))
+			{
+				size_t space = line.find(' ');
+				if (space == std::string::npos)
+					continue;
+
+				auto prefix = mapPrefixes.find(line.substr(0, space));
+				if (prefix != mapPrefixes.end())
+					addTextureSlot(slots, charToWchar(line.substr(space + 1)), prefix->second);
+			}
+		}
+
+		return slots;
+	}
+
+	// Cooking, path is relative to the texture root. Writes nothing if the encode falls below the minimum PSNR
+	static bool cookTexture(const std::wstring& texturePath, TextureCookSlot slot, CookedTextureResult& result, bool parallel = true, bool write = true)
+	{
+		std::wstring path = L"Textures\\" + texturePath;
+		std::wstring fileExtension = getFileExtension(path);
+		if (fileExtension == L"dds" || fileExtension == L"DDS" || fileExtension == L"hdr")
+			return false;
+
+		DirectX::ScratchImage source;
+		if (!loadSource(path, source))
+			return false;
+
+		// Block compressed top mips have to be a whole number of blocks
+		const DirectX::TexMetadata& metadata = source.GetMetadata();
+		if (metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.width % 4 != 0 || metadata.height % 4 != 0)
+		{
+			OutputDebugString(L"Texture not cooked, size is not a multiple of 4: ");
+			OutputDebugString(texturePath.c_str());
+			OutputDebugString(L"\n");
+			return false;
+		}
+
+		// Mips, color is filtered in linear space
+		DirectX::TEX_FILTER_FLAGS filter = DirectX::TEX_FILTER_FORCE_NON_WIC;
+		if (isColorSlot(slot))
+			filter |= DirectX::TEX_FILTER_SRGB;
+
+		DirectX::ScratchImage mipChain;
+		if (FAILED(DirectX::GenerateMipMaps(source.GetImages(), source.GetImageCount(), metadata, filter, 0, mipChain)))
+			return false;
+		if (slot == TextureCookSlot::NORMAL && !renormalize(mipChain))
+			return false;
+
+		// Encode
+		result.format = chooseFormat(slot, source);
+		auto startTime = std::chrono::steady_clock::now();
+		DirectX::ScratchImage compressed;
+		if (!compress(mipChain, result.format, compressed, parallel))
+			return false;
+		result.encodeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		result.width = (UINT)metadata.width;
+		result.height = (UINT)metadata.height;
+		result.mipLevels = (UINT)mipChain.GetMetadata().mipLevels;
+		result.sourceSize = mipChain.GetPixelsSize();
+		result.cookedSize = compressed.GetPixelsSize();
+		result.psnr = computePSNR(*mipChain.GetImage(0, 0, 0), *compressed.GetImage(0, 0, 0));
+		if (result.psnr < TEXTURE_COOK_MIN_PSNR)
+		{
+			char resultText[256];
+			sprintf_s(resultText, "Texture not cooked, %s at %.1f dB is below %.1f dB: ", getFormatName(result.format), result.psnr, TEXTURE_COOK_MIN_PSNR);
+			OutputDebugStringA(resultText);
+			OutputDebugString(texturePath.c_str());
+			OutputDebugString(L"\n");
+			return false;
+		}
+
+		if (write && FAILED(DirectX::SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(),
+			DirectX::DDS_FLAGS_NONE, ResourceHandler::getCookedTexturePath(path).c_str())))
+			return false;
+
+		return true;
+	}
+
+	// Cooks every texture a material uses, textures are spread over the job system and each one encodes its strips in parallel
+	static UINT cookTextures()
+	{
+		std::map<std::wstring, TextureCookSlot> slots = gatherTextureSlots();
+		std::vector<std::pair<std::wstring, TextureCookSlot>> textures(slots.begin(), slots.end());
+
+		std::atomic<UINT> nrOfCookedTextures(0);
+		JobSystem::getInstance().parallelFor((unsigned int)textures.size(), 1, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					CookedTextureResult result;
+					if (!cookTexture(textures[i].first, textures[i].second, result))
+						continue;
+
+					nrOfCookedTextures++;
+					char resultText[256];
+					sprintf_s(resultText, "Texture cooked (%s, %u mips, %.1f dB, %.1f ms): ", getFormatName(result.format), result.mipLevels, result.psnr, result.encodeTime);
+					OutputDebugStringA(resultText);
+					OutputDebugString(textures[i].first.c_str());
+					OutputDebugString(L"\n");
+				}
+			});
+
+		return nrOfCookedTextures;
+	}
+
+	// Benchmark, in TextureCookerTests.cpp
+	static TextureCookBenchmarkResult benchmark(UINT maxNrOfTextures = 8);
+};
+
+#endif // !TEXTURECOOKER_H
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "TextureCooker.h"
+#include <chrono>
+
+// Benchmark, encodes the top mip of the first material textures to every format on one thread and on the job system
+TextureCookBenchmarkResult TextureCooker::benchmark(UINT maxNrOfTextures)
+{
+	TextureCookBenchmarkResult result;
+	result.nrOfThreads = JobSystem::getInstance().getNrOfThreads();
+
+	std::vector<DirectX::ScratchImage> sources;
+	for (auto& texture : gatherTextureSlots())
+	{
+		if (sources.size() >= maxNrOfTextures)
+			break;
+
+		DirectX::ScratchImage image;
+		std::wstring fileExtension = getFileExtension(texture.first);
+		if (fileExtension == L"dds" || fileExtension == L"DDS" || fileExtension == L"hdr" || !loadSource(L"Textures\\" + texture.first, image))
+			continue;
+
+		const DirectX::TexMetadata& metadata = image.GetMetadata();
+		if (metadata.width % 4 != 0 || metadata.height % 4 != 0)
+			continue;
+
+		// Same source format for every encoder
+		DirectX::ScratchImage converted;
+		if (FAILED(DirectX::Convert(*image.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted)))
+			continue;
+		result.megapixels += metadata.width * metadata.height / 1000000.0;
+		sources.push_back(std::move(converted));
+	}
+	result.nrOfTextures = (UINT)sources.size();
+
+	const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM };
+	for (DXGI_FORMAT format : formats)
+	{
+		TextureCookBenchmarkFormat formatResult;
+		formatResult.format = format;
+		formatResult.minPSNR = 99.f;
+
+		double singleThreadTime = 0.0;
+		double time = 0.0;
+		for (const DirectX::ScratchImage& source : sources)
+		{
+			DirectX::ScratchImage compressed;
+			auto startTime = std::chrono::steady_clock::now();
+			compress(source, format, compressed, false);
+			singleThreadTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			startTime = std::chrono::steady_clock::now();
+			compress(source, format, compressed, true);
+			time += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			float psnr = computePSNR(*source.GetImage(0, 0, 0), *compressed.GetImage(0, 0, 0));
+			formatResult.averagePSNR += psnr / sources.size();
+			formatResult.minPSNR = std::min(formatResult.minPSNR, psnr);
+			if (psnr < TEXTURE_COOK_MIN_PSNR)
+				formatResult.nrBelowMinPSNR++;
+		}
+
+		formatResult.singleThreadMegapixelsPerSecond = singleThreadTime > 0.0 ? result.megapixels / singleThreadTime : 0.0;
+		formatResult.megapixelsPerSecond = time > 0.0 ? result.megapixels / time : 0.0;
+		result.formats.push_back(formatResult);
+	}
+
+	return result;
+}
@@ -0,0 +1,181 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <string>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include "JobSystem.h"
+
+// Decodes textures on the job system and hands them back to the thread that owns the device. Requests for a path that is
+// already in flight are merged, and uploads are budgeted per call so a burst of loads is spread over several frames
+
+struct TextureStreamerStats
+{
+	unsigned int nrOfRequests = 0;
+	unsigned int nrOfDeduplicated = 0;
+	unsigned int nrOfDecoded = 0;
+	unsigned int nrOfFailed = 0;
+	unsigned int nrOfUploaded = 0;
+	unsigned long long decodedBytes = 0;
+};
+
+template<typename Image>
+class TextureStreamer
+{
+public:
+	// Runs on a worker, fills the image and its size in bytes
+	using DecodeFunction = std::function<bool(const std::wstring& path, Image& image, size_t& size)>;
+	// Runs on the thread that calls processUploads(), decoded is false when the decode failed
+	using UploadFunction = std::function<void(const std::wstring& path, Image& image, bool decoded)>;
+
+private:
+	struct DecodeResult
+	{
+		std::wstring path;
+		Image image;
+		size_t size = 0;
+		bool decoded = false;
+	};
+
+	JobSystem* m_jobSystem;
+	DecodeFunction m_decode;
+	JobCounter m_decodeCounter;
+
+	// Requested and not uploaded yet, and decoded waiting for upload
+	std::mutex m_mutex;
+	std::set<std::wstring> m_inFlight;
+	std::deque<DecodeResult> m_decoded;
+
+	// Stats
+	std::atomic<unsigned int> m_nrOfRequests;
+	std::atomic<unsigned int> m_nrOfDeduplicated;
+	std::atomic<unsigned int> m_nrOfDecoded;
+	std::atomic<unsigned int> m_nrOfFailed;
+	std::atomic<unsigned int> m_nrOfUploaded;
+	std::atomic<unsigned long long> m_decodedBytes;
+
+public:
+	TextureStreamer(JobSystem& jobSystem, DecodeFunction decode)
+	{
+		m_jobSystem = &jobSystem;
+		m_decode = decode;
+		m_nrOfRequests = 0;
+		m_nrOfDeduplicated = 0;
+		m_nrOfDecoded = 0;
+		m_nrOfFailed = 0;
+		m_nrOfUploaded = 0;
+		m_decodedBytes = 0;
+	}
+	~TextureStreamer()
+	{
+		// Decode jobs point at this streamer
+		waitForDecodes();
+	}
+	TextureStreamer(const TextureStreamer&) = delete;
+	void operator=(const TextureStreamer&) = delete;
+
+	// Queues a decode, returns false if the path is already in flight
+	bool request(const std::wstring& path)
+	{
+		m_nrOfRequests++;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_inFlight.insert(path).second)
+			{
+				m_nrOfDeduplicated++;
+				return false;
+			}
+		}
+
+		m_jobSystem->run([this, path]()
+			{
+				DecodeResult result;
+				result.path = path;
+				result.decoded = m_decode(path, result.image, result.size);
+				if (result.decoded)
+				{
+					m_nrOfDecoded++;
+					m_decodedBytes += result.size;
+				}
+				else
+					m_nrOfFailed++;
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_decoded.push_back(std::move(result));
+			}, &m_decodeCounter);
+
+		return true;
+	}
+
+	// Uploads decoded images in completion order until byteBudget is spent. The first one always goes so a texture
+	// larger than the budget can not stall the queue
+	unsigned int processUploads(size_t byteBudget, const UploadFunction& upload)
+	{
+		unsigned int nrOfUploads = 0;
+		size_t uploadedBytes = 0;
+		while (true)
+		{
+			DecodeResult result;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_decoded.empty() || (nrOfUploads > 0 && uploadedBytes + m_decoded.front().size > byteBudget))
+					break;
+				result = std::move(m_decoded.front());
+				m_decoded.pop_front();
+			}
+
+			upload(result.path, result.image, result.decoded);
+			uploadedBytes += result.size;
+			nrOfUploads++;
+			m_nrOfUploaded++;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_inFlight.erase(result.path);
+		}
+		return nrOfUploads;
+	}
+
+	// Helps decode until every requested texture is waiting for upload
+	void waitForDecodes()
+	{
+		m_jobSystem->wait(m_decodeCounter);
+	}
+
+	// Getters
+	bool isInFlight(const std::wstring& path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_inFlight.count(path) > 0;
+	}
+	unsigned int getNrOfInFlight()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return (unsigned int)m_inFlight.size();
+	}
+	unsigned int getNrOfWaitingUploads()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return (unsigned int)m_decoded.size();
+	}
+
+	// Stats
+	TextureStreamerStats getStats() const
+	{
+		TextureStreamerStats stats;
+		stats.nrOfRequests = m_nrOfRequests;
+		stats.nrOfDeduplicated = m_nrOfDeduplicated;
+		stats.nrOfDecoded = m_nrOfDecoded;
+		stats.nrOfFailed = m_nrOfFailed;
+		stats.nrOfUploaded = m_nrOfUploaded;
+		stats.decodedBytes = m_decodedBytes;
+		return stats;
+	}
+
+	// Test, in TextureStreamerTests.cpp
+	static unsigned int test(unsigned int nrOfWorkers = 3);
+};
+
+#endif // !TEXTURESTREAMER_H
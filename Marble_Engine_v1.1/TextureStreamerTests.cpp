@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include <chrono>
+#include <thread>
+
+// Test, runs the queue against a fake decoder and returns the number of failed checks
+template<typename Image>
+unsigned int TextureStreamer<Image>::test(unsigned int nrOfWorkers)
+{
+	JobSystem jobSystem(nrOfWorkers);
+	unsigned int errors = 0;
+
+	// Images are their own size in bytes, paths containing "missing" fail
+	std::atomic<unsigned int> nrOfDecodeCalls;
+	nrOfDecodeCalls = 0;
+	auto decode = [&nrOfDecodeCalls](const std::wstring& path, size_t& image, size_t& size)
+	{
+		nrOfDecodeCalls++;
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		if (path.find(L"missing") != std::wstring::npos)
+			return false;
+		image = 1000;
+		size = image;
+		return true;
+	};
+
+	// Deduplication, also when the requests come from several threads at once
+	{
+		TextureStreamer<size_t> streamer(jobSystem, decode);
+		nrOfDecodeCalls = 0;
+		JobCounter counter;
+		for (unsigned int i = 0; i < 64; i++)
+			jobSystem.run([&streamer, i]() { streamer.request(L"texture" + std::to_wstring(i % 8) + L".png"); }, &counter);
+		jobSystem.wait(counter);
+		if (streamer.isInFlight(L"texture0.png") != true)
+			errors++;
+		streamer.waitForDecodes();
+
+		TextureStreamerStats stats = streamer.getStats();
+		if (nrOfDecodeCalls != 8 || stats.nrOfRequests != 64 || stats.nrOfDeduplicated != 56 || stats.nrOfDecoded != 8)
+			errors++;
+		if (streamer.getNrOfWaitingUploads() != 8)
+			errors++;
+
+		streamer.processUploads((size_t)-1, [](const std::wstring&, size_t&, bool) {});
+		if (streamer.getNrOfInFlight() != 0)
+			errors++;
+
+		// Uploaded paths can be requested again
+		if (!streamer.request(L"texture0.png"))
+			errors++;
+		streamer.waitForDecodes();
+	}
+
+	// Budget, whole images only and always at least one
+	{
+		TextureStreamer<size_t> streamer(jobSystem, decode);
+		for (unsigned int i = 0; i < 10; i++)
+			streamer.request(L"budget" + std::to_wstring(i) + L".png");
+		streamer.waitForDecodes();
+
+		unsigned int nrOfUploaded = 0;
+		auto upload = [&nrOfUploaded](const std::wstring&, size_t& image, bool decoded) { if (decoded && image == 1000) nrOfUploaded++; };
+		if (streamer.processUploads(3500, upload) != 3)
+			errors++;
+		if (streamer.processUploads(0, upload) != 1)
+			errors++;
+		if (streamer.processUploads((size_t)-1, upload) != 6 || nrOfUploaded != 10)
+			errors++;
+		if (streamer.processUploads((size_t)-1, upload) != 0)
+			errors++;
+	}
+
+	// Failures still reach the upload so the caller can fall back
+	{
+		TextureStreamer<size_t> streamer(jobSystem, decode);
+		streamer.request(L"missing.png");
+		streamer.request(L"found.png");
+		streamer.waitForDecodes();
+
+		unsigned int nrOfFailedUploads = 0;
+		streamer.processUploads((size_t)-1, [&nrOfFailedUploads](const std::wstring& path, size_t&, bool decoded)
+			{
+				if (!decoded && path == L"missing.png")
+					nrOfFailedUploads++;
+			});
+		if (nrOfFailedUploads != 1 || streamer.getStats().nrOfFailed != 1 || streamer.getStats().nrOfUploaded != 2)
+			errors++;
+	}
+
+	return errors;
+}
+
+
+// The test streams fake size_t images whatever the image type is, -streambench runs this instantiation
+template unsigned int TextureStreamer<size_t>::test(unsigned int nrOfWorkers);
@@ -0,0 +1,170 @@
+#ifndef TRANSFORMSTORE_H
+#define TRANSFORMSTORE_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <DirectXMath.h>
+
+// Structure of arrays transform store, world matrices are only rebuilt for transforms that changed
+// and the view projection multiply runs as one pass over the contiguous world matrices
+
+struct TransformBenchmarkResult
+{
+	unsigned int nrOfTransforms = 0;
+	unsigned int nrOfMoving = 0;
+	double perObjectTime = 0.0; // Average milliseconds per frame, every world and world view projection rebuilt per object
+	double staticCameraTime = 0.0; // Store, only moving transforms rebuilt
+	double movingCameraTime = 0.0; // Store, only moving worlds rebuilt but every world view projection
+	unsigned int mismatches = 0; // Matrices away from the MovementComponent path, over every frame of both store runs
+};
+
+class TransformStore
+{
+private:
+	enum Flags : unsigned char { ACTIVE = 1, DIRTY = 2 };
+
+	// Components
+	std::vector<DirectX::XMFLOAT3> m_scales;
+	std::vector<DirectX::XMFLOAT3> m_localRotations;
+	std::vector<DirectX::XMFLOAT3> m_rotations;
+	std::vector<DirectX::XMFLOAT3> m_positions;
+	std::vector<unsigned char> m_flags;
+	std::vector<unsigned int> m_freeTransforms;
+
+	// Matrices
+	std::vector<DirectX::XMFLOAT4X4A> m_worldMatrices;
+	std::vector<DirectX::XMFLOAT4X4A> m_normalMatrices;
+	std::vector<DirectX::XMFLOAT4X4A> m_wvpMatrices; // Transposed for the constant buffers
+	DirectX::XMFLOAT4X4A m_viewProjectionMatrix;
+
+	// Transforms changed by the last update
+	std::vector<unsigned int> m_movedTransforms;
+	std::vector<unsigned int> m_updatedTransforms;
+
+	static bool equal(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+public:
+	TransformStore()
+	{
+		DirectX::XMStoreFloat4x4A(&m_viewProjectionMatrix, DirectX::XMMatrixIdentity());
+	}
+
+	// Transforms, removed slots are reused
+	unsigned int add()
+	{
+		unsigned int transform;
+		if (!m_freeTransforms.empty())
+		{
+			transform = m_freeTransforms.back();
+			m_freeTransforms.pop_back();
+		}
+		else
+		{
+			transform = (unsigned int)m_flags.size();
+			m_scales.emplace_back();
+			m_localRotations.emplace_back();
+			m_rotations.emplace_back();
+			m_positions.emplace_back();
+			m_flags.emplace_back();
+			m_worldMatrices.emplace_back();
+			m_normalMatrices.emplace_back();
+			m_wvpMatrices.emplace_back();
+		}
+		m_scales[transform] = DirectX::XMFLOAT3(1.f, 1.f, 1.f);
+		m_localRotations[transform] = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+		m_rotations[transform] = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+		m_positions[transform] = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+		m_flags[transform] = ACTIVE | DIRTY;
+
+		return transform;
+	}
+	void remove(unsigned int transform)
+	{
+		if (transform >= m_flags.size() || !(m_flags[transform] & ACTIVE))
+			return;
+
+		m_flags[transform] = 0;
+		m_freeTransforms.push_back(transform);
+	}
+
+	// Marks the transform dirty only if something changed, static objects can set it every frame
+	void set(unsigned int transform, const DirectX::XMFLOAT3& scale, const DirectX::XMFLOAT3& localRotation, const DirectX::XMFLOAT3& rotation, const DirectX::XMFLOAT3& position)
+	{
+		if (equal(m_scales[transform], scale) && equal(m_localRotations[transform], localRotation) &&
+			equal(m_rotations[transform], rotation) && equal(m_positions[transform], position))
+			return;
+
+		m_scales[transform] = scale;
+		m_localRotations[transform] = localRotation;
+		m_rotations[transform] = rotation;
+		m_positions[transform] = position;
+		m_flags[transform] |= DIRTY;
+	}
+
+	// Rebuilds dirty worlds, then the world view projection of every transform whose world or the camera changed
+	void update(DirectX::FXMMATRIX viewProjectionMatrix)
+	{
+		using namespace DirectX;
+
+		XMFLOAT4X4A newViewProjection;
+		XMStoreFloat4x4A(&newViewProjection, viewProjectionMatrix);
+		bool cameraChanged = memcmp(&newViewProjection, &m_viewProjectionMatrix, sizeof(XMFLOAT4X4A)) != 0;
+		m_viewProjectionMatrix = newViewProjection;
+
+		// Worlds
+		m_movedTransforms.clear();
+		for (unsigned int i = 0; i < (unsigned int)m_flags.size(); i++)
+		{
+			if (m_flags[i] != (ACTIVE | DIRTY))
+				continue;
+
+			XMMATRIX worldMatrix =
+				XMMatrixScaling(m_scales[i].x, m_scales[i].y, m_scales[i].z) *
+				XMMatrixRotationRollPitchYaw(m_localRotations[i].x, m_localRotations[i].y, m_localRotations[i].z) *
+				XMMatrixRotationRollPitchYaw(m_rotations[i].x, m_rotations[i].y, m_rotations[i].z) *
+				XMMatrixTranslation(m_positions[i].x, m_positions[i].y, m_positions[i].z);
+			XMStoreFloat4x4A(&m_worldMatrices[i], worldMatrix);
+			XMStoreFloat4x4A(&m_normalMatrices[i], XMMatrixInverse(nullptr, worldMatrix));
+			m_flags[i] = ACTIVE;
+			m_movedTransforms.push_back(i);
+		}
+
+		// World View Projection
+		m_updatedTransforms.clear();
+		if (cameraChanged)
+		{
+			for (unsigned int i = 0; i < (unsigned int)m_flags.size(); i++)
+			{
+				if (m_flags[i] & ACTIVE)
+					m_updatedTransforms.push_back(i);
+			}
+		}
+		else
+			m_updatedTransforms = m_movedTransforms;
+
+		for (size_t i = 0; i < m_updatedTransforms.size(); i++)
+		{
+			unsigned int transform = m_updatedTransforms[i];
+			XMStoreFloat4x4A(&m_wvpMatrices[transform], XMMatrixMultiplyTranspose(XMLoadFloat4x4A(&m_worldMatrices[transform]), viewProjectionMatrix));
+		}
+	}
+
+	// Getters
+	const DirectX::XMFLOAT4X4A& getWorldMatrix(unsigned int transform) const { return m_worldMatrices[transform]; }
+	const DirectX::XMFLOAT4X4A& getNormalMatrix(unsigned int transform) const { return m_normalMatrices[transform]; }
+	const DirectX::XMFLOAT4X4A& getWVPMatrix(unsigned int transform) const { return m_wvpMatrices[transform]; }
+	const DirectX::XMFLOAT4X4A& getViewProjectionMatrix() const { return m_viewProjectionMatrix; }
+	const std::vector<unsigned int>& getMovedTransforms() const { return m_movedTransforms; }
+	const std::vector<unsigned int>& getUpdatedTransforms() const { return m_updatedTransforms; }
+	unsigned int getNrOfTransforms() const { return (unsigned int)(m_flags.size() - m_freeTransforms.size()); }
+
+	// Test and Benchmark, in TransformStoreTests.cpp
+	static unsigned int test();
+	static TransformBenchmarkResult benchmark(unsigned int nrOfTransforms = 50000, unsigned int nrOfFrames = 100, float movingFraction = 0.05f);
+};
+
+#endif // !TRANSFORMSTORE_H
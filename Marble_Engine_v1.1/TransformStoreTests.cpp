@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "TransformStore.h"
+#include "MovementComponent.h"
+#include <chrono>
+#include <random>
+
+struct TestTransform
+{
+	XMFLOAT3 scale = XMFLOAT3(1.f, 1.f, 1.f);
+	XMFLOAT3 localRotation = XMFLOAT3(0.f, 0.f, 0.f);
+	XMFLOAT3 rotation = XMFLOAT3(0.f, 0.f, 0.f);
+	XMFLOAT3 position = XMFLOAT3(0.f, 0.f, 0.f);
+};
+
+static bool nearlyEqual(const XMFLOAT4X4A& a, const XMFLOAT4X4A& b)
+{
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			if (fabsf(a.m[row][column] - b.m[row][column]) > 1e-4f * std::max(1.f, fabsf(b.m[row][column])))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Compares the store matrices with the ones a MovementComponent builds for the same transform, the world view projection
+// transposed like RenderObject::updateWCPBuffer() does for objects outside the store
+static bool matchesMovementComponent(const TransformStore& store, unsigned int transform, const TestTransform& values, FXMMATRIX viewProjectionMatrix)
+{
+	MovementComponent movement;
+	movement.scale = XMLoadFloat3(&values.scale);
+	movement.localRotation = XMLoadFloat3(&values.localRotation);
+	movement.rotation = XMLoadFloat3(&values.rotation);
+	movement.position = XMLoadFloat3(&values.position);
+	XMMATRIX worldMatrix = movement.getWorldMatrix();
+
+	XMFLOAT4X4A world, normal, wvp;
+	XMStoreFloat4x4A(&world, worldMatrix);
+	XMStoreFloat4x4A(&normal, XMMatrixInverse(nullptr, worldMatrix));
+	XMStoreFloat4x4A(&wvp, XMMatrixTranspose(worldMatrix * viewProjectionMatrix));
+	return nearlyEqual(store.getWorldMatrix(transform), world) && nearlyEqual(store.getNormalMatrix(transform), normal) &&
+		nearlyEqual(store.getWVPMatrix(transform), wvp);
+}
+
+// Test, dirty tracking and slot reuse on a few transforms with every component set
+unsigned int TransformStore::test()
+{
+	unsigned int errors = 0;
+	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.f / 9.f, 0.1f, 1000.f);
+	XMMATRIX viewProjectionMatrix = XMMatrixLookAtLH(XMVectorSet(10.f, 5.f, -20.f, 1.f), XMVectorSet(0.f, 0.f, 0.f, 1.f), XMVectorSet(0.f, 1.f, 0.f, 0.f)) * projectionMatrix;
+
+	TransformStore store;
+	std::vector<TestTransform> values(3);
+	values[0].position = XMFLOAT3(1.f, 2.f, 3.f);
+	values[1].scale = XMFLOAT3(2.f, 0.5f, 3.f);
+	values[1].localRotation = XMFLOAT3(0.3f, -1.2f, 0.7f);
+	values[1].rotation = XMFLOAT3(-0.4f, 2.5f, 0.1f);
+	values[1].position = XMFLOAT3(-50.f, 10.f, 200.f);
+	values[2].rotation = XMFLOAT3(0.f, XM_PI, 0.f);
+	values[2].position = XMFLOAT3(0.f, -5.f, 40.f);
+	auto setAll = [&]()
+	{
+		for (unsigned int i = 0; i < (unsigned int)values.size(); i++)
+			store.set(i, values[i].scale, values[i].localRotation, values[i].rotation, values[i].position);
+	};
+	auto matchesAll = [&](FXMMATRIX viewProjection)
+	{
+		unsigned int mismatches = 0;
+		for (unsigned int i = 0; i < (unsigned int)values.size(); i++)
+			mismatches += !matchesMovementComponent(store, i, values[i], viewProjection);
+		return mismatches;
+	};
+
+	// Added transforms are built on the first update
+	for (size_t i = 0; i < values.size(); i++)
+		errors += store.add() != (unsigned int)i;
+	setAll();
+	store.update(viewProjectionMatrix);
+	errors += store.getMovedTransforms().size() != 3 || store.getUpdatedTransforms().size() != 3;
+	errors += matchesAll(viewProjectionMatrix);
+
+	// Setting the same values again changes nothing
+	setAll();
+	store.update(viewProjectionMatrix);
+	errors += !store.getMovedTransforms().empty() || !store.getUpdatedTransforms().empty();
+
+	// A moved transform under a static camera
+	values[2].position.x += 0.25f;
+	setAll();
+	store.update(viewProjectionMatrix);
+	errors += store.getMovedTransforms() != std::vector<unsigned int>{ 2 } || store.getUpdatedTransforms() != std::vector<unsigned int>{ 2 };
+	errors += matchesAll(viewProjectionMatrix);
+
+	// A moved camera updates every world view projection but rebuilds no world
+	XMMATRIX movedViewProjectionMatrix = XMMatrixTranslation(0.f, 0.f, 3.f) * viewProjectionMatrix;
+	store.update(movedViewProjectionMatrix);
+	errors += !store.getMovedTransforms().empty() || store.getUpdatedTransforms().size() != 3;
+	errors += matchesAll(movedViewProjectionMatrix);
+
+	// Removed slots are reused with default values
+	store.remove(1);
+	store.remove(1);
+	errors += store.getNrOfTransforms() != 2;
+	errors += store.add() != 1;
+	values[1] = TestTransform();
+	store.update(movedViewProjectionMatrix);
+	errors += store.getMovedTransforms() != std::vector<unsigned int>{ 1 } || store.getUpdatedTransforms() != std::vector<unsigned int>{ 1 };
+	errors += matchesAll(movedViewProjectionMatrix);
+
+	return errors;
+}
+
+// Benchmark, a fraction of the transforms move every frame. After every store frame all matrices are compared with the
+// MovementComponent path, outside of the timing
+TransformBenchmarkResult TransformStore::benchmark(unsigned int nrOfTransforms, unsigned int nrOfFrames, float movingFraction)
+{
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> positionDistribution(-500.f, 500.f);
+	std::uniform_real_distribution<float> angleDistribution(-XM_PI, XM_PI);
+
+	std::vector<XMFLOAT3> scales(nrOfTransforms), rotations(nrOfTransforms), positions(nrOfTransforms);
+	for (unsigned int i = 0; i < nrOfTransforms; i++)
+	{
+		scales[i] = XMFLOAT3(1.f, 1.f, 1.f);
+		rotations[i] = XMFLOAT3(angleDistribution(generator), angleDistribution(generator), angleDistribution(generator));
+		positions[i] = XMFLOAT3(positionDistribution(generator), positionDistribution(generator), positionDistribution(generator));
+	}
+	unsigned int nrOfMoving = (unsigned int)(nrOfTransforms * movingFraction);
+	XMFLOAT3 noRotation(0.f, 0.f, 0.f);
+	XMMATRIX projectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.f / 9.f, 0.1f, 1000.f);
+
+	TransformBenchmarkResult result;
+	result.nrOfTransforms = nrOfTransforms;
+	result.nrOfMoving = nrOfMoving;
+
+	// Per Object, the old path rebuilt every matrix every frame
+	std::vector<XMFLOAT4X4A> perObjectMatrices(nrOfTransforms * 3);
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+	{
+		XMMATRIX viewProjectionMatrix = XMMatrixTranslation(0.f, 0.f, (float)frame) * projectionMatrix;
+		for (unsigned int i = 0; i < nrOfTransforms; i++)
+		{
+			if (i < nrOfMoving)
+				positions[i].y += 0.01f;
+
+			XMMATRIX worldMatrix =
+				XMMatrixScaling(scales[i].x, scales[i].y, scales[i].z) *
+				XMMatrixRotationRollPitchYaw(noRotation.x, noRotation.y, noRotation.z) *
+				XMMatrixRotationRollPitchYaw(rotations[i].x, rotations[i].y, rotations[i].z) *
+				XMMatrixTranslation(positions[i].x, positions[i].y, positions[i].z);
+			XMStoreFloat4x4A(&perObjectMatrices[i * 3], XMMatrixTranspose(worldMatrix * viewProjectionMatrix));
+			XMStoreFloat4x4A(&perObjectMatrices[i * 3 + 1], XMMatrixTranspose(worldMatrix));
+			XMStoreFloat4x4A(&perObjectMatrices[i * 3 + 2], XMMatrixInverse(nullptr, worldMatrix));
+		}
+	}
+	result.perObjectTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() / std::max(nrOfFrames, 1u);
+
+	// Store
+	TransformStore store;
+	for (unsigned int i = 0; i < nrOfTransforms; i++)
+	{
+		unsigned int transform = store.add();
+		store.set(transform, scales[i], noRotation, rotations[i], positions[i]);
+	}
+	store.update(projectionMatrix);
+
+	TestTransform values;
+	for (int movingCamera = 0; movingCamera < 2; movingCamera++)
+	{
+		double totalTime = 0.0;
+		for (unsigned int frame = 0; frame < nrOfFrames; frame++)
+		{
+			startTime = std::chrono::steady_clock::now();
+			XMMATRIX viewProjectionMatrix = movingCamera ? XMMatrixTranslation(0.f, 0.f, (float)frame) * projectionMatrix : projectionMatrix;
+			for (unsigned int i = 0; i < nrOfTransforms; i++)
+			{
+				if (i < nrOfMoving)
+					positions[i].y += 0.01f;
+				store.set(i, scales[i], noRotation, rotations[i], positions[i]);
+			}
+			store.update(viewProjectionMatrix);
+			totalTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+			// Reference, moving and static transforms
+			for (unsigned int i = 0; i < nrOfTransforms; i++)
+			{
+				values.scale = scales[i];
+				values.rotation = rotations[i];
+				values.position = positions[i];
+				result.mismatches += !matchesMovementComponent(store, i, values, viewProjectionMatrix);
+			}
+		}
+		double frameTime = totalTime / std::max(nrOfFrames, 1u);
+		if (movingCamera)
+			result.movingCameraTime = frameTime;
+		else
+			result.staticCameraTime = frameTime;
+	}
+
+	return result;
+}
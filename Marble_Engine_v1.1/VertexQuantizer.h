@@ -0,0 +1,353 @@
+#ifndef VERTEXQUANTIZER_H
+#define VERTEXQUANTIZER_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <limits>
+#include <type_traits>
+
+// Compressed VertexPosNormTexTan, 20 bytes instead of 56
+//   position, 16 bit unorm inside the mesh bounds, w holds the bitangent sign as 0 for -1 and 65535 for 1
+//   normal and tangent, octahedral 16 bit snorm, the bitangent is cross(normal, tangent) * sign
+//   texCoord, half floats
+struct VertexPosNormTexTanQuantized
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t texCoord[2];
+};
+
+// Decoded position is offset + unorm * scale per axis
+struct VertexQuantizationBounds
+{
+	float offset[3] = { 0.f, 0.f, 0.f };
+	float scale[3] = { 0.f, 0.f, 0.f };
+};
+
+// Error Bounds
+const float QUANTIZED_POSITION_ERROR = 0.5f / 65535.f; // Of the bounds size on each axis
+const float QUANTIZED_DIRECTION_ERROR = 0.0001f; // Distance between the unit vectors, about the angle in radians
+const float QUANTIZED_TEXCOORD_ERROR = 1.f / 2048.f; // Relative, half floats keep 11 significant bits
+
+struct VertexQuantizerErrors
+{
+	float position = 0.f; // Of the bounds size, the largest axis
+	float normal = 0.f;
+	float tangent = 0.f;
+	float bitangent = 0.f; // Only bounded for orthogonal tangent frames
+	float texCoord = 0.f; // Relative
+};
+
+struct VertexQuantizerBenchmarkResult
+{
+	unsigned int nrOfVertices = 0;
+	size_t bytesBefore = 0;
+	size_t bytesAfter = 0;
+	double encodeTime = 0.0; // Milliseconds
+	double decodeTime = 0.0;
+	VertexQuantizerErrors errors;
+};
+
+class VertexQuantizer
+{
+public:
+	// Float layout of VertexPosNormTexTan
+	struct VertexFloats
+	{
+		float position[3];
+		float normal[3];
+		float tangent[3];
+		float bitangent[3];
+		float texCoord[2];
+	};
+
+private:
+	// Half Floats, round to nearest even with subnormals, infinities and NaNs
+	static uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		uint32_t exponent = (bits >> 23) & 0xFF;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		if (exponent == 0xFF)
+			return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+		int halfExponent = (int)exponent - 127 + 15;
+		if (halfExponent >= 31)
+			return sign | 0x7C00;
+
+		if (halfExponent <= 0)
+		{
+			// Subnormal, the shift drops the bits below the half's smallest step
+			if (halfExponent < -10)
+				return sign;
+			mantissa |= 0x800000;
+			uint32_t shift = (uint32_t)(14 - halfExponent);
+			uint32_t halfMantissa = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+				halfMantissa++;
+			return sign | (uint16_t)halfMantissa;
+		}
+
+		uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+		uint32_t remainder = mantissa & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+			half++; // A carry into the exponent is still the right value, up to infinity
+		return sign | (uint16_t)half;
+	}
+	static float halfToFloat(uint16_t half)
+	{
+		uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1F;
+		uint32_t mantissa = half & 0x3FF;
+
+		uint32_t bits;
+		if (exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else if (exponent != 0)
+			bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			bits = sign;
+		else
+		{
+			// Subnormal, normalized into a float
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Vector Math
+	static float distance(const float a[3], const float b[3])
+	{
+		float x = a[0] - b[0], y = a[1] - b[1], z = a[2] - b[2];
+		return std::sqrt(x * x + y * y + z * z);
+	}
+	static void normalize(const float in[3], float out[3])
+	{
+		float length = std::sqrt(in[0] * in[0] + in[1] * in[1] + in[2] * in[2]);
+		for (int k = 0; k < 3; k++)
+			out[k] = length > 0.f ? in[k] / length : 0.f;
+	}
+	static void cross(const float a[3], const float b[3], float out[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// Octahedral
+	static float signNotZero(float value)
+	{
+		return value >= 0.f ? 1.f : -1.f;
+	}
+	static float snormToFloat(int16_t value)
+	{
+		return std::max(value / 32767.f, -1.f);
+	}
+	static void decodeOctahedral(const int16_t encoded[2], float direction[3])
+	{
+		float x = snormToFloat(encoded[0]), y = snormToFloat(encoded[1]);
+		float z = 1.f - std::fabs(x) - std::fabs(y);
+		if (z < 0.f)
+		{
+			float foldedX = (1.f - std::fabs(y)) * signNotZero(x);
+			y = (1.f - std::fabs(x)) * signNotZero(y);
+			x = foldedX;
+		}
+
+		float length = std::sqrt(x * x + y * y + z * z);
+		direction[0] = x / length;
+		direction[1] = y / length;
+		direction[2] = z / length;
+	}
+	static void encodeOctahedral(const float direction[3], int16_t encoded[2])
+	{
+		float sum = std::fabs(direction[0]) + std::fabs(direction[1]) + std::fabs(direction[2]);
+		if (!(sum > 0.f))
+		{
+			encoded[0] = encoded[1] = 0;
+			return;
+		}
+
+		float x = direction[0] / sum, y = direction[1] / sum;
+		if (direction[2] < 0.f)
+		{
+			float foldedX = (1.f - std::fabs(y)) * signNotZero(x);
+			y = (1.f - std::fabs(x)) * signNotZero(y);
+			x = foldedX;
+		}
+
+		// Rounding each axis on its own is not always the closest direction, the four neighbours are tried. Compared by distance
+		// since a dot product this close to 1 is below float precision
+		float unitDirection[3];
+		normalize(direction, unitDirection);
+		float bestDistance = std::numeric_limits<float>::max();
+		float floorX = std::floor(std::min(std::max(x, -1.f), 1.f) * 32767.f), floorY = std::floor(std::min(std::max(y, -1.f), 1.f) * 32767.f);
+		for (int i = 0; i < 4; i++)
+		{
+			int16_t candidate[2] = { (int16_t)std::min(floorX + (i & 1), 32767.f), (int16_t)std::min(floorY + (i >> 1), 32767.f) };
+			float decoded[3];
+			decodeOctahedral(candidate, decoded);
+			float candidateDistance = distance(decoded, unitDirection);
+			if (candidateDistance < bestDistance)
+			{
+				bestDistance = candidateDistance;
+				encoded[0] = candidate[0];
+				encoded[1] = candidate[1];
+			}
+		}
+	}
+
+public:
+	// Bounds of the positions, the first three floats every positionStride bytes
+	static VertexQuantizationBounds computeBounds(const float* positions, size_t positionStride, size_t nrOfVertices)
+	{
+		VertexQuantizationBounds bounds;
+		if (nrOfVertices == 0)
+			return bounds;
+
+		float minimum[3], maximum[3];
+		for (int k = 0; k < 3; k++)
+		{
+			minimum[k] = std::numeric_limits<float>::max();
+			maximum[k] = -std::numeric_limits<float>::max();
+		}
+		for (size_t i = 0; i < nrOfVertices; i++)
+		{
+			const float* position = (const float*)((const char*)positions + positionStride * i);
+			for (int k = 0; k < 3; k++)
+			{
+				minimum[k] = std::min(minimum[k], position[k]);
+				maximum[k] = std::max(maximum[k], position[k]);
+			}
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			bounds.offset[k] = minimum[k];
+			bounds.scale[k] = maximum[k] - minimum[k];
+		}
+		return bounds;
+	}
+
+	// Single Vertex
+	static VertexPosNormTexTanQuantized encode(const VertexFloats& vertex, const VertexQuantizationBounds& bounds)
+	{
+		VertexPosNormTexTanQuantized quantized;
+		for (int k = 0; k < 3; k++)
+		{
+			float unorm = bounds.scale[k] > 0.f ? (vertex.position[k] - bounds.offset[k]) / bounds.scale[k] : 0.f;
+			quantized.position[k] = (uint16_t)std::lround(std::min(std::max(unorm, 0.f), 1.f) * 65535.f);
+		}
+
+		float normalCrossTangent[3];
+		cross(vertex.normal, vertex.tangent, normalCrossTangent);
+		float handedness = normalCrossTangent[0] * vertex.bitangent[0] + normalCrossTangent[1] * vertex.bitangent[1] + normalCrossTangent[2] * vertex.bitangent[2];
+		quantized.position[3] = handedness < 0.f ? 0 : 65535;
+
+		encodeOctahedral(vertex.normal, quantized.normal);
+		encodeOctahedral(vertex.tangent, quantized.tangent);
+		quantized.texCoord[0] = floatToHalf(vertex.texCoord[0]);
+		quantized.texCoord[1] = floatToHalf(vertex.texCoord[1]);
+
+		return quantized;
+	}
+	static VertexFloats decode(const VertexPosNormTexTanQuantized& quantized, const VertexQuantizationBounds& bounds)
+	{
+		VertexFloats vertex;
+		for (int k = 0; k < 3; k++)
+			vertex.position[k] = bounds.offset[k] + quantized.position[k] / 65535.f * bounds.scale[k];
+
+		decodeOctahedral(quantized.normal, vertex.normal);
+		decodeOctahedral(quantized.tangent, vertex.tangent);
+
+		float bitangent[3];
+		cross(vertex.normal, vertex.tangent, bitangent);
+		float sign = quantized.position[3] < 32768 ? -1.f : 1.f;
+		for (int k = 0; k < 3; k++)
+			vertex.bitangent[k] = bitangent[k] * sign;
+
+		vertex.texCoord[0] = halfToFloat(quantized.texCoord[0]);
+		vertex.texCoord[1] = halfToFloat(quantized.texCoord[1]);
+
+		return vertex;
+	}
+
+	// Vertex Arrays, Vertex has the VertexPosNormTexTan float layout
+	template<typename Vertex>
+	static VertexQuantizationBounds encode(const Vertex* vertices, size_t nrOfVertices, VertexPosNormTexTanQuantized* quantized)
+	{
+		static_assert(sizeof(Vertex) == sizeof(VertexFloats) && std::is_trivially_copyable<Vertex>::value, "Vertex needs the VertexPosNormTexTan layout");
+
+		VertexQuantizationBounds bounds = computeBounds((const float*)vertices, sizeof(Vertex), nrOfVertices);
+		for (size_t i = 0; i < nrOfVertices; i++)
+		{
+			VertexFloats vertex;
+			memcpy(&vertex, &vertices[i], sizeof(VertexFloats));
+			quantized[i] = encode(vertex, bounds);
+		}
+		return bounds;
+	}
+	template<typename Vertex>
+	static void decode(const VertexPosNormTexTanQuantized* quantized, size_t nrOfVertices, const VertexQuantizationBounds& bounds, Vertex* vertices)
+	{
+		static_assert(sizeof(Vertex) == sizeof(VertexFloats) && std::is_trivially_copyable<Vertex>::value, "Vertex needs the VertexPosNormTexTan layout");
+
+		for (size_t i = 0; i < nrOfVertices; i++)
+		{
+			VertexFloats vertex = decode(quantized[i], bounds);
+			memcpy(&vertices[i], &vertex, sizeof(VertexFloats));
+		}
+	}
+
+	// Errors of a decoded vertex against its source, folded into the largest so far
+	static void measureErrors(const VertexFloats& source, const VertexFloats& decoded, const VertexQuantizationBounds& bounds, VertexQuantizerErrors& errors)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			if (bounds.scale[k] > 0.f)
+				errors.position = std::max(errors.position, std::fabs(decoded.position[k] - source.position[k]) / bounds.scale[k]);
+		}
+
+		float normal[3], tangent[3], bitangent[3];
+		normalize(source.normal, normal);
+		normalize(source.tangent, tangent);
+		normalize(source.bitangent, bitangent);
+		errors.normal = std::max(errors.normal, distance(normal, decoded.normal));
+		errors.tangent = std::max(errors.tangent, distance(tangent, decoded.tangent));
+		errors.bitangent = std::max(errors.bitangent, distance(bitangent, decoded.bitangent));
+
+		for (int k = 0; k < 2; k++)
+		{
+			float magnitude = std::max(std::fabs(source.texCoord[k]), 1.f / 16384.f); // Below half's normal range the step is fixed
+			errors.texCoord = std::max(errors.texCoord, std::fabs(decoded.texCoord[k] - source.texCoord[k]) / magnitude);
+		}
+	}
+
+	// Test and Benchmark, in VertexQuantizerTests.cpp
+	static VertexFloats createRandomVertex(std::mt19937& generator, float extent);
+
+	static unsigned int test();
+
+	static VertexQuantizerBenchmarkResult benchmark(unsigned int nrOfVertices = 1 << 20);
+};
+
+#endif // !VERTEXQUANTIZER_H
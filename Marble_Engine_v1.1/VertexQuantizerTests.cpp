@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "VertexQuantizer.h"
+#include <chrono>
+#include <random>
+
+// Random vertex inside a cube with an orthonormal frame, for the test and the benchmark
+VertexQuantizer::VertexFloats VertexQuantizer::createRandomVertex(std::mt19937& generator, float extent)
+{
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	std::uniform_real_distribution<float> texCoord(-4.f, 4.f);
+
+	// Orthonormal frame with a random handedness
+	VertexFloats vertex;
+	float normal[3] = { unit(generator), unit(generator), unit(generator) };
+	float other[3] = { unit(generator), unit(generator), unit(generator) };
+	if (normal[0] == 0.f && normal[1] == 0.f && normal[2] == 0.f)
+		normal[2] = 1.f;
+	normalize(normal, vertex.normal);
+	float tangent[3];
+	cross(other, vertex.normal, tangent);
+	normalize(tangent, vertex.tangent);
+	cross(vertex.normal, vertex.tangent, vertex.bitangent);
+	if (generator() & 1)
+	{
+		for (float& value : vertex.bitangent)
+			value = -value;
+	}
+
+	for (int k = 0; k < 3; k++)
+		vertex.position[k] = position(generator);
+	vertex.texCoord[0] = texCoord(generator);
+	vertex.texCoord[1] = texCoord(generator);
+	return vertex;
+}
+
+// Test
+unsigned int VertexQuantizer::test()
+{
+	unsigned int errors = 0;
+
+	// Layout matches the input layout descriptor offsets
+	errors += sizeof(VertexPosNormTexTanQuantized) != 20;
+	errors += offsetof(VertexPosNormTexTanQuantized, normal) != 8 || offsetof(VertexPosNormTexTanQuantized, tangent) != 12 || offsetof(VertexPosNormTexTanQuantized, texCoord) != 16;
+
+	// Half floats, exact values, rounding, subnormals and limits
+	const float exactValues[] = { 0.f, -0.f, 1.f, -1.f, 0.5f, 2048.f, 65504.f, 1.f / 1024.f, 0.00006103515625f, 0.000000059604645f };
+	for (float value : exactValues)
+		errors += halfToFloat(floatToHalf(value)) != value;
+	errors += floatToHalf(1.f + 1.f / 2048.f) != floatToHalf(1.f); // Halfway rounds to even
+	errors += floatToHalf(1.f + 3.f / 2048.f) != floatToHalf(1.f + 1.f / 512.f);
+	errors += halfToFloat(floatToHalf(100000.f)) != std::numeric_limits<float>::infinity();
+	errors += halfToFloat(floatToHalf(-std::numeric_limits<float>::infinity())) != -std::numeric_limits<float>::infinity();
+	errors += !std::isnan(halfToFloat(floatToHalf(std::numeric_limits<float>::quiet_NaN())));
+	errors += halfToFloat(floatToHalf(1e-9f)) != 0.f;
+	for (uint32_t half = 0; half < 0x7C00; half++)
+		errors += floatToHalf(halfToFloat((uint16_t)half)) != half; // Every finite half survives the round trip
+
+	// Octahedral axes and the folded seams decode to themselves
+	const float axes[][3] = { { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f },
+		{ 0.70710678f, 0.f, -0.70710678f }, { 0.f, -0.70710678f, -0.70710678f } };
+	for (const float* axis : axes)
+	{
+		int16_t encoded[2];
+		float decoded[3];
+		encodeOctahedral(axis, encoded);
+		decodeOctahedral(encoded, decoded);
+		errors += distance(axis, decoded) > QUANTIZED_DIRECTION_ERROR;
+	}
+
+	// Random vertices stay within the error bounds and keep their handedness
+	std::mt19937 generator(24);
+	for (float extent : { 0.01f, 1.f, 1000.f })
+	{
+		std::vector<VertexFloats> vertices(20000);
+		for (VertexFloats& vertex : vertices)
+			vertex = createRandomVertex(generator, extent);
+
+		std::vector<VertexPosNormTexTanQuantized> quantized(vertices.size());
+		std::vector<VertexFloats> decoded(vertices.size());
+		VertexQuantizationBounds bounds = encode(vertices.data(), vertices.size(), quantized.data());
+		decode(quantized.data(), quantized.size(), bounds, decoded.data());
+
+		VertexQuantizerErrors maxErrors;
+		for (size_t i = 0; i < vertices.size(); i++)
+			measureErrors(vertices[i], decoded[i], bounds, maxErrors);
+
+		errors += maxErrors.position > QUANTIZED_POSITION_ERROR * 1.01f;
+		errors += maxErrors.normal > QUANTIZED_DIRECTION_ERROR;
+		errors += maxErrors.tangent > QUANTIZED_DIRECTION_ERROR;
+		errors += maxErrors.bitangent > QUANTIZED_DIRECTION_ERROR * 3.f; // Cross product of two quantized directions
+		errors += maxErrors.texCoord > QUANTIZED_TEXCOORD_ERROR;
+	}
+
+	// Flat meshes keep their flat axis exactly, zero length directions do not break the encoder
+	{
+		VertexFloats vertex = {};
+		vertex.position[0] = 5.f;
+		vertex.position[1] = 2.f;
+		VertexQuantizationBounds bounds = computeBounds(vertex.position, sizeof(VertexFloats), 1);
+		VertexFloats decoded = decode(encode(vertex, bounds), bounds);
+		errors += decoded.position[0] != 5.f || decoded.position[1] != 2.f || decoded.position[2] != 0.f;
+		errors += std::isnan(decoded.normal[0]) || std::isnan(decoded.tangent[0]);
+	}
+
+	return errors;
+}
+
+// Benchmark, random vertices inside a 100 unit cube
+VertexQuantizerBenchmarkResult VertexQuantizer::benchmark(unsigned int nrOfVertices)
+{
+	std::mt19937 generator(1);
+	std::vector<VertexFloats> vertices(nrOfVertices);
+	for (VertexFloats& vertex : vertices)
+		vertex = createRandomVertex(generator, 50.f);
+
+	VertexQuantizerBenchmarkResult result;
+	result.nrOfVertices = nrOfVertices;
+	result.bytesBefore = vertices.size() * sizeof(VertexFloats);
+	result.bytesAfter = vertices.size() * sizeof(VertexPosNormTexTanQuantized);
+
+	std::vector<VertexPosNormTexTanQuantized> quantized(vertices.size());
+	std::vector<VertexFloats> decoded(vertices.size());
+	auto startTime = std::chrono::steady_clock::now();
+	VertexQuantizationBounds bounds = encode(vertices.data(), vertices.size(), quantized.data());
+	auto encodeTime = std::chrono::steady_clock::now();
+	decode(quantized.data(), quantized.size(), bounds, decoded.data());
+	auto decodeTime = std::chrono::steady_clock::now();
+
+	result.encodeTime = std::chrono::duration<double, std::milli>(encodeTime - startTime).count();
+	result.decodeTime = std::chrono::duration<double, std::milli>(decodeTime - encodeTime).count();
+	for (size_t i = 0; i < vertices.size(); i++)
+		measureErrors(vertices[i], decoded[i], bounds, result.errors);
+
+	return result;
+}
+
@@ -3,9 +3,10 @@
 
 #include <d3d11.h>
 #include <DirectXMath.h>
+#include "VertexQuantizer.h"
 using namespace DirectX;
 
-enum class LayoutType { POS_NOR_TEX_TAN, POS_NOR_TEX, POS_TEX_FINDEX, POS_TEX, POS_COL, POS, PARTICLE, NONE };
+enum class LayoutType { POS_NOR_TEX_TAN, POS_NOR_TEX_TAN_INSTANCED, POS_NOR_TEX_TAN_QUANTIZED, POS_NOR_TEX_TAN_QUANTIZED_INSTANCED, POS_NOR_TEX, POS_TEX_FINDEX, POS_TEX, POS_COL, POS, PARTICLE, NONE };
 
 
 struct VertexPos
@@ -98,6 +99,65 @@ const D3D11_INPUT_ELEMENT_DESC VertexPosNormTexTanDesc[] =
 	{ "TEXCOORD",   0, DXGI_FORMAT_R32G32_FLOAT,		0, 48, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
+// Instanced, one VS_WVP_CBUFFER per instance in slot 1 with the matrix rows as they are laid out in the constant buffer
+static const unsigned int VertexPosNormTexTanInstancedElementCount = 17;
+
+const D3D11_INPUT_ELEMENT_DESC VertexPosNormTexTanInstancedDesc[] =
+{
+	{ "POSITION",   		0, DXGI_FORMAT_R32G32B32_FLOAT,		0, 0,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",     		0, DXGI_FORMAT_R32G32B32_FLOAT,		0, 12,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",			0, DXGI_FORMAT_R32G32B32_FLOAT,		0, 24,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "BITANGENT",			0, DXGI_FORMAT_R32G32B32_FLOAT,		0, 36,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",   		0, DXGI_FORMAT_R32G32_FLOAT,		0, 48,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "INSTANCE_WVP",		0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 0,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 16,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 32,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 48,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 64,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 80,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 96,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 112,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 128,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 144,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 160,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 176,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
+// Quantized, VertexPosNormTexTanQuantized from VertexQuantizer.h, read by GeneralVS and ShadowMapVS built with QUANTIZED. The mesh
+// bounds come from a VS_QUANTIZATION_CBUFFER in slot 2
+static const unsigned int VertexPosNormTexTanQuantizedElementCount = 4;
+
+const D3D11_INPUT_ELEMENT_DESC VertexPosNormTexTanQuantizedDesc[] =
+{
+	{ "POSITION",   0, DXGI_FORMAT_R16G16B16A16_UNORM,	0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",     0, DXGI_FORMAT_R16G16_SNORM,		0, 8,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",	0, DXGI_FORMAT_R16G16_SNORM,		0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",   0, DXGI_FORMAT_R16G16_FLOAT,		0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+// Quantized and instanced, the instance data of VertexPosNormTexTanInstancedDesc after the quantized vertex
+static const unsigned int VertexPosNormTexTanQuantizedInstancedElementCount = 16;
+
+const D3D11_INPUT_ELEMENT_DESC VertexPosNormTexTanQuantizedInstancedDesc[] =
+{
+	{ "POSITION",   		0, DXGI_FORMAT_R16G16B16A16_UNORM,	0, 0,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL",     		0, DXGI_FORMAT_R16G16_SNORM,		0, 8,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT",			0, DXGI_FORMAT_R16G16_SNORM,		0, 12,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD",   		0, DXGI_FORMAT_R16G16_FLOAT,		0, 16,	D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "INSTANCE_WVP",		0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 0,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 16,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 32,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WVP",		3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 48,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 64,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 80,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 96,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_WORLD",		3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 112,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	0, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 128,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	1, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 144,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	2, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 160,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "INSTANCE_NORMAL",	3, DXGI_FORMAT_R32G32B32A32_FLOAT,	1, 176,	D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
 struct VertexParticle
 {
 	XMFLOAT3 position;
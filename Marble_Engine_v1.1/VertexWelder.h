@@ -0,0 +1,184 @@
+#ifndef VERTEXWELDER_H
+#define VERTEXWELDER_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Pure CPU vertex deduplication, vertices are seen as a row of floats with one tolerance per float. Two vertices merge when
+// every float differs by at most its tolerance, a tolerance of 0 merges exact matches only. Vertices are looked up by the
+// first floats, the position of every vertex type in the engine, in cells twice their tolerance wide so the vertices in
+// reach are in the own cell or the neighbour on the nearer side of each axis
+
+struct VertexWelderBenchmarkResult
+{
+	unsigned int nrOfVertices = 0;
+	unsigned int nrOfWeldedVertices = 0;
+	unsigned int iterations = 0;
+	double weldTime = 0.0; // Average milliseconds per weld
+	size_t scratchBytes = 0;
+};
+
+class VertexWelder
+{
+private:
+	static constexpr unsigned int EMPTY_SLOT = 0xFFFFFFFF;
+
+	static constexpr size_t MAX_HASHED_FLOATS = 3;
+
+	// Cell of one float, NaNs share a cell of their own
+	static int64_t quantize(float value, float inverseCellSize)
+	{
+		if (value != value)
+			return INT64_MIN;
+
+		if (inverseCellSize == 0.f)
+		{
+			// Exact, 0 and -0 are the same value
+			if (value == 0.f)
+				return 0;
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		double cell = std::floor((double)value * inverseCellSize);
+		if (cell < -9.0e18)
+			return -INT64_MAX;
+		if (cell > 9.0e18)
+			return INT64_MAX;
+		return (int64_t)cell;
+	}
+
+	// The other cell within one tolerance of the value, the same cell when the float is compared exactly
+	static int64_t getNeighbourCell(float value, int64_t cell, float inverseCellSize)
+	{
+		if (inverseCellSize == 0.f || value != value || cell == INT64_MAX || cell == -INT64_MAX)
+			return cell;
+		return (double)value * inverseCellSize - (double)cell < 0.5 ? cell - 1 : cell + 1;
+	}
+
+	static uint64_t hashCells(const int64_t* cells, size_t nrOfFloats)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < nrOfFloats; i++)
+		{
+			hash ^= (uint64_t)cells[i];
+			hash *= 1099511628211ull;
+			hash ^= hash >> 29;
+		}
+		return hash;
+	}
+
+	static bool withinTolerance(const float* a, const float* b, const float* epsilons, size_t nrOfFloats)
+	{
+		for (size_t i = 0; i < nrOfFloats; i++)
+		{
+			// Equal values first, so infinities and NaNs match themselves
+			bool equal = a[i] == b[i] || (a[i] != a[i] && b[i] != b[i]);
+			if (!equal && !(std::fabs(a[i] - b[i]) <= epsilons[i]))
+				return false;
+		}
+		return true;
+	}
+
+	static size_t getTableSize(size_t nrOfVertices)
+	{
+		size_t tableSize = 16;
+		while (tableSize < nrOfVertices * 2)
+			tableSize *= 2;
+		return tableSize;
+	}
+
+public:
+	// Welds in place, a vertex merges into the first kept vertex within tolerance and is kept otherwise, in first seen order.
+	// Kept vertices are never within tolerance of each other. epsilons holds one tolerance per float of Vertex, returns the
+	// new number of vertices
+	template<typename Vertex>
+	static unsigned int weld(Vertex* vertices, unsigned int nrOfVertices, unsigned int* indices, size_t nrOfIndices, const float* epsilons)
+	{
+		static_assert(std::is_trivially_copyable<Vertex>::value && sizeof(Vertex) % sizeof(float) == 0, "Vertex has to be made of floats");
+		const size_t nrOfFloats = sizeof(Vertex) / sizeof(float);
+		const size_t nrOfHashed = nrOfFloats < MAX_HASHED_FLOATS ? nrOfFloats : MAX_HASHED_FLOATS;
+
+		float inverseCellSizes[MAX_HASHED_FLOATS];
+		for (size_t i = 0; i < nrOfHashed; i++)
+			inverseCellSizes[i] = epsilons[i] > 0.f ? 0.5f / epsilons[i] : 0.f;
+
+		// Open addressing, slots hold indices of kept vertices and a cell can hold several
+		size_t tableMask = getTableSize(nrOfVertices) - 1;
+		std::vector<unsigned int> table(tableMask + 1, EMPTY_SLOT);
+		std::vector<unsigned int> remap(nrOfVertices);
+
+		int64_t cells[MAX_HASHED_FLOATS];
+		int64_t neighbours[MAX_HASHED_FLOATS];
+		int64_t probe[MAX_HASHED_FLOATS];
+
+		unsigned int nrOfWelded = 0;
+		for (unsigned int i = 0; i < nrOfVertices; i++)
+		{
+			const float* vertex = (const float*)&vertices[i];
+			for (size_t k = 0; k < nrOfHashed; k++)
+			{
+				cells[k] = quantize(vertex[k], inverseCellSizes[k]);
+				neighbours[k] = getNeighbourCell(vertex[k], cells[k], inverseCellSizes[k]);
+			}
+
+			// Own cell and every combination of neighbours, the kept vertex with the lowest index wins
+			unsigned int match = EMPTY_SLOT;
+			size_t ownSlot = 0;
+			for (unsigned int combination = 0; combination < (1u << nrOfHashed); combination++)
+			{
+				bool duplicate = false;
+				for (size_t k = 0; k < nrOfHashed; k++)
+				{
+					bool neighbour = (combination >> k) & 1;
+					duplicate = duplicate || (neighbour && neighbours[k] == cells[k]);
+					probe[k] = neighbour ? neighbours[k] : cells[k];
+				}
+				if (duplicate)
+					continue;
+
+				size_t slot = (size_t)hashCells(probe, nrOfHashed) & tableMask;
+				for (; table[slot] != EMPTY_SLOT; slot = (slot + 1) & tableMask)
+				{
+					const float* kept = (const float*)&vertices[table[slot]];
+					if (table[slot] < match && withinTolerance(kept, vertex, epsilons, nrOfFloats))
+						match = table[slot];
+				}
+				if (combination == 0)
+					ownSlot = slot;
+			}
+
+			if (match == EMPTY_SLOT)
+			{
+				// Kept vertices only move towards the front, over ones already read
+				match = nrOfWelded;
+				table[ownSlot] = nrOfWelded;
+				if (nrOfWelded != i)
+					vertices[nrOfWelded] = vertices[i];
+				nrOfWelded++;
+			}
+			remap[i] = match;
+		}
+
+		for (size_t i = 0; i < nrOfIndices; i++)
+			indices[i] = remap[indices[i]];
+
+		return nrOfWelded;
+	}
+
+	// Hash table and remap table of one weld
+	static size_t getScratchBytes(unsigned int nrOfVertices)
+	{
+		return (getTableSize(nrOfVertices) + nrOfVertices) * sizeof(unsigned int);
+	}
+
+	// Test and Benchmark, in VertexWelderTests.cpp
+	static unsigned int test();
+	static VertexWelderBenchmarkResult benchmark(unsigned int gridSize = 512, unsigned int iterations = 10);
+};
+
+#endif // !VERTEXWELDER_H
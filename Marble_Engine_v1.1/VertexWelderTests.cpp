@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "VertexWelder.h"
+#include "TestSupport.h"
+#include <chrono>
+#include <random>
+
+unsigned int VertexWelder::test()
+{
+	unsigned int errors = 0;
+	TestGridSettings faceByFaceGrid;
+	faceByFaceGrid.faceByFace = true;
+	const float exact[8] = {};
+	const float loose[8] = { 0.01f, 0.01f, 0.01f, 0.01f, 0.01f, 0.01f, 0.001f, 0.001f };
+
+	// Shared grid corners collapse to (size + 1)^2 and every triangle keeps its corners
+	for (unsigned int size : { 1u, 7u, 64u })
+	{
+		std::vector<TestVertex> vertices, original;
+		std::vector<unsigned int> indices, originalIndices;
+		createTestGrid(size, vertices, indices, faceByFaceGrid);
+		original = vertices;
+		originalIndices = indices;
+
+		unsigned int nrOfVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), exact);
+		errors += nrOfVertices != (size + 1) * (size + 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			errors += indices[i] >= nrOfVertices;
+			errors += memcmp(&vertices[indices[i]], &original[originalIndices[i]], sizeof(TestVertex)) != 0;
+		}
+	}
+
+	// Attributes split vertices, a different normal or uv at the same position is a seam
+	{
+		std::vector<TestVertex> vertices = {
+			{ { 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f } },
+			{ { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 0.f } },
+			{ { 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.5f, 0.f } },
+			{ { -0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f } } };
+		std::vector<unsigned int> indices = { 0, 1, 2, 3 };
+		unsigned int nrOfVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), exact);
+		errors += nrOfVertices != 3;
+		errors += indices != std::vector<unsigned int>({ 0, 1, 2, 0 });
+	}
+
+	// Tolerance, nearly equal vertices merge while ones further apart than the tolerance never do
+	std::mt19937 generator(3);
+	std::uniform_real_distribution<float> noise(0.f, 0.0001f);
+	std::uniform_real_distribution<float> position(-10.f, 10.f);
+	for (int round = 0; round < 10; round++)
+	{
+		std::vector<TestVertex> vertices, original;
+		std::vector<unsigned int> indices;
+		for (unsigned int i = 0; i < 1000; i++)
+		{
+			TestVertex vertex = { { position(generator), position(generator), position(generator) }, { 0.f, 0.f, 1.f }, { 0.25f, 0.75f } };
+			for (int copy = 0; copy < 3; copy++)
+			{
+				TestVertex nearby = vertex;
+				for (float& value : nearby.position)
+					value += noise(generator);
+				indices.push_back((unsigned int)vertices.size());
+				vertices.push_back(nearby);
+			}
+		}
+		original = vertices;
+
+		unsigned int nrOfVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), loose);
+		errors += nrOfVertices != 1000;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			const TestVertex& welded = vertices[indices[i]];
+			for (int k = 0; k < 3; k++)
+				errors += std::fabs(welded.position[k] - original[i].position[k]) > loose[k];
+		}
+	}
+
+	// Cell borders, a pair straddling one merges and a pair further apart than the tolerance inside one cell does not
+	{
+		const float offsets[4] = { 0.0199f, 0.0201f, 0.042f, 0.057f };
+		std::vector<TestVertex> vertices;
+		for (float offset : offsets)
+			vertices.push_back({ { offset, 5.f - offset, -offset }, { 0.f, 0.f, 1.f }, { 0.25f, 0.75f } });
+		std::vector<unsigned int> indices = { 0, 1, 2, 3 };
+		unsigned int nrOfVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), loose);
+		errors += nrOfVertices != 3;
+		errors += indices != std::vector<unsigned int>({ 0, 0, 1, 2 });
+	}
+
+	// Kept vertices are never within tolerance of each other, against a brute force check on a dense cloud
+	{
+		std::uniform_real_distribution<float> dense(0.f, 0.1f);
+		std::vector<TestVertex> vertices(2000);
+		for (TestVertex& vertex : vertices)
+			vertex = { { dense(generator), dense(generator), dense(generator) }, { 0.f, 0.f, 1.f }, { 0.25f, 0.75f } };
+		std::vector<TestVertex> original = vertices;
+		std::vector<unsigned int> indices(vertices.size());
+		std::iota(indices.begin(), indices.end(), 0);
+
+		unsigned int nrOfVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), loose);
+		auto within = [&](const TestVertex& a, const TestVertex& b)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				if (std::fabs(a.position[k] - b.position[k]) > loose[k])
+					return false;
+			}
+			return true;
+		};
+		for (unsigned int a = 0; a < nrOfVertices; a++)
+		{
+			for (unsigned int b = a + 1; b < nrOfVertices; b++)
+				errors += within(vertices[a], vertices[b]);
+		}
+		for (size_t i = 0; i < indices.size(); i++)
+			errors += indices[i] >= nrOfVertices || !within(vertices[indices[i]], original[i]);
+	}
+
+	// Empty and single vertex meshes
+	{
+		std::vector<TestVertex> vertices(1);
+		std::vector<unsigned int> indices = { 0, 0, 0 };
+		errors += weld(vertices.data(), 0, nullptr, 0, exact) != 0;
+		errors += weld(vertices.data(), 1, indices.data(), indices.size(), exact) != 1;
+	}
+
+	return errors;
+}
+
+// Benchmark, a face by face grid of gridSize^2 quads
+VertexWelderBenchmarkResult VertexWelder::benchmark(unsigned int gridSize, unsigned int iterations)
+{
+	const float epsilons[8] = { 0.00001f, 0.00001f, 0.00001f, 0.001f, 0.001f, 0.001f, 0.00001f, 0.00001f };
+	TestGridSettings faceByFaceGrid;
+	faceByFaceGrid.faceByFace = true;
+	std::vector<TestVertex> sourceVertices, vertices;
+	std::vector<unsigned int> sourceIndices, indices;
+	createTestGrid(gridSize, sourceVertices, sourceIndices, faceByFaceGrid);
+
+	VertexWelderBenchmarkResult result;
+	result.nrOfVertices = (unsigned int)sourceVertices.size();
+	result.iterations = iterations;
+	result.scratchBytes = getScratchBytes(result.nrOfVertices);
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		vertices = sourceVertices;
+		indices = sourceIndices;
+
+		auto startTime = std::chrono::steady_clock::now();
+		result.nrOfWeldedVertices = weld(vertices.data(), (unsigned int)vertices.size(), indices.data(), indices.size(), epsilons);
+		result.weldTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	if (iterations)
+		result.weldTime /= iterations;
+
+	return result;
+}
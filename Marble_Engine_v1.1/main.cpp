@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Application.h"
+#include "HeadlessModes.h"
 
 Application* app;
 
@@ -7,6 +8,11 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 {
 	HRESULT hr = CoInitialize(NULL);
 
+	// Headless Modes, "-cook" and the tests and benchmarks in HeadlessModes.cpp run instead of the engine and exit without opening a window
+	int exitCode = 0;
+	if (runHeadlessModes(lpCmdLine, exitCode))
+		return exitCode;
+
 	bool initOK = false;
 	app = &Application::getInstance();
 	initOK = app->initialize(hInstance, lpCmdLine, app->getWindow(), nShowCmd);